@@ -99,6 +99,20 @@
 #ifdef HAVE_LIBGCRYPT
 #include <wsutil/wsgcrypt.h>
 #include <wsutil/file_util.h>
+/*
+ * The hashes are computed in threads other than the main one (see
+ * hasher_start() and -j).  libgcrypt before 1.6 has to be given locking
+ * callbacks for that; we can do so with pthreads, and on Windows only a
+ * libgcrypt that does its own locking can be used from threads.
+ */
+#ifndef _WIN32
+#include <errno.h>
+#include <pthread.h>
+GCRY_THREAD_OPTION_PTHREAD_IMPL;
+#define HASH_IN_THREADS
+#elif GCRYPT_VERSION_NUMBER >= 0x010600
+#define HASH_IN_THREADS
+#endif
 #endif
 
 #ifndef HAVE_GETOPT
@@ -123,6 +137,20 @@
 
 static gboolean continue_after_wtap_open_offline_failure = TRUE;
 
+/*
+ * The '-I' option writes a capture index next to every file read, see
+ * wtap_save_index(); a file that has an up to date index is never read
+ * through, its infos come from the index.
+ */
+static gboolean save_capture_index = FALSE;
+
+/*
+ * The '-j' option processes that many files at once, each in a thread
+ * of its own; the infos are still reported in the order the files were
+ * given.
+ */
+static guint process_threads = 1;
+
 /*
  * table report variables
  */
@@ -164,6 +192,7 @@ static gboolean cap_data_rate_bit = TRUE;   /* Report data rate bites/sec */
 static gboolean cap_packet_size = TRUE;     /* Report average packet size */
 static gboolean cap_packet_rate = TRUE;     /* Report average packet rate */
 static gboolean cap_order = TRUE;           /* Report if packets are in chronological order (True/False) */
+static gboolean cap_process_time = FALSE;   /* Report time taken to process the file (not one of "all infos") */
 
 #ifdef HAVE_LIBGCRYPT
 static gboolean cap_file_hashes = TRUE;     /* Calculate file hashes */
@@ -273,11 +302,7 @@ GError *parse_err = NULL;
 
 #define HASH_STR_SIZE (41) /* Max hash size * 2 + '\0' */
 #define HASH_BUF_SIZE (1024 * 1024)
-
-
-static gchar file_sha1[HASH_STR_SIZE];
-static gchar file_rmd160[HASH_STR_SIZE];
-static gchar file_md5[HASH_STR_SIZE];
+#define HASH_BUFS     4    /* buffers between the reader and the hash thread */
 
 #define FILE_HASH_OPT "H"
 #else
@@ -328,6 +353,13 @@ typedef struct _capture_info {
   order_t       order;
 
   int          *encap_counts;           /* array of per_packet encap counts; array has one entry per wtap_encap type */
+
+  double        process_time;           /* seconds taken to open, read and hash the file */
+#ifdef HAVE_LIBGCRYPT
+  gchar         file_sha1[HASH_STR_SIZE];
+  gchar         file_rmd160[HASH_STR_SIZE];
+  gchar         file_md5[HASH_STR_SIZE];
+#endif
 } capture_info;
 
 
@@ -571,14 +603,15 @@ print_stats(const gchar *filename, capture_info *cf_info)
   }
 #ifdef HAVE_LIBGCRYPT
   if (cap_file_hashes) {
-    printf     ("SHA1:                %s\n", file_sha1);
-    printf     ("RIPEMD160:           %s\n", file_rmd160);
-    printf     ("MD5:                 %s\n", file_md5);
+    printf     ("SHA1:                %s\n", cf_info->file_sha1);
+    printf     ("RIPEMD160:           %s\n", cf_info->file_rmd160);
+    printf     ("MD5:                 %s\n", cf_info->file_md5);
   }
 #endif /* HAVE_LIBGCRYPT */
   if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
   if (cap_comment && cf_info->comment)
     printf     ("Capture comment:     %s\n", cf_info->comment);
+  if (cap_process_time)   printf     ("Processing time:     %.6f seconds\n", cf_info->process_time);
 }
 
 static void
@@ -633,6 +666,7 @@ print_stats_table_header(void)
 #endif /* HAVE_LIBGCRYPT */
   if (cap_order)          print_stats_table_header_label("Strict time order");
   if (cap_comment)        print_stats_table_header_label("Capture comment");
+  if (cap_process_time)   print_stats_table_header_label("Processing time (seconds)");
 
   printf("\n");
 }
@@ -791,17 +825,17 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
   if (cap_file_hashes) {
     putsep();
     putquote();
-    printf("%s", file_sha1);
+    printf("%s", cf_info->file_sha1);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_rmd160);
+    printf("%s", cf_info->file_rmd160);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_md5);
+    printf("%s", cf_info->file_md5);
     putquote();
   }
 #endif /* HAVE_LIBGCRYPT */
@@ -820,12 +854,22 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     putquote();
   }
 
+  if (cap_process_time) {
+    putsep();
+    putquote();
+    printf("%f", cf_info->process_time);
+    putquote();
+  }
 
   printf("\n");
 }
 
+/*
+ * Fill in cf_info for the file; anything to report on the standard error
+ * goes to errors, as the file may be processed in a thread of its own.
+ */
 static int
-process_cap_file(wtap *wth, const char *filename)
+process_cap_file(wtap *wth, const char *filename, capture_info *cf_info, GString *errors)
 {
   int                   err;
   gchar                *err_info;
@@ -837,7 +881,6 @@ process_cap_file(wtap *wth, const char *filename)
   guint32               snaplen_min_inferred = 0xffffffff;
   guint32               snaplen_max_inferred =          0;
   const struct wtap_pkthdr *phdr;
-  capture_info          cf_info;
   gboolean              have_times = TRUE;
   double                start_time = 0;
   double                stop_time  = 0;
@@ -847,13 +890,30 @@ process_cap_file(wtap *wth, const char *filename)
   order_t               order = IN_ORDER;
   wtapng_section_t     *shb_inf;
   gchar                *p;
+  wtap_index           *idx;
+  struct wtap_pkthdr    idx_phdr;
 
 
-  cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+  cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+
+  /* An up to date index has all we need without reading the file */
+  if (save_capture_index)
+    wtap_save_index(wth, filename);
+  idx = wtap_index_open(wth, filename);
+  err = 0;
 
   /* Tally up data that we need to parse through the file to find */
-  while (wtap_read(wth, &err, &err_info, &data_offset))  {
-    phdr = wtap_phdr(wth);
+  for (;;) {
+    if (idx != NULL) {
+      if (packet == wtap_index_count(idx))
+        break;
+      wtap_index_get(idx, packet, &idx_phdr);
+      phdr = &idx_phdr;
+    } else {
+      if (!wtap_read(wth, &err, &err_info, &data_offset))
+        break;
+      phdr = wtap_phdr(wth);
+    }
     if (phdr->presence_flags & WTAP_HAS_TS) {
       prev_time = cur_time;
       cur_time = secs_nsecs(&phdr->ts);
@@ -894,16 +954,19 @@ process_cap_file(wtap *wth, const char *filename)
     /* Per-packet encapsulation */
     if (wtap_file_encap(wth) == WTAP_ENCAP_PER_PACKET) {
       if ((phdr->pkt_encap > 0) && (phdr->pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-        cf_info.encap_counts[phdr->pkt_encap] += 1;
+        cf_info->encap_counts[phdr->pkt_encap] += 1;
       } else {
-        fprintf(stderr, "capinfos: Unknown per-packet encapsulation: %d [frame number: %d]\n", phdr->pkt_encap, packet);
+        g_string_append_printf(errors, "capinfos: Unknown per-packet encapsulation: %d [frame number: %d]\n", phdr->pkt_encap, packet);
       }
     }
 
-  } /* while */
+  } /* for */
+
+  if (idx != NULL)
+    wtap_index_close(idx);
 
   if (err != 0) {
-    fprintf(stderr,
+    g_string_append_printf(errors,
         "capinfos: An error occurred after reading %u packets from \"%s\": %s.\n",
         packet, filename, wtap_strerror(err));
     switch (err) {
@@ -912,80 +975,78 @@ process_cap_file(wtap *wth, const char *filename)
       case WTAP_ERR_UNSUPPORTED_ENCAP:
       case WTAP_ERR_BAD_FILE:
       case WTAP_ERR_DECOMPRESS:
-        fprintf(stderr, "(%s)\n", err_info);
+        g_string_append_printf(errors, "(%s)\n", err_info);
         g_free(err_info);
         break;
     }
-    g_free(cf_info.encap_counts);
     return 1;
   }
 
   /* File size */
   size = wtap_file_size(wth, &err);
   if (size == -1) {
-    fprintf(stderr,
+    g_string_append_printf(errors,
         "capinfos: Can't get size of \"%s\": %s.\n",
         filename, g_strerror(err));
-    g_free(cf_info.encap_counts);
     return 1;
   }
 
-  cf_info.filesize = size;
+  cf_info->filesize = size;
 
   /* File Type */
-  cf_info.file_type = wtap_file_type(wth);
-  cf_info.iscompressed = wtap_iscompressed(wth);
+  cf_info->file_type = wtap_file_type(wth);
+  cf_info->iscompressed = wtap_iscompressed(wth);
 
   /* File Encapsulation */
-  cf_info.file_encap = wtap_file_encap(wth);
+  cf_info->file_encap = wtap_file_encap(wth);
 
   /* Packet size limit (snaplen) */
-  cf_info.snaplen = wtap_snapshot_length(wth);
-  if(cf_info.snaplen > 0)
-    cf_info.snap_set = TRUE;
+  cf_info->snaplen = wtap_snapshot_length(wth);
+  if(cf_info->snaplen > 0)
+    cf_info->snap_set = TRUE;
   else
-    cf_info.snap_set = FALSE;
+    cf_info->snap_set = FALSE;
 
-  cf_info.snaplen_min_inferred = snaplen_min_inferred;
-  cf_info.snaplen_max_inferred = snaplen_max_inferred;
+  cf_info->snaplen_min_inferred = snaplen_min_inferred;
+  cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
   /* # of packets */
-  cf_info.packet_count = packet;
+  cf_info->packet_count = packet;
 
   /* File Times */
-  cf_info.times_known = have_times;
-  cf_info.start_time = start_time;
-  cf_info.stop_time = stop_time;
-  cf_info.duration = stop_time-start_time;
-  cf_info.know_order = know_order;
-  cf_info.order = order;
+  cf_info->times_known = have_times;
+  cf_info->start_time = start_time;
+  cf_info->stop_time = stop_time;
+  cf_info->duration = stop_time-start_time;
+  cf_info->know_order = know_order;
+  cf_info->order = order;
 
   /* Number of packet bytes */
-  cf_info.packet_bytes = bytes;
+  cf_info->packet_bytes = bytes;
 
-  cf_info.data_rate   = 0.0;
-  cf_info.packet_rate = 0.0;
-  cf_info.packet_size = 0.0;
+  cf_info->data_rate   = 0.0;
+  cf_info->packet_rate = 0.0;
+  cf_info->packet_size = 0.0;
 
   if (packet > 0) {
-    if (cf_info.duration > 0.0) {
-      cf_info.data_rate   = (double)bytes  / (stop_time-start_time); /* Data rate per second */
-      cf_info.packet_rate = (double)packet / (stop_time-start_time); /* packet rate per second */
+    if (cf_info->duration > 0.0) {
+      cf_info->data_rate   = (double)bytes  / (stop_time-start_time); /* Data rate per second */
+      cf_info->packet_rate = (double)packet / (stop_time-start_time); /* packet rate per second */
     }
-    cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
   }
 
-  cf_info.comment = NULL;
+  cf_info->comment = NULL;
   shb_inf = wtap_file_get_shb_info(wth);
   if (shb_inf) {
     /* opt_comment is always 0-terminated by pcapng_read_section_header_block */
-    cf_info.comment = g_strdup(shb_inf->opt_comment);
+    cf_info->comment = g_strdup(shb_inf->opt_comment);
   }
   g_free(shb_inf);
-  if (cf_info.comment) {
+  if (cf_info->comment) {
     /* multi-line comments would conflict with the formatting that capinfos uses
        we replace linefeeds with spaces */
-    p = cf_info.comment;
+    p = cf_info->comment;
     while (*p != '\0') {
       if (*p=='\n')
         *p=' ';
@@ -993,16 +1054,356 @@ process_cap_file(wtap *wth, const char *filename)
     }
   }
 
-  if(long_report) {
-    print_stats(filename, &cf_info);
+  return 0;
+}
+
+#ifdef HAVE_LIBGCRYPT
+static void
+hash_to_str(const unsigned char *hash, size_t length, char *str) {
+  int i;
+
+  for (i = 0; i < (int) length; i++) {
+    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
+  }
+}
+
+/*
+ * The hashes of a file are computed in a thread of their own while the
+ * file is read, from the data wiretap reads it into (see
+ * wtap_set_raw_tap()), so the file is read only once.  The data is
+ * copied into a few buffers that go back and forth between the reader
+ * and the hash thread through two queues.
+ */
+typedef struct _hash_buf {
+  guint         len;                    /* 0 marks the end of the file */
+  guint8        data[HASH_BUF_SIZE];
+} hash_buf;
+
+typedef struct _file_hasher {
+  gcry_md_hd_t  hd;
+  GThread      *thread;                 /* or NULL to hash in the reader */
+  GAsyncQueue  *free_bufs;              /* empty buffers for the reader */
+  GAsyncQueue  *full_bufs;              /* buffers for the hash thread */
+  hash_buf     *cur;                    /* buffer being filled, or NULL */
+} file_hasher;
+
+static gpointer
+hash_thread(gpointer data)
+{
+  file_hasher *hasher = (file_hasher *)data;
+  hash_buf    *buf;
+  gboolean     end;
+
+  do {
+    buf = (hash_buf *)g_async_queue_pop(hasher->full_bufs);
+    end = buf->len == 0;
+    gcry_md_write(hasher->hd, buf->data, buf->len);
+    buf->len = 0;
+    g_async_queue_push(hasher->free_bufs, buf);
+  } while (!end);
+  return NULL;
+}
+
+static void
+hash_raw_data(const guint8 *data, guint len, void *user_data)
+{
+  file_hasher *hasher = (file_hasher *)user_data;
+  guint        n;
+
+  if (hasher->thread == NULL) {
+    gcry_md_write(hasher->hd, data, len);
+    return;
+  }
+  while (len) {
+    if (hasher->cur == NULL)
+      hasher->cur = (hash_buf *)g_async_queue_pop(hasher->free_bufs);
+    n = MIN(len, HASH_BUF_SIZE - hasher->cur->len);
+    memcpy(hasher->cur->data + hasher->cur->len, data, n);
+    hasher->cur->len += n;
+    data += n;
+    len -= n;
+    if (hasher->cur->len == HASH_BUF_SIZE) {
+      g_async_queue_push(hasher->full_bufs, hasher->cur);
+      hasher->cur = NULL;
+    }
+  }
+}
+
+static gboolean
+hasher_start(file_hasher *hasher, wtap *wth)
+{
+  int i;
+
+  memset(hasher, 0, sizeof *hasher);
+  gcry_md_open(&hasher->hd, GCRY_MD_SHA1, 0);
+  if (!hasher->hd)
+    return FALSE;
+  gcry_md_enable(hasher->hd, GCRY_MD_RMD160);
+  gcry_md_enable(hasher->hd, GCRY_MD_MD5);
+
+  hasher->free_bufs = g_async_queue_new();
+  hasher->full_bufs = g_async_queue_new();
+  for (i = 0; i < HASH_BUFS; i++)
+    g_async_queue_push(hasher->free_bufs, g_new0(hash_buf, 1));
+#ifdef HASH_IN_THREADS
+#if GLIB_CHECK_VERSION(2,31,0)
+  hasher->thread = g_thread_try_new("hash", hash_thread, hasher, NULL);
+#else
+  hasher->thread = g_thread_create(hash_thread, hasher, TRUE, NULL);
+#endif
+#endif
+
+  wtap_set_raw_tap(wth, hash_raw_data, hasher);
+  return TRUE;
+}
+
+/* Hash the rest of the file, and fill in the hashes if all of it was hashed */
+static void
+hasher_finish(file_hasher *hasher, wtap *wth, capture_info *cf_info)
+{
+  gboolean  complete;
+  int       err;
+  int       i;
+
+  complete = wtap_raw_tap_finish(wth, &err);
+  if (hasher->thread != NULL) {
+    if (hasher->cur == NULL)
+      hasher->cur = (hash_buf *)g_async_queue_pop(hasher->free_bufs);
+    if (hasher->cur->len) {
+      g_async_queue_push(hasher->full_bufs, hasher->cur);
+      hasher->cur = (hash_buf *)g_async_queue_pop(hasher->free_bufs);
+    }
+    /* an empty buffer ends the thread */
+    g_async_queue_push(hasher->full_bufs, hasher->cur);
+    g_thread_join(hasher->thread);
+  }
+  for (i = 0; i < HASH_BUFS; i++)
+    g_free(g_async_queue_pop(hasher->free_bufs));
+  g_async_queue_unref(hasher->free_bufs);
+  g_async_queue_unref(hasher->full_bufs);
+
+  if (complete) {
+    gcry_md_final(hasher->hd);
+    hash_to_str(gcry_md_read(hasher->hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
+    hash_to_str(gcry_md_read(hasher->hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, cf_info->file_rmd160);
+    hash_to_str(gcry_md_read(hasher->hd, GCRY_MD_MD5), HASH_SIZE_MD5, cf_info->file_md5);
+  }
+  gcry_md_close(hasher->hd);
+}
+#endif /* HAVE_LIBGCRYPT */
+
+/*
+ * Everything reported for one file.  With -j, files are processed in
+ * worker threads, and the main thread reports on them in the order they
+ * were given once they are done.
+ */
+typedef struct _file_result {
+  const char   *filename;
+  gboolean      opened;                 /* FALSE if the file couldn't be opened */
+  int           status;                 /* process_cap_file() return value */
+  GString      *errors;                 /* for the standard error */
+  capture_info  cf_info;
+} file_result;
+
+static void
+process_file(file_result *res)
+{
+  wtap    *wth;
+  int      err;
+  gchar   *err_info;
+  GTimer  *timer;
+#ifdef HAVE_LIBGCRYPT
+  file_hasher hasher;
+  gboolean hashing = FALSE;
+#endif
+
+  res->errors = g_string_new("");
+#ifdef HAVE_LIBGCRYPT
+  g_strlcpy(res->cf_info.file_sha1, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(res->cf_info.file_rmd160, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(res->cf_info.file_md5, "<unknown>", HASH_STR_SIZE);
+#endif
+
+  timer = g_timer_new();
+  wth = wtap_open_offline(res->filename, &err, &err_info, FALSE);
+
+  if (!wth) {
+    g_string_append_printf(res->errors, "capinfos: Can't open %s: %s\n",
+        res->filename, wtap_strerror(err));
+    switch (err) {
+
+      case WTAP_ERR_UNSUPPORTED:
+      case WTAP_ERR_UNSUPPORTED_ENCAP:
+      case WTAP_ERR_BAD_FILE:
+        g_string_append_printf(res->errors, "(%s)\n", err_info);
+        g_free(err_info);
+        break;
+    }
+    g_timer_destroy(timer);
+    return;
+  }
+  res->opened = TRUE;
+
+#ifdef HAVE_LIBGCRYPT
+  if (cap_file_hashes)
+    hashing = hasher_start(&hasher, wth);
+#endif
+
+  res->status = process_cap_file(wth, res->filename, &res->cf_info, res->errors);
+
+#ifdef HAVE_LIBGCRYPT
+  if (hashing)
+    hasher_finish(&hasher, wth, &res->cf_info);
+#endif
+
+  wtap_close(wth);
+  res->cf_info.process_time = g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+}
+
+/* Report on a file; exits if that's what should happen after a failure */
+static int
+report_file(file_result *res, gboolean first)
+{
+  int status = 0;
+
+  fputs(res->errors->str, stderr);
+  if (!res->opened) {
+    if (!continue_after_wtap_open_offline_failure)
+      exit(1); /* error status */
+    status = 1; /* remember that an error has occurred */
   } else {
-    print_stats_table(filename, &cf_info);
+    if (!first && long_report)
+      printf("\n");
+    if (res->status)
+      exit(res->status);
+    if (long_report) {
+      print_stats(res->filename, &res->cf_info);
+    } else {
+      print_stats_table(res->filename, &res->cf_info);
+    }
   }
 
-  g_free(cf_info.encap_counts);
-  g_free(cf_info.comment);
+  g_string_free(res->errors, TRUE);
+  g_free(res->cf_info.encap_counts);
+  g_free(res->cf_info.comment);
+  return status;
+}
 
-  return 0;
+/*
+ * Files processed with -j.  Workers take the files in order, but don't
+ * get more than PROCESS_AHEAD files per thread ahead of the one to be
+ * reported next, so the results waiting to be reported stay few.
+ */
+#define PROCESS_AHEAD 4
+
+typedef struct _file_pool {
+  file_result  *results;
+  guint         nfiles;
+  guint         next;                   /* next file for a worker to take */
+  guint         reported;               /* files reported on so far */
+  guint         ahead;                  /* most files taken ahead of reported */
+  gboolean     *done;                   /* per file: TRUE once processed */
+  GMutex       *mtx;
+  GCond        *cond;
+} file_pool;
+
+static gpointer
+process_worker(gpointer data)
+{
+  file_pool *pool = (file_pool *)data;
+  guint      i;
+
+  for (;;) {
+    g_mutex_lock(pool->mtx);
+    while (pool->next < pool->nfiles && pool->next >= pool->reported + pool->ahead)
+      g_cond_wait(pool->cond, pool->mtx);
+    if (pool->next == pool->nfiles) {
+      g_mutex_unlock(pool->mtx);
+      break;
+    }
+    i = pool->next++;
+    g_mutex_unlock(pool->mtx);
+
+    process_file(&pool->results[i]);
+
+    g_mutex_lock(pool->mtx);
+    pool->done[i] = TRUE;
+    g_cond_broadcast(pool->cond);
+    g_mutex_unlock(pool->mtx);
+  }
+  return NULL;
+}
+
+/* Process the files in nthreads threads, and report on them in order */
+static int
+process_files_parallel(file_result *results, guint nfiles, guint nthreads)
+{
+  file_pool  pool;
+  GThread  **threads;
+  guint      nstarted, i;
+  int        status = 0;
+
+  pool.results = results;
+  pool.nfiles = nfiles;
+  pool.next = 0;
+  pool.reported = 0;
+  pool.ahead = nthreads * PROCESS_AHEAD;
+  pool.done = g_new0(gboolean, nfiles);
+#if GLIB_CHECK_VERSION(2,31,0)
+  pool.mtx = g_new(GMutex, 1);
+  g_mutex_init(pool.mtx);
+  pool.cond = g_new(GCond, 1);
+  g_cond_init(pool.cond);
+#else
+  pool.mtx = g_mutex_new();
+  pool.cond = g_cond_new();
+#endif
+
+  threads = g_new(GThread *, nthreads);
+  for (nstarted = 0; nstarted < nthreads; nstarted++) {
+#if GLIB_CHECK_VERSION(2,31,0)
+    threads[nstarted] = g_thread_try_new("capinfos worker", process_worker, &pool, NULL);
+#else
+    threads[nstarted] = g_thread_create(process_worker, &pool, TRUE, NULL);
+#endif
+    if (threads[nstarted] == NULL)
+      break;
+  }
+
+  for (i = 0; i < nfiles; i++) {
+    if (nstarted == 0) {
+      /* no threads at all; do it ourselves */
+      process_file(&results[i]);
+    } else {
+      g_mutex_lock(pool.mtx);
+      while (!pool.done[i])
+        g_cond_wait(pool.cond, pool.mtx);
+      g_mutex_unlock(pool.mtx);
+    }
+
+    status |= report_file(&results[i], i == 0);
+
+    g_mutex_lock(pool.mtx);
+    pool.reported = i + 1;
+    g_cond_broadcast(pool.cond);
+    g_mutex_unlock(pool.mtx);
+  }
+
+  for (i = 0; i < nstarted; i++)
+    g_thread_join(threads[i]);
+  g_free(threads);
+#if GLIB_CHECK_VERSION(2,31,0)
+  g_mutex_clear(pool.mtx);
+  g_free(pool.mtx);
+  g_cond_clear(pool.cond);
+  g_free(pool.cond);
+#else
+  g_mutex_free(pool.mtx);
+  g_cond_free(pool.cond);
+#endif
+  g_free(pool.done);
+  return status;
 }
 
 static void
@@ -1076,6 +1477,9 @@ usage(gboolean is_error)
   fprintf(output, "  -h display this help and exit\n");
   fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
   fprintf(output, "  -A generate all infos (default)\n");
+  fprintf(output, "  -I write a capture index (<file>.pktidx) for faster opening\n");
+  fprintf(output, "  -P also display the time taken to process each file (in seconds)\n");
+  fprintf(output, "  -j <n> process <n> files at once (default is 1)\n");
   fprintf(output, "\n");
   fprintf(output, "Options are processed from left to right order with later options superceeding\n");
   fprintf(output, "or adding to earlier options.\n");
@@ -1100,42 +1504,28 @@ failure_message(const char *msg_format _U_, va_list ap _U_)
 }
 #endif
 
-#ifdef HAVE_LIBGCRYPT
-static void
-hash_to_str(const unsigned char *hash, size_t length, char *str) {
-  int i;
-
-  for (i = 0; i < (int) length; i++) {
-    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
-  }
-}
-#endif /* HAVE_LIBGCRYPT */
-
 int
 main(int argc, char *argv[])
 {
-  wtap  *wth;
-  int    err;
-  gchar *err_info;
   int    opt;
   int    overall_error_status;
+  char  *p;
+  file_result *results;
+  guint  nfiles, i;
 
-  int status = 0;
 #ifdef HAVE_PLUGINS
   char  *init_progfile_dir_error;
 #endif
-#ifdef HAVE_LIBGCRYPT
-  FILE  *fh;
-  char  *hash_buf = NULL;
-  gcry_md_hd_t hd = NULL;
-  size_t hash_bytes;
-#endif
 
 #ifdef _WIN32
   arg_list_utf_16to8(argc, argv);
   create_app_running_mutex();
 #endif /* _WIN32 */
 
+#if !GLIB_CHECK_VERSION(2,31,0)
+  g_thread_init(NULL);
+#endif
+
   /*
    * Get credential information for later use.
    */
@@ -1206,7 +1596,7 @@ main(int argc, char *argv[])
   g_option_context_free(ctx);
 
 #endif /* USE_GOPTION */
-  while ((opt = getopt(argc, argv, "tEcs" FILE_HASH_OPT "dluaeyizvhxokCALTMRrSNqQBmb")) !=-1) {
+  while ((opt = getopt(argc, argv, "tEcs" FILE_HASH_OPT "dluaeyizvhxokCALTMRrSNqQBmbIPj:")) !=-1) {
 
     switch (opt) {
 
@@ -1304,6 +1694,23 @@ main(int argc, char *argv[])
         enable_all_infos();
         break;
 
+      case 'I':
+        save_capture_index = TRUE;
+        break;
+
+      case 'P':
+        cap_process_time = TRUE;
+        break;
+
+      case 'j':
+        process_threads = (guint)strtoul(optarg, &p, 10);
+        if (p == optarg || *p != '\0' || process_threads == 0) {
+          fprintf(stderr, "capinfos: \"%s\" isn't a valid number of files to process at once\n",
+              optarg);
+          exit(1);
+        }
+        break;
+
       case 'L':
         long_report = TRUE;
         break;
@@ -1374,70 +1781,36 @@ main(int argc, char *argv[])
 
 #ifdef HAVE_LIBGCRYPT
   if (cap_file_hashes) {
+#ifdef HASH_IN_THREADS
+#ifndef _WIN32
+    /* Must be done before anything else in libgcrypt */
+    gcry_control(GCRYCTL_SET_THREAD_CBS, &gcry_threads_pthread);
+#endif
+#else
+    /* This libgcrypt can't be used from more than one thread */
+    process_threads = 1;
+#endif
     gcry_check_version(NULL);
-    gcry_md_open(&hd, GCRY_MD_SHA1, 0);
-    if (hd) {
-      gcry_md_enable(hd, GCRY_MD_RMD160);
-      gcry_md_enable(hd, GCRY_MD_MD5);
-    }
-    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
   }
 #endif
 
-  overall_error_status = 0;
-
-  for (opt = optind; opt < argc; opt++) {
-
-#ifdef HAVE_LIBGCRYPT
-    g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_md5, "<unknown>", HASH_STR_SIZE);
-
-    if (cap_file_hashes) {
-      fh = ws_fopen(argv[opt], "rb");
-      if (fh && hd) {
-        while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-          gcry_md_write(hd, hash_buf, hash_bytes);
-        }
-        gcry_md_final(hd);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_MD5), HASH_SIZE_MD5, file_md5);
-      }
-      if (fh) fclose(fh);
-      if (hd) gcry_md_reset(hd);
-    }
-#endif /* HAVE_LIBGCRYPT */
-
-    wth = wtap_open_offline(argv[opt], &err, &err_info, FALSE);
-
-    if (!wth) {
-      fprintf(stderr, "capinfos: Can't open %s: %s\n", argv[opt],
-          wtap_strerror(err));
-      switch (err) {
+  nfiles = argc - optind;
+  results = g_new0(file_result, nfiles);
+  for (i = 0; i < nfiles; i++)
+    results[i].filename = argv[optind + i];
 
-        case WTAP_ERR_UNSUPPORTED:
-        case WTAP_ERR_UNSUPPORTED_ENCAP:
-        case WTAP_ERR_BAD_FILE:
-          fprintf(stderr, "(%s)\n", err_info);
-          g_free(err_info);
-          break;
-      }
-      overall_error_status = 1; /* remember that an error has occurred */
-      if(!continue_after_wtap_open_offline_failure)
-        exit(1); /* error status */
-    }
-
-    if(wth) {
-      if ((opt > optind) && (long_report))
-        printf("\n");
-      status = process_cap_file(wth, argv[opt]);
+  overall_error_status = 0;
 
-      wtap_close(wth);
-      if (status)
-        exit(status);
+  if (process_threads > 1 && nfiles > 1) {
+    overall_error_status = process_files_parallel(results, nfiles,
+        MIN(process_threads, nfiles));
+  } else {
+    for (i = 0; i < nfiles; i++) {
+      process_file(&results[i]);
+      overall_error_status |= report_file(&results[i], i == 0);
     }
   }
+  g_free(results);
 
   return overall_error_status;
 }
@@ -68,6 +68,71 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+/* The enabled filters of color_filter_list combined into one program (see
+ * dfilter_combine()), so that a packet is matched against all of them in
+ * one go and every field is only looked up once. It's built when a packet
+ * is first colorized after the list changed; color_program_filters maps
+ * the index of the matching filter back to the color filter. If any of the
+ * filters can't be compiled again, the filters are tried one by one. */
+static dfilter_t *color_program          = NULL;
+static GPtrArray *color_program_filters  = NULL;
+static gboolean   color_program_valid    = FALSE;
+
+/* Time spent in color_filters_colorize_packet() */
+static GTimer    *colorize_timer         = NULL;
+static guint      colorize_packets       = 0;
+static gdouble    colorize_seconds       = 0.0;
+
+/* Forget the combined program after the filter list has changed */
+static void
+color_filters_invalidate_program(void)
+{
+    if (color_program != NULL) {
+        dfilter_free(color_program);
+        color_program = NULL;
+    }
+    if (color_program_filters != NULL) {
+        g_ptr_array_free(color_program_filters, TRUE);
+        color_program_filters = NULL;
+    }
+    color_program_valid = FALSE;
+}
+
+static void
+color_filters_build_program(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+    GPtrArray      *compiled;
+    dfilter_t      *df;
+    guint           i;
+
+    color_program_valid = TRUE;
+
+    compiled = g_ptr_array_new();
+    color_program_filters = g_ptr_array_new();
+
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (colorf->disabled || colorf->c_colorfilter == NULL)
+            continue;
+        /* dfilter_combine() takes the program apart, compile another one */
+        if (!dfilter_compile(colorf->filter_text, &df) || df == NULL) {
+            for (i = 0; i < compiled->len; i++)
+                dfilter_free((dfilter_t *)g_ptr_array_index(compiled, i));
+            g_ptr_array_free(compiled, TRUE);
+            g_ptr_array_free(color_program_filters, TRUE);
+            color_program_filters = NULL;
+            return;
+        }
+        g_ptr_array_add(compiled, df);
+        g_ptr_array_add(color_program_filters, colorf);
+    }
+
+    color_program = dfilter_combine((dfilter_t **)compiled->pdata, compiled->len);
+    g_ptr_array_free(compiled, TRUE);
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -188,6 +253,7 @@ color_filters_set_tmp(guint8 filt_nr, gchar *filter, gboolean disabled)
                 colorf->filter_text = g_strdup(tmpfilter);
                 colorf->c_colorfilter = compiled_filter;
                 colorf->disabled = ((i!=filt_nr) ? TRUE : disabled);
+                color_filters_invalidate_program();
                 /* Remember that there are now temporary coloring filters set */
                 if( filter )
                     tmp_colors_set = TRUE;
@@ -288,6 +354,7 @@ void
 color_filters_init(void)
 {
     /* delete all currently existing filters */
+    color_filters_invalidate_program();
     color_filter_list_delete(&color_filter_list);
 
     /* start the list with the temporary colorizing rules */
@@ -302,6 +369,8 @@ color_filters_init(void)
 void
 color_filters_reload(void)
 {
+    color_filters_invalidate_program();
+
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
@@ -373,6 +442,8 @@ color_filter_validate_cb(gpointer filter_arg, gpointer unused _U_)
 void
 color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl)
 {
+    color_filters_invalidate_program();
+
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
@@ -429,7 +500,15 @@ prime_edt(gpointer data, gpointer user_data)
 void
 color_filters_prime_edt(epan_dissect_t *edt)
 {
-    if (color_filters_used())
+    if (!color_filters_used())
+        return;
+
+    if (!color_program_valid)
+        color_filters_build_program();
+
+    if (color_program != NULL)
+        epan_dissect_prime_dfilter(edt, color_program);
+    else
         g_slist_foreach(color_filter_list, prime_edt, edt);
 }
 
@@ -439,23 +518,66 @@ color_filters_colorize_packet(epan_dissect_t *edt)
 {
     GSList         *curr;
     color_filter_t *colorf;
+    color_filter_t *matched = NULL;
+    int             match;
 
     /* If we have color filters, "search" for the matching one. */
     if (color_filters_used()) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
+        if (colorize_timer == NULL)
+            colorize_timer = g_timer_new();
+        g_timer_start(colorize_timer);
+
+        if (!color_program_valid)
+            color_filters_build_program();
+
+        if (color_program != NULL) {
+            match = dfilter_apply_first_edt(color_program, edt);
+            if (match >= 0)
+                matched = (color_filter_t *)g_ptr_array_index(color_program_filters, match);
+        } else {
+            curr = color_filter_list;
+
+            while(curr != NULL) {
+                colorf = (color_filter_t *)curr->data;
+                if ( (!colorf->disabled) &&
+                     (colorf->c_colorfilter != NULL) &&
+                     dfilter_apply_edt(colorf->c_colorfilter, edt)) {
+                    matched = colorf;
+                    break;
+                }
+                curr = g_slist_next(curr);
             }
-            curr = g_slist_next(curr);
         }
+
+        colorize_seconds += g_timer_elapsed(colorize_timer, NULL);
+        colorize_packets++;
+    }
+
+    return matched;
+}
+
+void
+color_filters_get_stats(guint *packets, guint *rules, gdouble *seconds)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+
+    *packets = colorize_packets;
+    *seconds = colorize_seconds;
+
+    *rules = 0;
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (!colorf->disabled && colorf->c_colorfilter != NULL)
+            (*rules)++;
     }
+}
 
-    return NULL;
+void
+color_filters_reset_stats(void)
+{
+    colorize_packets = 0;
+    colorize_seconds = 0.0;
 }
 
 /* read filters from the given file */
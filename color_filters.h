@@ -108,6 +108,19 @@ void color_filters_prime_edt(epan_dissect_t *edt);
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt);
 
+/** Get the colorizing statistics since color_filters_reset_stats().
+ *
+ * @param packets set to the number of packets colorized
+ * @param rules set to the number of enabled color filters
+ * @param seconds set to the time spent matching them
+ */
+void color_filters_get_stats(guint *packets, guint *rules, gdouble *seconds);
+
+/** Reset the colorizing statistics, e.g. before recolorizing.
+ *
+ */
+void color_filters_reset_stats(void);
+
 /** Clone the currently active filter list.
  *
  * @param user_data will be returned by each call to to color_filter_add_cb()
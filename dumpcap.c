@@ -144,12 +144,19 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
-static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
+/*
+ * When using threads, the writer sleeps on this condition when every
+ * interface's ring is empty; capture threads only take the mutex to wake
+ * it up if pcap_writer_waiting says it's asleep.
+ */
+static GMutex *pcap_writer_mtx;
+static GCond *pcap_writer_cond;
+static volatile gint pcap_writer_waiting;
+static guint64 pcap_writer_blocked_usecs;   /* time the writer spent waiting for packets */
+
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 #ifdef _WIN32
 static gchar *sig_pipe_name = NULL;
@@ -238,6 +245,43 @@ typedef enum {
     PIPERR, 
     PIPNEXIST 
 } cap_pipe_err_t;
+
+/*
+ * Single-producer/single-consumer ring used, when using threads, to hand
+ * packets from an interface's capture thread to the writer.  Records
+ * (a pcap_ring_rec followed by the packet data) are laid out back to back
+ * in a slab allocated once per capture; a record that doesn't fit at the
+ * end of the slab goes at its start, with a wrap marker (a record with a
+ * length of 0) left behind if there's room for one.  The ring is empty if
+ * head == tail; the capture thread never lets head catch up with tail.
+ */
+typedef struct _pcap_ring_rec {
+    guint32                      len;                    /**< record size, including this header; 0 for a wrap marker */
+    guint32                      pad;
+    struct pcap_pkthdr           phdr;
+} pcap_ring_rec;
+
+#define PCAP_RING_ALIGN(n)          (((n) + 7) & ~7)
+#define PCAP_RING_REC_SIZE(caplen)  PCAP_RING_ALIGN((gint)sizeof(pcap_ring_rec) + (gint)(caplen))
+
+/* Number of packets the writer takes from a ring before moving on to the next one */
+#define PCAP_RING_BATCH 64
+
+/* Size of the ring of an interface if neither -C nor -N was given */
+#define PCAP_RING_DEFAULT_SIZE (16 * 1024 * 1024)
+
+typedef struct _pcap_ring {
+    guint8                      *slab;
+    gint                         size;                   /**< size of slab */
+    volatile gint                head;                   /**< next free byte; written by the capture thread */
+    volatile gint                tail;                   /**< next byte to dequeue; written by the writer */
+    volatile gint                packets;                /**< packets in the ring */
+    /* Statistics, only written by the capture thread */
+    gint                         peak_packets;           /**< highest number of packets queued */
+    gint                         peak_bytes;             /**< highest number of bytes queued */
+    guint32                      full_drops;             /**< packets dropped because the ring was full */
+} pcap_ring;
+
 typedef struct _pcap_options {
     guint32                      received;
     guint32                      dropped;
@@ -278,6 +322,7 @@ typedef struct _pcap_options {
     GMutex                      *cap_pipe_read_mtx;
     GAsyncQueue                 *cap_pipe_pending_q, *cap_pipe_done_q;
 #endif
+    pcap_ring                    ring;                   /**< packets queued for the writer, when using threads */
 } pcap_options;
 
 typedef struct _loop_data {
@@ -298,12 +343,6 @@ typedef struct _loop_data {
     guint32   autostop_files;
 } loop_data;
 
-typedef struct _pcap_queue_element {
-    pcap_options       *pcap_opts;
-    struct pcap_pkthdr  phdr;
-    u_char             *pd;
-} pcap_queue_element;
-
 /*
  * Standard secondary message for unexpected errors.
  */
@@ -375,6 +414,8 @@ static void WS_MSVC_NORETURN exit_main(int err) G_GNUC_NORETURN;
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, gchar *name);
+static void report_ring_stats(pcap_options *pcap_opts, gchar *name);
+static void report_writer_wait(void);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -500,8 +541,10 @@ print_usage(gboolean print_ver)
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "\n");
     fprintf(output, "Miscellaneous:\n");
-    fprintf(output, "  -N <packet_limit>        maximum number of packets buffered within dumpcap\n");
-    fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets within dumpcap\n");
+    fprintf(output, "  -N <packet_limit>        maximum number of packets buffered per interface\n");
+    fprintf(output, "                           within dumpcap\n");
+    fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
+    fprintf(output, "                           per interface within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v                       print version information and exit\n");
@@ -2582,6 +2625,7 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
 #endif
         pcap_opts->cap_pipe_bytes_to_read = 0;
         pcap_opts->cap_pipe_bytes_read = 0;
+        memset(&pcap_opts->ring, 0, sizeof(pcap_ring));
         pcap_opts->cap_pipe_state = STATE_EXPECT_REC_HDR;
         pcap_opts->cap_pipe_err = PIPOK;
 #ifdef _WIN32
@@ -2749,6 +2793,8 @@ static void capture_loop_close_input(loop_data *ld)
             pcap_close(pcap_opts->pcap_h);
             pcap_opts->pcap_h = NULL;
         }
+        g_free(pcap_opts->ring.slab);
+        pcap_opts->ring.slab = NULL;
     }
 
     ld->go = FALSE;
@@ -3384,6 +3430,166 @@ do_file_switch_or_stop(capture_options *capture_opts,
     return TRUE;
 }
 
+/*
+ * Allocate the ring of an interface.  It is sized by the byte limit or,
+ * if only a packet limit was given, to hold that many maximum-sized
+ * packets; with neither, it gets PCAP_RING_DEFAULT_SIZE bytes, so that
+ * the writer can stall for a while without packets being dropped.  It has
+ * to hold a few maximum-sized packets even if the byte limit is lower
+ * than that.
+ */
+static void
+pcap_ring_init(pcap_options *pcap_opts)
+{
+    pcap_ring *ring = &pcap_opts->ring;
+    gint64     size = pcap_queue_byte_limit;
+    gint       snaplen = pcap_opts->snaplen > 0 ? pcap_opts->snaplen : WTAP_MAX_PACKET_SIZE;
+
+    if (size == 0) {
+        if (pcap_queue_packet_limit > 0)
+            size = pcap_queue_packet_limit * PCAP_RING_REC_SIZE(snaplen);
+        else
+            size = PCAP_RING_DEFAULT_SIZE;
+    }
+    if (size < 4 * PCAP_RING_REC_SIZE(snaplen))
+        size = 4 * PCAP_RING_REC_SIZE(snaplen);
+    if (size > G_MAXINT / 2) {
+        size = G_MAXINT / 2;
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_WARNING,
+              "The queue of interface %u is limited to %d bytes.",
+              pcap_opts->interface_id, (gint)size);
+    }
+    ring->size = PCAP_RING_ALIGN((gint)size);
+    ring->slab = (guint8 *)g_malloc(ring->size);
+    ring->head = 0;
+    ring->tail = 0;
+    ring->packets = 0;
+    ring->peak_packets = 0;
+    ring->peak_bytes = 0;
+    ring->full_drops = 0;
+}
+
+/*
+ * Find room for a record of rec_size bytes, given the current head and
+ * tail.  Returns the offset at which to put it, or -1 if the ring is full.
+ */
+static gint
+pcap_ring_reserve(pcap_ring *ring, gint head, gint tail, gint rec_size)
+{
+    if (head >= tail) {
+        /* Free space is [head, size) and [0, tail). */
+        if (ring->size - head > rec_size ||
+            (ring->size - head == rec_size && tail != 0))
+            return head;
+        /* It doesn't fit at the end; put it at the start, if it fits there. */
+        if (rec_size >= tail)
+            return -1;
+        if (ring->size - head >= (gint)sizeof(pcap_ring_rec))
+            ((pcap_ring_rec *)(void *)(ring->slab + head))->len = 0;
+        return 0;
+    }
+    /* Free space is [head, tail). */
+    if (tail - head > rec_size)
+        return head;
+    return -1;
+}
+
+/*
+ * Write up to max_packets packets from an interface's ring to the
+ * capture file.  Returns the number of packets written.
+ */
+static int
+pcap_ring_drain(pcap_options *pcap_opts, int max_packets)
+{
+    pcap_ring     *ring = &pcap_opts->ring;
+    gint           head = g_atomic_int_get(&ring->head);
+    gint           tail = ring->tail;
+    pcap_ring_rec *rec;
+    int            count = 0;
+
+    while (tail != head && count < max_packets) {
+        rec = (pcap_ring_rec *)(void *)(ring->slab + tail);
+        if (ring->size - tail < (gint)sizeof(pcap_ring_rec) || rec->len == 0) {
+            /* The next record is at the start of the slab. */
+            tail = 0;
+            continue;
+        }
+        capture_loop_write_packet_cb((u_char *)pcap_opts, &rec->phdr,
+                                     (const u_char *)(rec + 1));
+        tail += rec->len;
+        if (tail == ring->size)
+            tail = 0;
+        count++;
+    }
+    if (tail != ring->tail) {
+        g_atomic_int_set(&ring->tail, tail);
+        g_atomic_int_add(&ring->packets, -count);
+    }
+    return count;
+}
+
+/*
+ * Write a batch of packets from each interface's ring, and return the
+ * number of packets written.
+ */
+static int
+pcap_rings_drain(int max_packets_per_ring)
+{
+    guint i;
+    int   count = 0;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        count += pcap_ring_drain(g_array_index(global_ld.pcaps, pcap_options *, i),
+                                 max_packets_per_ring);
+    }
+    return count;
+}
+
+static gboolean
+pcap_rings_empty(void)
+{
+    guint         i;
+    pcap_options *pcap_opts;
+
+    for (i = 0; i < global_ld.pcaps->len; i++) {
+        pcap_opts = g_array_index(global_ld.pcaps, pcap_options *, i);
+        if (g_atomic_int_get(&pcap_opts->ring.head) != pcap_opts->ring.tail)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * Wait, for at most WRITER_THREAD_TIMEOUT, for a capture thread to queue
+ * a packet.
+ */
+static void
+pcap_writer_wait(void)
+{
+    guint64 wait_start = create_timestamp();
+#if !GLIB_CHECK_VERSION(2,31,18)
+    GTimeVal wait_end;
+
+    g_get_current_time(&wait_end);
+    g_time_val_add(&wait_end, WRITER_THREAD_TIMEOUT);
+#endif
+
+    g_mutex_lock(pcap_writer_mtx);
+    g_atomic_int_set(&pcap_writer_waiting, 1);
+    /* Check again, now that the capture threads know to wake us up. */
+    if (global_ld.go && pcap_rings_empty()) {
+#if GLIB_CHECK_VERSION(2,31,18)
+        g_cond_wait_until(pcap_writer_cond, pcap_writer_mtx,
+                          g_get_monotonic_time() + WRITER_THREAD_TIMEOUT);
+#else
+        g_cond_timed_wait(pcap_writer_cond, pcap_writer_mtx, &wait_end);
+#endif
+    }
+    g_atomic_int_set(&pcap_writer_waiting, 0);
+    g_mutex_unlock(pcap_writer_mtx);
+    pcap_writer_blocked_usecs += create_timestamp() - wait_start;
+}
+
 static void *
 pcap_read_handler(void* arg)
 {
@@ -3557,9 +3763,21 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
-        pcap_queue_bytes = 0;
-        pcap_queue_packets = 0;
+#if GLIB_CHECK_VERSION(2,31,0)
+        pcap_writer_mtx = g_new(GMutex, 1);
+        g_mutex_init(pcap_writer_mtx);
+        pcap_writer_cond = g_new(GCond, 1);
+        g_cond_init(pcap_writer_cond);
+#else
+        pcap_writer_mtx = g_mutex_new();
+        pcap_writer_cond = g_cond_new();
+#endif
+        pcap_writer_waiting = 0;
+        pcap_writer_blocked_usecs = 0;
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_opts = g_array_index(global_ld.pcaps, pcap_options *, i);
+            pcap_ring_init(pcap_opts);
+        }
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_opts = g_array_index(global_ld.pcaps, pcap_options *, i);
 #if GLIB_CHECK_VERSION(2,31,0)
@@ -3573,37 +3791,9 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            pcap_queue_element *queue_element;
-#if GLIB_CHECK_VERSION(2,31,18)
-
-            g_async_queue_lock(pcap_queue);
-            queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-#else
-            GTimeVal write_thread_time;
-
-            g_get_current_time(&write_thread_time);
-            g_time_val_add(&write_thread_time, WRITER_THREAD_TIMEOUT);
-            g_async_queue_lock(pcap_queue);
-            queue_element = (pcap_queue_element *)g_async_queue_timed_pop_unlocked(pcap_queue, &write_thread_time);
-#endif
-            if (queue_element) {
-                pcap_queue_bytes -= queue_element->phdr.caplen;
-                pcap_queue_packets -= 1;
-            }
-            g_async_queue_unlock(pcap_queue);
-            if (queue_element) {
-                g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                      "Dequeued a packet of length %d captured on interface %d.",
-                      queue_element->phdr.caplen, queue_element->pcap_opts->interface_id);
-
-                capture_loop_write_packet_cb((u_char *) queue_element->pcap_opts,
-                                             &queue_element->phdr,
-                                             queue_element->pd);
-                g_free(queue_element->pd);
-                g_free(queue_element);
-                inpkts = 1;
-            } else {
-                inpkts = 0;
+            inpkts = pcap_rings_drain(PCAP_RING_BATCH);
+            if (inpkts == 0) {
+                pcap_writer_wait();
             }
         } else {
             pcap_opts = g_array_index(global_ld.pcaps, pcap_options *, 0);
@@ -3696,7 +3886,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Capture loop stopping ...");
     if (use_threads) {
-        pcap_queue_element *queue_element;
+        int flushed_pkts;
 
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_opts = g_array_index(global_ld.pcaps, pcap_options *, i);
@@ -3706,30 +3896,24 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Thread of interface %u terminated.",
                   pcap_opts->interface_id);
         }
-        while (1) {
-            g_async_queue_lock(pcap_queue);
-            queue_element = (pcap_queue_element *)g_async_queue_try_pop_unlocked(pcap_queue);
-            if (queue_element) {
-                pcap_queue_bytes -= queue_element->phdr.caplen;
-                pcap_queue_packets -= 1;
-            }
-            g_async_queue_unlock(pcap_queue);
-            if (queue_element == NULL) {
-                break;
-            }
-            g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-                  "Dequeued a packet of length %d captured on interface %d.",
-                  queue_element->phdr.caplen, queue_element->pcap_opts->interface_id);
-            capture_loop_write_packet_cb((u_char *)queue_element->pcap_opts,
-                                         &queue_element->phdr,
-                                         queue_element->pd);
-            g_free(queue_element->pd);
-            g_free(queue_element);
-            global_ld.inpkts_to_sync_pipe += 1;
+        /* The capture threads are gone; write whatever they left behind. */
+        while ((flushed_pkts = pcap_rings_drain(G_MAXINT)) > 0) {
+            global_ld.inpkts_to_sync_pipe += flushed_pkts;
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
             }
         }
+#if GLIB_CHECK_VERSION(2,31,0)
+        g_mutex_clear(pcap_writer_mtx);
+        g_free(pcap_writer_mtx);
+        g_cond_clear(pcap_writer_cond);
+        g_free(pcap_writer_cond);
+#else
+        g_mutex_free(pcap_writer_mtx);
+        g_cond_free(pcap_writer_cond);
+#endif
+        pcap_writer_mtx = NULL;
+        pcap_writer_cond = NULL;
     }
 
 
@@ -3848,6 +4032,12 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             }
         }
         report_packet_drops(received, pcap_dropped, pcap_opts->dropped, pcap_opts->flushed, interface_opts.console_display_name);
+        if (use_threads) {
+            report_ring_stats(pcap_opts, interface_opts.console_display_name);
+        }
+    }
+    if (use_threads) {
+        report_writer_wait();
     }
 
     /* close the input file (pcap or capture pipe) */
@@ -4015,9 +4205,11 @@ static void
 capture_loop_queue_packet_cb(u_char *pcap_opts_p, const struct pcap_pkthdr *phdr,
                              const u_char *pd)
 {
-    pcap_options       *pcap_opts = (pcap_options *) (void *) pcap_opts_p;
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    pcap_options  *pcap_opts = (pcap_options *) (void *) pcap_opts_p;
+    pcap_ring     *ring      = &pcap_opts->ring;
+    pcap_ring_rec *rec;
+    gint           rec_size  = PCAP_RING_REC_SIZE(phdr->caplen);
+    gint           head, tail, offset, packets, bytes;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4027,49 +4219,56 @@ capture_loop_queue_packet_cb(u_char *pcap_opts_p, const struct pcap_pkthdr *phdr
         return;
     }
 
-    queue_element = (pcap_queue_element *)g_malloc(sizeof(pcap_queue_element));
-    if (queue_element == NULL) {
-       pcap_opts->dropped++;
-       return;
-    }
-    queue_element->pcap_opts = pcap_opts;
-    queue_element->phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_opts->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
+    /* Read the packet count before the tail, so that a packet the writer
+       is dequeueing can't be counted as free space and as queued. */
+    packets = g_atomic_int_get(&ring->packets);
+    tail = g_atomic_int_get(&ring->tail);
+    head = ring->head;
+    if ((pcap_queue_packet_limit > 0) && (packets >= pcap_queue_packet_limit)) {
+        offset = -1;
     } else {
-        limit_reached = TRUE;
+        offset = pcap_ring_reserve(ring, head, tail, rec_size);
     }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
+    if (offset < 0) {
         pcap_opts->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
+        ring->full_drops++;
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_opts->interface_id);
-    } else {
-        pcap_opts->received++;
-        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-              "Queued a packet of length %d captured on interface %u.",
-              phdr->caplen, pcap_opts->interface_id);
+        return;
     }
-    /* I don't want to hold the mutex over the debug output. So the
-       output may be wrong */
+
+    rec = (pcap_ring_rec *)(void *)(ring->slab + offset);
+    rec->len = rec_size;
+    rec->phdr = *phdr;
+    memcpy(rec + 1, pd, phdr->caplen);
+    head = offset + rec_size;
+    if (head == ring->size)
+        head = 0;
+    /* Count the packet before publishing it, so the count can't go negative. */
+    g_atomic_int_inc(&ring->packets);
+    g_atomic_int_set(&ring->head, head);
+    pcap_opts->received++;
+
+    /* Keep track of how full the ring gets, so it can be sized. */
+    if (packets + 1 > ring->peak_packets)
+        ring->peak_packets = packets + 1;
+    bytes = head - tail;
+    if (bytes < 0)
+        bytes += ring->size;
+    if (bytes > ring->peak_bytes)
+        ring->peak_bytes = bytes;
+
     g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
-          "Queue size is now %" G_GINT64_MODIFIER "d bytes (%" G_GINT64_MODIFIER "d packets)",
-          pcap_queue_bytes, pcap_queue_packets);
+          "Queued a packet of length %d captured on interface %u.",
+          phdr->caplen, pcap_opts->interface_id);
+
+    /* Wake up the writer if it's waiting for packets. */
+    if (g_atomic_int_get(&pcap_writer_waiting)) {
+        g_mutex_lock(pcap_writer_mtx);
+        g_cond_signal(pcap_writer_cond);
+        g_mutex_unlock(pcap_writer_mtx);
+    }
 }
 
 static int
@@ -4607,12 +4806,7 @@ main(int argc, char *argv[])
     if ((pcap_queue_byte_limit > 0) || (pcap_queue_packet_limit > 0)) {
         use_threads = TRUE;
     }
-    if ((pcap_queue_byte_limit == 0) && (pcap_queue_packet_limit == 0)) {
-        /* Use some default if the user hasn't specified some */
-        /* XXX: Are these defaults good enough? */
-        pcap_queue_byte_limit = 1000 * 1000;
-        pcap_queue_packet_limit = 1000;
-    }
+    /* If neither limit was given, pcap_ring_init() uses PCAP_RING_DEFAULT_SIZE */
     if (arg_error) {
         print_usage(FALSE);
         exit_main(1);
@@ -5042,6 +5236,50 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+/*
+ * Report how full an interface's ring got, so that -C and -N can be sized.
+ */
+static void
+report_ring_stats(pcap_options *pcap_opts, gchar *name)
+{
+    pcap_ring *ring = &pcap_opts->ring;
+
+    if (capture_child || quiet) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Ring buffer on interface %s: peak %d packets/%d of %d bytes, %u dropped when full",
+            name, ring->peak_packets, ring->peak_bytes, ring->size,
+            ring->full_drops);
+    } else {
+        fprintf(stderr,
+            "Ring buffer on interface '%s': peak %d packets/%d of %d bytes (%.1f%%), %u dropped when full\n",
+            name, ring->peak_packets, ring->peak_bytes, ring->size,
+            ring->size ? 100.0 * ring->peak_bytes / ring->size : 0.0,
+            ring->full_drops);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
+/*
+ * Report how long the writer, which serves all the rings, spent waiting
+ * for packets.
+ */
+static void
+report_writer_wait(void)
+{
+    if (capture_child || quiet) {
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+            "Writer waited %" G_GINT64_MODIFIER "u ms for packets",
+            pcap_writer_blocked_usecs / 1000);
+    } else {
+        fprintf(stderr,
+            "Writer waited %" G_GINT64_MODIFIER "u ms for packets\n",
+            pcap_writer_blocked_usecs / 1000);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
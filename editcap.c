@@ -111,20 +111,44 @@ struct select_item {
 
 /*
  * Duplicate frame detection
+ *
+ * The digests of the last dup_window packets are kept in the fd_hash[]
+ * ring, in arrival order.  Every digest in the ring is also counted in
+ * fd_hash_set, an open-addressing hash table, so checking whether a
+ * packet has a duplicate in the window doesn't depend on the window
+ * size.
  */
 typedef struct _fd_hash_t {
   md5_byte_t digest[16];
   guint32 len;
   nstime_t time;
+  gboolean in_set;      /* counted in fd_hash_set */
 } fd_hash_t;
 
+typedef struct _fd_hash_set_slot_t {
+  md5_byte_t digest[16];
+  guint32 len;
+  guint32 count;        /* occurrences in the window; 0 if the slot is free */
+} fd_hash_set_slot_t;
+
+typedef enum {
+  DUP_DIGEST_MD5,
+  DUP_DIGEST_MURMUR3
+} dup_digest_e;
+
 #define DEFAULT_DUP_DEPTH 5     /* Used with -d */
-#define MAX_DUP_DEPTH 1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
+#define MAX_DUP_DEPTH 1000000   /* the maximum window (and size of fd_hash[] with -w) for de-duplication */
 
-fd_hash_t fd_hash[MAX_DUP_DEPTH];
+fd_hash_t *fd_hash = NULL;
 int dup_window = DEFAULT_DUP_DEPTH;
 int cur_dup_entry = 0;
 
+static fd_hash_set_slot_t *fd_hash_set = NULL;
+static guint32 fd_hash_set_mask = 0;
+
+static dup_digest_e dup_digest = DUP_DIGEST_MD5;
+static gboolean dup_ignore_volatile = FALSE;
+
 #define ONE_MILLION 1000000
 #define ONE_BILLION 1000000000
 
@@ -546,54 +570,339 @@ set_rel_time(char *optarg_str_p)
   relative_time_window.nsecs = (int)val;
 }
 
-static gboolean
-is_duplicate(guint8* fd, guint32 len) {
-  int i;
-  md5_state_t ms;
+/*
+ * 128-bit MurmurHash3 (x64 variant) by Austin Appleby, who placed it in
+ * the public domain.  It's much cheaper than MD5 and good enough to tell
+ * packets apart when we don't need a cryptographic digest.
+ */
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
 
-  cur_dup_entry++;
-  if (cur_dup_entry >= dup_window)
-    cur_dup_entry = 0;
+static guint64
+murmur3_fmix64(guint64 k)
+{
+  k ^= k >> 33;
+  k *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+  k ^= k >> 33;
+  k *= G_GUINT64_CONSTANT(0xc4ceb9fe1a85ec53);
+  k ^= k >> 33;
+  return k;
+}
 
-  /* Calculate our digest */
-  md5_init(&ms);
-  md5_append(&ms, fd, len);
-  md5_finish(&ms, fd_hash[cur_dup_entry].digest);
+static void
+murmur3_128(const guint8 *data, guint32 len, md5_byte_t digest[16])
+{
+  const guint64 c1 = G_GUINT64_CONSTANT(0x87c37b91114253d5);
+  const guint64 c2 = G_GUINT64_CONSTANT(0x4cf5ad432745937f);
+  guint64 h1 = 0, h2 = 0, k1, k2;
+  const guint8 *tail;
+  guint32 nblocks = len / 16;
+  guint32 i;
+
+  for (i = 0; i < nblocks; i++) {
+    memcpy(&k1, data + i * 16, 8);
+    memcpy(&k2, data + i * 16 + 8, 8);
+    k1 = GUINT64_FROM_LE(k1);
+    k2 = GUINT64_FROM_LE(k2);
+
+    k1 *= c1; k1 = ROTL64(k1, 31); k1 *= c2; h1 ^= k1;
+    h1 = ROTL64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+    k2 *= c2; k2 = ROTL64(k2, 33); k2 *= c1; h2 ^= k2;
+    h2 = ROTL64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+  }
 
-  fd_hash[cur_dup_entry].len = len;
+  tail = data + nblocks * 16;
+  k1 = 0;
+  k2 = 0;
+  switch (len & 15) {
+  case 15: k2 ^= ((guint64)tail[14]) << 48; /* FALLTHROUGH */
+  case 14: k2 ^= ((guint64)tail[13]) << 40; /* FALLTHROUGH */
+  case 13: k2 ^= ((guint64)tail[12]) << 32; /* FALLTHROUGH */
+  case 12: k2 ^= ((guint64)tail[11]) << 24; /* FALLTHROUGH */
+  case 11: k2 ^= ((guint64)tail[10]) << 16; /* FALLTHROUGH */
+  case 10: k2 ^= ((guint64)tail[ 9]) << 8;  /* FALLTHROUGH */
+  case  9: k2 ^= ((guint64)tail[ 8]);
+           k2 *= c2; k2 = ROTL64(k2, 33); k2 *= c1; h2 ^= k2;
+           /* FALLTHROUGH */
+  case  8: k1 ^= ((guint64)tail[ 7]) << 56; /* FALLTHROUGH */
+  case  7: k1 ^= ((guint64)tail[ 6]) << 48; /* FALLTHROUGH */
+  case  6: k1 ^= ((guint64)tail[ 5]) << 40; /* FALLTHROUGH */
+  case  5: k1 ^= ((guint64)tail[ 4]) << 32; /* FALLTHROUGH */
+  case  4: k1 ^= ((guint64)tail[ 3]) << 24; /* FALLTHROUGH */
+  case  3: k1 ^= ((guint64)tail[ 2]) << 16; /* FALLTHROUGH */
+  case  2: k1 ^= ((guint64)tail[ 1]) << 8;  /* FALLTHROUGH */
+  case  1: k1 ^= ((guint64)tail[ 0]);
+           k1 *= c1; k1 = ROTL64(k1, 31); k1 *= c2; h1 ^= k1;
+  }
 
-  /* Look for duplicates */
-  for (i = 0; i < dup_window; i++) {
-    if (i == cur_dup_entry)
-      continue;
+  h1 ^= len;
+  h2 ^= len;
+  h1 += h2;
+  h2 += h1;
+  h1 = murmur3_fmix64(h1);
+  h2 = murmur3_fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+
+  h1 = GUINT64_TO_BE(h1);
+  h2 = GUINT64_TO_BE(h2);
+  memcpy(digest, &h1, 8);
+  memcpy(digest + 8, &h2, 8);
+}
 
-    if (fd_hash[i].len == fd_hash[cur_dup_entry].len &&
-        memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-      return TRUE;
+/*
+ * Copy a packet into a scratch buffer with the bytes that legitimately
+ * differ between copies of a packet seen at different mirror points
+ * removed or zeroed: 802.1Q/802.1ad tags, the IPv4 TTL and header
+ * checksum and the IPv6 hop limit.  Only Ethernet and raw IP are
+ * understood; anything else is returned unchanged.
+ */
+static guint8 *
+mask_volatile_bytes(guint8 *fd, guint32 *lenp, int encap)
+{
+  static guint8 *scratch = NULL;
+  static guint32 scratch_size = 0;
+  guint32 len = *lenp;
+  guint32 off = 0;
+  guint16 ethertype;
+
+  if (len > scratch_size) {
+    scratch_size = len;
+    scratch = (guint8 *)g_realloc(scratch, scratch_size);
+  }
+  memcpy(scratch, fd, len);
+
+  switch (encap) {
+
+  case WTAP_ENCAP_ETHERNET:
+    if (len < 14)
+      return scratch;
+    off = 12;
+    ethertype = (scratch[off] << 8) | scratch[off + 1];
+    while ((ethertype == 0x8100 || ethertype == 0x88a8 || ethertype == 0x9100) &&
+           len - off >= 8) {
+      /* Drop the tag, keeping the destination and source addresses. */
+      memmove(scratch + off, scratch + off + 4, len - off - 4);
+      len -= 4;
+      ethertype = (scratch[off] << 8) | scratch[off + 1];
+    }
+    off += 2;
+    if (ethertype != 0x0800 && ethertype != 0x86dd) {
+      *lenp = len;
+      return scratch;
     }
+    break;
+
+  case WTAP_ENCAP_RAW_IP:
+    break;
+
+  default:
+    return scratch;
   }
 
-  return FALSE;
+  if (len - off >= 20 && (scratch[off] >> 4) == 4) {
+    scratch[off + 8] = 0;       /* TTL */
+    scratch[off + 10] = 0;      /* header checksum */
+    scratch[off + 11] = 0;
+  } else if (len - off >= 40 && (scratch[off] >> 4) == 6) {
+    scratch[off + 7] = 0;       /* hop limit */
+  }
+  *lenp = len;
+  return scratch;
 }
 
-static gboolean
-is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
-  int i;
+/*
+ * Compute the digest of a packet into the current fd_hash[] entry, along
+ * with the length of what was digested: with -M, a tagged and an untagged
+ * copy of a packet only compare equal once the tags are gone.
+ */
+static void
+compute_digest(guint8* fd, guint32 len, int encap)
+{
   md5_state_t ms;
 
+  if (dup_ignore_volatile)
+    fd = mask_volatile_bytes(fd, &len, encap);
+
+  switch (dup_digest) {
+
+  case DUP_DIGEST_MD5:
+    md5_init(&ms);
+    md5_append(&ms, fd, len);
+    md5_finish(&ms, fd_hash[cur_dup_entry].digest);
+    break;
+
+  case DUP_DIGEST_MURMUR3:
+    murmur3_128(fd, len, fd_hash[cur_dup_entry].digest);
+    break;
+  }
+  fd_hash[cur_dup_entry].len = len;
+}
+
+static const char *
+dup_digest_name(void)
+{
+  return dup_digest == DUP_DIGEST_MD5 ? "MD5" : "MurmurHash3";
+}
+
+/*
+ * Allocate the fd_hash[] ring and the hash table indexing it.  The table
+ * has at least twice as many slots as the ring, so probe sequences stay
+ * short.
+ */
+static void
+dup_init(void)
+{
+  int i, ring_size = MAX(dup_window, 1);
+  guint32 set_size = 16;
+
+  fd_hash = g_new(fd_hash_t, ring_size);
+  for (i = 0; i < ring_size; i++) {
+    memset(&fd_hash[i].digest, 0, 16);
+    fd_hash[i].len = 0;
+    nstime_set_unset(&fd_hash[i].time);
+    fd_hash[i].in_set = FALSE;
+  }
+
+  while (set_size < 2 * (guint32)ring_size)
+    set_size <<= 1;
+  fd_hash_set = g_new0(fd_hash_set_slot_t, set_size);
+  fd_hash_set_mask = set_size - 1;
+}
+
+static guint32
+fd_hash_set_hash(const fd_hash_t *entry)
+{
+  guint32 h;
+
+  /* The digest is already well mixed; any four bytes of it will do. */
+  memcpy(&h, entry->digest, sizeof h);
+  return (h ^ entry->len) & fd_hash_set_mask;
+}
+
+static fd_hash_set_slot_t *
+fd_hash_set_find(const fd_hash_t *entry)
+{
+  guint32 i = fd_hash_set_hash(entry);
+
+  while (fd_hash_set[i].count != 0) {
+    if (fd_hash_set[i].len == entry->len &&
+        memcmp(fd_hash_set[i].digest, entry->digest, 16) == 0)
+      return &fd_hash_set[i];
+    i = (i + 1) & fd_hash_set_mask;
+  }
+  return NULL;
+}
+
+static void
+fd_hash_set_add(const fd_hash_t *entry)
+{
+  guint32 i = fd_hash_set_hash(entry);
+
+  while (fd_hash_set[i].count != 0) {
+    if (fd_hash_set[i].len == entry->len &&
+        memcmp(fd_hash_set[i].digest, entry->digest, 16) == 0) {
+      fd_hash_set[i].count++;
+      return;
+    }
+    i = (i + 1) & fd_hash_set_mask;
+  }
+  memcpy(fd_hash_set[i].digest, entry->digest, 16);
+  fd_hash_set[i].len = entry->len;
+  fd_hash_set[i].count = 1;
+}
+
+/*
+ * Drop one occurrence of a digest.  When the last one goes, the slot is
+ * freed by shifting back any later entries of its probe sequence, so no
+ * tombstones are needed (linear probing deletion, Knuth 6.4 algorithm R).
+ */
+static void
+fd_hash_set_remove(const fd_hash_t *entry)
+{
+  fd_hash_set_slot_t *slot = fd_hash_set_find(entry);
+  guint32 i, j, k;
+
+  if (slot == NULL || --slot->count != 0)
+    return;
+
+  i = (guint32)(slot - fd_hash_set);
+  j = i;
+  for (;;) {
+    j = (j + 1) & fd_hash_set_mask;
+    if (fd_hash_set[j].count == 0)
+      break;
+    memcpy(&k, fd_hash_set[j].digest, sizeof k);
+    k = (k ^ fd_hash_set[j].len) & fd_hash_set_mask;
+    /* Move j into the hole at i unless its home slot k lies cyclically in (i, j]. */
+    if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+    fd_hash_set[i] = fd_hash_set[j];
+    i = j;
+  }
+  fd_hash_set[i].count = 0;
+}
+
+/*
+ * Advance to the next fd_hash[] entry, evicting the oldest packet from
+ * the window, and compute the digest of the current packet into it.
+ */
+static void
+dup_advance(guint8* fd, guint32 len, int encap)
+{
   cur_dup_entry++;
-  if (cur_dup_entry >= dup_window)
+  if (cur_dup_entry >= MAX(dup_window, 1))
     cur_dup_entry = 0;
 
-  /* Calculate our digest */
-  md5_init(&ms);
-  md5_append(&ms, fd, len);
-  md5_finish(&ms, fd_hash[cur_dup_entry].digest);
+  if (fd_hash[cur_dup_entry].in_set) {
+    fd_hash_set_remove(&fd_hash[cur_dup_entry]);
+    fd_hash[cur_dup_entry].in_set = FALSE;
+  }
 
-  fd_hash[cur_dup_entry].len = len;
+  compute_digest(fd, len, encap);
+}
+
+static void
+dup_add_current(void)
+{
+  fd_hash_set_add(&fd_hash[cur_dup_entry]);
+  fd_hash[cur_dup_entry].in_set = TRUE;
+}
+
+static gboolean
+is_duplicate(guint8* fd, guint32 len, int encap) {
+  gboolean dup;
+
+  dup_advance(fd, len, encap);
+
+  /* Look for duplicates */
+  dup = fd_hash_set_find(&fd_hash[cur_dup_entry]) != NULL;
+
+  /* With a window of 0 nothing is remembered. */
+  if (dup_window > 0)
+    dup_add_current();
+
+  return dup;
+}
+
+static gboolean
+is_duplicate_rel_time(guint8* fd, guint32 len, int encap, const nstime_t *current) {
+  int i;
+  gboolean seen;
+
+  dup_advance(fd, len, encap);
   fd_hash[cur_dup_entry].time.secs = current->secs;
   fd_hash[cur_dup_entry].time.nsecs = current->nsecs;
 
+  seen = fd_hash_set_find(&fd_hash[cur_dup_entry]) != NULL;
+  dup_add_current();
+  if (!seen) {
+    /*
+     * No packet with this digest anywhere in fd_hash[], so there's
+     * nothing to scan for; this is the common case.
+     */
+    return FALSE;
+  }
+
   /*
    * Look for relative time related duplicates.
    * This is hopefully a reasonably efficient mechanism for
@@ -610,9 +919,9 @@ is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
    * always the case!!).
    *
    * The fd_hash[] table was deliberatly created large (1,000,000).
-   * Looking for time related duplicates in large trace files with
-   * non-fractional dup time window values can potentially take
-   * a long time to complete.
+   * We only get here if fd_hash_set says there is a packet with the
+   * same digest somewhere in the table, so the scan is only done for
+   * packets that are likely to be duplicates.
    */
 
   for (i = cur_dup_entry - 1;; i--) {
@@ -722,6 +1031,13 @@ usage(gboolean is_error)
   fprintf(output, "                         LESS THAN <dup time window> prior to current packet.\n");
   fprintf(output, "                         A <dup time window> is specified in relative seconds\n");
   fprintf(output, "                         (e.g. 0.000001).\n");
+  fprintf(output, "  -H <digest>            digest used to compare packets with -d, -D or -w:\n");
+  fprintf(output, "                         md5 (the default) or murmur3, a much faster\n");
+  fprintf(output, "                         non-cryptographic 128-bit hash.\n");
+  fprintf(output, "  -M                     ignore VLAN tags, the IPv4 TTL and header checksum and\n");
+  fprintf(output, "                         the IPv6 hop limit when comparing Ethernet and raw IP\n");
+  fprintf(output, "                         packets, so duplicates captured at different mirror\n");
+  fprintf(output, "                         points are detected.\n");
   fprintf(output, "\n");
   fprintf(output, "           NOTE: The use of the 'Duplicate packet removal' options with\n");
   fprintf(output, "           other editcap options except -v may not always work as expected.\n");
@@ -764,7 +1080,7 @@ usage(gboolean is_error)
   fprintf(output, "  -v                     verbose output.\n");
   fprintf(output, "                         If -v is used with any of the 'Duplicate Packet\n");
   fprintf(output, "                         Removal' options (-d, -D or -w) then Packet lengths\n");
-  fprintf(output, "                         and MD5 hashes are printed to standard-out.\n");
+  fprintf(output, "                         and digests are printed to standard-out.\n");
   fprintf(output, "\n");
 }
 
@@ -900,7 +1216,7 @@ main(int argc, char *argv[])
 #endif
 
   /* Process the options */
-  while ((opt = getopt(argc, argv, "A:B:c:C:dD:E:F:hrs:i:t:S:T:vw:")) !=-1) {
+  while ((opt = getopt(argc, argv, "A:B:c:C:dD:E:F:hH:Mrs:i:t:S:T:vw:")) !=-1) {
 
     switch (opt) {
 
@@ -969,6 +1285,22 @@ main(int argc, char *argv[])
       }
       break;
 
+    case 'H':
+      if (strcmp(optarg, "md5") == 0) {
+        dup_digest = DUP_DIGEST_MD5;
+      } else if (strcmp(optarg, "murmur3") == 0) {
+        dup_digest = DUP_DIGEST_MURMUR3;
+      } else {
+        fprintf(stderr, "editcap: \"%s\" isn't a valid digest; use md5 or murmur3\n",
+            optarg);
+        exit(1);
+      }
+      break;
+
+    case 'M':
+      dup_ignore_volatile = TRUE;
+      break;
+
     case 'w':
       dup_detect = FALSE;
       dup_detect_by_time = TRUE;
@@ -1151,13 +1483,8 @@ main(int argc, char *argv[])
       if (add_selection(argv[i]) == FALSE)
         break;
 
-    if (dup_detect || dup_detect_by_time) {
-      for (i = 0; i < dup_window; i++) {
-        memset(&fd_hash[i].digest, 0, 16);
-        fd_hash[i].len = 0;
-        nstime_set_unset(&fd_hash[i].time);
-      }
-    }
+    if (dup_detect || dup_detect_by_time)
+      dup_init();
 
     while (wtap_read(wth, &err, &err_info, &data_offset)) {
       read_count++;
@@ -1388,9 +1715,9 @@ main(int argc, char *argv[])
 
         /* suppress duplicates by packet window */
         if (dup_detect) {
-          if (is_duplicate(buf, phdr->caplen)) {
+          if (is_duplicate(buf, phdr->caplen, phdr->pkt_encap)) {
             if (verbose) {
-              fprintf(stdout, "Skipped: %u, Len: %u, MD5 Hash: ", count, phdr->caplen);
+              fprintf(stdout, "Skipped: %u, Len: %u, %s Hash: ", count, phdr->caplen, dup_digest_name());
               for (i = 0; i < 16; i++) {
                 fprintf(stdout, "%02x", (unsigned char)fd_hash[cur_dup_entry].digest[i]);
               }
@@ -1401,7 +1728,7 @@ main(int argc, char *argv[])
             continue;
           } else {
             if (verbose) {
-              fprintf(stdout, "Packet: %u, Len: %u, MD5 Hash: ", count, phdr->caplen);
+              fprintf(stdout, "Packet: %u, Len: %u, %s Hash: ", count, phdr->caplen, dup_digest_name());
               for (i = 0; i < 16; i++) {
                 fprintf(stdout, "%02x", (unsigned char)fd_hash[cur_dup_entry].digest[i]);
               }
@@ -1417,9 +1744,9 @@ main(int argc, char *argv[])
           current.secs = phdr->ts.secs;
           current.nsecs = phdr->ts.nsecs;
 
-          if (is_duplicate_rel_time(buf, phdr->caplen, &current)) {
+          if (is_duplicate_rel_time(buf, phdr->caplen, phdr->pkt_encap, &current)) {
             if (verbose) {
-              fprintf(stdout, "Skipped: %u, Len: %u, MD5 Hash: ", count, phdr->caplen);
+              fprintf(stdout, "Skipped: %u, Len: %u, %s Hash: ", count, phdr->caplen, dup_digest_name());
               for (i = 0; i < 16; i++) {
                 fprintf(stdout, "%02x", (unsigned char)fd_hash[cur_dup_entry].digest[i]);
               }
@@ -1430,7 +1757,7 @@ main(int argc, char *argv[])
             continue;
           } else {
             if (verbose) {
-              fprintf(stdout, "Packet: %u, Len: %u, MD5 Hash: ", count, phdr->caplen);
+              fprintf(stdout, "Packet: %u, Len: %u, %s Hash: ", count, phdr->caplen, dup_digest_name());
               for (i = 0; i < 16; i++) {
                 fprintf(stdout, "%02x", (unsigned char)fd_hash[cur_dup_entry].digest[i]);
               }
@@ -302,6 +302,23 @@ col_custom_prime_edt(epan_dissect_t *edt, column_info *cinfo)
   }
 }
 
+void
+col_custom_prime_interest(column_info *cinfo, proto_interest_t *interest)
+{
+  int i;
+
+  if(!HAVE_CUSTOM_COLS(cinfo))
+      return;
+
+  for (i = cinfo->col_first[COL_CUSTOM];
+       i <= cinfo->col_last[COL_CUSTOM]; i++) {
+    if (cinfo->fmt_matx[i][COL_CUSTOM] &&
+        cinfo->col_custom_dfilter[i]){
+        dfilter_prime_interest(cinfo->col_custom_dfilter[i], interest);
+    }
+  }
+}
+
 /*  Appends a vararg list to a packet info string.
  *  This function's code is duplicated in col_append_sep_fstr() below because
  *  the for() loop below requires us to call va_start/va_end so intermediate
@@ -171,6 +171,10 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo);
 WS_DLL_PUBLIC
 void col_custom_prime_edt(epan_dissect_t *edt, column_info *cinfo);
 
+/** For internal Wireshark use only.  Not to be called from dissectors. */
+WS_DLL_PUBLIC
+void col_custom_prime_interest(column_info *cinfo, proto_interest_t *interest);
+
 /** For internal Wireshark use only.  Not to be called from dissectors. */
 WS_DLL_PUBLIC
 gboolean have_custom_cols(column_info *cinfo);
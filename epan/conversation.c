@@ -33,25 +33,45 @@
 #include "conversation.h"
 
 /*
- * Hash table for conversations with no wildcards.
+ * All conversations live in a single open-addressing hash table.  What used
+ * to be four GHashTables, one for each combination of the NO_ADDR2 and
+ * NO_PORT2 wildcards, are now four kinds of key in the same table: the kind
+ * takes part in both the hash and the comparison, so a lookup for one kind
+ * never matches a conversation of another.
+ *
+ * Every slot holds the head of a chain of conversations with the same key
+ * (ordered by setup frame, see conversation_insert_into_hashtable()) and
+ * the hash of that key, so that probing compares addresses only when the
+ * hashes match, and growing the table doesn't have to rehash anything.
+ * Collisions are resolved by linear probing; an empty slot has no chain.
  */
-static GHashTable *conversation_hashtable_exact = NULL;
+#define CONV_EXACT		0
+#define CONV_NO_ADDR2		1
+#define CONV_NO_PORT2		2
+#define CONV_NO_ADDR2_OR_PORT2	(CONV_NO_ADDR2|CONV_NO_PORT2)
 
-/*
- * Hash table for conversations with one wildcard address.
- */
-static GHashTable *conversation_hashtable_no_addr2 = NULL;
+#define CONV_KIND(options) \
+	((((options) & NO_ADDR2) ? CONV_NO_ADDR2 : 0) | \
+	 (((options) & (NO_PORT2|NO_PORT2_FORCE)) ? CONV_NO_PORT2 : 0))
 
-/*
- * Hash table for conversations with one wildcard port.
- */
-static GHashTable *conversation_hashtable_no_port2 = NULL;
+typedef struct _conversation_slot {
+	guint32 hash;
+	conversation_t *chain;
+} conversation_slot;
+
+#define CONVERSATION_TABLE_MIN_SIZE	1024
+
+static conversation_slot *conversation_table = NULL;
+static guint32 conversation_table_mask;
+static guint32 conversation_table_count;
 
 /*
- * Hash table for conversations with one wildcard address and port.
+ * The conversation most recently found by an exact match.  Consecutive
+ * packets usually belong to the same flow (and several dissectors look up
+ * the conversation of the same packet), so find_conversation() checks this
+ * one before hashing anything.
  */
-static GHashTable *conversation_hashtable_no_addr2_or_port2 = NULL;
-
+static conversation_t *conversation_last_exact = NULL;
 
 #ifdef __NOT_USED__
 typedef struct conversation_key {
@@ -75,10 +95,10 @@ static guint32 new_index;
  * Protocol-specific data attached to a conversation_t structure - protocol
  * index and opaque pointer.
  */
-typedef struct _conv_proto_data {
+struct _conv_proto_data {
 	int	proto;
 	void	*proto_data;
-} conv_proto_data;
+};
 
 /*
  * Creates a new conversation with known endpoints based on a conversation
@@ -177,249 +197,221 @@ conversation_create_from_template(conversation_t *conversation, const address *a
 }
 
 /*
- * Compute the hash value for two given address/port pairs if the match
- * is to be exact.
+ * Hash an address and a port, FNV-1a style.
  */
-static guint
-conversation_hash_exact(gconstpointer v)
+static guint32
+conversation_hash_endpoint(const address *addr, const guint32 port)
 {
-	const conversation_key *key = (const conversation_key *)v;
-	guint hash_val;
+	const guint8 *data = (const guint8 *)addr->data;
+	guint32 hash_val = 2166136261U;
+	int i;
 
-	hash_val = 0;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr1);
-	hash_val += key->port1;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr2);
-	hash_val += key->port2;
+	for (i = 0; i < addr->len; i++)
+		hash_val = (hash_val ^ data[i]) * 16777619U;
+	hash_val = (hash_val ^ port) * 16777619U;
 
 	return hash_val;
 }
 
 /*
- * Compare two conversation keys for an exact match.
+ * Compute the hash value for two given address/port pairs for a key of the
+ * given kind.  The parts of the key that a wildcard stands for don't take
+ * part in it.
+ *
+ * The two endpoints of an exact key are combined by adding their hashes,
+ * as both directions of a conversation have to end up in the same place;
+ * wildcard keys are only ever looked up in the direction they were created
+ * in, see find_conversation().
  */
-static gint
-conversation_match_exact(gconstpointer v, gconstpointer w)
+static guint32
+conversation_hash(const guint kind, const address *addr1, const address *addr2,
+    const port_type ptype, const guint32 port1, const guint32 port2)
 {
-	const conversation_key *v1 = (const conversation_key *)v;
-	const conversation_key *v2 = (const conversation_key *)w;
+	guint32 hash_val;
 
-	if (v1->ptype != v2->ptype)
-		return 0;	/* different types of port */
+	switch (kind) {
 
-	/*
-	 * Are the first and second port 1 values the same, the first and
-	 * second port 2 values the same, the first and second address
-	 * 1 values the same, and the first and second address 2 values
-	 * the same?
-	 */
-	if (v1->port1 == v2->port1 &&
-	    v1->port2 == v2->port2 &&
-	    ADDRESSES_EQUAL(&v1->addr1, &v2->addr1) &&
-	    ADDRESSES_EQUAL(&v1->addr2, &v2->addr2)) {
-		/*
-		 * Yes.  It's the same conversation, and the two
-		 * address/port pairs are going in the same direction.
-		 */
-		return 1;
-	}
+	case CONV_EXACT:
+		hash_val = conversation_hash_endpoint(addr1, port1) +
+		    conversation_hash_endpoint(addr2, port2);
+		break;
 
-	/*
-	 * Is the first port 2 the same as the second port 1, the first
-	 * port 1 the same as the second port 2, the first address 2
-	 * the same as the second address 1, and the first address 1
-	 * the same as the second address 2?
-	 */
-	if (v1->port2 == v2->port1 &&
-	    v1->port1 == v2->port2 &&
-	    ADDRESSES_EQUAL(&v1->addr2, &v2->addr1) &&
-	    ADDRESSES_EQUAL(&v1->addr1, &v2->addr2)) {
-		/*
-		 * Yes.  It's the same conversation, and the two
-		 * address/port pairs are going in opposite directions.
-		 */
-		return 1;
-	}
+	case CONV_NO_ADDR2:
+		hash_val = conversation_hash_endpoint(addr1, port1) ^
+		    (port2 * 2654435761U);
+		break;
 
-	/*
-	 * The addresses or the ports don't match.
-	 */
-	return 0;
-}
+	case CONV_NO_PORT2:
+		hash_val = conversation_hash_endpoint(addr1, port1) ^
+		    (conversation_hash_endpoint(addr2, 0) * 2654435761U);
+		break;
 
-/*
- * Compute the hash value for two given address/port pairs if the match
- * has a wildcard address 2.
- */
-static guint
-conversation_hash_no_addr2(gconstpointer v)
-{
-	const conversation_key *key = (const conversation_key *)v;
-	guint hash_val;
+	default:
+		hash_val = conversation_hash_endpoint(addr1, port1);
+		break;
+	}
+	hash_val ^= ((guint32)ptype << 2) | kind;
 
-	hash_val = 0;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr1);
-	hash_val += key->port1;
-	hash_val += key->port2;
+	/* Mix the bits, so that the low ones used for the index depend on
+	 * all of them (the MurmurHash3 finalizer). */
+	hash_val ^= hash_val >> 16;
+	hash_val *= 0x85ebca6bU;
+	hash_val ^= hash_val >> 13;
+	hash_val *= 0xc2b2ae35U;
+	hash_val ^= hash_val >> 16;
 
 	return hash_val;
 }
 
-/*
- * Compare two conversation keys, except for the address 2 value.
- * We don't check both directions of the conversation - the routine
- * doing the hash lookup has to do two searches, as the hash key
- * will be different for the two directions.
- */
-static gint
-conversation_match_no_addr2(gconstpointer v, gconstpointer w)
+static guint32
+conversation_hash_conv(const conversation_t *conv)
 {
-	const conversation_key *v1 = (const conversation_key *)v;
-	const conversation_key *v2 = (const conversation_key *)w;
+	const conversation_key *key = conv->key_ptr;
 
-	if (v1->ptype != v2->ptype)
-		return 0;	/* different types of port */
-
-	/*
-	 * Are the first and second port 1 values the same, the first and
-	 * second port 2 valuess the same, and the first and second
-	 * address 1 values the same?
-	 */
-	if (v1->port1 == v2->port1 &&
-	    v1->port2 == v2->port2 &&
-	    ADDRESSES_EQUAL(&v1->addr1, &v2->addr1)) {
-		/*
-		 * Yes.  It's the same conversation, and the two
-		 * address/port pairs are going in the same direction.
-		 */
-		return 1;
-	}
-
-	/*
-	 * The addresses or the ports don't match.
-	 */
-	return 0;
-}
-
-/*
- * Compute the hash value for two given address/port pairs if the match
- * has a wildcard port 2.
- */
-static guint
-conversation_hash_no_port2(gconstpointer v)
-{
-	const conversation_key *key = (const conversation_key *)v;
-	guint hash_val;
-
-	hash_val = 0;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr1);
-	hash_val += key->port1;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr2);
-
-	return hash_val;
+	return conversation_hash(CONV_KIND(conv->options), &key->addr1,
+	    &key->addr2, key->ptype, key->port1, key->port2);
 }
 
 /*
- * Compare two conversation keys, except for the port 2 value.
- * We don't check both directions of the conversation - the routine
- * doing the hash lookup has to do two searches, as the hash key
- * will be different for the two directions.
+ * Compare the key of a conversation with two given address/port pairs,
+ * ignoring the parts of the key its wildcards stand for.
+ *
+ * Exact keys match in both directions.  For wildcard keys we don't check
+ * both directions of the conversation - the routine doing the lookup has
+ * to do two searches, as the hash will be different for the two directions.
  */
-static gint
-conversation_match_no_port2(gconstpointer v, gconstpointer w)
+static gboolean
+conversation_match(const conversation_key *key, const guint kind,
+    const address *addr1, const address *addr2, const port_type ptype,
+    const guint32 port1, const guint32 port2)
 {
-	const conversation_key *v1 = (const conversation_key *)v;
-	const conversation_key *v2 = (const conversation_key *)w;
+	if (key->ptype != ptype)
+		return FALSE;	/* different types of port */
 
-	if (v1->ptype != v2->ptype)
-		return 0;	/* different types of port */
+	switch (kind) {
 
-	/*
-	 * Are the first and second port 1 values the same, the first and
-	 * second address 1 values the same, and the first and second
-	 * address 2 values the same?
-	 */
-	if (v1->port1 == v2->port1 &&
-	    ADDRESSES_EQUAL(&v1->addr1, &v2->addr1) &&
-	    ADDRESSES_EQUAL(&v1->addr2, &v2->addr2)) {
+	case CONV_EXACT:
 		/*
-		 * Yes.  It's the same conversation, and the two
-		 * address/port pairs are going in the same direction.
+		 * Are the ports and addresses the same, either with the
+		 * two address/port pairs going in the same direction or
+		 * with them going in opposite directions?
 		 */
-		return 1;
+		if (key->port1 == port1 &&
+		    key->port2 == port2 &&
+		    ADDRESSES_EQUAL(&key->addr1, addr1) &&
+		    ADDRESSES_EQUAL(&key->addr2, addr2))
+			return TRUE;
+		return key->port2 == port1 &&
+		    key->port1 == port2 &&
+		    ADDRESSES_EQUAL(&key->addr2, addr1) &&
+		    ADDRESSES_EQUAL(&key->addr1, addr2);
+
+	case CONV_NO_ADDR2:
+		return key->port1 == port1 &&
+		    key->port2 == port2 &&
+		    ADDRESSES_EQUAL(&key->addr1, addr1);
+
+	case CONV_NO_PORT2:
+		return key->port1 == port1 &&
+		    ADDRESSES_EQUAL(&key->addr1, addr1) &&
+		    ADDRESSES_EQUAL(&key->addr2, addr2);
+
+	default:
+		return key->port1 == port1 &&
+		    ADDRESSES_EQUAL(&key->addr1, addr1);
 	}
-
-	/*
-	 * The addresses or the ports don't match.
-	 */
-	return 0;
 }
 
 /*
- * Compute the hash value for two given address/port pairs if the match
- * has a wildcard address 2 and port 2.
+ * Find the slot holding the chain of conversations of the given kind with
+ * the given address/port pairs.  If there is none, returns the empty slot
+ * where such a chain would go.
  */
-static guint
-conversation_hash_no_addr2_or_port2(gconstpointer v)
+static conversation_slot *
+conversation_table_probe(const guint32 hash, const guint kind,
+    const address *addr1, const address *addr2, const port_type ptype,
+    const guint32 port1, const guint32 port2)
 {
-	const conversation_key *key = (const conversation_key *)v;
-	guint hash_val;
+	conversation_slot *slot;
+	guint32 i;
+
+	for (i = hash & conversation_table_mask; ; i = (i + 1) & conversation_table_mask) {
+		slot = &conversation_table[i];
+		if (slot->chain == NULL)
+			return slot;
+		if (slot->hash == hash &&
+		    CONV_KIND(slot->chain->options) == kind &&
+		    conversation_match(slot->chain->key_ptr, kind, addr1,
+			addr2, ptype, port1, port2))
+			return slot;
+	}
+}
 
-	hash_val = 0;
-	ADD_ADDRESS_TO_HASH(hash_val, &key->addr1);
-	hash_val += key->port1;
+static conversation_slot *
+conversation_table_probe_conv(const guint32 hash, const conversation_t *conv)
+{
+	const conversation_key *key = conv->key_ptr;
 
-	return hash_val;
+	return conversation_table_probe(hash, CONV_KIND(conv->options),
+	    &key->addr1, &key->addr2, key->ptype, key->port1, key->port2);
 }
 
 /*
- * Compare the address 1 and port 1 in the two conversation keys.
- * We don't check both directions of the conversation - the routine
- * doing the hash lookup has to do two searches, as the hash key
- * will be different for the two directions.
+ * Double the size of the table.  The hashes are kept in the slots, so
+ * nothing has to be rehashed.
  */
-static gint
-conversation_match_no_addr2_or_port2(gconstpointer v, gconstpointer w)
+static void
+conversation_table_grow(void)
 {
-	const conversation_key *v1 = (const conversation_key *)v;
-	const conversation_key *v2 = (const conversation_key *)w;
-
-	if (v1->ptype != v2->ptype)
-		return 0;	/* different types of port */
-
-	/*
-	 * Are the first and second port 1 values the same and the first
-	 * and second address 1 values the same?
-	 */
-	if (v1->port1 == v2->port1 &&
-	    ADDRESSES_EQUAL(&v1->addr1, &v2->addr1)) {
-		/*
-		 * Yes.  It's the same conversation, and the two
-		 * address/port pairs are going in the same direction.
-		 */
-		return 1;
+	conversation_slot *old_table = conversation_table;
+	guint32 old_size = conversation_table_mask + 1;
+	guint32 i, j;
+
+	conversation_table = g_new0(conversation_slot, old_size * 2);
+	conversation_table_mask = old_size * 2 - 1;
+
+	for (i = 0; i < old_size; i++) {
+		if (old_table[i].chain == NULL)
+			continue;
+		for (j = old_table[i].hash & conversation_table_mask;
+		     conversation_table[j].chain != NULL;
+		     j = (j + 1) & conversation_table_mask)
+			;
+		conversation_table[j] = old_table[i];
 	}
 
-	/*
-	 * The addresses or the ports don't match.
-	 */
-	return 0;
+	g_free(old_table);
 }
 
 /*
- * Free the proto_data.  The conversation itself is se_allocated.
+ * Empty a slot.  With linear probing we can't just leave a hole, as that
+ * would end the probe sequence of the chains stored after it, so move back
+ * every following chain that may go into the hole, up to the next empty
+ * slot.
  */
 static void
-free_data_list(gpointer key _U_, gpointer value, gpointer user_data _U_)
+conversation_table_remove_slot(conversation_slot *slot)
 {
-	conversation_t *conv = (conversation_t *)value;
+	guint32 hole = (guint32)(slot - conversation_table);
+	guint32 i, home;
 
-	/* TODO: se_slist? */
-	g_slist_free(conv->data_list);
-
-	/* Not really necessary, but... */
-	conv->data_list = NULL;
+	for (i = (hole + 1) & conversation_table_mask;
+	     conversation_table[i].chain != NULL;
+	     i = (i + 1) & conversation_table_mask) {
+		home = conversation_table[i].hash & conversation_table_mask;
+		/*
+		 * The chain may move to the hole unless its home slot lies
+		 * (cyclically) after the hole and no later than where it is.
+		 */
+		if (((i - home) & conversation_table_mask) >=
+		    ((i - hole) & conversation_table_mask)) {
+			conversation_table[hole] = conversation_table[i];
+			hole = i;
+		}
+	}
 
+	conversation_table[hole].chain = NULL;
+	conversation_table_count--;
 }
 
 /*
@@ -428,32 +420,16 @@ free_data_list(gpointer key _U_, gpointer value, gpointer user_data _U_)
 void
 conversation_cleanup(void)
 {
-	/*  Clean up the hash tables, but only after freeing any proto_data
-	 *  that may be hanging off the conversations.
-	 *  The conversation keys are se_ allocated so we don't have to clean them up.
+	/*  The conversations, their keys and their proto_data arrays are
+	 *  se_ allocated so we only have to free the table.
 	 */
 	conversation_keys = NULL;
-	if (conversation_hashtable_exact != NULL) {
-		g_hash_table_foreach(conversation_hashtable_exact, free_data_list, NULL);
-		g_hash_table_destroy(conversation_hashtable_exact);
-	}
-	if (conversation_hashtable_no_addr2 != NULL) {
-		g_hash_table_foreach(conversation_hashtable_no_addr2, free_data_list, NULL);
-		g_hash_table_destroy(conversation_hashtable_no_addr2);
-	}
-	if (conversation_hashtable_no_port2 != NULL) {
-		g_hash_table_foreach(conversation_hashtable_no_port2, free_data_list, NULL);
-		g_hash_table_destroy(conversation_hashtable_no_port2);
-	}
-	if (conversation_hashtable_no_addr2_or_port2 != NULL) {
-		g_hash_table_foreach(conversation_hashtable_no_addr2_or_port2, free_data_list, NULL);
-		g_hash_table_destroy(conversation_hashtable_no_addr2_or_port2);
-	}
+	conversation_last_exact = NULL;
 
-	conversation_hashtable_exact = NULL;
-	conversation_hashtable_no_addr2 = NULL;
-	conversation_hashtable_no_port2 = NULL;
-	conversation_hashtable_no_addr2_or_port2 = NULL;
+	g_free(conversation_table);
+	conversation_table = NULL;
+	conversation_table_mask = 0;
+	conversation_table_count = 0;
 }
 
 /*
@@ -463,26 +439,10 @@ conversation_cleanup(void)
 void
 conversation_init(void)
 {
-	/*
-	 * Free up any space allocated for conversation protocol data
-	 * areas.
-	 *
-	 * We can free the space, as the structures it contains are
-	 * pointed to by conversation data structures that were freed
-	 * above.
-	 */
-	conversation_hashtable_exact =
-	    g_hash_table_new(conversation_hash_exact,
-	      conversation_match_exact);
-	conversation_hashtable_no_addr2 =
-	    g_hash_table_new(conversation_hash_no_addr2,
-	      conversation_match_no_addr2);
-	conversation_hashtable_no_port2 =
-	    g_hash_table_new(conversation_hash_no_port2,
-	      conversation_match_no_port2);
-	conversation_hashtable_no_addr2_or_port2 =
-	    g_hash_table_new(conversation_hash_no_addr2_or_port2,
-	      conversation_match_no_addr2_or_port2);
+	conversation_table = g_new0(conversation_slot, CONVERSATION_TABLE_MIN_SIZE);
+	conversation_table_mask = CONVERSATION_TABLE_MIN_SIZE - 1;
+	conversation_table_count = 0;
+	conversation_last_exact = NULL;
 
 	/*
 	 * Start the conversation indices over at 0.
@@ -491,23 +451,32 @@ conversation_init(void)
 }
 
 /*
- * Does the right thing when inserting into one of the conversation hash tables,
+ * Does the right thing when inserting into the conversation hash table,
  * taking into account ordering and hash chains and all that good stuff.
  *
  * Mostly adapted from the old conversation_new().
  */
-void
-conversation_insert_into_hashtable(GHashTable *hashtable, conversation_t *conv)
+static void
+conversation_insert_into_hashtable(conversation_t *conv)
 {
 	conversation_t *chain_head, *chain_tail, *cur, *prev;
+	conversation_slot *slot;
+	guint32 hash;
 
-	chain_head = (conversation_t *)g_hash_table_lookup(hashtable, conv->key_ptr);
+	hash = conversation_hash_conv(conv);
+	slot = conversation_table_probe_conv(hash, conv);
+	chain_head = slot->chain;
 
 	if (NULL==chain_head) {
 		/* New entry */
 		conv->next = NULL;
 		conv->last = conv;
-		g_hash_table_insert(hashtable, conv->key_ptr, conv);
+		slot->hash = hash;
+		slot->chain = conv;
+
+		/* Keep the table at most half full */
+		if (++conversation_table_count > conversation_table_mask / 2)
+			conversation_table_grow();
 	}
 	else {
 		/* There's an existing chain for this key */
@@ -534,7 +503,7 @@ conversation_insert_into_hashtable(GHashTable *hashtable, conversation_t *conv)
 				conv->next = chain_head;
 				conv->last = chain_tail;
 				chain_head->last = NULL;
-				g_hash_table_insert(hashtable, conv->key_ptr, conv);
+				slot->chain = conv;
 			}
 			else {
 				/* Inserting into the middle of the chain */
@@ -547,21 +516,28 @@ conversation_insert_into_hashtable(GHashTable *hashtable, conversation_t *conv)
 }
 
 /*
- * Does the right thing when removing from one of the conversation hash tables,
+ * Does the right thing when removing from the conversation hash table,
  * taking into account ordering and hash chains and all that good stuff.
  */
-void
-conversation_remove_from_hashtable(GHashTable *hashtable, conversation_t *conv)
+static void
+conversation_remove_from_hashtable(conversation_t *conv)
 {
 	conversation_t *chain_head, *cur, *prev;
+	conversation_slot *slot;
 
-	chain_head = (conversation_t *)g_hash_table_lookup(hashtable, conv->key_ptr);
+	slot = conversation_table_probe_conv(conversation_hash_conv(conv), conv);
+	chain_head = slot->chain;
+
+	if (chain_head == NULL) {
+		/* XXX: Conversation not found. */
+		return;
+	}
 
 	if (conv == chain_head) {
 		/* We are currently the front of the chain */
 		if (NULL == conv->next) {
 			/* We are the only conversation in the chain */
-			g_hash_table_remove(hashtable, conv->key_ptr);
+			conversation_table_remove_slot(slot);
 		}
 		else {
 			/* Update the head of the chain */
@@ -573,7 +549,7 @@ conversation_remove_from_hashtable(GHashTable *hashtable, conversation_t *conv)
 			else
 				chain_head->latest_found = conv->latest_found;
 
-			g_hash_table_insert(hashtable, chain_head->key_ptr, chain_head);
+			slot->chain = chain_head;
 		}
 	}
 	else {
@@ -587,7 +563,7 @@ conversation_remove_from_hashtable(GHashTable *hashtable, conversation_t *conv)
 			;
 
 		if (cur != conv) {
-			/* XXX: Conversation not found. Wrong hashtable? */
+			/* XXX: Conversation not found. */
 			return;
 		}
 
@@ -619,24 +595,9 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 	DISSECTOR_ASSERT(!(options | CONVERSATION_TEMPLATE) || ((options | (NO_ADDR2 | NO_PORT2 | NO_PORT2_FORCE))) &&
 				"A conversation template may not be constructed without wildcard options");
 */
-	GHashTable* hashtable;
 	conversation_t *conversation=NULL;
 	conversation_key *new_key;
 
-	if (options & NO_ADDR2) {
-		if (options & (NO_PORT2|NO_PORT2_FORCE)) {
-			hashtable = conversation_hashtable_no_addr2_or_port2;
-		} else {
-			hashtable = conversation_hashtable_no_addr2;
-		}
-	} else {
-		if (options & (NO_PORT2|NO_PORT2_FORCE)) {
-			hashtable = conversation_hashtable_no_port2;
-		} else {
-			hashtable = conversation_hashtable_exact;
-		}
-	}
-
 	new_key = se_new(struct conversation_key);
 	new_key->next = conversation_keys;
 	conversation_keys = new_key;
@@ -651,7 +612,8 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 
 	conversation->index = new_index;
 	conversation->setup_frame = setup_frame;
-	conversation->data_list = NULL;
+	conversation->proto_data = NULL;
+	conversation->num_proto_data = 0;
 
 	/* clear dissector handle */
 	conversation->dissector_handle = NULL;
@@ -662,7 +624,7 @@ conversation_new(const guint32 setup_frame, const address *addr1, const address
 
 	new_index++;
 
-	conversation_insert_into_hashtable(hashtable, conversation);
+	conversation_insert_into_hashtable(conversation);
 
 	return conversation;
 }
@@ -683,18 +645,10 @@ conversation_set_port2(conversation_t *conv, const guint32 port)
 	if ((!(conv->options & NO_PORT2)) || (conv->options & NO_PORT2_FORCE))
 		return;
 
-	if (conv->options & NO_ADDR2) {
-		conversation_remove_from_hashtable(conversation_hashtable_no_addr2_or_port2, conv);
-	} else {
-		conversation_remove_from_hashtable(conversation_hashtable_no_port2, conv);
-	}
+	conversation_remove_from_hashtable(conv);
 	conv->options &= ~NO_PORT2;
 	conv->key_ptr->port2  = port;
-	if (conv->options & NO_ADDR2) {
-		conversation_insert_into_hashtable(conversation_hashtable_no_addr2, conv);
-	} else {
-		conversation_insert_into_hashtable(conversation_hashtable_exact, conv);
-	}
+	conversation_insert_into_hashtable(conv);
 }
 
 /*
@@ -713,44 +667,28 @@ conversation_set_addr2(conversation_t *conv, const address *addr)
 	if (!(conv->options & NO_ADDR2))
 		return;
 
-	if (conv->options & NO_PORT2) {
-		conversation_remove_from_hashtable(conversation_hashtable_no_addr2_or_port2, conv);
-	} else {
-		conversation_remove_from_hashtable(conversation_hashtable_no_port2, conv);
-	}
+	conversation_remove_from_hashtable(conv);
 	conv->options &= ~NO_ADDR2;
 	SE_COPY_ADDRESS(&conv->key_ptr->addr2, addr);
-	if (conv->options & NO_PORT2) {
-		conversation_insert_into_hashtable(conversation_hashtable_no_port2, conv);
-	} else {
-		conversation_insert_into_hashtable(conversation_hashtable_exact, conv);
-	}
+	conversation_insert_into_hashtable(conv);
 }
 
 /*
- * Search a particular hash table for a conversation with the specified
- * {addr1, port1, addr2, port2} and set up before frame_num.
+ * Search the hash table for a conversation of the given kind with the
+ * specified {addr1, port1, addr2, port2} and set up before frame_num.
  */
 static conversation_t *
-conversation_lookup_hashtable(GHashTable *hashtable, const guint32 frame_num, const address *addr1, const address *addr2,
+conversation_lookup_hashtable(const guint kind, const guint32 frame_num, const address *addr1, const address *addr2,
     const port_type ptype, const guint32 port1, const guint32 port2)
 {
 	conversation_t* convo=NULL;
 	conversation_t* match=NULL;
 	conversation_t* chain_head=NULL;
-	conversation_key key;
+	guint32 hash;
 
-	/*
-	 * We don't make a copy of the address data, we just copy the
-	 * pointer to it, as "key" disappears when we return.
-	 */
-	key.addr1 = *addr1;
-	key.addr2 = *addr2;
-	key.ptype = ptype;
-	key.port1 = port1;
-	key.port2 = port2;
-
-	chain_head = (conversation_t *)g_hash_table_lookup(hashtable, &key);
+	hash = conversation_hash(kind, addr1, addr2, ptype, port1, port2);
+	chain_head = conversation_table_probe(hash, kind, addr1, addr2, ptype,
+	    port1, port2)->chain;
 
 	if (chain_head && (chain_head->setup_frame <= frame_num)) {
 		match = chain_head;
@@ -774,6 +712,31 @@ conversation_lookup_hashtable(GHashTable *hashtable, const guint32 frame_num, co
 	return match;
 }
 
+/*
+ * Check whether the conversation found by the last exact match is the one
+ * an exact match for these address/port pairs would find for frame_num.
+ *
+ * Conversations with an exact key are never removed from the table, and
+ * their chains are ordered by setup frame, so it is if its key matches and
+ * it is the conversation in its chain set up most recently before
+ * frame_num.
+ */
+static conversation_t *
+conversation_lookup_last_exact(const guint32 frame_num, const address *addr_a, const address *addr_b,
+    const port_type ptype, const guint32 port_a, const guint32 port_b)
+{
+	conversation_t *conv = conversation_last_exact;
+
+	if (conv == NULL || conv->setup_frame > frame_num)
+		return NULL;
+	if (conv->next != NULL && conv->next->setup_frame <= frame_num)
+		return NULL;
+	if (!conversation_match(conv->key_ptr, CONV_EXACT, addr_a, addr_b,
+		ptype, port_a, port_b))
+		return NULL;
+
+	return conv;
+}
 
 /*
  * Given two address/port pairs for a packet, search for a conversation
@@ -827,15 +790,24 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
        * Exact matches check both directions.
        */
       conversation =
-         conversation_lookup_hashtable(conversation_hashtable_exact,
+         conversation_lookup_last_exact(frame_num, addr_a, addr_b, ptype,
+         port_a, port_b);
+      if (conversation != NULL)
+         return conversation;
+      conversation =
+         conversation_lookup_hashtable(CONV_EXACT,
          frame_num, addr_a, addr_b, ptype,
          port_a, port_b);
-      if ((conversation == NULL) && (addr_a->type == AT_FC)) {
+      if (conversation != NULL) {
+         conversation_last_exact = conversation;
+         return conversation;
+      }
+      if (addr_a->type == AT_FC) {
          /* In Fibre channel, OXID & RXID are never swapped as
           * TCP/UDP ports are in TCP/IP.
           */
          conversation =
-            conversation_lookup_hashtable(conversation_hashtable_exact,
+            conversation_lookup_hashtable(CONV_EXACT,
             frame_num, addr_b, addr_a, ptype,
             port_a, port_b);
       }
@@ -858,14 +830,14 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
        * ("addr_b" doesn't take part in this lookup.)
        */
       conversation =
-         conversation_lookup_hashtable(conversation_hashtable_no_addr2,
+         conversation_lookup_hashtable(CONV_NO_ADDR2,
          frame_num, addr_a, addr_b, ptype, port_a, port_b);
       if ((conversation == NULL) && (addr_a->type == AT_FC)) {
          /* In Fibre channel, OXID & RXID are never swapped as
           * TCP/UDP ports are in TCP/IP.
           */
          conversation =
-            conversation_lookup_hashtable(conversation_hashtable_no_addr2,
+            conversation_lookup_hashtable(CONV_NO_ADDR2,
             frame_num, addr_b, addr_a, ptype,
             port_a, port_b);
       }
@@ -908,7 +880,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
        */
       if (!(options & NO_ADDR_B)) {
          conversation =
-            conversation_lookup_hashtable(conversation_hashtable_no_addr2,
+            conversation_lookup_hashtable(CONV_NO_ADDR2,
             frame_num, addr_b, addr_a, ptype, port_b, port_a);
          if (conversation != NULL) {
             /*
@@ -950,14 +922,14 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
        * ("port_b" doesn't take part in this lookup.)
        */
       conversation =
-         conversation_lookup_hashtable(conversation_hashtable_no_port2,
+         conversation_lookup_hashtable(CONV_NO_PORT2,
          frame_num, addr_a, addr_b, ptype, port_a, port_b);
       if ((conversation == NULL) && (addr_a->type == AT_FC)) {
          /* In Fibre channel, OXID & RXID are never swapped as
           * TCP/UDP ports are in TCP/IP
           */
          conversation =
-            conversation_lookup_hashtable(conversation_hashtable_no_port2,
+            conversation_lookup_hashtable(CONV_NO_PORT2,
             frame_num, addr_b, addr_a, ptype, port_a, port_b);
       }
       if (conversation != NULL) {
@@ -999,7 +971,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
        */
       if (!(options & NO_PORT_B)) {
          conversation =
-            conversation_lookup_hashtable(conversation_hashtable_no_port2,
+            conversation_lookup_hashtable(CONV_NO_PORT2,
             frame_num, addr_b, addr_a, ptype, port_b, port_a);
          if (conversation != NULL) {
             /*
@@ -1036,7 +1008,7 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
     * (Neither "addr_b" nor "port_b" take part in this lookup.)
     */
    conversation =
-      conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
+      conversation_lookup_hashtable(CONV_NO_ADDR2_OR_PORT2,
       frame_num, addr_a, addr_b, ptype, port_a, port_b);
    if (conversation != NULL) {
       /*
@@ -1081,11 +1053,11 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
     */
    if (addr_a->type == AT_FC)
       conversation =
-      conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
+      conversation_lookup_hashtable(CONV_NO_ADDR2_OR_PORT2,
       frame_num, addr_b, addr_a, ptype, port_a, port_b);
    else
       conversation =
-      conversation_lookup_hashtable(conversation_hashtable_no_addr2_or_port2,
+      conversation_lookup_hashtable(CONV_NO_ADDR2_OR_PORT2,
       frame_num, addr_b, addr_a, ptype, port_b, port_a);
    if (conversation != NULL) {
       /*
@@ -1118,50 +1090,64 @@ find_conversation(const guint32 frame_num, const address *addr_a, const address
    return NULL;
 }
 
-static gint
-p_compare(gconstpointer a, gconstpointer b)
+/*
+ * Find the entry for a protocol in the proto_data array of a conversation,
+ * or where it would go.  The array is sorted by protocol, and a
+ * conversation rarely carries data for more than a couple of protocols.
+ */
+static guint
+conversation_find_proto_data(const conversation_t *conv, const int proto)
 {
-	const conv_proto_data *ap = (const conv_proto_data *)a;
-	const conv_proto_data *bp = (const conv_proto_data *)b;
-
-	if (ap->proto > bp->proto)
-		return 1;
-	else if (ap->proto == bp->proto)
-		return 0;
-	else
-		return -1;
+	guint i;
+
+	for (i = 0; i < conv->num_proto_data; i++) {
+		if (conv->proto_data[i].proto >= proto)
+			break;
+	}
+
+	return i;
 }
 
 void
 conversation_add_proto_data(conversation_t *conv, const int proto, void *proto_data)
 {
-	conv_proto_data *p1 = se_new(conv_proto_data);
+	conv_proto_data *new_data;
+	guint i;
+
+	i = conversation_find_proto_data(conv, proto);
 
-	p1->proto = proto;
-	p1->proto_data = proto_data;
+	if (i < conv->num_proto_data && conv->proto_data[i].proto == proto) {
+		/* Replace the data added earlier for this protocol. */
+		conv->proto_data[i].proto_data = proto_data;
+		return;
+	}
 
-	/* Add it to the list of items for this conversation. */
+	if (conv->num_proto_data == conv->max_proto_data) {
+		/* The old array is se_ allocated, and goes with the file. */
+		conv->max_proto_data = conv->max_proto_data ? conv->max_proto_data * 2 : 2;
+		new_data = se_alloc_array(conv_proto_data, conv->max_proto_data);
+		if (conv->num_proto_data)
+			memcpy(new_data, conv->proto_data,
+			    conv->num_proto_data * sizeof(conv_proto_data));
+		conv->proto_data = new_data;
+	}
 
-	conv->data_list = g_slist_insert_sorted(conv->data_list, (gpointer *)p1,
-	    p_compare);
+	memmove(&conv->proto_data[i + 1], &conv->proto_data[i],
+	    (conv->num_proto_data - i) * sizeof(conv_proto_data));
+	conv->proto_data[i].proto = proto;
+	conv->proto_data[i].proto_data = proto_data;
+	conv->num_proto_data++;
 }
 
 void *
 conversation_get_proto_data(const conversation_t *conv, const int proto)
 {
-	conv_proto_data temp, *p1;
-	GSList *item;
-
-	temp.proto = proto;
-	temp.proto_data = NULL;
+	guint i;
 
-	item = g_slist_find_custom(conv->data_list, (gpointer *)&temp,
-	    p_compare);
+	i = conversation_find_proto_data(conv, proto);
 
-	if (item != NULL) {
-		p1 = (conv_proto_data *)item->data;
-		return p1->proto_data;
-	}
+	if (i < conv->num_proto_data && conv->proto_data[i].proto == proto)
+		return conv->proto_data[i].proto_data;
 
 	return NULL;
 }
@@ -1169,18 +1155,14 @@ conversation_get_proto_data(const conversation_t *conv, const int proto)
 void
 conversation_delete_proto_data(conversation_t *conv, const int proto)
 {
-	conv_proto_data temp;
-	GSList *item;
-
-	temp.proto = proto;
-	temp.proto_data = NULL;
+	guint i;
 
-	item = g_slist_find_custom(conv->data_list, (gpointer *)&temp,
-	    p_compare);
+	i = conversation_find_proto_data(conv, proto);
 
-	while(item){
-		conv->data_list = g_slist_remove(conv->data_list, item->data);
-		item=item->next;
+	if (i < conv->num_proto_data && conv->proto_data[i].proto == proto) {
+		conv->num_proto_data--;
+		memmove(&conv->proto_data[i], &conv->proto_data[i + 1],
+		    (conv->num_proto_data - i) * sizeof(conv_proto_data));
 	}
 }
 
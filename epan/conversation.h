@@ -59,6 +59,12 @@ extern "C" {
 
 #include "packet.h"		/* for conversation dissector type */
 
+/**
+ * Protocol-specific data attached to a conversation, see
+ * conversation_add_proto_data().
+ */
+typedef struct _conv_proto_data conv_proto_data;
+
 /**
  * Data structure representing a conversation.
  */
@@ -78,7 +84,9 @@ typedef struct conversation {
 								/** pointer to the last conversation on hash chain */
 	guint32	index;				/** unique ID for conversation */
 	guint32 setup_frame;		/** frame number that setup this conversation */
-	GSList *data_list;			/** list of data associated with conversation */
+	conv_proto_data *proto_data;	/** data associated with conversation, sorted by protocol */
+	guint16 num_proto_data;		/** number of entries in proto_data */
+	guint16 max_proto_data;		/** number of entries allocated for proto_data */
 	dissector_handle_t dissector_handle;
 								/** handle for protocol dissector client associated with conversation */
 	guint	options;			/** wildcard flags */
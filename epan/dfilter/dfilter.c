@@ -23,11 +23,13 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "dfilter-int.h"
 #include "syntax-tree.h"
 #include "gencode.h"
+#include "optimize.h"
 #include "semcheck.h"
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
@@ -218,6 +220,7 @@ dfilter_compile(const gchar *text, dfilter_t **dfp)
 	const char	*depr_test;
 	guint		i;
 	GPtrArray	*deprecated;
+	gboolean	optimize;
 
 	g_assert(dfp);
 
@@ -323,9 +326,17 @@ dfilter_compile(const gchar *text, dfilter_t **dfp)
 			goto FAILURE;
 		}
 
+		/* Optimize unless asked not to, e.g. to compare the code with dftest */
+		optimize = getenv("WIRESHARK_DEBUG_DFILTER_NO_OPTIMIZE") == NULL;
+		if (optimize)
+			dfw_optimize(dfw);
+
 		/* Create bytecode */
 		dfw_gencode(dfw);
 
+		if (optimize)
+			dfw_optimize_insns(dfw);
+
 		/* Tuck away the bytecode in the dfilter_t */
 		dfilter = dfilter_new();
 		dfilter->insns = dfw->insns;
@@ -370,6 +381,190 @@ FAILURE:
 }
 
 
+/* Does an instruction look at the accumulator before anything has set it? */
+static gboolean
+reads_accum(const dfvm_insn_t *insn)
+{
+	switch (insn->op) {
+		case IF_TRUE_GOTO:
+		case IF_FALSE_GOTO:
+		case NOT:
+		case RETURN:
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+static void
+remap_register(dfvm_value_t *val, const guint *reg_map)
+{
+	if (val && val->type == REGISTER)
+		val->value.numeric = reg_map[val->value.numeric];
+}
+
+static void
+add_interesting_field(gpointer key, gpointer value _U_, gpointer user_data)
+{
+	int **fieldp = (int **)user_data;
+
+	*(*fieldp)++ = GPOINTER_TO_INT(key);
+}
+
+/*
+ * The programs of the filters are laid out one after the other.  The
+ * RETURN of each one becomes a MATCH, which returns the index of the
+ * filter if the accumulator is TRUE and otherwise goes on with the next
+ * filter.  A field is read into the same register by all of the filters,
+ * so it is looked up in the tree at most once per packet; the other
+ * registers and the constants are renumbered so that they don't overlap.
+ */
+dfilter_t *
+dfilter_combine(dfilter_t **dfs, guint count)
+{
+	dfilter_t	*combined, *df;
+	GHashTable	*field_regs, *fields;
+	GPtrArray	*matches;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val;
+	guint		**reg_maps;
+	guint		i, j, r, reg, num_registers = 0, num_consts = 0;
+	guint		base;
+	int		*field;
+
+	field_regs = g_hash_table_new(g_direct_hash, g_direct_equal);
+	reg_maps = g_new0(guint *, count);
+
+	/* Registers that hold fields and intermediate results first ... */
+	for (i = 0; i < count; i++) {
+		df = dfs[i];
+		if (!df)
+			continue;
+		reg_maps[i] = g_new(guint, df->max_registers);
+		for (r = 0; r < df->num_registers; r++)
+			reg_maps[i][r] = G_MAXUINT;
+		for (j = 0; j < df->insns->len; j++) {
+			insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, j);
+			if (insn->op != READ_TREE)
+				continue;
+			/* Stored as reg+1, as in dfw_append_read_tree() */
+			reg = GPOINTER_TO_UINT(g_hash_table_lookup(field_regs,
+				insn->arg1->value.hfinfo));
+			if (reg == 0) {
+				reg = ++num_registers;
+				g_hash_table_insert(field_regs,
+					insn->arg1->value.hfinfo,
+					GUINT_TO_POINTER(reg));
+			}
+			reg_maps[i][insn->arg2->value.numeric] = reg - 1;
+		}
+		for (r = 0; r < df->num_registers; r++) {
+			if (reg_maps[i][r] == G_MAXUINT)
+				reg_maps[i][r] = num_registers++;
+		}
+	}
+	/* ... then the constants, which dfvm_apply() doesn't clear */
+	for (i = 0; i < count; i++) {
+		df = dfs[i];
+		if (!df)
+			continue;
+		for (r = df->num_registers; r < df->max_registers; r++)
+			reg_maps[i][r] = num_registers + num_consts++;
+	}
+	g_hash_table_destroy(field_regs);
+
+	combined = dfilter_new();
+	combined->insns = g_ptr_array_new();
+	combined->consts = g_ptr_array_new();
+	fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+	matches = g_ptr_array_new();
+
+	for (i = 0; i < count; i++) {
+		df = dfs[i];
+		if (!df)
+			continue;
+
+		/* Every filter but the first starts with the accumulator
+		 * FALSE, the filter before it didn't match */
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, 0);
+		if (combined->insns->len > 0 && reads_accum(insn)) {
+			insn = dfvm_insn_new(NOT);
+			insn->id = combined->insns->len;
+			g_ptr_array_add(combined->insns, insn);
+		}
+		base = combined->insns->len;
+
+		for (j = 0; j < df->insns->len; j++) {
+			insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, j);
+			insn->id = base + j;
+			remap_register(insn->arg1, reg_maps[i]);
+			remap_register(insn->arg2, reg_maps[i]);
+			remap_register(insn->arg3, reg_maps[i]);
+			remap_register(insn->arg4, reg_maps[i]);
+			if (insn->op == IF_TRUE_GOTO || insn->op == IF_FALSE_GOTO)
+				insn->arg1->value.numeric += base;
+			if (insn->op == RETURN) {
+				insn->op = MATCH;
+				val = dfvm_value_new(INTEGER);
+				val->value.numeric = i;
+				insn->arg1 = val;
+				insn->arg2 = dfvm_value_new(INSN_NUMBER);
+				g_ptr_array_add(matches, insn->arg2);
+			}
+			g_ptr_array_add(combined->insns, insn);
+		}
+		for (j = 0; j < df->consts->len; j++) {
+			insn = (dfvm_insn_t *)g_ptr_array_index(df->consts, j);
+			remap_register(insn->arg2, reg_maps[i]);
+			g_ptr_array_add(combined->consts, insn);
+		}
+
+		/* A MATCH that isn't taken goes on with the next filter */
+		for (j = 0; j < matches->len; j++) {
+			val = (dfvm_value_t *)g_ptr_array_index(matches, j);
+			val->value.numeric = combined->insns->len;
+		}
+		g_ptr_array_set_size(matches, 0);
+
+		for (j = 0; j < (guint)df->num_interesting_fields; j++)
+			g_hash_table_insert(fields,
+				GINT_TO_POINTER(df->interesting_fields[j]),
+				GUINT_TO_POINTER(TRUE));
+
+		/* The instructions belong to the combined filter now */
+		g_ptr_array_free(df->insns, TRUE);
+		g_ptr_array_free(df->consts, TRUE);
+		df->insns = NULL;
+		df->consts = NULL;
+		dfilter_free(df);
+		g_free(reg_maps[i]);
+	}
+	g_ptr_array_free(matches, TRUE);
+	g_free(reg_maps);
+
+	/* None of them matched */
+	insn = dfvm_insn_new(RETURN);
+	insn->id = combined->insns->len;
+	g_ptr_array_add(combined->insns, insn);
+
+	combined->num_interesting_fields = g_hash_table_size(fields);
+	if (combined->num_interesting_fields > 0) {
+		combined->interesting_fields = g_new(int,
+			combined->num_interesting_fields);
+		field = combined->interesting_fields;
+		g_hash_table_foreach(fields, add_interesting_field, &field);
+	}
+	g_hash_table_destroy(fields);
+
+	combined->num_registers = num_registers;
+	combined->max_registers = num_registers + num_consts;
+	combined->registers = g_new0(GList*, combined->max_registers);
+	combined->attempted_load = g_new0(gboolean, combined->max_registers);
+	dfvm_init_const(combined);
+
+	return combined;
+}
+
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -382,6 +577,18 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 	return dfvm_apply(df, edt->tree);
 }
 
+int
+dfilter_apply_first_edt(dfilter_t *df, epan_dissect_t* edt)
+{
+	return dfvm_apply_first(df, edt->tree);
+}
+
+void
+dfilter_apply_all_edt(dfilter_t *df, epan_dissect_t* edt, gboolean *matched)
+{
+	dfvm_apply_all(df, edt->tree, matched);
+}
+
 
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
@@ -393,6 +600,16 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
     }
 }
 
+void
+dfilter_prime_interest(const dfilter_t *df, proto_interest_t *interest)
+{
+    int i;
+
+    for (i = 0; i < df->num_interesting_fields; i++) {
+        proto_interest_add_hfid(interest, df->interesting_fields[i]);
+    }
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
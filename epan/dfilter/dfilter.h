@@ -86,10 +86,38 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt);
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* Combines count compiled dfilters into one, for use with
+ * dfilter_apply_first_edt().  Fields used by several of the filters
+ * are read from the tree only once.  The dfilters are consumed by
+ * this; NULL entries never match. */
+WS_DLL_PUBLIC
+dfilter_t *
+dfilter_combine(dfilter_t **dfs, guint count);
+
+/* Apply a dfilter made by dfilter_combine().  Returns the index of
+ * the first of the combined dfilters that matches, or -1 if none
+ * does. */
+WS_DLL_PUBLIC
+int
+dfilter_apply_first_edt(dfilter_t *df, epan_dissect_t* edt);
+
+/* Apply a dfilter made by dfilter_combine(), setting matched[i] to
+ * whether the i'th of the combined dfilters matches.  Entries for
+ * NULL dfilters are left alone. */
+WS_DLL_PUBLIC
+void
+dfilter_apply_all_edt(dfilter_t *df, epan_dissect_t* edt, gboolean *matched);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 
+/* Add the fields/protocols used in a dfilter to a set of interesting
+ * fields. */
+WS_DLL_PUBLIC
+void
+dfilter_prime_interest(const dfilter_t *df, proto_interest_t *interest);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
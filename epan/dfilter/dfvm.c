@@ -38,6 +38,236 @@ dfvm_insn_new(dfvm_opcode_t op)
 	return insn;
 }
 
+/* Hash an fvalue consistently with fvalue_eq(); only for values that
+ * dfvm_fvalue_hashable() accepts. */
+static guint
+fvalue_hash(gconstpointer key)
+{
+	fvalue_t	*fv = (fvalue_t *)key;
+	const guint8	*p;
+	guint		i, len, h;
+	guint64		v64;
+
+	switch (fvalue_ftype(fv)->ftype) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_IPXNET:
+		case FT_FRAMENUM:
+			return fvalue_get_uinteger(fv);
+
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+			return (guint)fvalue_get_sinteger(fv);
+
+		case FT_UINT64:
+		case FT_INT64:
+			v64 = fvalue_get_integer64(fv);
+			return (guint)(v64 ^ (v64 >> 32));
+
+		case FT_IPv4:
+			return ((ipv4_addr *)fvalue_get(fv))->addr;
+
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+			return g_str_hash(fvalue_get(fv));
+
+		case FT_ETHER:
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+			p = (const guint8 *)fvalue_get(fv);
+			len = fvalue_length(fv);
+			h = len;
+			for (i = 0; i < len; i++)
+				h = (h << 5) - h + p[i];
+			return h;
+
+		default:
+			g_assert_not_reached();
+			return 0;
+	}
+}
+
+static gboolean
+fvalue_hash_equal(gconstpointer a, gconstpointer b)
+{
+	return fvalue_eq((const fvalue_t *)a, (const fvalue_t *)b);
+}
+
+gboolean
+dfvm_fvalue_hashable(fvalue_t *fv)
+{
+	switch (fvalue_ftype(fv)->ftype) {
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_IPXNET:
+		case FT_FRAMENUM:
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_UINT64:
+		case FT_INT64:
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_ETHER:
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+			return TRUE;
+
+		case FT_IPv4:
+			/* A subnet is equal to every address in it */
+			return ((ipv4_addr *)fvalue_get(fv))->nmask == 0xffffffff;
+
+		default:
+			return FALSE;
+	}
+}
+
+/* Order ranges by their lower bounds */
+static gint
+range_compare(gconstpointer a, gconstpointer b)
+{
+	const dfvm_fvalue_range_t	*ra = (const dfvm_fvalue_range_t *)a;
+	const dfvm_fvalue_range_t	*rb = (const dfvm_fvalue_range_t *)b;
+
+	if (fvalue_lt(ra->lower, rb->lower))
+		return -1;
+	if (fvalue_lt(rb->lower, ra->lower))
+		return 1;
+	return 0;
+}
+
+/* Make the range of addresses of an IPv4 subnet */
+static void
+ipv4_subnet_range(fvalue_t *fv, dfvm_fvalue_range_t *range)
+{
+	ipv4_addr	*addr = (ipv4_addr *)fvalue_get(fv);
+	guint32		lower, upper;
+
+	lower = addr->addr & addr->nmask;
+	upper = lower | ~addr->nmask;
+	range->lower = fvalue_new(FT_IPv4);
+	fvalue_set_uinteger(range->lower, g_htonl(lower));
+	range->upper = fvalue_new(FT_IPv4);
+	fvalue_set_uinteger(range->upper, g_htonl(upper));
+}
+
+/* Sort the ranges, and merge the ones that overlap */
+static void
+merge_ranges(GArray *ranges)
+{
+	dfvm_fvalue_range_t	*cur, *next;
+	guint			i, n;
+
+	if (ranges->len < 2)
+		return;
+
+	g_array_sort(ranges, range_compare);
+	n = 0;
+	for (i = 1; i < ranges->len; i++) {
+		cur = &g_array_index(ranges, dfvm_fvalue_range_t, n);
+		next = &g_array_index(ranges, dfvm_fvalue_range_t, i);
+		if (fvalue_le(next->lower, cur->upper)) {
+			if (fvalue_lt(cur->upper, next->upper)) {
+				FVALUE_FREE(cur->upper);
+				cur->upper = next->upper;
+			}
+			else {
+				FVALUE_FREE(next->upper);
+			}
+			FVALUE_FREE(next->lower);
+		}
+		else {
+			n++;
+			g_array_index(ranges, dfvm_fvalue_range_t, n) = *next;
+		}
+	}
+	g_array_set_size(ranges, n + 1);
+}
+
+/* Takes a SET node's list of (lower, upper) pairs of FVALUE nodes, and
+ * takes over their fvalues, but not the list or the nodes */
+dfvm_fvalue_set_t*
+dfvm_fvalue_set_new(GSList *values)
+{
+	dfvm_fvalue_set_t	*set;
+	dfvm_fvalue_range_t	range;
+	fvalue_t		*fv;
+	gboolean		hashable = TRUE;
+	GSList			*l;
+	guint			i;
+
+	set = g_new(dfvm_fvalue_set_t, 1);
+	set->fvalues = g_ptr_array_new();
+	set->hash = NULL;
+	set->ranges = g_array_new(FALSE, FALSE, sizeof(dfvm_fvalue_range_t));
+	set->ftype = FT_NONE;
+	set->range_ftype = FT_NONE;
+
+	for (l = values; l; l = g_slist_next(l->next)) {
+		fv = (fvalue_t *)stnode_data((stnode_t *)l->data);
+		if (l->next->data) {
+			range.lower = fv;
+			range.upper = (fvalue_t *)stnode_data((stnode_t *)l->next->data);
+			set->range_ftype = fvalue_ftype(fv)->ftype;
+			g_array_append_val(set->ranges, range);
+		}
+		else if (fvalue_ftype(fv)->ftype == FT_IPv4 && !dfvm_fvalue_hashable(fv)) {
+			ipv4_subnet_range(fv, &range);
+			FVALUE_FREE(fv);
+			set->range_ftype = FT_IPv4;
+			g_array_append_val(set->ranges, range);
+		}
+		else {
+			if (set->fvalues->len == 0)
+				set->ftype = fvalue_ftype(fv)->ftype;
+			if (!dfvm_fvalue_hashable(fv) || fvalue_ftype(fv)->ftype != set->ftype)
+				hashable = FALSE;
+			g_ptr_array_add(set->fvalues, fv);
+		}
+	}
+
+	/* Semcheck gives all the bounds the type of the field */
+	merge_ranges(set->ranges);
+
+	if (hashable && set->fvalues->len > 0) {
+		set->hash = g_hash_table_new(fvalue_hash, fvalue_hash_equal);
+		for (i = 0; i < set->fvalues->len; i++) {
+			fv = (fvalue_t *)g_ptr_array_index(set->fvalues, i);
+			g_hash_table_insert(set->hash, fv, fv);
+		}
+	}
+	return set;
+}
+
+static void
+dfvm_fvalue_set_free(dfvm_fvalue_set_t *set)
+{
+	dfvm_fvalue_range_t	*range;
+	guint			i;
+
+	if (set->hash)
+		g_hash_table_destroy(set->hash);
+	for (i = 0; i < set->fvalues->len; i++)
+		FVALUE_FREE((fvalue_t *)g_ptr_array_index(set->fvalues, i));
+	g_ptr_array_free(set->fvalues, TRUE);
+	for (i = 0; i < set->ranges->len; i++) {
+		range = &g_array_index(set->ranges, dfvm_fvalue_range_t, i);
+		FVALUE_FREE(range->lower);
+		FVALUE_FREE(range->upper);
+	}
+	g_array_free(set->ranges, TRUE);
+	g_free(set);
+}
+
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
@@ -45,6 +275,9 @@ dfvm_value_free(dfvm_value_t *v)
 		case FVALUE:
 			FVALUE_FREE(v->value.fvalue);
 			break;
+		case FVALUE_SET:
+			dfvm_fvalue_set_free(v->value.fvalue_set);
+			break;
 		case DRANGE:
 			drange_free(v->value.drange);
 			break;
@@ -130,10 +363,12 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_BITWISE_AND:
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
+			case ANY_IN:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
 			case IF_FALSE_GOTO:
+			case MATCH:
 			default:
 				g_assert_not_reached();
 				break;
@@ -264,6 +499,14 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					id, arg1->value.numeric, arg2->value.numeric);
 				break;
 
+			case ANY_IN:
+				fprintf(f, "%05d ANY_IN\t\treg#%u in {%u values%s, %u ranges}\n",
+					id, arg1->value.numeric,
+					arg2->value.fvalue_set->fvalues->len,
+					arg2->value.fvalue_set->hash ? ", hashed" : "",
+					arg2->value.fvalue_set->ranges->len);
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -282,6 +525,12 @@ dfvm_dump(FILE *f, dfilter_t *df)
 						id, arg1->value.numeric);
 				break;
 
+			case MATCH:
+				fprintf(f, "%05d MATCH\t\tfilter #%u, else %d\n",
+						id, arg1->value.numeric,
+						arg2->value.numeric);
+				break;
+
 			default:
 				g_assert_not_reached();
 				break;
@@ -370,6 +619,57 @@ any_test(dfilter_t *df, FvalueCmpFunc cmp, int reg1, int reg2)
 }
 
 
+/* Binary search for the range that a value is in */
+static gboolean
+in_ranges(GArray *ranges, fvalue_t *fv)
+{
+	dfvm_fvalue_range_t	*range;
+	guint			lo, hi, mid;
+
+	/* Find the last range that starts at or below the value */
+	lo = 0;
+	hi = ranges->len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		range = &g_array_index(ranges, dfvm_fvalue_range_t, mid);
+		if (fvalue_le(range->lower, fv))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return FALSE;
+	range = &g_array_index(ranges, dfvm_fvalue_range_t, lo - 1);
+	return fvalue_le(fv, range->upper);
+}
+
+static gboolean
+any_in(dfilter_t *df, int reg, dfvm_fvalue_set_t *set)
+{
+	GList		*list;
+	fvalue_t	*fv;
+	ftenum_t	ftype;
+	guint		i;
+
+	for (list = df->registers[reg]; list; list = g_list_next(list)) {
+		fv = (fvalue_t *)list->data;
+		ftype = fvalue_ftype(fv)->ftype;
+		if (set->ranges->len > 0 && ftype == set->range_ftype &&
+		    in_ranges(set->ranges, fv))
+			return TRUE;
+		if (set->hash && ftype == set->ftype && dfvm_fvalue_hashable(fv)) {
+			if (g_hash_table_lookup_extended(set->hash, fv, NULL, NULL))
+				return TRUE;
+			continue;
+		}
+		for (i = 0; i < set->fvalues->len; i++) {
+			if (fvalue_eq(fv, (fvalue_t *)g_ptr_array_index(set->fvalues, i)))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 /* Free the list nodes w/o freeing the memory that each
  * list node points to. */
 static void
@@ -415,8 +715,11 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 
-gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+/* Runs the program.  If it was made by dfilter_combine(), *match is set to
+ * the index of the filter that matched, if any; or, if matched isn't NULL,
+ * all of the filters are run and matched[i] is set for each of them. */
+static gboolean
+dfvm_run(dfilter_t *df, proto_tree *tree, int *match, gboolean *matched)
 {
 	int		id, length;
 	gboolean	accum = TRUE;
@@ -527,6 +830,11 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg1->value.numeric, arg2->value.numeric);
 				break;
 
+			case ANY_IN:
+				accum = any_in(df, arg1->value.numeric,
+						arg2->value.fvalue_set);
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -549,6 +857,22 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				}
 				break;
 
+			case MATCH:
+				if (matched) {
+					matched[arg1->value.numeric] = accum;
+					/* The next filter starts as if this one
+					 * hadn't matched */
+					accum = FALSE;
+				} else if (accum) {
+					*match = arg1->value.numeric;
+					free_register_overhead(df);
+					return TRUE;
+				}
+				/* On to the next filter; the fields read so far
+				 * stay loaded */
+				id = arg2->value.numeric;
+				goto AGAIN;
+
 			case PUT_FVALUE:
 #if 0
                                 /* These were handled in the constants initialization */
@@ -567,6 +891,34 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	return FALSE; /* to appease the compiler */
 }
 
+gboolean
+dfvm_apply(dfilter_t *df, proto_tree *tree)
+{
+	int		match;
+
+	return dfvm_run(df, tree, &match, NULL);
+}
+
+/* Returns the index of the first filter of a combined program that matches,
+ * or -1 */
+int
+dfvm_apply_first(dfilter_t *df, proto_tree *tree)
+{
+	int		match = -1;
+
+	dfvm_run(df, tree, &match, NULL);
+	return match;
+}
+
+/* Sets matched[i] for each filter of a combined program */
+void
+dfvm_apply_all(dfilter_t *df, proto_tree *tree, gboolean *matched)
+{
+	int		match;
+
+	dfvm_run(df, tree, &match, matched);
+}
+
 void
 dfvm_init_const(dfilter_t *df)
 {
@@ -601,10 +953,12 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_BITWISE_AND:
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
+			case ANY_IN:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
 			case IF_FALSE_GOTO:
+			case MATCH:
 			default:
 				g_assert_not_reached();
 				break;
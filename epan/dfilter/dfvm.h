@@ -38,9 +38,29 @@ typedef enum {
 	REGISTER,
 	INTEGER,
 	DRANGE,
-	FUNCTION_DEF
+	FUNCTION_DEF,
+	FVALUE_SET
 } dfvm_value_type_t;
 
+/* A range of values in an ANY_IN test, both bounds included */
+typedef struct {
+	fvalue_t	*lower;
+	fvalue_t	*upper;
+} dfvm_fvalue_range_t;
+
+/* The constants of an ANY_IN test.  If all of the single values can be
+ * hashed, they are also in a hash table, so that a field value is looked
+ * up instead of being compared with every one of them.  Ranges, and IPv4
+ * subnets, are merged into a sorted array of disjoint ranges that is
+ * searched with a binary search. */
+typedef struct {
+	GPtrArray	*fvalues;	/* single values */
+	GHashTable	*hash;		/* NULL if any of the values can't be hashed */
+	GArray		*ranges;	/* of dfvm_fvalue_range_t, sorted by lower */
+	ftenum_t	ftype;		/* of the values in the hash table */
+	ftenum_t	range_ftype;	/* of the bounds of the ranges */
+} dfvm_fvalue_set_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -50,6 +70,7 @@ typedef struct {
 		drange_t		*drange;
 		header_field_info	*hfinfo;
         df_func_def_t   *funcdef;
+		dfvm_fvalue_set_t	*fvalue_set;
 	} value;
 
 } dfvm_value_t;
@@ -74,7 +95,9 @@ typedef enum {
 	ANY_CONTAINS,
 	ANY_MATCHES,
 	MK_RANGE,
-    CALL_FUNCTION
+    CALL_FUNCTION,
+	ANY_IN,
+	MATCH		/* only in programs made by dfilter_combine() */
 
 } dfvm_opcode_t;
 
@@ -96,12 +119,24 @@ dfvm_insn_free(dfvm_insn_t *insn);
 dfvm_value_t*
 dfvm_value_new(dfvm_value_type_t type);
 
+gboolean
+dfvm_fvalue_hashable(fvalue_t *fv);
+
+dfvm_fvalue_set_t*
+dfvm_fvalue_set_new(GSList *values);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df);
 
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+int
+dfvm_apply_first(dfilter_t *df, proto_tree *tree);
+
+void
+dfvm_apply_all(dfilter_t *df, proto_tree *tree, gboolean *matched);
+
 void
 dfvm_init_const(dfilter_t *df);
 
@@ -277,6 +277,30 @@ gen_relation(dfwork_t *dfw, dfvm_opcode_t op, stnode_t *st_arg1, stnode_t *st_ar
 	}
 }
 
+static void
+gen_set_membership(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2;
+	dfvm_value_t	*jmp = NULL;
+	int		reg;
+
+	reg = gen_entity(dfw, st_arg1, &jmp);
+
+	insn = dfvm_insn_new(ANY_IN);
+	val1 = dfvm_value_new(REGISTER);
+	val1->value.numeric = reg;
+	val2 = dfvm_value_new(FVALUE_SET);
+	val2->value.fvalue_set = dfvm_fvalue_set_new((GSList *)stnode_data(st_arg2));
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	dfw_append_insn(dfw, insn);
+
+	if (jmp) {
+		jmp->value.numeric = dfw->next_insn_id;
+	}
+}
+
 /* Parse an entity, returning the reg that it gets put into.
  * p_jmp will be set if it has to be set by the calling code; it should
  * be set to the place to jump to, to return to the calling code,
@@ -422,6 +446,10 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 		case TEST_OP_MATCHES:
 			gen_relation(dfw, ANY_MATCHES, st_arg1, st_arg2);
 			break;
+
+		case TEST_OP_IN:
+			gen_set_membership(dfw, st_arg1, st_arg2);
+			break;
 	}
 }
 
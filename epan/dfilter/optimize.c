@@ -0,0 +1,469 @@
+/*
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The optimizer runs between semcheck and gencode, and once more on the
+ * generated code:
+ *
+ *  - "or" chains of equality tests of one field against constants, such as
+ *    "ip.addr == 10.0.0.1 or ip.addr == 10.0.0.2 or ...", are folded into a
+ *    single "ip.addr in {...}" test, which loads the field once and looks
+ *    its values up in a hash table.
+ *
+ *  - "and" chains are reordered so that existence tests, which don't load
+ *    any values, run before the other terms.
+ *
+ *  - A READ_TREE of a field that an earlier READ_TREE on every path to it
+ *    has already found is dropped, along with its IF-FALSE-GOTO.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "dfilter-int.h"
+#include "optimize.h"
+#include "dfvm.h"
+#include "syntax-tree.h"
+#include "sttype-set.h"
+#include "sttype-test.h"
+
+static stnode_t*
+optimize(stnode_t *st_node);
+
+/* Free a test whose operands live on elsewhere */
+static void
+detach_and_free(stnode_t *st_node)
+{
+	sttype_test_set2_args(st_node, NULL, NULL);
+	stnode_free(st_node);
+}
+
+/* Collect the optimized terms of a chain of "op" tests, left to right,
+ * freeing the tests that made up the chain. */
+static void
+flatten(stnode_t *st_node, test_op_t op, GPtrArray *terms)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == op) {
+			detach_and_free(st_node);
+			flatten(st_arg1, op, terms);
+			flatten(st_arg2, op, terms);
+			return;
+		}
+	}
+	g_ptr_array_add(terms, optimize(st_node));
+}
+
+/* Build a left-associative chain of "op" tests out of terms */
+static stnode_t*
+rebuild(test_op_t op, GPtrArray *terms)
+{
+	stnode_t	*st_node, *st_test;
+	guint		i;
+
+	st_node = (stnode_t *)g_ptr_array_index(terms, 0);
+	for (i = 1; i < terms->len; i++) {
+		st_test = stnode_new(STTYPE_TEST, NULL);
+		sttype_test_set2(st_test, op, st_node,
+				(stnode_t *)g_ptr_array_index(terms, i));
+		st_node = st_test;
+	}
+	return st_node;
+}
+
+/* Run existence tests first; otherwise keep the order */
+static stnode_t*
+optimize_and(stnode_t *st_node)
+{
+	GPtrArray	*terms, *sorted;
+	stnode_t	*term;
+	test_op_t	st_op;
+	guint		i;
+
+	terms = g_ptr_array_new();
+	flatten(st_node, TEST_OP_AND, terms);
+
+	sorted = g_ptr_array_sized_new(terms->len);
+	for (i = 0; i < terms->len; i++) {
+		term = (stnode_t *)g_ptr_array_index(terms, i);
+		sttype_test_get(term, &st_op, NULL, NULL);
+		if (st_op == TEST_OP_EXISTS)
+			g_ptr_array_add(sorted, term);
+	}
+	for (i = 0; i < terms->len; i++) {
+		term = (stnode_t *)g_ptr_array_index(terms, i);
+		sttype_test_get(term, &st_op, NULL, NULL);
+		if (st_op != TEST_OP_EXISTS)
+			g_ptr_array_add(sorted, term);
+	}
+
+	st_node = rebuild(TEST_OP_AND, sorted);
+	g_ptr_array_free(sorted, TRUE);
+	g_ptr_array_free(terms, TRUE);
+	return st_node;
+}
+
+/* The terms of an "or" chain that test one field against constants */
+typedef struct {
+	guint		count;		/* number of terms */
+	guint		first;		/* index of the first term */
+	stnode_t	*field;		/* FIELD node of the first term */
+	GSList		*values;	/* set_nodelist_prepend() list */
+} or_group_t;
+
+/*
+ * If term is "field == constant" or "field in {...}", return the FIELD
+ * node, and the constant or the set.
+ */
+static stnode_t*
+foldable(stnode_t *term, stnode_t **p_values)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	sttype_test_get(term, &st_op, &st_arg1, &st_arg2);
+	if (st_op == TEST_OP_IN) {
+		*p_values = st_arg2;
+		return st_arg1;
+	}
+	if (st_op != TEST_OP_EQ)
+		return NULL;
+	if (stnode_type_id(st_arg1) == STTYPE_FIELD &&
+	    stnode_type_id(st_arg2) == STTYPE_FVALUE) {
+		*p_values = st_arg2;
+		return st_arg1;
+	}
+	if (stnode_type_id(st_arg1) == STTYPE_FVALUE &&
+	    stnode_type_id(st_arg2) == STTYPE_FIELD) {
+		*p_values = st_arg1;
+		return st_arg2;
+	}
+	return NULL;
+}
+
+static void
+group_free(gpointer data)
+{
+	or_group_t	*group = (or_group_t *)data;
+
+	set_nodelist_free(group->values);
+	g_free(group);
+}
+
+/* Fold the equality tests of each field into one set membership test */
+static stnode_t*
+optimize_or(stnode_t *st_node)
+{
+	GPtrArray	*terms, *folded;
+	GHashTable	*groups;
+	or_group_t	*group;
+	stnode_t	*term, *field, *values, *st_test;
+	stnode_t	*st_arg1, *st_arg2;
+	GSList		*l;
+	guint		i;
+
+	terms = g_ptr_array_new();
+	flatten(st_node, TEST_OP_OR, terms);
+
+	/* Collect the constants each field is compared with.  Copies of
+	 * FVALUE nodes share their fvalue, which neither of them frees. */
+	groups = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, group_free);
+	for (i = 0; i < terms->len; i++) {
+		term = (stnode_t *)g_ptr_array_index(terms, i);
+		if (stnode_type_id(term) != STTYPE_TEST)
+			continue;
+		field = foldable(term, &values);
+		if (!field)
+			continue;
+		group = (or_group_t *)g_hash_table_lookup(groups, stnode_data(field));
+		if (!group) {
+			group = g_new0(or_group_t, 1);
+			group->first = i;
+			group->field = field;
+			g_hash_table_insert(groups, stnode_data(field), group);
+		}
+		group->count++;
+		if (stnode_type_id(values) == STTYPE_SET) {
+			for (l = (GSList *)stnode_data(values); l; l = g_slist_next(l->next))
+				group->values = set_nodelist_prepend(group->values,
+						stnode_dup((stnode_t *)l->data),
+						stnode_dup((stnode_t *)l->next->data));
+		}
+		else {
+			group->values = set_nodelist_prepend(group->values,
+					stnode_dup(values), NULL);
+		}
+	}
+
+	folded = g_ptr_array_sized_new(terms->len);
+	for (i = 0; i < terms->len; i++) {
+		term = (stnode_t *)g_ptr_array_index(terms, i);
+		group = NULL;
+		field = NULL;
+		if (stnode_type_id(term) == STTYPE_TEST) {
+			field = foldable(term, &values);
+			if (field)
+				group = (or_group_t *)g_hash_table_lookup(groups, stnode_data(field));
+		}
+		if (!group || group->count < 2) {
+			g_ptr_array_add(folded, term);
+			continue;
+		}
+
+		if (i == group->first) {
+			/* Keep the FIELD node for the set membership test */
+			sttype_test_get(term, NULL, &st_arg1, &st_arg2);
+			sttype_test_set2_args(term,
+					st_arg1 == field ? NULL : st_arg1,
+					st_arg2 == field ? NULL : st_arg2);
+
+			st_test = stnode_new(STTYPE_TEST, NULL);
+			sttype_test_set2(st_test, TEST_OP_IN, field,
+					stnode_new(STTYPE_SET, g_slist_reverse(group->values)));
+			group->values = NULL;
+			g_ptr_array_add(folded, st_test);
+		}
+		/* Freeing the test leaves the fvalues alone */
+		stnode_free(term);
+	}
+
+	st_node = rebuild(TEST_OP_OR, folded);
+	g_hash_table_destroy(groups);
+	g_ptr_array_free(folded, TRUE);
+	g_ptr_array_free(terms, TRUE);
+	return st_node;
+}
+
+static stnode_t*
+optimize(stnode_t *st_node)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return st_node;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	switch (st_op) {
+		case TEST_OP_NOT:
+			sttype_test_set2_args(st_node, optimize(st_arg1), NULL);
+			return st_node;
+
+		case TEST_OP_AND:
+			return optimize_and(st_node);
+
+		case TEST_OP_OR:
+			return optimize_or(st_node);
+
+		default:
+			return st_node;
+	}
+}
+
+void
+dfw_optimize(dfwork_t *dfw)
+{
+	dfw->st_root = optimize(dfw->st_root);
+}
+
+
+/* What is known about the registers when an instruction is reached */
+typedef struct {
+	guint8	*loaded;	/* per register: READ_TREE found the field */
+	int	pending;	/* register whose READ_TREE result is in the
+				   accumulator, -1 if none */
+} insn_state_t;
+
+/* Merge the state at the end of one path into the state of an instruction */
+static void
+merge_state(insn_state_t *dst, const insn_state_t *src, int num_registers)
+{
+	int	i;
+
+	if (!dst->loaded) {
+		dst->loaded = (guint8 *)g_memdup(src->loaded, num_registers);
+		dst->pending = src->pending;
+		return;
+	}
+	for (i = 0; i < num_registers; i++)
+		dst->loaded[i] &= src->loaded[i];
+	if (dst->pending != src->pending)
+		dst->pending = -1;
+}
+
+static gboolean
+is_jump(const dfvm_insn_t *insn)
+{
+	return insn->op == IF_TRUE_GOTO || insn->op == IF_FALSE_GOTO;
+}
+
+/*
+ * Find the "READ_TREE reg; IF-FALSE-GOTO" pairs for which every path
+ * leading to them has already found the field, and drop them.  All jumps
+ * go forward, so the instructions can be visited in order, each after all
+ * of the paths leading to it.  The accumulator set by a dropped READ_TREE
+ * is never looked at: the next instruction is the load of another
+ * operand or the test that uses the field, and that sets it again.
+ */
+void
+dfw_optimize_insns(dfwork_t *dfw)
+{
+	GPtrArray	*insns = dfw->insns;
+	int		num_insns = insns->len;
+	int		num_registers = dfw->next_register;
+	insn_state_t	*state, cur, taken;
+	gboolean	*is_target, *drop;
+	int		*new_id;
+	dfvm_insn_t	*insn, *next, *after;
+	int		i, target, reg, num_dropped = 0;
+
+	if (num_insns == 0 || num_registers == 0)
+		return;
+
+	is_target = g_new0(gboolean, num_insns);
+	for (i = 0; i < num_insns; i++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(insns, i);
+		if (is_jump(insn)) {
+			target = insn->arg1->value.numeric;
+			if (target <= i || target >= num_insns) {
+				/* Not the code gencode writes; leave it alone */
+				g_free(is_target);
+				return;
+			}
+			is_target[target] = TRUE;
+		}
+	}
+
+	state = g_new0(insn_state_t, num_insns);
+	drop = g_new0(gboolean, num_insns);
+	state[0].loaded = (guint8 *)g_malloc0(num_registers);
+	state[0].pending = -1;
+	cur.loaded = (guint8 *)g_malloc(num_registers);
+
+	for (i = 0; i < num_insns; i++) {
+		if (!state[i].loaded)
+			continue;	/* unreachable */
+		memcpy(cur.loaded, state[i].loaded, num_registers);
+		cur.pending = state[i].pending;
+
+		insn = (dfvm_insn_t *)g_ptr_array_index(insns, i);
+		switch (insn->op) {
+			case READ_TREE:
+				reg = insn->arg2->value.numeric;
+				next = i + 1 < num_insns ?
+					(dfvm_insn_t *)g_ptr_array_index(insns, i + 1) : NULL;
+				after = i + 2 < num_insns ?
+					(dfvm_insn_t *)g_ptr_array_index(insns, i + 2) : NULL;
+				if (cur.loaded[reg] && next && next->op == IF_FALSE_GOTO &&
+				    !is_target[i + 1] && after && !is_jump(after) &&
+				    after->op != NOT && after->op != RETURN) {
+					/* The jump can't be taken any more */
+					drop[i] = drop[i + 1] = TRUE;
+					num_dropped += 2;
+					merge_state(&state[i + 2], &cur, num_registers);
+					i++;
+					continue;
+				}
+				cur.pending = reg;
+				break;
+
+			case IF_TRUE_GOTO:
+			case IF_FALSE_GOTO:
+				/* The accumulator is TRUE on one path, FALSE on the other */
+				taken.loaded = (guint8 *)g_memdup(cur.loaded, num_registers);
+				taken.pending = cur.pending;
+				if (cur.pending >= 0) {
+					if (insn->op == IF_TRUE_GOTO)
+						taken.loaded[cur.pending] = TRUE;
+					else
+						cur.loaded[cur.pending] = TRUE;
+				}
+				merge_state(&state[insn->arg1->value.numeric], &taken, num_registers);
+				g_free(taken.loaded);
+				break;
+
+			case MK_RANGE:
+				/* Leaves the accumulator alone */
+				break;
+
+			case RETURN:
+				continue;
+
+			default:
+				cur.pending = -1;
+				break;
+		}
+		if (i + 1 < num_insns)
+			merge_state(&state[i + 1], &cur, num_registers);
+	}
+
+	if (num_dropped > 0) {
+		/* A jump to a dropped instruction goes to the next kept one */
+		new_id = g_new(int, num_insns);
+		for (i = 0, target = 0; i < num_insns; i++) {
+			new_id[i] = target;
+			if (!drop[i])
+				target++;
+		}
+
+		dfw->insns = g_ptr_array_sized_new(num_insns - num_dropped);
+		for (i = 0; i < num_insns; i++) {
+			insn = (dfvm_insn_t *)g_ptr_array_index(insns, i);
+			if (drop[i]) {
+				dfvm_insn_free(insn);
+				continue;
+			}
+			insn->id = new_id[i];
+			if (is_jump(insn))
+				insn->arg1->value.numeric = new_id[insn->arg1->value.numeric];
+			g_ptr_array_add(dfw->insns, insn);
+		}
+		dfw->next_insn_id = dfw->insns->len;
+		g_ptr_array_free(insns, TRUE);
+		g_free(new_id);
+	}
+
+	for (i = 0; i < num_insns; i++)
+		g_free(state[i].loaded);
+	g_free(state);
+	g_free(cur.loaded);
+	g_free(drop);
+	g_free(is_target);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -388,8 +388,8 @@ static void yy_fatal_error (yyconst char msg[]  );
 	*yy_cp = '\0'; \
 	(yy_c_buf_p) = yy_cp;
 
-#define YY_NUM_RULES 46
-#define YY_END_OF_BUFFER 47
+#define YY_NUM_RULES 49
+#define YY_END_OF_BUFFER 50
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -397,20 +397,21 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static yyconst flex_int16_t yy_accept[111] =
+static yyconst flex_int16_t yy_accept[115] =
     {   0,
-        0,    0,    0,    0,    0,    0,    0,    0,   47,   45,
-        1,    1,   22,   37,   18,    2,    3,   44,    4,   44,
-       13,   45,    9,   28,   44,   44,   44,   44,   44,   44,
-       44,   44,   44,   45,   20,   36,   46,   36,   33,   29,
-       29,   31,   34,   35,   33,   32,   31,   34,   42,   38,
-       46,    1,    7,   24,   44,   44,    0,   15,    5,   11,
-       44,   44,   44,    6,   12,   10,   16,   14,   44,    8,
-       44,   27,   26,   29,   29,    0,   35,   42,   41,   39,
-       41,   43,   25,   44,   44,   44,   23,   30,   39,   40,
-       44,   44,   44,   39,   40,   44,   44,   44,   44,   44,
-
-       44,   44,   44,   21,   44,   19,   44,   44,   17,    0
+        0,    0,    0,    0,    0,    0,    0,    0,   50,   48,
+        1,    1,   25,   40,   20,    2,    3,   47,    4,   47,
+       15,   48,   11,   31,   47,   47,   47,   47,   47,   47,
+       47,   47,   47,   47,    5,   48,    6,   22,   39,   49,
+       39,   36,   32,   32,   34,   37,   38,   36,   35,   34,
+       37,   45,   41,   49,    1,    9,   27,   47,   47,    0,
+       17,    7,   13,   47,   47,   47,    8,   14,   12,   24,
+       18,   16,   47,   10,   47,   30,   29,   32,   32,    0,
+       38,   45,   44,   42,   44,   46,   28,   47,   47,   47,
+       26,   33,   42,   43,   47,   47,   47,   42,   43,   47,
+
+       47,   47,   47,   47,   47,   47,   47,   23,   47,   21,
+       47,   47,   19,    0
     } ;
 
 static yyconst flex_int32_t yy_ec[256] =
@@ -428,7 +429,7 @@ static yyconst flex_int32_t yy_ec[256] =
 
        30,   21,   31,   32,   33,   12,   12,   34,   35,   36,
        37,   12,   38,   39,   40,   41,   12,   12,   42,   43,
-       12,   12,    1,   44,    1,   45,    1,    1,    1,    1,
+       12,   12,   44,   45,   46,   47,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
@@ -445,137 +446,141 @@ static yyconst flex_int32_t yy_ec[256] =
         1,    1,    1,    1,    1
     } ;
 
-static yyconst flex_int32_t yy_meta[46] =
+static yyconst flex_int32_t yy_meta[48] =
     {   0,
         1,    1,    2,    1,    3,    1,    1,    1,    4,    5,
         6,    4,    7,    8,    8,    8,    6,    1,    1,    1,
         8,    1,    3,    5,    4,    8,    8,    8,    8,    8,
         4,    4,    4,    4,    4,    4,    4,    4,    4,    4,
-        4,    4,    4,    1,    1
+        4,    4,    4,    1,    1,    1,    1
     } ;
 
-static yyconst flex_int16_t yy_base[122] =
+static yyconst flex_int16_t yy_base[126] =
     {   0,
-        0,    0,   43,   65,   38,   53,   42,   46,  122,  324,
-       69,   81,   94,  324,   98,  324,  324,    0,  324,   77,
-       66,   59,   54,  324,   78,   79,   84,   85,   86,   87,
-       92,   94,   93,   22,  324,  324,  324,   94,  324,  119,
-      122,  324,  324,    0,  324,  324,  324,  324,    0,  324,
-      105,  123,  324,  324,    0,  102,  125,  324,  324,  324,
-      134,  133,  136,  141,  142,  143,  144,  151,  152,  157,
-      158,  160,  324,  161,  164,    0,    0,    0,  324,  115,
-        0,  167,  175,  176,  178,  177,  183,    0,  144,    0,
-      188,  185,  193,  324,  324,  194,  199,  200,  201,  207,
-
-      213,  214,  215,  220,  228,  227,  229,  235,  236,  324,
-      265,  273,  281,  286,  291,  299,  307,  315,   53,   48,
-       42
+        0,    0,   45,   67,   40,   55,   44,   48,  122,  335,
+       71,   83,   92,  335,   98,  335,  335,    0,  335,   79,
+       68,   61,   56,  335,   80,   81,   86,   87,   88,   94,
+       96,   89,   97,   99,  335,   23,  335,  335,  335,  335,
+      105,  335,  117,  125,  335,  335,    0,  335,  335,  335,
+      335,    0,  335,  121,  140,  335,  335,    0,  104,  130,
+      335,  335,  335,  138,  115,  139,  140,  141,  146,  148,
+      149,  156,  157,  159,  164,  165,  335,  165,  168,    0,
+        0,    0,  335,  171,    0,  173,  181,  182,  184,  183,
+      190,    0,  186,    0,  193,  201,  200,  335,  335,  203,
+
+      206,  208,  220,  209,  221,  222,  227,  228,  233,  235,
+      240,  242,  243,  335,  276,  284,  292,  297,  302,  310,
+      318,  326,   55,   50,   44
     } ;
 
-static yyconst flex_int16_t yy_def[122] =
+static yyconst flex_int16_t yy_def[126] =
     {   0,
-      110,    1,  111,  111,  112,  112,  113,  113,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  114,  110,  115,
-      110,  110,  110,  110,  115,  115,  115,  115,  115,  115,
-      115,  115,  115,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  116,  110,  110,  110,  110,  117,  110,
-      118,  110,  110,  110,  114,  115,  110,  110,  110,  110,
-      115,  115,  115,  115,  115,  115,  115,  115,  115,  115,
-      115,  115,  110,  110,  110,  119,  116,  117,  110,  110,
-      120,  110,  115,  115,  115,  115,  115,  119,  110,  121,
-      115,  115,  115,  110,  110,  115,  115,  115,  115,  115,
-
-      115,  115,  115,  115,  115,  115,  115,  115,  115,    0,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110
+      114,    1,  115,  115,  116,  116,  117,  117,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  118,  114,  119,
+      114,  114,  114,  114,  119,  119,  119,  119,  119,  119,
+      119,  119,  119,  119,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  120,  114,  114,  114,
+      114,  121,  114,  122,  114,  114,  114,  118,  119,  114,
+      114,  114,  114,  119,  119,  119,  119,  119,  119,  119,
+      119,  119,  119,  119,  119,  119,  114,  114,  114,  123,
+      120,  121,  114,  114,  124,  114,  119,  119,  119,  119,
+      119,  123,  114,  125,  119,  119,  119,  114,  114,  119,
+
+      119,  119,  119,  119,  119,  119,  119,  119,  119,  119,
+      119,  119,  119,    0,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114
     } ;
 
-static yyconst flex_int16_t yy_nxt[370] =
+static yyconst flex_int16_t yy_nxt[383] =
     {   0,
        10,   11,   12,   13,   14,   15,   16,   17,   18,   19,
        20,   20,   10,   20,   20,   20,   20,   21,   22,   23,
        20,   24,   10,   10,   20,   25,   26,   27,   20,   28,
-       29,   20,   20,   30,   31,   32,   33,   20,   20,   20,
-       20,   20,   20,   34,   35,   37,   50,   45,   46,   95,
-       50,   38,   39,   38,   47,   90,   40,   41,   41,   42,
-       88,   48,   45,   46,   51,   73,   43,   37,   51,   47,
-       52,   52,   60,   38,   39,   38,   48,   59,   40,   41,
-       41,   42,   52,   52,   58,   55,   55,   55,   43,   57,
-       57,   57,   55,   55,   55,   55,   57,   57,   57,   57,
-
-       55,   55,   55,   54,   57,   57,   57,   74,   75,   75,
-       55,   62,   53,   61,   57,   65,   67,   69,   80,   80,
-       63,  110,   64,   70,   52,   52,   66,   68,   89,   89,
-       71,   72,   75,   75,   75,   75,   75,   75,   82,   82,
-       82,   55,   55,  110,   55,   57,   57,   81,   57,   55,
-       55,   55,   55,   57,   57,   57,   57,   94,   94,   55,
-       55,   76,   83,   57,   57,   55,   55,  110,   55,   57,
-       57,   85,   57,   84,   75,   75,   75,   75,   75,   75,
-       82,   82,   82,   55,   55,   55,   55,   57,   57,   57,
-       57,   55,   86,   55,  110,   57,   55,   57,   87,  110,
-
-       57,   55,   55,   76,   93,   57,   57,   55,   55,   55,
-       97,   57,   57,   57,  110,   55,  110,   91,   92,   57,
-       96,   55,   55,   55,   98,   57,   57,   57,   55,  101,
-      102,  100,   57,   99,  110,   55,   55,   55,  105,   57,
-       57,   57,  103,   55,   55,  110,  110,   57,   57,  110,
-      110,  110,  104,  107,  106,  110,  110,  110,  110,  110,
-      110,  110,  110,  109,  108,   36,   36,   36,   36,   36,
-       36,   36,   36,   44,   44,   44,   44,   44,   44,   44,
-       44,   49,   49,   49,   49,   49,   49,   49,   49,   55,
-      110,   55,  110,   55,   56,  110,   56,   56,   56,   77,
-
-       77,   77,   77,  110,  110,   77,   77,   78,   78,  110,
-       78,   78,   78,   78,   78,   79,  110,   79,   79,   79,
-       79,   79,   79,    9,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110
+       29,   20,   30,   31,   32,   33,   34,   20,   20,   20,
+       20,   20,   20,   35,   36,   37,   38,   40,   53,   48,
+       49,   99,   53,   41,   42,   41,   50,   94,   43,   44,
+       44,   45,   92,   51,   48,   49,   54,   77,   46,   40,
+       54,   50,   55,   55,   63,   41,   42,   41,   51,   62,
+       43,   44,   44,   45,   55,   55,   61,   58,   58,   58,
+       46,   60,   60,   60,   58,   58,   58,   58,   60,   60,
+
+       60,   60,   58,   57,   58,   58,   60,   58,   60,   60,
+       56,   60,   58,   65,   73,   64,   60,   68,   78,   79,
+       79,  114,   66,   58,   67,   71,   74,   60,   69,   70,
+       79,   79,   79,   75,   84,   84,   72,   76,   79,   79,
+       79,   55,   55,   86,   86,   86,   58,   58,   58,   58,
+       60,   60,   60,   60,   58,   88,   58,   58,   60,   80,
+       60,   60,  114,   85,   58,   58,   87,   58,   60,   60,
+      114,   60,   58,   58,   89,  114,   60,   60,   79,   79,
+       79,   79,   79,   79,   93,   93,   86,   86,   86,   58,
+       58,   58,   58,   60,   60,   60,   60,   90,   58,   98,
+
+       98,   58,   60,  114,   91,   60,  114,   80,   58,   58,
+       97,   58,   60,   60,   58,   60,   58,   58,   60,  114,
+       60,   60,  114,   95,   96,  100,  101,  114,   58,   58,
+       58,  102,   60,   60,   60,   58,   58,  105,  104,   60,
+       60,   58,  103,   58,  107,   60,  109,   60,   58,  106,
+       58,   58,   60,  114,   60,   60,  114,  114,  111,  114,
+      108,  114,  114,  114,  114,  114,  110,  114,  114,  114,
+      113,  114,  114,  114,  114,  112,   39,   39,   39,   39,
+       39,   39,   39,   39,   47,   47,   47,   47,   47,   47,
+       47,   47,   52,   52,   52,   52,   52,   52,   52,   52,
+
+       58,  114,   58,  114,   58,   59,  114,   59,   59,   59,
+       81,   81,   81,   81,  114,  114,   81,   81,   82,   82,
+      114,   82,   82,   82,   82,   82,   83,  114,   83,   83,
+       83,   83,   83,   83,    9,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114
     } ;
 
-static yyconst flex_int16_t yy_chk[370] =
+static yyconst flex_int16_t yy_chk[383] =
     {   0,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    3,    7,    5,    5,  121,
-        8,    3,    3,    3,    5,  120,    3,    3,    3,    3,
-      119,    5,    6,    6,    7,   34,    3,    4,    8,    6,
-       11,   11,   23,    4,    4,    4,    6,   22,    4,    4,
-        4,    4,   12,   12,   21,   20,   25,   26,    4,   20,
-       25,   26,   27,   28,   29,   30,   27,   28,   29,   30,
-
-       31,   33,   32,   15,   31,   33,   32,   38,   38,   38,
-       56,   26,   13,   25,   56,   29,   30,   31,   51,   51,
-       27,    9,   28,   32,   52,   52,   29,   30,   80,   80,
-       32,   33,   40,   40,   40,   41,   41,   41,   57,   57,
-       57,   62,   61,    0,   63,   62,   61,   51,   63,   64,
-       65,   66,   67,   64,   65,   66,   67,   89,   89,   68,
-       69,   40,   61,   68,   69,   70,   71,    0,   72,   70,
-       71,   63,   72,   62,   74,   74,   74,   75,   75,   75,
-       82,   82,   82,   83,   84,   86,   85,   83,   84,   86,
-       85,   87,   69,   92,    0,   87,   91,   92,   71,    0,
-
-       91,   93,   96,   74,   86,   93,   96,   97,   98,   99,
-       92,   97,   98,   99,    0,  100,    0,   84,   85,  100,
-       91,  101,  102,  103,   93,  101,  102,  103,  104,   98,
-       99,   97,  104,   96,    0,  106,  105,  107,  102,  106,
-      105,  107,  100,  108,  109,    0,    0,  108,  109,    0,
-        0,    0,  101,  105,  103,    0,    0,    0,    0,    0,
-        0,    0,    0,  108,  107,  111,  111,  111,  111,  111,
-      111,  111,  111,  112,  112,  112,  112,  112,  112,  112,
-      112,  113,  113,  113,  113,  113,  113,  113,  113,  114,
-        0,  114,    0,  114,  115,    0,  115,  115,  115,  116,
-
-      116,  116,  116,    0,    0,  116,  116,  117,  117,    0,
-      117,  117,  117,  117,  117,  118,    0,  118,  118,  118,
-      118,  118,  118,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110,  110,
-      110,  110,  110,  110,  110,  110,  110,  110,  110
+        1,    1,    1,    1,    1,    1,    1,    3,    7,    5,
+        5,  125,    8,    3,    3,    3,    5,  124,    3,    3,
+        3,    3,  123,    5,    6,    6,    7,   36,    3,    4,
+        8,    6,   11,   11,   23,    4,    4,    4,    6,   22,
+        4,    4,    4,    4,   12,   12,   21,   20,   25,   26,
+        4,   20,   25,   26,   27,   28,   29,   32,   27,   28,
+
+       29,   32,   30,   15,   31,   33,   30,   34,   31,   33,
+       13,   34,   59,   26,   32,   25,   59,   29,   41,   41,
+       41,    9,   27,   65,   28,   31,   33,   65,   29,   30,
+       43,   43,   43,   33,   54,   54,   31,   34,   44,   44,
+       44,   55,   55,   60,   60,   60,   64,   66,   67,   68,
+       64,   66,   67,   68,   69,   65,   70,   71,   69,   43,
+       70,   71,    0,   54,   72,   73,   64,   74,   72,   73,
+        0,   74,   75,   76,   66,    0,   75,   76,   78,   78,
+       78,   79,   79,   79,   84,   84,   86,   86,   86,   87,
+       88,   90,   89,   87,   88,   90,   89,   73,   91,   93,
+
+       93,   95,   91,    0,   75,   95,    0,   78,   97,   96,
+       90,  100,   97,   96,  101,  100,  102,  104,  101,    0,
+      102,  104,    0,   88,   89,   95,   96,    0,  103,  105,
+      106,   97,  103,  105,  106,  107,  108,  102,  101,  107,
+      108,  109,  100,  110,  104,  109,  106,  110,  111,  103,
+      112,  113,  111,    0,  112,  113,    0,    0,  109,    0,
+      105,    0,    0,    0,    0,    0,  107,    0,    0,    0,
+      112,    0,    0,    0,    0,  111,  115,  115,  115,  115,
+      115,  115,  115,  115,  116,  116,  116,  116,  116,  116,
+      116,  116,  117,  117,  117,  117,  117,  117,  117,  117,
+
+      118,    0,  118,    0,  118,  119,    0,  119,  119,  119,
+      120,  120,  120,  120,    0,    0,  120,  120,  121,  121,
+        0,  121,  121,  121,  121,  121,  122,    0,  122,  122,
+      122,  122,  122,  122,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114,  114,  114,  114,  114,  114,  114,  114,  114,
+      114,  114
     } ;
 
 static yy_state_type yy_last_accepting_state;
@@ -667,7 +672,7 @@ static void mark_lval_deprecated(const char *s);
 
 
 
-#line 671 "scanner.c"
+#line 676 "scanner.c"
 
 #define INITIAL 0
 #define RANGE_INT 1
@@ -858,7 +863,7 @@ YY_DECL
 #line 85 "scanner.l"
 
 
-#line 862 "scanner.c"
+#line 867 "scanner.c"
 
 	if ( !(yy_init) )
 		{
@@ -911,13 +916,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 111 )
+				if ( yy_current_state >= 115 )
 					yy_c = yy_meta[(unsigned int) yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
 			++yy_cp;
 			}
-		while ( yy_current_state != 110 );
+		while ( yy_current_state != 114 );
 		yy_cp = (yy_last_accepting_cpos);
 		yy_current_state = (yy_last_accepting_state);
 
@@ -960,186 +965,201 @@ return simple(TOKEN_COMMA);
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 95 "scanner.l"
-return simple(TOKEN_TEST_EQ);
+#line 94 "scanner.l"
+return simple(TOKEN_LBRACE);
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 96 "scanner.l"
-return simple(TOKEN_TEST_EQ);
+#line 95 "scanner.l"
+return simple(TOKEN_RBRACE);
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
 #line 97 "scanner.l"
+return simple(TOKEN_TEST_EQ);
+	YY_BREAK
+case 8:
+YY_RULE_SETUP
+#line 98 "scanner.l"
+return simple(TOKEN_TEST_EQ);
+	YY_BREAK
+case 9:
+YY_RULE_SETUP
+#line 99 "scanner.l"
 {
 	mark_lval_deprecated("!=");
 	return simple(TOKEN_TEST_NE);
 }
 	YY_BREAK
-case 8:
+case 10:
 YY_RULE_SETUP
-#line 101 "scanner.l"
+#line 103 "scanner.l"
 {
 	mark_lval_deprecated("ne");
 	return simple(TOKEN_TEST_NE);
 }
 	YY_BREAK
-case 9:
-YY_RULE_SETUP
-#line 105 "scanner.l"
-return simple(TOKEN_TEST_GT);
-	YY_BREAK
-case 10:
-YY_RULE_SETUP
-#line 106 "scanner.l"
-return simple(TOKEN_TEST_GT);
-	YY_BREAK
 case 11:
 YY_RULE_SETUP
 #line 107 "scanner.l"
-return simple(TOKEN_TEST_GE);
+return simple(TOKEN_TEST_GT);
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
 #line 108 "scanner.l"
-return simple(TOKEN_TEST_GE);
+return simple(TOKEN_TEST_GT);
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
 #line 109 "scanner.l"
-return simple(TOKEN_TEST_LT);
+return simple(TOKEN_TEST_GE);
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
 #line 110 "scanner.l"
-return simple(TOKEN_TEST_LT);
+return simple(TOKEN_TEST_GE);
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
 #line 111 "scanner.l"
-return simple(TOKEN_TEST_LE);
+return simple(TOKEN_TEST_LT);
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
 #line 112 "scanner.l"
-return simple(TOKEN_TEST_LE);
+return simple(TOKEN_TEST_LT);
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
 #line 113 "scanner.l"
-return simple(TOKEN_TEST_BITWISE_AND);
+return simple(TOKEN_TEST_LE);
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
 #line 114 "scanner.l"
-return simple(TOKEN_TEST_BITWISE_AND);
+return simple(TOKEN_TEST_LE);
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
 #line 115 "scanner.l"
-return simple(TOKEN_TEST_CONTAINS);
+return simple(TOKEN_TEST_BITWISE_AND);
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
 #line 116 "scanner.l"
-return simple(TOKEN_TEST_MATCHES);
+return simple(TOKEN_TEST_BITWISE_AND);
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
 #line 117 "scanner.l"
-return simple(TOKEN_TEST_MATCHES);
+return simple(TOKEN_TEST_CONTAINS);
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
 #line 118 "scanner.l"
-return simple(TOKEN_TEST_NOT);
+return simple(TOKEN_TEST_MATCHES);
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
 #line 119 "scanner.l"
-return simple(TOKEN_TEST_NOT);
+return simple(TOKEN_TEST_MATCHES);
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
 #line 120 "scanner.l"
-return simple(TOKEN_TEST_AND);
+return simple(TOKEN_TEST_IN);
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
 #line 121 "scanner.l"
-return simple(TOKEN_TEST_AND);
+return simple(TOKEN_TEST_NOT);
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
 #line 122 "scanner.l"
-return simple(TOKEN_TEST_OR);
+return simple(TOKEN_TEST_NOT);
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
 #line 123 "scanner.l"
-return simple(TOKEN_TEST_OR);
+return simple(TOKEN_TEST_AND);
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
+#line 124 "scanner.l"
+return simple(TOKEN_TEST_AND);
+	YY_BREAK
+case 29:
+YY_RULE_SETUP
+#line 125 "scanner.l"
+return simple(TOKEN_TEST_OR);
+	YY_BREAK
+case 30:
+YY_RULE_SETUP
 #line 126 "scanner.l"
+return simple(TOKEN_TEST_OR);
+	YY_BREAK
+case 31:
+YY_RULE_SETUP
+#line 129 "scanner.l"
 {
 	BEGIN(RANGE_INT);
 	return simple(TOKEN_LBRACKET);
 }
 	YY_BREAK
-case 29:
+case 32:
 YY_RULE_SETUP
-#line 131 "scanner.l"
+#line 134 "scanner.l"
 {
 	BEGIN(RANGE_PUNCT);
 	return set_lval_int(TOKEN_INTEGER, df_text);
 }
 	YY_BREAK
-case 30:
+case 33:
 YY_RULE_SETUP
-#line 136 "scanner.l"
+#line 139 "scanner.l"
 {
 	BEGIN(RANGE_PUNCT);
 	return set_lval_int(TOKEN_INTEGER, df_text);
 }
 	YY_BREAK
-case 31:
+case 34:
 YY_RULE_SETUP
-#line 141 "scanner.l"
+#line 144 "scanner.l"
 {
 	BEGIN(RANGE_INT);
 	return simple(TOKEN_COLON);
 }
 	YY_BREAK
-case 32:
+case 35:
 YY_RULE_SETUP
-#line 146 "scanner.l"
+#line 149 "scanner.l"
 {
 	BEGIN(RANGE_INT);
 	return simple(TOKEN_HYPHEN);
 }
 	YY_BREAK
-case 33:
+case 36:
 YY_RULE_SETUP
-#line 151 "scanner.l"
+#line 154 "scanner.l"
 {
 	BEGIN(RANGE_INT);
 	return simple(TOKEN_COMMA);
 }
 	YY_BREAK
-case 34:
+case 37:
 YY_RULE_SETUP
-#line 156 "scanner.l"
+#line 159 "scanner.l"
 {
 	BEGIN(INITIAL);
 	return simple(TOKEN_RBRACKET);
 }
 	YY_BREAK
 /* Error if none of the above while scanning a range (slice) */
-case 35:
-/* rule 35 can match eol */
+case 38:
+/* rule 38 can match eol */
 YY_RULE_SETUP
-#line 163 "scanner.l"
+#line 166 "scanner.l"
 {
 	dfilter_fail("Invalid string \"%s\" found while scanning slice.", df_text);
 	return SCAN_FAILED;
@@ -1148,17 +1168,17 @@ YY_RULE_SETUP
 /* XXX It would be nice to be able to match an entire non-integer string,
 	 * but beware of Flex's "match the most text" rule.
 	 */
-case 36:
+case 39:
 YY_RULE_SETUP
-#line 172 "scanner.l"
+#line 175 "scanner.l"
 {
 	dfilter_fail("Invalid character \"%s\" found while scanning slice; expected integer.", df_text);
 	return SCAN_FAILED;
 }
 	YY_BREAK
-case 37:
+case 40:
 YY_RULE_SETUP
-#line 177 "scanner.l"
+#line 180 "scanner.l"
 {
 	/* start quote */
 	/* The example of how to scan for strings was taken from
@@ -1181,7 +1201,7 @@ YY_RULE_SETUP
 }
 	YY_BREAK
 case YY_STATE_EOF(DQUOTE):
-#line 198 "scanner.l"
+#line 201 "scanner.l"
 {
 	/* unterminated string */
 	/* The example of how to handle unclosed strings was taken from
@@ -1193,9 +1213,9 @@ case YY_STATE_EOF(DQUOTE):
 	return SCAN_FAILED;
 }
 	YY_BREAK
-case 38:
+case 41:
 YY_RULE_SETUP
-#line 209 "scanner.l"
+#line 212 "scanner.l"
 {
 	/* end quote */
 	int token;
@@ -1206,9 +1226,9 @@ YY_RULE_SETUP
 	return token;
 }
 	YY_BREAK
-case 39:
+case 42:
 YY_RULE_SETUP
-#line 219 "scanner.l"
+#line 222 "scanner.l"
 {
 	/* octal sequence */
 	unsigned long result;
@@ -1222,9 +1242,9 @@ YY_RULE_SETUP
 	g_string_append_c(quoted_string, (gchar) result);
 }
 	YY_BREAK
-case 40:
+case 43:
 YY_RULE_SETUP
-#line 232 "scanner.l"
+#line 235 "scanner.l"
 {
 	/* hex sequence */
 	unsigned long result;
@@ -1232,34 +1252,34 @@ YY_RULE_SETUP
 	g_string_append_c(quoted_string, (gchar) result);
 }
 	YY_BREAK
-case 41:
+case 44:
 YY_RULE_SETUP
-#line 240 "scanner.l"
+#line 243 "scanner.l"
 {
 	/* escaped character */
 	g_string_append_c(quoted_string, df_text[1]);
 }
 	YY_BREAK
-case 42:
-/* rule 42 can match eol */
+case 45:
+/* rule 45 can match eol */
 YY_RULE_SETUP
-#line 245 "scanner.l"
+#line 248 "scanner.l"
 {
 	/* non-escaped string */
 	g_string_append(quoted_string, df_text);
 }
 	YY_BREAK
-case 43:
+case 46:
 YY_RULE_SETUP
-#line 252 "scanner.l"
+#line 255 "scanner.l"
 {
         /* CIDR */
         return set_lval(TOKEN_UNPARSED, df_text);
 }
 	YY_BREAK
-case 44:
+case 47:
 YY_RULE_SETUP
-#line 257 "scanner.l"
+#line 260 "scanner.l"
 {
 	/* Is it a field name? */
 	header_field_info *hfinfo;
@@ -1284,20 +1304,20 @@ YY_RULE_SETUP
 	}
 }
 	YY_BREAK
-case 45:
+case 48:
 YY_RULE_SETUP
-#line 281 "scanner.l"
+#line 284 "scanner.l"
 {
 	/* Default */
 	return set_lval(TOKEN_UNPARSED, df_text);
 }
 	YY_BREAK
-case 46:
+case 49:
 YY_RULE_SETUP
-#line 287 "scanner.l"
+#line 290 "scanner.l"
 ECHO;
 	YY_BREAK
-#line 1301 "scanner.c"
+#line 1321 "scanner.c"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(RANGE_INT):
 case YY_STATE_EOF(RANGE_PUNCT):
@@ -1592,7 +1612,7 @@ static int yy_get_next_buffer (void)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 111 )
+			if ( yy_current_state >= 115 )
 				yy_c = yy_meta[(unsigned int) yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
@@ -1620,11 +1640,11 @@ static int yy_get_next_buffer (void)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 111 )
+		if ( yy_current_state >= 115 )
 			yy_c = yy_meta[(unsigned int) yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + (unsigned int) yy_c];
-	yy_is_jam = (yy_current_state == 110);
+	yy_is_jam = (yy_current_state == 114);
 
 	return yy_is_jam ? 0 : yy_current_state;
 }
@@ -2257,7 +2277,7 @@ void df_free (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 287 "scanner.l"
+#line 290 "scanner.l"
 
 
 
@@ -2269,6 +2289,8 @@ simple(int token)
 		case TOKEN_RPAREN:
 		case TOKEN_LBRACKET:
 		case TOKEN_RBRACKET:
+		case TOKEN_LBRACE:
+		case TOKEN_RBRACE:
 		case TOKEN_COLON:
 		case TOKEN_COMMA:
 		case TOKEN_HYPHEN:
@@ -2281,6 +2303,7 @@ simple(int token)
 		case TOKEN_TEST_BITWISE_AND:
 		case TOKEN_TEST_CONTAINS:
 		case TOKEN_TEST_MATCHES:
+		case TOKEN_TEST_IN:
 		case TOKEN_TEST_NOT:
 		case TOKEN_TEST_AND:
 		case TOKEN_TEST_OR:
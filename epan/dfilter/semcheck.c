@@ -30,6 +30,7 @@
 #include "sttype-range.h"
 #include "sttype-test.h"
 #include "sttype-function.h"
+#include "sttype-set.h"
 
 #include <epan/exceptions.h>
 #include <epan/packet.h>
@@ -348,6 +349,7 @@ check_exists(stnode_t *st_arg1)
 		case STTYPE_TEST:
 		case STTYPE_INTEGER:
 		case STTYPE_FVALUE:
+		case STTYPE_SET:
 		case STTYPE_NUM_TYPES:
 			g_assert_not_reached();
 	}
@@ -1149,6 +1151,122 @@ header_field_info   *hfinfo;
 	}
 }
 
+/* A LogFunc for conversions whose failure isn't an error */
+static void
+ignore_fail(const char *format _U_, ...)
+{
+}
+
+/* Convert a value in a set to the type of a field */
+static fvalue_t*
+mk_set_fvalue(header_field_info *hfinfo, stnode_t *st_value)
+{
+	fvalue_t	*fvalue;
+	char		*s;
+
+	s = (char *)stnode_data(st_value);
+	if (stnode_type_id(st_value) == STTYPE_STRING)
+		fvalue = fvalue_from_string(hfinfo->type, s, dfilter_fail);
+	else
+		fvalue = fvalue_from_unparsed(hfinfo->type, s, FALSE, dfilter_fail);
+	if (!fvalue) {
+		/* check value_string */
+		fvalue = mk_fvalue_from_val_string(hfinfo, s);
+	}
+	return fvalue;
+}
+
+/* Split "lower-upper" into two values of the type of a field.  As values
+ * such as negative numbers and Ethernet addresses can contain hyphens
+ * themselves, each hyphen is tried in turn. */
+static gboolean
+mk_set_range(header_field_info *hfinfo, char *s,
+		fvalue_t **p_lower, fvalue_t **p_upper)
+{
+	fvalue_t	*lower, *upper;
+	char		*hyphen, *lower_str;
+
+	if (*s == '\0')
+		return FALSE;
+
+	for (hyphen = strchr(s + 1, '-'); hyphen; hyphen = strchr(hyphen + 1, '-')) {
+		lower_str = g_strndup(s, hyphen - s);
+		lower = fvalue_from_unparsed(hfinfo->type, lower_str, FALSE, ignore_fail);
+		g_free(lower_str);
+		if (!lower)
+			continue;
+		upper = fvalue_from_unparsed(hfinfo->type, hyphen + 1, FALSE, ignore_fail);
+		if (upper) {
+			*p_lower = lower;
+			*p_upper = upper;
+			return TRUE;
+		}
+		FVALUE_FREE(lower);
+	}
+	return FALSE;
+}
+
+/* Check the semantics of a set membership test, and convert the values
+ * and ranges in the set into FVALUE nodes. */
+static void
+check_relation_in(stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	header_field_info	*hfinfo1;
+	stnode_t		*st_value;
+	fvalue_t		*lower, *upper;
+	GSList			*l;
+
+	DebugLog(("   4 check_relation_in()\n"));
+
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD) {
+		dfilter_fail("Only a field can be tested for membership in a set.");
+		THROW(TypeError);
+	}
+
+	hfinfo1 = (header_field_info*)stnode_data(st_arg1);
+	if (!ftype_can_eq(hfinfo1->type)) {
+		dfilter_fail("%s (type=%s) cannot participate in 'in' comparison.",
+				hfinfo1->abbrev, ftype_pretty_name(hfinfo1->type));
+		THROW(TypeError);
+	}
+
+	/* The list holds (lower, upper) pairs; see sttype-set.h */
+	for (l = (GSList *)stnode_data(st_arg2); l; l = g_slist_next(l->next)) {
+		st_value = (stnode_t *)l->data;
+		upper = NULL;
+		lower = mk_set_fvalue(hfinfo1, st_value);
+		if (!lower && stnode_type_id(st_value) == STTYPE_UNPARSED &&
+		    mk_set_range(hfinfo1, (char *)stnode_data(st_value), &lower, &upper)) {
+			/* It's a range, not a bad value */
+			dfilter_error_msg = NULL;
+
+			if (!ftype_can_le(hfinfo1->type)) {
+				dfilter_fail("%s (type=%s) cannot be compared with the range \"%s\".",
+						hfinfo1->abbrev, ftype_pretty_name(hfinfo1->type),
+						(char *)stnode_data(st_value));
+				FVALUE_FREE(lower);
+				FVALUE_FREE(upper);
+				THROW(TypeError);
+			}
+			if (!fvalue_le(lower, upper)) {
+				dfilter_fail("The range \"%s\" is empty.",
+						(char *)stnode_data(st_value));
+				FVALUE_FREE(lower);
+				FVALUE_FREE(upper);
+				THROW(TypeError);
+			}
+		}
+		if (!lower) {
+			THROW(TypeError);
+		}
+
+		l->data = stnode_new(STTYPE_FVALUE, lower);
+		stnode_free(st_value);
+		if (upper)
+			l->next->data = stnode_new(STTYPE_FVALUE, upper);
+	}
+}
+
 /* Check the semantics of any type of TEST */
 static void
 check_test(stnode_t *st_node)
@@ -1208,6 +1326,9 @@ check_test(stnode_t *st_node)
 			break;
 		case TEST_OP_MATCHES:
 			check_relation("matches", TRUE, ftype_can_matches, st_node, st_arg1, st_arg2);			break;
+		case TEST_OP_IN:
+			check_relation_in(st_arg1, st_arg2);
+			break;
 
 		default:
 			g_assert_not_reached();
@@ -0,0 +1,80 @@
+/*
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include "syntax-tree.h"
+#include "sttype-set.h"
+
+/* Before semcheck the nodes of a SET are STRING or UNPARSED nodes, with no
+ * upper bounds; semcheck replaces them with FVALUE nodes, splitting ranges
+ * into their bounds. */
+
+static gpointer
+set_dup(gconstpointer data)
+{
+	GSList	*l, *copy = NULL;
+
+	for (l = (GSList *)data; l; l = g_slist_next(l))
+		copy = g_slist_prepend(copy, stnode_dup((stnode_t *)l->data));
+	return g_slist_reverse(copy);
+}
+
+static void
+set_free(gpointer value)
+{
+	set_nodelist_free((GSList *)value);
+}
+
+void
+set_nodelist_free(GSList *params)
+{
+	GSList	*l;
+
+	for (l = params; l; l = g_slist_next(l)) {
+		if (l->data)
+			stnode_free((stnode_t *)l->data);
+	}
+	g_slist_free(params);
+}
+
+GSList*
+set_nodelist_prepend(GSList *params, stnode_t *lower, stnode_t *upper)
+{
+	params = g_slist_prepend(params, lower);
+	return g_slist_prepend(params, upper);
+}
+
+void
+sttype_register_set(void)
+{
+	static sttype_t set_type = {
+		STTYPE_SET,
+		"SET",
+		NULL,
+		set_free,
+		set_dup
+	};
+
+	sttype_register(&set_type);
+}
@@ -0,0 +1,41 @@
+/*
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef STTYPE_SET_H
+#define STTYPE_SET_H
+
+#include "syntax-tree.h"
+
+/* A SET node's data is a GSList of pairs of nodes: the lower and upper
+ * bound of a range of values, or a single value followed by NULL. */
+
+/* Free a list of pairs, and the nodes in it */
+void
+set_nodelist_free(GSList *params);
+
+/* Prepend a pair to a list that will be put in order with g_slist_reverse();
+ * upper is NULL for a single value */
+GSList*
+set_nodelist_prepend(GSList *params, stnode_t *lower, stnode_t *upper);
+
+#endif
@@ -39,6 +39,7 @@ typedef enum {
 	STTYPE_INTEGER,
 	STTYPE_RANGE,
 	STTYPE_FUNCTION,
+	STTYPE_SET,
 	STTYPE_NUM_TYPES
 } sttype_id_t;
 
@@ -73,6 +74,7 @@ void sttype_register_function(void);
 void sttype_register_integer(void);
 void sttype_register_pointer(void);
 void sttype_register_range(void);
+void sttype_register_set(void);
 void sttype_register_string(void);
 void sttype_register_test(void);
 
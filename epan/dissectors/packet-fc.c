@@ -1172,9 +1172,7 @@ dissect_fc_helper (tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, gboolean
                                          !is_lastframe_inseq);
 
              if (fcfrag_head) {
-                  next_tvb = tvb_new_child_real_data(tvb, fcfrag_head->data,
-                                                fcfrag_head->datalen,
-                                                fcfrag_head->datalen);
+                  next_tvb = fragment_new_reassembled_tvb(tvb, fcfrag_head);
 
                   /* Add the defragmented data to the data source list. */
                   add_new_data_source(pinfo, next_tvb, "Reassembled FC");
@@ -170,6 +170,7 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree)
 	proto_tree  *comments_tree;
 	proto_item  *item;
 	const gchar *cap_plurality, *frame_plurality;
+	nstime_t     shift_offset;
 
 	tree=parent_tree;
 
@@ -227,14 +228,14 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree)
 		}
 	}
 
-	if(pinfo->fd->opt_comment){
+	if(frame_data_get_comment(pinfo->fd)){
 		item = proto_tree_add_item(tree, proto_pkt_comment, tvb, 0, -1, ENC_NA);
 		comments_tree = proto_item_add_subtree(item, ett_comments);
 		comment_item = proto_tree_add_string_format(comments_tree, hf_comments_text, tvb, 0, -1,
-							                   pinfo->fd->opt_comment, "%s",
-							                   pinfo->fd->opt_comment);
+							                   frame_data_get_comment(pinfo->fd), "%s",
+							                   frame_data_get_comment(pinfo->fd));
 		expert_add_info_format(pinfo, comment_item, PI_COMMENTS_GROUP, PI_COMMENT,
-					                       "%s",  pinfo->fd->opt_comment);
+					                       "%s",  frame_data_get_comment(pinfo->fd));
 
 
 	}
@@ -324,8 +325,9 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree)
 				expert_add_info_format(pinfo, item, PI_MALFORMED, PI_WARN,
 						       "Arrival Time: Fractional second out of range (0-1000000000)");
 			}
+			frame_data_get_shift_offset(pinfo->fd, &shift_offset);
 			item = proto_tree_add_time(fh_tree, hf_frame_shift_offset, tvb,
-					    0, 0, &(pinfo->fd->shift_offset));
+					    0, 0, &shift_offset);
 			PROTO_ITEM_SET_GENERATED(item);
 
 			if(generate_epoch_time) {
@@ -396,20 +396,18 @@ http_reqs_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t*
 	int reqs_by_this_addr;
 	int resps_by_this_addr;
 	int i = v->response_code;
-	gchar *ip_str;
 
 
 	if (v->request_method) {
-		ip_str = ep_address_to_str(&pinfo->dst);
-
-		tick_stat_node(st, st_str_reqs, 0, FALSE);
-		tick_stat_node(st, st_str_reqs_by_srv_addr, st_node_reqs, TRUE);
-		tick_stat_node(st, st_str_reqs_by_http_host, st_node_reqs, TRUE);
-		reqs_by_this_addr = tick_stat_node(st, ip_str, st_node_reqs_by_srv_addr, TRUE);
+		tick_stat_node_by_id(st, st_node_reqs);
+		tick_stat_node_by_id(st, st_node_reqs_by_srv_addr);
+		tick_stat_node_by_id(st, st_node_reqs_by_http_host);
+		reqs_by_this_addr = stats_tree_address_node(st, &pinfo->dst, st_node_reqs_by_srv_addr, TRUE);
+		tick_stat_node_by_id(st, reqs_by_this_addr);
 
 		if (v->http_host) {
 			reqs_by_this_host = tick_stat_node(st, v->http_host, st_node_reqs_by_http_host, TRUE);
-			tick_stat_node(st, ip_str, reqs_by_this_host, FALSE);
+			tick_stat_node_by_id(st, stats_tree_address_node(st, &pinfo->dst, reqs_by_this_host, FALSE));
 
 			tick_stat_node(st, v->http_host, reqs_by_this_addr, FALSE);
 		}
@@ -417,10 +415,9 @@ http_reqs_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t*
 		return 1;
 
 	} else if (i != 0) {
-		ip_str = ep_address_to_str(&pinfo->src);
-
-		tick_stat_node(st, st_str_resps_by_srv_addr, 0, FALSE);
-		resps_by_this_addr = tick_stat_node(st, ip_str, st_node_resps_by_srv_addr, TRUE);
+		tick_stat_node_by_id(st, st_node_resps_by_srv_addr);
+		resps_by_this_addr = stats_tree_address_node(st, &pinfo->src, st_node_resps_by_srv_addr, TRUE);
+		tick_stat_node_by_id(st, resps_by_this_addr);
 
 		if ( (i>100)&&(i<400) ) {
 			tick_stat_node(st, "OK", resps_by_this_addr, FALSE);
@@ -453,7 +450,7 @@ http_req_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_
 	int reqs_by_this_host;
 
 	if (v->request_method) {
-		tick_stat_node(st, st_str_requests_by_host, 0, FALSE);
+		tick_stat_node_by_id(st, st_node_requests_by_host);
 
 		if (v->http_host) {
 			reqs_by_this_host = tick_stat_node(st, v->http_host, st_node_requests_by_host, TRUE);
@@ -515,43 +512,41 @@ http_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* e
 	const http_info_value_t* v = (const http_info_value_t*)p;
 	guint i = v->response_code;
 	int resp_grp;
-	const gchar *resp_str;
+	int resp_node;
 	gchar str[64];
 
-	tick_stat_node(st, st_str_packets, 0, FALSE);
+	tick_stat_node_by_id(st, st_node_packets);
 
 	if (i) {
-		tick_stat_node(st, st_str_responses, st_node_packets, FALSE);
+		tick_stat_node_by_id(st, st_node_responses);
 
 		if ( (i<100)||(i>=600) ) {
 			resp_grp = st_node_resp_broken;
-			resp_str = st_str_resp_broken;
 		} else if (i<200) {
 			resp_grp = st_node_resp_100;
-			resp_str = st_str_resp_100;
 		} else if (i<300) {
 			resp_grp = st_node_resp_200;
-			resp_str = st_str_resp_200;
 		} else if (i<400) {
 			resp_grp = st_node_resp_300;
-			resp_str = st_str_resp_300;
 		} else if (i<500) {
 			resp_grp = st_node_resp_400;
-			resp_str = st_str_resp_400;
 		} else {
 			resp_grp = st_node_resp_500;
-			resp_str = st_str_resp_500;
 		}
 
-		tick_stat_node(st, resp_str, st_node_responses, FALSE);
+		tick_stat_node_by_id(st, resp_grp);
 
-		g_snprintf(str, sizeof(str), "%u %s", i,
-			   val_to_str(i, vals_status_code, "Unknown (%d)"));
-		tick_stat_node(st, str, resp_grp, FALSE);
+		resp_node = stats_tree_node_id_by_key(st, resp_grp, &i, sizeof i);
+		if (resp_node < 0) {
+			g_snprintf(str, sizeof(str), "%u %s", i,
+				   val_to_str(i, vals_status_code, "Unknown (%d)"));
+			resp_node = stats_tree_create_keyed_node(st, str, resp_grp, &i, sizeof i, FALSE);
+		}
+		tick_stat_node_by_id(st, resp_node);
 	} else if (v->request_method) {
 		stats_tree_tick_pivot(st,st_node_requests,v->request_method);
 	} else {
-		tick_stat_node(st, st_str_other, st_node_packets, FALSE);
+		tick_stat_node_by_id(st, st_node_other);
 	}
 
 	return 1;
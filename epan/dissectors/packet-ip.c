@@ -454,6 +454,9 @@ ip_defragment_init(void)
 {
   reassembly_table_init(&ip_reassembly_table,
                         &addresses_reassembly_table_functions);
+  /* Nothing here holds on to a reassembly in progress between frames */
+  reassembly_table_set_limits(&ip_reassembly_table,
+                              REASSEMBLY_LIMIT_FROM_PREFS, REASSEMBLY_LIMIT_FROM_PREFS);
 }
 
 void
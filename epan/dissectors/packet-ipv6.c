@@ -557,6 +557,9 @@ ipv6_reassemble_init(void)
 {
   reassembly_table_init(&ipv6_reassembly_table,
                         &addresses_reassembly_table_functions);
+  /* Nothing here holds on to a reassembly in progress between frames */
+  reassembly_table_set_limits(&ipv6_reassembly_table,
+                              REASSEMBLY_LIMIT_FROM_PREFS, REASSEMBLY_LIMIT_FROM_PREFS);
 }
 
 enum {
@@ -69,6 +69,10 @@ static gint sip_tap = -1;
 static dissector_handle_t sigcomp_handle;
 static dissector_handle_t sip_diag_handle;
 
+/* Needles for tvb_pbrk_pattern_guint8(), compiled at registration */
+static ws_mempbrk_pattern pbrk_comma_semi;
+static ws_mempbrk_pattern pbrk_whitespace;
+
 /* Initialize the protocol and registered fields */
 static gint proto_sip                     = -1;
 static gint proto_raw_sip                 = -1;
@@ -1443,7 +1447,7 @@ display_sip_uri (tvbuff_t *tvb, proto_tree *sip_element_tree, uri_offset_info* u
         /* Put the contact parameters in the tree */
 
         while (current_offset < uri_offsets->name_addr_end) {
-            queried_offset = tvb_pbrk_guint8(tvb, current_offset, uri_offsets->name_addr_end - current_offset, ",;", &c);
+            queried_offset = tvb_pbrk_pattern_guint8(tvb, current_offset, uri_offsets->name_addr_end - current_offset, &pbrk_comma_semi, &c);
 
             if (queried_offset == -1) {
                 /* Reached line end */
@@ -1553,7 +1557,7 @@ dissect_sip_contact_item(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, gi
 				/* We have an opening quote but no closing quote. */
 				current_offset = line_end_offset;
 			} else {
-				current_offset = tvb_pbrk_guint8(tvb, queried_offset+1, line_end_offset - queried_offset, ",;", &c);
+				current_offset = tvb_pbrk_pattern_guint8(tvb, queried_offset+1, line_end_offset - queried_offset, &pbrk_comma_semi, &c);
 				if(current_offset==-1){
 					/* Last parameter, line end */
 					current_offset = line_end_offset;
@@ -2963,7 +2967,7 @@ dissect_sip_common(tvbuff_t *tvb, int offset, packet_info *pinfo, proto_tree *tr
 							if (hf_index != POS_AUTHENTICATION_INFO)
 							{
 								/* The first time comma_offset is "start of parameters" */
-								comma_offset = tvb_pbrk_guint8(tvb, value_offset, line_end_offset - value_offset, " \t\r\n", NULL);
+								comma_offset = tvb_pbrk_pattern_guint8(tvb, value_offset, line_end_offset - value_offset, &pbrk_whitespace, NULL);
 								proto_tree_add_item(sip_element_tree, hf_sip_auth_scheme,
 													tvb, value_offset, comma_offset - value_offset,
 													ENC_ASCII|ENC_NA);
@@ -5224,6 +5228,9 @@ void proto_register_sip(void)
 
 	register_init_routine(&sip_init_protocol);
 	register_heur_dissector_list("sip", &heur_subdissector_list);
+
+	ws_mempbrk_compile(&pbrk_comma_semi, ",;");
+	ws_mempbrk_compile(&pbrk_whitespace, " \t\r\n");
 	/* Register for tapping */
 	sip_tap = register_tap("sip");
 
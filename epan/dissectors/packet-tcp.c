@@ -1882,9 +1882,7 @@ again:
             int old_len;
 
             /* create a new TVB structure for desegmented data */
-            next_tvb = tvb_new_child_real_data(tvb, ipfd_head->data,
-                                               ipfd_head->datalen,
-                                               ipfd_head->datalen);
+            next_tvb = fragment_new_reassembled_tvb(tvb, ipfd_head);
 
             /* add desegmented data to the data source list */
             add_new_data_source(pinfo, next_tvb, "Reassembled TCP");
@@ -4777,7 +4775,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
                     /* create a new TVB structure for desegmented data
                      * datalen-1 to strip the dummy FIN byte off
                      */
-                    next_tvb = tvb_new_child_real_data(tvb, ipfd_head->data, ipfd_head->datalen, ipfd_head->datalen);
+                    next_tvb = fragment_new_reassembled_tvb(tvb, ipfd_head);
 
                     /* add desegmented data to the data source list */
                     add_new_data_source(pinfo, next_tvb, "Reassembled TCP");
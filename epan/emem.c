@@ -28,7 +28,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
-#include <ctype.h>
 
 #include <time.h>
 #ifdef HAVE_SYS_TIME_H
@@ -158,6 +157,10 @@ typedef struct _emem_pool_t {
 	 */
 	gboolean debug_verify_pointers;
 
+	/* Usage counters; nothing is freed before emem_free_all(), so the
+	 * in-use figures are everything allocated since then. */
+	wmem_allocator_stats_t stats;
+
 } emem_pool_t;
 
 static emem_pool_t ep_packet_mem;
@@ -181,6 +184,8 @@ static intptr_t pagesize;
 
 static void *emem_alloc_chunk(size_t size, emem_pool_t *mem);
 static void *emem_alloc_glib(size_t size, emem_pool_t *mem);
+static void emem_tree_init(void);
+static void emem_tree_free_all(void);
 
 /*
  * Set a canary value to be placed between memchunks.
@@ -345,6 +350,7 @@ emem_init(void)
 {
 	ep_init_chunk();
 	se_init_chunk();
+	emem_tree_init();
 
 	if (getenv("WIRESHARK_DEBUG_SCRUB_MEMORY"))
 		debug_use_memory_scrubber  = TRUE;
@@ -859,6 +865,15 @@ emem_alloc(size_t size, emem_pool_t *mem)
 
 	buf = mem->memory_alloc(size, mem);
 
+	mem->stats.total_allocs++;
+	mem->stats.total_bytes += size;
+	mem->stats.in_use_chunks++;
+	mem->stats.in_use_bytes += size;
+	if (mem->stats.in_use_chunks > mem->stats.peak_chunks)
+		mem->stats.peak_chunks = mem->stats.in_use_chunks;
+	if (mem->stats.in_use_bytes > mem->stats.peak_bytes)
+		mem->stats.peak_bytes = mem->stats.in_use_bytes;
+
 	/*  XXX - this is a waste of time if the allocator function is going to
 	 *  memset this straight back to 0.
 	 */
@@ -1143,7 +1158,6 @@ emem_free_all(emem_pool_t *mem)
 	gboolean use_chunks = mem->debug_use_chunks;
 
 	emem_chunk_t *npc;
-	emem_tree_t *tree_list;
 
 	/* move all used chunks over to the free list */
 	while(mem->used_list){
@@ -1188,10 +1202,9 @@ emem_free_all(emem_pool_t *mem)
 		mem->free_list = NULL;
 	}
 
-	/* release/reset all allocated trees */
-	for(tree_list=mem->trees;tree_list;tree_list=tree_list->next){
-		tree_list->tree=NULL;
-	}
+	mem->stats.in_use_chunks = 0;
+	mem->stats.in_use_bytes = 0;
+	mem->stats.free_all_count++;
 }
 
 /* release all allocated memory back to the pool. */
@@ -1210,6 +1223,7 @@ se_free_all(void)
 #endif
 
 	emem_free_all(&se_packet_mem);
+	emem_tree_free_all();
 }
 
 ep_stack_t
@@ -1256,467 +1270,109 @@ ep_stack_pop(ep_stack_t stack)
 	}
 }
 
-emem_tree_t *
-se_tree_create(int type, const char *name)
-{
-	emem_tree_t *tree_list;
-
-	tree_list=(emem_tree_t *)g_malloc(sizeof(emem_tree_t));
-	tree_list->next=se_packet_mem.trees;
-	tree_list->type=type;
-	tree_list->tree=NULL;
-	tree_list->name=name;
-	tree_list->malloc=se_alloc;
-	se_packet_mem.trees=tree_list;
-
-	return tree_list;
-}
+/* The trees are wmem B-trees. Their nodes (and the headers of non-persistent
+ * trees) come from se_tree_mem, which is released together with the se_
+ * pool, or from g_malloc() for pe_ trees.
+ *
+ * The memory used by the trees is accounted per tree name, so that the
+ * "-z mem" statistics can tell which dissectors' trees grow over a capture:
+ * all the trees created under one name share an emem_tree_stats_t. */
+static wmem_allocator_t *se_tree_mem = NULL;
+static GHashTable *se_tree_stats = NULL;
+static GHashTable *pe_tree_stats = NULL;
 
-void *
-emem_tree_lookup32(emem_tree_t *se_tree, guint32 key)
+static void
+emem_tree_init(void)
 {
-	emem_tree_node_t *node;
-
-	node=se_tree->tree;
-
-	while(node){
-		if(key==node->key32){
-			return node->data;
-		}
-		if(key<node->key32){
-			node=node->left;
-			continue;
-		}
-		if(key>node->key32){
-			node=node->right;
-			continue;
-		}
-	}
-	return NULL;
+	se_tree_mem = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+	se_tree_stats = g_hash_table_new(g_str_hash, g_str_equal);
+	pe_tree_stats = g_hash_table_new(g_str_hash, g_str_equal);
 }
 
-void *
-emem_tree_lookup32_le(emem_tree_t *se_tree, guint32 key)
+static emem_tree_stats_t *
+emem_tree_get_stats(GHashTable *table, const char *name, gboolean persistent)
 {
-	emem_tree_node_t *node;
-
-	node=se_tree->tree;
-
-	if(!node){
-		return NULL;
-	}
-
-
-	while(node){
-		if(key==node->key32){
-			return node->data;
-		}
-		if(key<node->key32){
-			if(node->left){
-				node=node->left;
-				continue;
-			} else {
-				break;
-			}
-		}
-		if(key>node->key32){
-			if(node->right){
-				node=node->right;
-				continue;
-			} else {
-				break;
-			}
-		}
-	}
-
+	emem_tree_stats_t *stats;
 
-	if(!node){
-		return NULL;
-	}
-
-	/* If we are still at the root of the tree this means that this node
-	 * is either smaller than the search key and then we return this
-	 * node or else there is no smaller key available and then
-	 * we return NULL.
-	 */
-	if(!node->parent){
-		if(key>node->key32){
-			return node->data;
-		} else {
-			return NULL;
-		}
-	}
-
-	if(node->parent->left==node){
-		/* left child */
-
-		if(key>node->key32){
-			/* if this is a left child and its key is smaller than
-			 * the search key, then this is the node we want.
-			 */
-			return node->data;
-		} else {
-			/* if this is a left child and its key is bigger than
-			 * the search key, we have to check if any
-			 * of our ancestors are smaller than the search key.
-			 */
-			while(node){
-				if(key>node->key32){
-					return node->data;
-				}
-				node=node->parent;
-			}
-			return NULL;
-		}
-	} else {
-		/* right child */
+	if (!name)
+		name = "(unnamed)";
 
-		if(node->key32<key){
-			/* if this is the right child and its key is smaller
-			 * than the search key then this is the one we want.
-			 */
-			return node->data;
-		} else {
-			/* if this is the right child and its key is larger
-			 * than the search key then our parent is the one we
-			 * want.
-			 */
-			return node->parent->data;
-		}
+	stats = (emem_tree_stats_t *)g_hash_table_lookup(table, name);
+	if (!stats) {
+		stats = g_new0(emem_tree_stats_t, 1);
+		stats->name = g_strdup(name);
+		stats->persistent = persistent;
+		g_hash_table_insert(table, (gpointer)stats->name, stats);
 	}
+	stats->trees++;
 
+	return stats;
 }
 
-
-static inline emem_tree_node_t *
-emem_tree_parent(emem_tree_node_t *node)
-{
-	return node->parent;
-}
-
-static inline emem_tree_node_t *
-emem_tree_grandparent(emem_tree_node_t *node)
-{
-	emem_tree_node_t *parent;
-
-	parent=emem_tree_parent(node);
-	if(parent){
-		return parent->parent;
-	}
-	return NULL;
-}
-
-static inline emem_tree_node_t *
-emem_tree_uncle(emem_tree_node_t *node)
-{
-	emem_tree_node_t *parent, *grandparent;
-
-	parent=emem_tree_parent(node);
-	if(!parent){
-		return NULL;
-	}
-	grandparent=emem_tree_parent(parent);
-	if(!grandparent){
-		return NULL;
-	}
-	if(parent==grandparent->left){
-		return grandparent->right;
-	}
-	return grandparent->left;
-}
-
-static inline void rb_insert_case1(emem_tree_t *se_tree, emem_tree_node_t *node);
-static inline void rb_insert_case2(emem_tree_t *se_tree, emem_tree_node_t *node);
-
-static inline void
-rotate_left(emem_tree_t *se_tree, emem_tree_node_t *node)
-{
-	if(node->parent){
-		if(node->parent->left==node){
-			node->parent->left=node->right;
-		} else {
-			node->parent->right=node->right;
-		}
-	} else {
-		se_tree->tree=node->right;
-	}
-	node->right->parent=node->parent;
-	node->parent=node->right;
-	node->right=node->right->left;
-	if(node->right){
-		node->right->parent=node;
-	}
-	node->parent->left=node;
-}
-
-static inline void
-rotate_right(emem_tree_t *se_tree, emem_tree_node_t *node)
-{
-	if(node->parent){
-		if(node->parent->left==node){
-			node->parent->left=node->left;
-		} else {
-			node->parent->right=node->left;
-		}
-	} else {
-		se_tree->tree=node->left;
-	}
-	node->left->parent=node->parent;
-	node->parent=node->left;
-	node->left=node->left->right;
-	if(node->left){
-		node->left->parent=node;
-	}
-	node->parent->right=node;
-}
-
-static inline void
-rb_insert_case5(emem_tree_t *se_tree, emem_tree_node_t *node)
-{
-	emem_tree_node_t *grandparent;
-	emem_tree_node_t *parent;
-
-	parent=emem_tree_parent(node);
-	grandparent=emem_tree_parent(parent);
-	parent->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-	grandparent->u.rb_color=EMEM_TREE_RB_COLOR_RED;
-	if( (node==parent->left) && (parent==grandparent->left) ){
-		rotate_right(se_tree, grandparent);
-	} else {
-		rotate_left(se_tree, grandparent);
-	}
-}
-
-static inline void
-rb_insert_case4(emem_tree_t *se_tree, emem_tree_node_t *node)
+static void
+emem_tree_release_stats(gpointer key _U_, gpointer value, gpointer user_data _U_)
 {
-	emem_tree_node_t *grandparent;
-	emem_tree_node_t *parent;
+	emem_tree_stats_t *stats = (emem_tree_stats_t *)value;
 
-	parent=emem_tree_parent(node);
-	grandparent=emem_tree_parent(parent);
-	if(!grandparent){
-		return;
-	}
-	if( (node==parent->right) && (parent==grandparent->left) ){
-		rotate_left(se_tree, parent);
-		node=node->left;
-	} else if( (node==parent->left) && (parent==grandparent->right) ){
-		rotate_right(se_tree, parent);
-		node=node->right;
-	}
-	rb_insert_case5(se_tree, node);
+	if (stats->mem.bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->mem.bytes;
+	memset(&stats->mem, 0, sizeof(stats->mem));
 }
 
-static inline void
-rb_insert_case3(emem_tree_t *se_tree, emem_tree_node_t *node)
+/* release the memory of all se_ trees; called from se_free_all() */
+static void
+emem_tree_free_all(void)
 {
-	emem_tree_node_t *grandparent;
-	emem_tree_node_t *parent;
-	emem_tree_node_t *uncle;
+	emem_tree_t *tree_list;
 
-	uncle=emem_tree_uncle(node);
-	if(uncle && (uncle->u.rb_color==EMEM_TREE_RB_COLOR_RED)){
-		parent=emem_tree_parent(node);
-		parent->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-		uncle->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-		grandparent=emem_tree_grandparent(node);
-		grandparent->u.rb_color=EMEM_TREE_RB_COLOR_RED;
-		rb_insert_case1(se_tree, grandparent);
-	} else {
-		rb_insert_case4(se_tree, node);
+	/* reset all persistent trees, the others are gone altogether */
+	for(tree_list=se_packet_mem.trees;tree_list;tree_list=tree_list->next){
+		tree_list->tree=NULL;
 	}
-}
 
-static inline void
-rb_insert_case2(emem_tree_t *se_tree, emem_tree_node_t *node)
-{
-	emem_tree_node_t *parent;
+	wmem_free_all(se_tree_mem);
+	wmem_gc(se_tree_mem);
 
-	parent=emem_tree_parent(node);
-	/* parent is always non-NULL here */
-	if(parent->u.rb_color==EMEM_TREE_RB_COLOR_BLACK){
-		return;
-	}
-	rb_insert_case3(se_tree, node);
+	g_hash_table_foreach(se_tree_stats, emem_tree_release_stats, NULL);
 }
 
-static inline void
-rb_insert_case1(emem_tree_t *se_tree, emem_tree_node_t *node)
+static emem_tree_t *
+emem_tree_new(emem_tree_t *tree_list, int type, const char *name,
+	      wmem_allocator_t *allocator, emem_tree_stats_t *stats)
 {
-	emem_tree_node_t *parent;
+	tree_list->next=NULL;
+	tree_list->type=type;
+	tree_list->tree=NULL;
+	tree_list->name=name;
+	tree_list->allocator=allocator;
+	tree_list->stats=stats;
 
-	parent=emem_tree_parent(node);
-	if(!parent){
-		node->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-		return;
-	}
-	rb_insert_case2(se_tree, node);
+	return tree_list;
 }
 
-/* insert a new node in the tree. if this node matches an already existing node
- * then just replace the data for that node */
-void
-emem_tree_insert32(emem_tree_t *se_tree, guint32 key, void *data)
+/* returns the wmem tree behind an emem tree, creating it if needed */
+static wmem_tree_t *
+emem_tree_get(emem_tree_t *se_tree)
 {
-	emem_tree_node_t *node;
-
-	node=se_tree->tree;
-
-	/* is this the first node ?*/
-	if(!node){
-		node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-		switch(se_tree->type){
-		case EMEM_TREE_TYPE_RED_BLACK:
-			node->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-			break;
-		}
-		node->parent=NULL;
-		node->left=NULL;
-		node->right=NULL;
-		node->key32=key;
-		node->data=data;
-		node->u.is_subtree = EMEM_TREE_NODE_IS_DATA;
-		se_tree->tree=node;
-		return;
+	if (!se_tree->tree) {
+		se_tree->tree = wmem_tree_new(se_tree->allocator);
+		wmem_tree_set_stats(se_tree->tree, &se_tree->stats->mem);
 	}
 
-	/* it was not the new root so walk the tree until we find where to
-	 * insert this new leaf.
-	 */
-	while(1){
-		/* this node already exists, so just replace the data pointer*/
-		if(key==node->key32){
-			node->data=data;
-			return;
-		}
-		if(key<node->key32) {
-			if(!node->left){
-				/* new node to the left */
-				emem_tree_node_t *new_node;
-				new_node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-				node->left=new_node;
-				new_node->parent=node;
-				new_node->left=NULL;
-				new_node->right=NULL;
-				new_node->key32=key;
-				new_node->data=data;
-				new_node->u.is_subtree=EMEM_TREE_NODE_IS_DATA;
-				node=new_node;
-				break;
-			}
-			node=node->left;
-			continue;
-		}
-		if(key>node->key32) {
-			if(!node->right){
-				/* new node to the right */
-				emem_tree_node_t *new_node;
-				new_node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-				node->right=new_node;
-				new_node->parent=node;
-				new_node->left=NULL;
-				new_node->right=NULL;
-				new_node->key32=key;
-				new_node->data=data;
-				new_node->u.is_subtree=EMEM_TREE_NODE_IS_DATA;
-				node=new_node;
-				break;
-			}
-			node=node->right;
-			continue;
-		}
-	}
-
-	/* node will now point to the newly created node */
-	switch(se_tree->type){
-	case EMEM_TREE_TYPE_RED_BLACK:
-		node->u.rb_color=EMEM_TREE_RB_COLOR_RED;
-		rb_insert_case1(se_tree, node);
-		break;
-	}
+	return se_tree->tree;
 }
 
-static void *
-lookup_or_insert32(emem_tree_t *se_tree, guint32 key, void*(*func)(void*),void* ud, int is_subtree)
+emem_tree_t *
+se_tree_create(int type, const char *name)
 {
-	emem_tree_node_t *node;
-
-	node=se_tree->tree;
-
-	/* is this the first node ?*/
-	if(!node){
-		node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-		switch(se_tree->type){
-			case EMEM_TREE_TYPE_RED_BLACK:
-				node->u.rb_color=EMEM_TREE_RB_COLOR_BLACK;
-				break;
-		}
-		node->parent=NULL;
-		node->left=NULL;
-		node->right=NULL;
-		node->key32=key;
-		node->data= func(ud);
-		node->u.is_subtree = is_subtree;
-		se_tree->tree=node;
-		return node->data;
-	}
-
-	/* it was not the new root so walk the tree until we find where to
-		* insert this new leaf.
-		*/
-	while(1){
-		/* this node already exists, so just return the data pointer*/
-		if(key==node->key32){
-			return node->data;
-		}
-		if(key<node->key32) {
-			if(!node->left){
-				/* new node to the left */
-				emem_tree_node_t *new_node;
-				new_node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-				node->left=new_node;
-				new_node->parent=node;
-				new_node->left=NULL;
-				new_node->right=NULL;
-				new_node->key32=key;
-				new_node->data= func(ud);
-				new_node->u.is_subtree = is_subtree;
-				node=new_node;
-				break;
-			}
-			node=node->left;
-			continue;
-		}
-		if(key>node->key32) {
-			if(!node->right){
-				/* new node to the right */
-				emem_tree_node_t *new_node;
-				new_node=(emem_tree_node_t *)se_tree->malloc(sizeof(emem_tree_node_t));
-				node->right=new_node;
-				new_node->parent=node;
-				new_node->left=NULL;
-				new_node->right=NULL;
-				new_node->key32=key;
-				new_node->data= func(ud);
-				new_node->u.is_subtree = is_subtree;
-				node=new_node;
-				break;
-			}
-			node=node->right;
-			continue;
-		}
-	}
+	emem_tree_t *tree_list;
 
-	/* node will now point to the newly created node */
-	switch(se_tree->type){
-		case EMEM_TREE_TYPE_RED_BLACK:
-			node->u.rb_color=EMEM_TREE_RB_COLOR_RED;
-			rb_insert_case1(se_tree, node);
-			break;
-	}
+	tree_list=emem_tree_new(g_new(emem_tree_t, 1), type, name, se_tree_mem,
+				emem_tree_get_stats(se_tree_stats, name, FALSE));
+	tree_list->next=se_packet_mem.trees;
+	se_packet_mem.trees=tree_list;
 
-	return node->data;
+	return tree_list;
 }
 
 /* When the se data is released, this entire tree will dissapear as if it
@@ -1725,16 +1381,9 @@ lookup_or_insert32(emem_tree_t *se_tree, guint32 key, void*(*func)(void*),void*
 emem_tree_t *
 se_tree_create_non_persistent(int type, const char *name)
 {
-	emem_tree_t *tree_list;
-
-	tree_list=(emem_tree_t *)se_alloc(sizeof(emem_tree_t));
-	tree_list->next=NULL;
-	tree_list->type=type;
-	tree_list->tree=NULL;
-	tree_list->name=name;
-	tree_list->malloc=se_alloc;
-
-	return tree_list;
+	return emem_tree_new(wmem_new(se_tree_mem, emem_tree_t), type, name,
+			     se_tree_mem,
+			     emem_tree_get_stats(se_tree_stats, name, FALSE));
 }
 
 /* This tree is PErmanent and will never be released
@@ -1742,300 +1391,98 @@ se_tree_create_non_persistent(int type, const char *name)
 emem_tree_t *
 pe_tree_create(int type, const char *name)
 {
-	emem_tree_t *tree_list;
-
-	tree_list=g_new(emem_tree_t, 1);
-	tree_list->next=NULL;
-	tree_list->type=type;
-	tree_list->tree=NULL;
-	tree_list->name=name;
-	tree_list->malloc=(void *(*)(size_t)) g_malloc;
-
-	return tree_list;
+	return emem_tree_new(g_new(emem_tree_t, 1), type, name, NULL,
+			     emem_tree_get_stats(pe_tree_stats, name, TRUE));
 }
 
-/* create another (sub)tree using the same memory allocation scope
- * as the parent tree.
- */
-static emem_tree_t *
-emem_tree_create_subtree(emem_tree_t *parent_tree, const char *name)
+void
+emem_tree_insert32(emem_tree_t *se_tree, guint32 key, void *data)
 {
-	emem_tree_t *tree_list;
+	wmem_tree_insert32(emem_tree_get(se_tree), key, data);
+}
 
-	tree_list=(emem_tree_t *)parent_tree->malloc(sizeof(emem_tree_t));
-	tree_list->next=NULL;
-	tree_list->type=parent_tree->type;
-	tree_list->tree=NULL;
-	tree_list->name=name;
-	tree_list->malloc=parent_tree->malloc;
+void *
+emem_tree_lookup32(emem_tree_t *se_tree, guint32 key)
+{
+	if (!se_tree->tree)
+		return NULL;
 
-	return tree_list;
+	return wmem_tree_lookup32(se_tree->tree, key);
 }
 
-static void *
-create_sub_tree(void* d)
+void *
+emem_tree_lookup32_le(emem_tree_t *se_tree, guint32 key)
 {
-	emem_tree_t *se_tree = (emem_tree_t *)d;
-	return emem_tree_create_subtree(se_tree, "subtree");
-}
+	if (!se_tree->tree)
+		return NULL;
 
-/* insert a new node in the tree. if this node matches an already existing node
- * then just replace the data for that node */
+	return wmem_tree_lookup32_le(se_tree->tree, key);
+}
 
-void
-emem_tree_insert32_array(emem_tree_t *se_tree, emem_tree_key_t *key, void *data)
+/* The wmem tree doesn't limit the key length, but anything longer than
+ * this is a dissector bug and should throw rather than be inserted.
+ */
+static void
+emem_tree_check_key(emem_tree_key_t *key)
 {
-	emem_tree_t *insert_tree = NULL;
 	emem_tree_key_t *cur_key;
-	guint32 i, insert_key32 = 0;
 
-	if(!se_tree || !key) return;
+	/* We didn't get a valid key. Should we return NULL instead? */
+	DISSECTOR_ASSERT(key->length > 0);
 
 	for (cur_key = key; cur_key->length > 0; cur_key++) {
 		if(cur_key->length > 100) {
 			DISSECTOR_ASSERT_NOT_REACHED();
 		}
-
-		for (i = 0; i < cur_key->length; i++) {
-			/* Insert using the previous key32 */
-			if (!insert_tree) {
-				insert_tree = se_tree;
-			} else {
-				insert_tree = (emem_tree_t *)lookup_or_insert32(insert_tree, insert_key32, create_sub_tree, se_tree, EMEM_TREE_NODE_IS_SUBTREE);
-			}
-			insert_key32 = cur_key->key[i];
-		}
-	}
-
-	if(!insert_tree) {
-		/* We didn't get a valid key. Should we return NULL instead? */
-		DISSECTOR_ASSERT_NOT_REACHED();
 	}
+}
 
-	emem_tree_insert32(insert_tree, insert_key32, data);
+void
+emem_tree_insert32_array(emem_tree_t *se_tree, emem_tree_key_t *key, void *data)
+{
+	if(!se_tree || !key) return;
 
+	emem_tree_check_key(key);
+	wmem_tree_insert32_array(emem_tree_get(se_tree), key, data);
 }
 
 void *
 emem_tree_lookup32_array(emem_tree_t *se_tree, emem_tree_key_t *key)
 {
-	emem_tree_t *lookup_tree = NULL;
-	emem_tree_key_t *cur_key;
-	guint32 i, lookup_key32 = 0;
-
 	if(!se_tree || !key) return NULL; /* prevent searching on NULL pointer */
 
-	for (cur_key = key; cur_key->length > 0; cur_key++) {
-		if(cur_key->length > 100) {
-			DISSECTOR_ASSERT_NOT_REACHED();
-		}
-
-		for (i = 0; i < cur_key->length; i++) {
-			/* Lookup using the previous key32 */
-			if (!lookup_tree) {
-				lookup_tree = se_tree;
-			} else {
-				lookup_tree = (emem_tree_t *)emem_tree_lookup32(lookup_tree, lookup_key32);
-				if (!lookup_tree) {
-					return NULL;
-				}
-			}
-			lookup_key32 = cur_key->key[i];
-		}
-	}
-
-	if(!lookup_tree) {
-		/* We didn't get a valid key. Should we return NULL instead? */
-		DISSECTOR_ASSERT_NOT_REACHED();
-	}
+	emem_tree_check_key(key);
+	if (!se_tree->tree)
+		return NULL;
 
-	return emem_tree_lookup32(lookup_tree, lookup_key32);
+	return wmem_tree_lookup32_array(se_tree->tree, key);
 }
 
 void *
 emem_tree_lookup32_array_le(emem_tree_t *se_tree, emem_tree_key_t *key)
 {
-	emem_tree_t *lookup_tree = NULL;
-	emem_tree_key_t *cur_key;
-	guint32 i, lookup_key32 = 0;
-
 	if(!se_tree || !key) return NULL; /* prevent searching on NULL pointer */
 
-	for (cur_key = key; cur_key->length > 0; cur_key++) {
-		if(cur_key->length > 100) {
-			DISSECTOR_ASSERT_NOT_REACHED();
-		}
-
-		for (i = 0; i < cur_key->length; i++) {
-			/* Lookup using the previous key32 */
-			if (!lookup_tree) {
-				lookup_tree = se_tree;
-			} else {
-				lookup_tree = (emem_tree_t *)emem_tree_lookup32_le(lookup_tree, lookup_key32);
-				if (!lookup_tree) {
-					return NULL;
-				}
-			}
-			lookup_key32 = cur_key->key[i];
-		}
-	}
-
-	if(!lookup_tree) {
-		/* We didn't get a valid key. Should we return NULL instead? */
-		DISSECTOR_ASSERT_NOT_REACHED();
-	}
-
-	return emem_tree_lookup32_le(lookup_tree, lookup_key32);
+	emem_tree_check_key(key);
+	if (!se_tree->tree)
+		return NULL;
 
+	return wmem_tree_lookup32_array_le(se_tree->tree, key);
 }
 
-/* Strings are stored as an array of uint32 containing the string characters
-   with 4 characters in each uint32.
-   The first byte of the string is stored as the most significant byte.
-   If the string is not a multiple of 4 characters in length the last
-   uint32 containing the string bytes are padded with 0 bytes.
-   After the uint32's containing the string, there is one final terminator
-   uint32 with the value 0x00000001
-*/
 void
 emem_tree_insert_string(emem_tree_t* se_tree, const gchar* k, void* v, guint32 flags)
 {
-	emem_tree_key_t key[2];
-	guint32 *aligned=NULL;
-	guint32 len = (guint32) strlen(k);
-	guint32 divx = (len+3)/4+1;
-	guint32 i;
-	guint32 tmp;
-
-	aligned = (guint32 *)g_malloc(divx * sizeof (guint32));
-
-	/* pack the bytes one one by one into guint32s */
-	tmp = 0;
-	for (i = 0;i < len;i++) {
-		unsigned char ch;
-
-		ch = (unsigned char)k[i];
-		if (flags & EMEM_TREE_STRING_NOCASE) {
-			if(isupper(ch)) {
-				ch = tolower(ch);
-			}
-		}
-		tmp <<= 8;
-		tmp |= ch;
-		if (i%4 == 3) {
-			aligned[i/4] = tmp;
-			tmp = 0;
-		}
-	}
-	/* add required padding to the last uint32 */
-	if (i%4 != 0) {
-		while (i%4 != 0) {
-			i++;
-			tmp <<= 8;
-		}
-		aligned[i/4-1] = tmp;
-	}
-
-	/* add the terminator */
-	aligned[divx-1] = 0x00000001;
-
-	key[0].length = divx;
-	key[0].key = aligned;
-	key[1].length = 0;
-	key[1].key = NULL;
-
-
-	emem_tree_insert32_array(se_tree, key, v);
-	g_free(aligned);
+	wmem_tree_insert_string(emem_tree_get(se_tree), k, v, flags);
 }
 
 void *
 emem_tree_lookup_string(emem_tree_t* se_tree, const gchar* k, guint32 flags)
 {
-	emem_tree_key_t key[2];
-	guint32 *aligned=NULL;
-	guint32 len = (guint) strlen(k);
-	guint32 divx = (len+3)/4+1;
-	guint32 i;
-	guint32 tmp;
-	void *ret;
-
-	aligned = (guint32 *)g_malloc(divx * sizeof (guint32));
-
-	/* pack the bytes one one by one into guint32s */
-	tmp = 0;
-	for (i = 0;i < len;i++) {
-		unsigned char ch;
-
-		ch = (unsigned char)k[i];
-		if (flags & EMEM_TREE_STRING_NOCASE) {
-			if(isupper(ch)) {
-				ch = tolower(ch);
-			}
-		}
-		tmp <<= 8;
-		tmp |= ch;
-		if (i%4 == 3) {
-			aligned[i/4] = tmp;
-			tmp = 0;
-		}
-	}
-	/* add required padding to the last uint32 */
-	if (i%4 != 0) {
-		while (i%4 != 0) {
-			i++;
-			tmp <<= 8;
-		}
-		aligned[i/4-1] = tmp;
-	}
-
-	/* add the terminator */
-	aligned[divx-1] = 0x00000001;
-
-	key[0].length = divx;
-	key[0].key = aligned;
-	key[1].length = 0;
-	key[1].key = NULL;
-
-
-	ret = emem_tree_lookup32_array(se_tree, key);
-	g_free(aligned);
-	return ret;
-}
-
-static gboolean
-emem_tree_foreach_nodes(emem_tree_node_t* node, tree_foreach_func callback, void *user_data)
-{
-	gboolean stop_traverse = FALSE;
-
-	if (!node)
-		return FALSE;
-
-	if(node->left) {
-		stop_traverse = emem_tree_foreach_nodes(node->left, callback, user_data);
-		if (stop_traverse) {
-			return TRUE;
-		}
-	}
-
-	if (node->u.is_subtree == EMEM_TREE_NODE_IS_SUBTREE) {
-		stop_traverse = emem_tree_foreach((emem_tree_t *)node->data, callback, user_data);
-	} else {
-		stop_traverse = callback(node->data, user_data);
-	}
-
-	if (stop_traverse) {
-		return TRUE;
-	}
-
-	if(node->right) {
-		stop_traverse = emem_tree_foreach_nodes(node->right, callback, user_data);
-		if (stop_traverse) {
-			return TRUE;
-		}
-	}
+	if (!se_tree->tree)
+		return NULL;
 
-	return FALSE;
+	return wmem_tree_lookup_string(se_tree->tree, k, flags);
 }
 
 gboolean
@@ -2044,59 +1491,57 @@ emem_tree_foreach(emem_tree_t* emem_tree, tree_foreach_func callback, void *user
 	if (!emem_tree)
 		return FALSE;
 
-	if(!emem_tree->tree)
-		return FALSE;
-
-	return emem_tree_foreach_nodes(emem_tree->tree, callback, user_data);
+	return wmem_tree_foreach(emem_tree->tree, callback, user_data);
 }
 
-static void emem_print_subtree(emem_tree_t* emem_tree, guint32 level);
-
-static void
-emem_tree_print_nodes(const char *prefix, emem_tree_node_t* node, guint32 level)
+void
+emem_print_tree(emem_tree_t* emem_tree)
 {
-	guint32 i;
-
-	if (!node)
+	if (!emem_tree)
 		return;
 
-	for(i=0;i<level;i++){
-		printf("    ");
-	}
-
-	printf("%sNODE:%p parent:%p left:%p right:%p colour:%s key:%u %s:%p\n", prefix,
-		(void *)node,(void *)(node->parent),(void *)(node->left),(void *)(node->right),
-		(node->u.rb_color)?"Black":"Red",(node->key32),(node->u.is_subtree)?"tree":"data",node->data);
-	if(node->left)
-		emem_tree_print_nodes("L-", node->left, level+1);
-	if(node->right)
-		emem_tree_print_nodes("R-", node->right, level+1);
-
-	if (node->u.is_subtree)
-		emem_print_subtree((emem_tree_t *)node->data, level+1);
+	printf("EMEM tree:%p name:%s\n", (void *)emem_tree, emem_tree->name);
+	if (emem_tree->tree)
+		wmem_print_tree(emem_tree->tree);
 }
 
-static void
-emem_print_subtree(emem_tree_t* emem_tree, guint32 level)
+/*
+ * Statistics
+ */
+void
+emem_get_stats(wmem_allocator_stats_t *ep_stats, wmem_allocator_stats_t *se_stats,
+	       wmem_allocator_stats_t *se_tree_stats_out)
 {
-	guint32 i;
+	*ep_stats = ep_packet_mem.stats;
+	*se_stats = se_packet_mem.stats;
+	wmem_allocator_get_stats(se_tree_mem, se_tree_stats_out);
+}
 
-	if (!emem_tree)
-		return;
+typedef struct {
+	emem_tree_stats_func func;
+	void *user_data;
+} emem_tree_stats_foreach_t;
 
-	for(i=0;i<level;i++){
-		printf("    ");
-	}
+static void
+emem_tree_stats_foreach_cb(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	emem_tree_stats_t *stats = (emem_tree_stats_t *)value;
+	emem_tree_stats_foreach_t *ctx = (emem_tree_stats_foreach_t *)user_data;
 
-	printf("EMEM tree:%p type:%s name:%s root:%p\n",emem_tree,(emem_tree->type==1)?"RedBlack":"unknown",emem_tree->name,(void *)(emem_tree->tree));
-	if(emem_tree->tree)
-		emem_tree_print_nodes("Root-", emem_tree->tree, level);
+	if (stats->mem.bytes > stats->peak_bytes)
+		stats->peak_bytes = stats->mem.bytes;
+	ctx->func(stats, ctx->user_data);
 }
 
 void
-emem_print_tree(emem_tree_t* emem_tree)
+emem_tree_stats_foreach(emem_tree_stats_func func, void *user_data)
 {
-	emem_print_subtree(emem_tree, 0);
+	emem_tree_stats_foreach_t ctx;
+
+	ctx.func = func;
+	ctx.user_data = user_data;
+	g_hash_table_foreach(se_tree_stats, emem_tree_stats_foreach_cb, &ctx);
+	g_hash_table_foreach(pe_tree_stats, emem_tree_stats_foreach_cb, &ctx);
 }
 
 /*
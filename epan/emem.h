@@ -29,6 +29,8 @@
 #include <glib.h>
 
 #include "ws_symbol_export.h"
+#include "wmem/wmem_core.h"
+#include "wmem/wmem_tree.h"
 
 /** @file
  */
@@ -206,35 +208,22 @@ struct _emem_chunk_t;
 /**************************************************************
  * binary trees
  **************************************************************/
-typedef struct _emem_tree_node_t {
-	struct _emem_tree_node_t *parent;
-	struct _emem_tree_node_t *left;
-	struct _emem_tree_node_t *right;
-	struct {
-#define EMEM_TREE_RB_COLOR_RED		0
-#define EMEM_TREE_RB_COLOR_BLACK	1
-		guint32 rb_color:1;
-#define EMEM_TREE_NODE_IS_DATA		0
-#define EMEM_TREE_NODE_IS_SUBTREE	1
-		guint32 is_subtree:1;
-	} u;
-	guint32 key32;
-	void *data;
-} emem_tree_node_t;
-
-/** Right now we only do basic red/black trees   but in the future we might want
- * to try something different, such as a tree where each node keeps track
- * of how many times it has been looked up, and letting often looked up
- * nodes bubble upwards in the tree using rotate_right/left.
- * That would probably be good for things like nfs filehandles
+/** The trees are wmem B-trees (see wmem/wmem_tree.h) whose memory is
+ * released together with the SE heap, or never for PE trees.
+ * EMEM_TREE_TYPE_RED_BLACK is still the type to pass to the create
+ * functions; it no longer says anything about the layout of the tree.
  */
 #define EMEM_TREE_TYPE_RED_BLACK	1
+
+struct _emem_tree_stats_t;
+
 typedef struct _emem_tree_t {
 	struct _emem_tree_t *next;
 	int type;
 	const char *name;    /**< just a string to make debugging easier */
-	emem_tree_node_t *tree;
-	void *(*malloc)(size_t);
+	wmem_tree_t *tree;   /**< created on the first insert */
+	wmem_allocator_t *allocator;	/**< NULL for g_malloc() */
+	struct _emem_tree_stats_t *stats;	/**< shared by all trees of this name */
 } emem_tree_t;
 
 /* *******************************************************************
@@ -244,7 +233,7 @@ typedef struct _emem_tree_t {
  * When the SE heap is released back to the system the pointer to the
  * tree is automatically reset to NULL.
  *
- * type is : EMEM_TREE_TYPE_RED_BLACK for a standard red/black tree.
+ * type is : EMEM_TREE_TYPE_RED_BLACK
  */
 WS_DLL_PUBLIC
 emem_tree_t *se_tree_create(int type, const char *name) G_GNUC_MALLOC;
@@ -351,10 +340,7 @@ void *emem_tree_lookup32(emem_tree_t *se_tree, guint32 key);
 WS_DLL_PUBLIC
 void *emem_tree_lookup32_le(emem_tree_t *se_tree, guint32 key);
 
-typedef struct _emem_tree_key_t {
-	guint32 length;			/**< length in guint32 words */
-	guint32 *key;
-} emem_tree_key_t;
+typedef wmem_tree_key_t emem_tree_key_t;
 
 /** This function is used to insert a node indexed by a sequence of guint32
  * key values.
@@ -408,7 +394,7 @@ WS_DLL_PUBLIC
 void *emem_tree_lookup32_array_le(emem_tree_t *se_tree, emem_tree_key_t *key);
 
 /** case insensitive strings as keys */
-#define EMEM_TREE_STRING_NOCASE			0x00000001
+#define EMEM_TREE_STRING_NOCASE			WMEM_TREE_STRING_NOCASE
 /** Insert a new value under a string key */
 WS_DLL_PUBLIC
 void emem_tree_insert_string(emem_tree_t* h, const gchar* k, void* v, guint32 flags);
@@ -424,6 +410,31 @@ typedef gboolean (*tree_foreach_func)(void *value, void *userdata);
 WS_DLL_PUBLIC
 gboolean emem_tree_foreach(emem_tree_t* emem_tree, tree_foreach_func callback, void *user_data);
 
+/* ******************************************************************
+ * Statistics
+ * ****************************************************************** */
+
+/** Memory used by all the trees created under one name */
+typedef struct _emem_tree_stats_t {
+	const char *name;
+	gboolean persistent;	/**< PE trees, never released */
+	guint trees;		/**< trees created under this name so far */
+	wmem_tree_stats_t mem;	/**< memory in use now */
+	gsize peak_bytes;	/**< the most mem.bytes has ever been */
+} emem_tree_stats_t;
+
+/** Get the usage counters of the EP and SE pools and of the pool that
+ * holds the SE trees. */
+WS_DLL_PUBLIC
+void emem_get_stats(wmem_allocator_stats_t *ep_stats, wmem_allocator_stats_t *se_stats,
+		    wmem_allocator_stats_t *se_tree_stats);
+
+typedef void (*emem_tree_stats_func)(const emem_tree_stats_t *stats, void *user_data);
+
+/** Call func for the statistics of every tree name, in no particular order */
+WS_DLL_PUBLIC
+void emem_tree_stats_foreach(emem_tree_stats_func func, void *user_data);
+
 
 /* ******************************************************************
  * String buffers - Growable strings similar to GStrings
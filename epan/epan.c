@@ -255,6 +255,13 @@ epan_dissect_prime_dfilter(epan_dissect_t *edt, const dfilter_t* dfcode)
     dfilter_prime_proto_tree(dfcode, edt->tree);
 }
 
+void
+epan_dissect_set_interest(epan_dissect_t *edt, proto_interest_t *interest)
+{
+    if (edt->tree)
+        proto_tree_set_interest(edt->tree, interest);
+}
+
 /* ----------------------- */
 const gchar *
 epan_custom_set(epan_dissect_t *edt, int field_id,
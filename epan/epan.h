@@ -171,6 +171,13 @@ WS_DLL_PUBLIC
 void
 epan_dissect_prime_dfilter(epan_dissect_t *edt, const dfilter_t *dfcode);
 
+/** Make the proto_tree use a set of interesting fields built once for all
+ * the packets, see proto_interest_new().  Call this right after
+ * epan_dissect_init(); the fields should still be primed as usual. */
+WS_DLL_PUBLIC
+void
+epan_dissect_set_interest(epan_dissect_t *edt, proto_interest_t *interest);
+
 /** fill the dissect run output into the packet list columns */
 WS_DLL_PUBLIC
 void
@@ -273,13 +273,13 @@ frame_data_init(frame_data *fdata, guint32 num,
   fdata->color_filter = NULL;
   fdata->abs_ts.secs = phdr->ts.secs;
   fdata->abs_ts.nsecs = phdr->ts.nsecs;
-  fdata->shift_offset.secs = 0;
-  fdata->shift_offset.nsecs = 0;
   fdata->rel_ts.secs = 0;
   fdata->rel_ts.nsecs = 0;
   fdata->prev_dis = NULL;
   fdata->prev_cap = NULL;
-  fdata->opt_comment = phdr->opt_comment;
+  fdata->cold = NULL;
+  if (phdr->opt_comment)
+    frame_data_set_comment(fdata, phdr->opt_comment);
 }
 
 void
@@ -352,12 +352,55 @@ frame_data_destroy(frame_data *fdata)
     fdata->pfd = NULL;
   }
 
-  if (fdata->opt_comment) {
-    g_free(fdata->opt_comment);
-    fdata->opt_comment = NULL;
+  if (fdata->cold) {
+    g_free(fdata->cold->opt_comment);
+    g_free(fdata->cold);
+    fdata->cold = NULL;
   }
 }
 
+/* Get the cold fields of a frame, allocating them if it has none yet. */
+static frame_data_cold *
+frame_data_get_cold(frame_data *fdata)
+{
+  if (!fdata->cold)
+    fdata->cold = g_new0(frame_data_cold, 1);
+  return fdata->cold;
+}
+
+const gchar *
+frame_data_get_comment(const frame_data *fdata)
+{
+  return fdata->cold ? fdata->cold->opt_comment : NULL;
+}
+
+void
+frame_data_set_comment(frame_data *fdata, gchar *comment)
+{
+  if (!fdata->cold && !comment)
+    return;
+  frame_data_get_cold(fdata);
+  g_free(fdata->cold->opt_comment);
+  fdata->cold->opt_comment = comment;
+}
+
+void
+frame_data_get_shift_offset(const frame_data *fdata, nstime_t *offset)
+{
+  if (fdata->cold)
+    *offset = fdata->cold->shift_offset;
+  else
+    nstime_set_zero(offset);
+}
+
+void
+frame_data_set_shift_offset(frame_data *fdata, const nstime_t *offset)
+{
+  if (!fdata->cold && offset->secs == 0 && offset->nsecs == 0)
+    return;
+  frame_data_get_cold(fdata)->shift_offset = *offset;
+}
+
 /*
  * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
  *
@@ -43,6 +43,14 @@ typedef enum {
 	PACKET_CHAR_ENC_CHAR_EBCDIC	 = 1	/* EBCDIC */
 } packet_char_enc;
 
+/** Per-frame fields that few frames have, kept out of frame_data so that
+   the frames that don't have them don't pay for them.  Use the
+   frame_data_get_ and frame_data_set_ routines to get at them. */
+typedef struct _frame_data_cold {
+  gchar        *opt_comment;  /**< NULL if not available */
+  nstime_t      shift_offset; /**< How much the abs_ts of the frame is shifted */
+} frame_data_cold;
+
 /** The frame number is the ordinal number of the frame in the capture, so
    it's 1-origin.  In various contexts, 0 as a frame number means "frame
    number unknown". */
@@ -73,11 +81,10 @@ typedef struct _frame_data {
   const void *color_filter;  /**< Per-packet matching color_filter_t object */
 
   nstime_t     abs_ts;       /**< Absolute timestamp */
-  nstime_t     shift_offset; /**< How much the abs_tm of the frame is shifted */
   nstime_t     rel_ts;       /**< Relative timestamp (yes, it can be negative) */
   const struct _frame_data *prev_dis;   /**< Previous displayed frame */
   const struct _frame_data *prev_cap;   /**< Previous captured frame */
-  gchar        *opt_comment; /**< NULL if not available */
+  frame_data_cold *cold;     /**< NULL if the frame has no comment and isn't time shifted */
 } frame_data;
 
 #ifdef WANT_PACKET_EDITOR
@@ -100,6 +107,19 @@ WS_DLL_PUBLIC gint frame_data_compare(const frame_data *fdata1, const frame_data
 
 WS_DLL_PUBLIC void frame_data_reset(frame_data *fdata);
 
+/** Get the comment of a frame, NULL if it has none. */
+WS_DLL_PUBLIC const gchar *frame_data_get_comment(const frame_data *fdata);
+
+/** Replace the comment of a frame, freeing the old one; the frame takes
+   ownership of the new comment, which may be NULL to remove it. */
+WS_DLL_PUBLIC void frame_data_set_comment(frame_data *fdata, gchar *comment);
+
+/** Get how much the time stamp of a frame is shifted. */
+WS_DLL_PUBLIC void frame_data_get_shift_offset(const frame_data *fdata, nstime_t *offset);
+
+/** Set how much the time stamp of a frame is shifted. */
+WS_DLL_PUBLIC void frame_data_set_shift_offset(frame_data *fdata, const nstime_t *offset);
+
 WS_DLL_PUBLIC void frame_data_destroy(frame_data *fdata);
 
 WS_DLL_PUBLIC void frame_data_init(frame_data *fdata, guint32 num,
@@ -214,6 +214,9 @@ typedef struct _packet_info {
   GSList *frame_end_routines;
 
   struct _wmem_allocator_t *pool;      /**< Memory pool scoped to the pinfo struct */
+  struct _reassembly_shown *reassembly_evictions_shown; /**< reassembly tables that reported the reassemblies
+                                                          * they discarded in this frame during this dissection
+                                                          */
 } packet_info;
 
 /**< For old code that hasn't yet been changed. */
@@ -2355,6 +2355,22 @@ prefs_register_modules(void)
                                    "Display all hidden protocol items in the packet list.",
                                    &prefs.display_hidden_proto_items);
 
+    prefs_register_uint_preference(protocols_module, "reassembly_memory_limit",
+                                   "Reassembly memory limit (KB)",
+                                   "Maximum memory held by the incomplete reassemblies of a "
+                                   "protocol that allows it (IPv4, IPv6); the oldest ones are "
+                                   "discarded beyond it. 0 means no limit.",
+                                   10,
+                                   &prefs.reassembly_memory_limit);
+
+    prefs_register_uint_preference(protocols_module, "reassembly_timeout",
+                                   "Reassembly timeout (s)",
+                                   "Discard incomplete reassemblies of a protocol that allows "
+                                   "it (IPv4, IPv6) that got no fragment for this many seconds "
+                                   "of capture time. 0 means no timeout.",
+                                   10,
+                                   &prefs.reassembly_timeout);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -2778,6 +2794,8 @@ pre_init_prefs(void)
   prefs.rtp_player_max_visible = RTP_PLAYER_DEFAULT_VISIBLE;
 
   prefs.display_hidden_proto_items = FALSE;
+  prefs.reassembly_memory_limit    = 0;
+  prefs.reassembly_timeout         = 0;
 
   prefs_pre_initialized = TRUE;
 }
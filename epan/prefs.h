@@ -196,6 +196,8 @@ typedef struct _e_prefs {
   guint        rtp_player_max_visible;
   guint        tap_update_interval;
   gboolean     display_hidden_proto_items;
+  guint        reassembly_memory_limit;	/* KB, 0 for no limit */
+  guint        reassembly_timeout;	/* seconds, 0 for no timeout */
   gpointer     filter_expressions;	/* Actually points to &head */
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
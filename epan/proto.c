@@ -260,20 +260,170 @@ static GList *protocols = NULL;
 
 #define INITIAL_NUM_PROTOCOL_HFINFO	1500
 
+/*
+ * A slab hands out items of one size from a single chunk of memory, and
+ * is reset rather than freed.  If a tree needs more items than the chunk
+ * holds, more chunks are added, and on the next reset they're replaced by
+ * one chunk big enough for all of them; so after a few packets the items
+ * of a tree come from one chunk sized for the largest tree seen.
+ */
+#define PROTO_SLAB_MIN_ITEMS	256
+
+typedef struct {
+	gsize	 item_size;
+	guint8	*chunk;		/* the chunk items are taken from */
+	guint	 used;		/* items taken from it */
+	guint	 size;		/* items it holds */
+	GSList	*full;		/* chunks filled since the last reset */
+	guint	 full_items;	/* items they hold */
+} proto_slab_t;
+
+static void
+proto_slab_init(proto_slab_t *slab, gsize item_size)
+{
+	slab->item_size  = item_size;
+	slab->chunk      = NULL;
+	slab->used       = 0;
+	slab->size       = 0;
+	slab->full       = NULL;
+	slab->full_items = 0;
+}
+
+static void *
+proto_slab_alloc(proto_slab_t *slab)
+{
+	if (slab->used == slab->size) {
+		if (slab->chunk != NULL) {
+			slab->full = g_slist_prepend(slab->full, slab->chunk);
+			slab->full_items += slab->size;
+		}
+		slab->size = slab->size ? slab->size * 2 : PROTO_SLAB_MIN_ITEMS;
+		slab->chunk = (guint8 *)g_malloc(slab->size * slab->item_size);
+		slab->used = 0;
+	}
+	return slab->chunk + slab->item_size * slab->used++;
+}
+
+static void
+proto_slab_free_chunks(proto_slab_t *slab)
+{
+	GSList *chunk;
+
+	for (chunk = slab->full; chunk != NULL; chunk = chunk->next)
+		g_free(chunk->data);
+	g_slist_free(slab->full);
+	slab->full = NULL;
+	slab->full_items = 0;
+	g_free(slab->chunk);
+	slab->chunk = NULL;
+}
+
+static void
+proto_slab_reset(proto_slab_t *slab)
+{
+	if (slab->full != NULL) {
+		guint items = slab->full_items + slab->used;
+
+		proto_slab_free_chunks(slab);
+		slab->size = items;
+		slab->chunk = (guint8 *)g_malloc(slab->size * slab->item_size);
+	}
+	slab->used = 0;
+}
+
+/*
+ * A set of interesting fields; see proto_interest_new().  A field is in
+ * the set if its bit in "hfids" is set; its dense index is the number of
+ * bits set before it, which "rank" holds for the start of every word.
+ */
+struct _proto_interest {
+	guint32	     *hfids;		/* bitmap of the fields in the set */
+	guint32	     *rank;		/* bits set in the words before each */
+	guint	      words;		/* in both */
+	guint	      num_hfids;	/* bits set in all of them */
+	gboolean      compiled;		/* rank is up to date */
+
+	GPtrArray   **finfos;		/* the field_infos for each field in
+					 * the tree using the set, by dense
+					 * index; created on first use */
+	guint	      num_finfos;	/* number of entries in finfos */
+	guint	     *used;		/* dense indexes of the arrays in
+					 * finfos the tree has added to */
+	guint	      num_used;
+
+	proto_tree   *tree;		/* the tree using the set, if any */
+	proto_slab_t  finfo_slab;	/* items of that tree */
+	proto_slab_t  node_slab;
+};
+
 /* Contains information about a field when a dissector calls
- * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(fi)  fi = g_slice_new(field_info)
-#define FIELD_INFO_FREE(fi) g_slice_free(field_info, fi)
+ * proto_tree_add_item.  Trees using a proto_interest_t take them from
+ * its slab, which is reset when the tree is freed. */
+#define FIELD_INFO_NEW(tree_data, fi)					\
+	fi = (tree_data)->interest ?					\
+	    (field_info *)proto_slab_alloc(&(tree_data)->interest->finfo_slab) : \
+	    g_slice_new(field_info)
+#define FIELD_INFO_FREE(tree_data, fi)					\
+	do {								\
+		if (!(tree_data)->interest)				\
+			g_slice_free(field_info, fi);			\
+	} while (0)
 
 /* Contains the space for proto_nodes. */
-#define PROTO_NODE_NEW(node)				\
-	node = g_slice_new(proto_node);			\
-	node->first_child = NULL;			\
-	node->last_child = NULL;			\
+#define PROTO_NODE_NEW(tree_data, node)					\
+	node = (tree_data)->interest ?					\
+	    (proto_node *)proto_slab_alloc(&(tree_data)->interest->node_slab) : \
+	    g_slice_new(proto_node);					\
+	node->first_child = NULL;					\
+	node->last_child = NULL;					\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(node)				\
-	g_slice_free(proto_node, node)
+#define PROTO_NODE_FREE(tree_data, node)				\
+	do {								\
+		if (!(tree_data)->interest)				\
+			g_slice_free(proto_node, node);			\
+	} while (0)
+
+/* Count the bits set in a word */
+static inline guint
+proto_interest_popcount(guint32 word)
+{
+	word = word - ((word >> 1) & 0x55555555);
+	word = (word & 0x33333333) + ((word >> 2) & 0x33333333);
+	word = (word + (word >> 4)) & 0x0F0F0F0F;
+	return (word * 0x01010101) >> 24;
+}
+
+static inline gboolean
+proto_interest_has(const proto_interest_t *interest, const int hfid)
+{
+	return (guint)hfid < interest->words * 32 &&
+	    (interest->hfids[hfid / 32] & (1U << (hfid % 32))) != 0;
+}
+
+/* The dense index of a field in a compiled set */
+static inline guint
+proto_interest_index(const proto_interest_t *interest, const int hfid)
+{
+	return interest->rank[hfid / 32] +
+	    proto_interest_popcount(interest->hfids[hfid / 32] &
+				    ((1U << (hfid % 32)) - 1));
+}
+
+/* The tree using the set is being freed */
+static void
+proto_interest_release(proto_interest_t *interest)
+{
+	guint i;
+
+	for (i = 0; i < interest->num_used; i++)
+		g_ptr_array_set_size(interest->finfos[interest->used[i]], 0);
+	interest->num_used = 0;
+
+	proto_slab_reset(&interest->finfo_slab);
+	proto_slab_reset(&interest->node_slab);
+	interest->tree = NULL;
+}
 
 /* String space for protocol and field items for the GUI */
 #define ITEM_LABEL_NEW(il)				\
@@ -561,32 +711,35 @@ free_node_tree_data(tree_data_t *tree_data)
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
 	if (tree_data->fi_tmp)
-		FIELD_INFO_FREE(tree_data->fi_tmp);
+		FIELD_INFO_FREE(tree_data, tree_data->fi_tmp);
+	if (tree_data->interest)
+		proto_interest_release(tree_data->interest);
 
 	/* And finally the tree_data_t itself. */
 	g_free(tree_data);
 }
 
-#define FREE_NODE_FIELD_INFO(finfo)	\
+#define FREE_NODE_FIELD_INFO(tree_data, finfo)	\
 	if (finfo->rep) {			\
 		ITEM_LABEL_FREE(finfo->rep);	\
 	}				\
 	FVALUE_CLEANUP(&finfo->value);	\
-	FIELD_INFO_FREE(finfo);
+	FIELD_INFO_FREE(tree_data, finfo);
 
 static void
 proto_tree_free_node(proto_node *node, gpointer data _U_)
 {
+	tree_data_t *tree_data = PTREE_DATA(node);
 	field_info *finfo  = PNODE_FINFO(node);
 
 	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
 
 	/* free the field_info data. */
-	FREE_NODE_FIELD_INFO(finfo);
+	FREE_NODE_FIELD_INFO(tree_data, finfo);
 	node->finfo = NULL;
 
 	/* Free the proto_node. */
-	PROTO_NODE_FREE(node);
+	PROTO_NODE_FREE(tree_data, node);
 }
 
 /* frees the resources that the dissection a proto_tree uses */
@@ -597,8 +750,8 @@ proto_tree_free(proto_tree *tree)
 
 	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
 
-	/* free root node */
-	PROTO_NODE_FREE(tree);
+	/* free root node; it's never taken from a slab */
+	g_slice_free(proto_node, tree);
 
 	/* free tree data */
 	free_node_tree_data(tree_data);
@@ -1173,6 +1326,21 @@ proto_lookup_or_create_interesting_hfids(proto_tree *tree,
 	DISSECTOR_ASSERT(hfinfo);
 
 	if (hfinfo->ref_type == HF_REF_TYPE_DIRECT) {
+		proto_interest_t *interest = PTREE_DATA(tree)->interest;
+
+		if (interest != NULL && proto_interest_has(interest, hfinfo->id)) {
+			guint idx = proto_interest_index(interest, hfinfo->id);
+
+			ptrs = interest->finfos[idx];
+			if (ptrs == NULL) {
+				ptrs = g_ptr_array_new();
+				interest->finfos[idx] = ptrs;
+			}
+			if (ptrs->len == 0)
+				interest->used[interest->num_used++] = idx;
+			return ptrs;
+		}
+
 		if (PTREE_DATA(tree)->interesting_hfids == NULL) {
 			/* Initialize the hash because we now know that it is needed */
 			PTREE_DATA(tree)->interesting_hfids =
@@ -1221,7 +1389,7 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 		 * good thing we saved it, now we can reverse the
 		 * memory leak and reclaim it.
 		 */
-		FIELD_INFO_FREE(tree_data->fi_tmp);
+		FIELD_INFO_FREE(tree_data, tree_data->fi_tmp);
 	}
 	/* we might throw an exception, keep track of this one
 	 * across the "dangerous" section below.
@@ -3413,7 +3581,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 	DISSECTOR_ASSERT(tfi == NULL ||
 		(tfi->tree_type >= 0 && tfi->tree_type < num_tree_types));
 
-	PROTO_NODE_NEW(pnode);
+	PROTO_NODE_NEW(PTREE_DATA(tree), pnode);
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
 	pnode->tree_data = PTREE_DATA(tree);
@@ -3602,7 +3770,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(fi);
+	FIELD_INFO_NEW(PTREE_DATA(tree), fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -4283,8 +4451,12 @@ proto_tree_create_root(packet_info *pinfo)
 {
 	proto_node *pnode;
 
-	/* Initialize the proto_node */
-	PROTO_NODE_NEW(pnode);
+	/* Initialize the proto_node; the root is never taken from a slab,
+	 * as the tree doesn't use a set of interesting fields yet */
+	pnode = g_slice_new(proto_node);
+	pnode->first_child = NULL;
+	pnode->last_child = NULL;
+	pnode->next = NULL;
 	pnode->parent = NULL;
 	PNODE_FINFO(pnode) = NULL;
 	pnode->tree_data = g_new(tree_data_t, 1);
@@ -4294,6 +4466,7 @@ proto_tree_create_root(packet_info *pinfo)
 
 	/* Don't initialize the tree_data_t. Wait until we know we need it */
 	pnode->tree_data->interesting_hfids = NULL;
+	pnode->tree_data->interest = NULL;
 
 	/* Set the default to FALSE so it's easier to
 	 * find errors; if we expect to see the protocol tree
@@ -4341,6 +4514,115 @@ proto_tree_prime_hfid(proto_tree *tree _U_, const gint hfid)
 	}
 }
 
+proto_interest_t *
+proto_interest_new(void)
+{
+	proto_interest_t *interest = g_new0(proto_interest_t, 1);
+
+	proto_slab_init(&interest->finfo_slab, sizeof(field_info));
+	proto_slab_init(&interest->node_slab, sizeof(proto_node));
+
+	return interest;
+}
+
+void
+proto_interest_add_hfid(proto_interest_t *interest, const int hfid)
+{
+	guint word = (guint)hfid / 32;
+
+	/* Dense indexes change; only do this while no tree is using it */
+	g_assert(interest->tree == NULL);
+
+	proto_tree_prime_hfid(NULL, hfid);
+
+	if (word >= interest->words) {
+		guint words = MAX(word + 1, gpa_hfinfo.len / 32 + 1);
+
+		interest->hfids = (guint32 *)g_realloc(interest->hfids, words * sizeof(guint32));
+		memset(interest->hfids + interest->words, 0,
+		       (words - interest->words) * sizeof(guint32));
+		interest->rank = (guint32 *)g_realloc(interest->rank, words * sizeof(guint32));
+		interest->words = words;
+	}
+	if (!proto_interest_has(interest, hfid)) {
+		interest->hfids[word] |= 1U << (hfid % 32);
+		interest->compiled = FALSE;
+	}
+}
+
+static void
+proto_interest_compile(proto_interest_t *interest)
+{
+	guint i, n = 0;
+
+	for (i = 0; i < interest->words; i++) {
+		interest->rank[i] = n;
+		n += proto_interest_popcount(interest->hfids[i]);
+	}
+	interest->num_hfids = n;
+
+	/* The arrays are all empty between trees, so the ones we have
+	 * can be handed out again under their new indexes */
+	if (n > interest->num_finfos) {
+		interest->finfos = (GPtrArray **)g_realloc(interest->finfos, n * sizeof(GPtrArray *));
+		memset(interest->finfos + interest->num_finfos, 0,
+		       (n - interest->num_finfos) * sizeof(GPtrArray *));
+		interest->num_finfos = n;
+		interest->used = (guint *)g_realloc(interest->used, n * sizeof(guint));
+	}
+	interest->compiled = TRUE;
+}
+
+void
+proto_interest_free(proto_interest_t *interest)
+{
+	guint i;
+	int hfid;
+
+	g_assert(interest->tree == NULL);
+
+	/* Drop the references, as freeing a primed tree does */
+	for (hfid = 0; (guint)hfid < interest->words * 32; hfid++) {
+		header_field_info *hfinfo;
+
+		if (!proto_interest_has(interest, hfid))
+			continue;
+		PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
+		if (hfinfo->parent != -1) {
+			header_field_info *parent_hfinfo;
+			PROTO_REGISTRAR_GET_NTH(hfinfo->parent, parent_hfinfo);
+			parent_hfinfo->ref_type = HF_REF_TYPE_NONE;
+		}
+		hfinfo->ref_type = HF_REF_TYPE_NONE;
+	}
+
+	for (i = 0; i < interest->num_finfos; i++) {
+		if (interest->finfos[i] != NULL)
+			g_ptr_array_free(interest->finfos[i], TRUE);
+	}
+	g_free(interest->finfos);
+	g_free(interest->used);
+	g_free(interest->hfids);
+	g_free(interest->rank);
+	proto_slab_free_chunks(&interest->finfo_slab);
+	proto_slab_free_chunks(&interest->node_slab);
+	g_free(interest);
+}
+
+gboolean
+proto_tree_set_interest(proto_tree *tree, proto_interest_t *interest)
+{
+	if (!tree || interest->tree != NULL || tree->first_child != NULL)
+		return FALSE;
+
+	if (!interest->compiled)
+		proto_interest_compile(interest);
+
+	interest->tree = tree;
+	PTREE_DATA(tree)->interest = interest;
+	return TRUE;
+}
+
 proto_tree *
 proto_item_add_subtree(proto_item *pi,	const gint idx) {
 	field_info *fi;
@@ -6296,9 +6578,19 @@ proto_check_for_protocol_or_field(const proto_tree* tree, const int id)
 GPtrArray *
 proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 {
+	const proto_interest_t *interest;
+
 	if (!tree)
 		return NULL;
 
+	interest = PTREE_DATA(tree)->interest;
+	if (interest != NULL && proto_interest_has(interest, id)) {
+		GPtrArray *ptrs = interest->finfos[proto_interest_index(interest, id)];
+
+		/* As with the hash, there's no array until the field is seen */
+		return (ptrs != NULL && ptrs->len != 0) ? ptrs : NULL;
+	}
+
 	if (PTREE_DATA(tree)->interesting_hfids != NULL)
 		return (GPtrArray *)g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
 					   GINT_TO_POINTER(id));
@@ -6312,7 +6604,9 @@ proto_tracking_interesting_fields(const proto_tree *tree)
 	if (!tree)
 		return FALSE;
 
-	return (PTREE_DATA(tree)->interesting_hfids != NULL);
+	return (PTREE_DATA(tree)->interesting_hfids != NULL ||
+		(PTREE_DATA(tree)->interest != NULL &&
+		 PTREE_DATA(tree)->interest->num_used != 0));
 }
 
 /* Helper struct for proto_find_info() and	proto_all_finfos() */
@@ -464,10 +464,14 @@ typedef struct
 #define FI_GET_BITS_OFFSET(fi) (FI_GET_FLAG(fi, FI_BITS_OFFSET(7)) >> 5)
 #define FI_GET_BITS_SIZE(fi)   (FI_GET_FLAG(fi, FI_BITS_SIZE(63)) >> 8)
 
+/** A compiled set of interesting fields, see proto_interest_new(). */
+typedef struct _proto_interest proto_interest_t;
+
 /** One of these exists for the entire protocol tree. Each proto_node
  * in the protocol tree points to the same copy. */
 typedef struct {
     GHashTable  *interesting_hfids;
+    proto_interest_t *interest;
     gboolean     visible;
     gboolean     fake_protocols;
     gint         count;
@@ -729,6 +733,40 @@ proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols);
 extern void
 proto_tree_prime_hfid(proto_tree *tree, const int hfid);
 
+/** Create an empty set of interesting fields.
+    A proto_interest_t holds what proto_tree_prime_hfid() would have to
+    set up again for every packet: which fields are interesting, compiled
+    into a bitmap, and an array of field_info pointers for each of them,
+    found through a dense index rather than a hash lookup. A tree using it
+    also carves its items from a slab owned by the set, which is reset
+    rather than freed when the tree is freed. Build one per filter and
+    column set and attach it to every tree dissected with that set.
+ @return the new, empty set */
+WS_DLL_PUBLIC proto_interest_t *
+proto_interest_new(void);
+
+/** Add a field/protocol ID to a set of interesting fields. This marks it as
+    referenced, as proto_tree_prime_hfid() does.
+ @param interest the set
+ @param hfid the interesting field id */
+WS_DLL_PUBLIC void
+proto_interest_add_hfid(proto_interest_t *interest, const int hfid);
+
+/** Free a set of interesting fields. No tree may be using it.
+ @param interest the set */
+WS_DLL_PUBLIC void
+proto_interest_free(proto_interest_t *interest);
+
+/** Make a tree use a set of interesting fields, until the tree is freed.
+    This must be done before anything is added to the tree, and only one
+    tree at a time can use a set. Fields primed with proto_tree_prime_hfid()
+    that aren't in the set are still tracked, just more slowly.
+ @param tree the tree to be set
+ @param interest the set
+ @return TRUE if the tree uses the set, FALSE if it couldn't */
+WS_DLL_PUBLIC gboolean
+proto_tree_set_interest(proto_tree *tree, proto_interest_t *interest);
+
 /** Get a parent item of a subtree.
  @param tree the tree to get the parent from
  @return parent item */
@@ -27,6 +27,9 @@
 #include <string.h>
 
 #include <epan/packet.h>
+#include <epan/emem.h>
+#include <epan/expert.h>
+#include <epan/prefs.h>
 
 #include <epan/reassemble.h>
 
@@ -404,6 +407,343 @@ free_fragments(gpointer data, gpointer user_data _U_)
 	g_slice_free(fragment_data, fd_head);
 }
 
+/*
+ * A reassembly in progress in a table with limits, see
+ * reassembly_table_set_limits().  They are kept in a list ordered by when
+ * a fragment was last added to them, so the ones to throw away first are
+ * at the front.
+ */
+typedef struct _reassembly_pending {
+	struct _reassembly_pending *prev;
+	struct _reassembly_pending *next;
+	fragment_data *fd_head;
+	gpointer key;		/* the key of fd_head in the fragment table */
+	time_t	last_added;	/* packet time of the last fragment added */
+	gsize	bytes;
+} reassembly_pending;
+
+/*
+ * What was thrown away in a frame, to report it again on later passes.
+ */
+typedef struct {
+	guint	count;
+	guint64	bytes;
+} reassembly_eviction;
+
+/*
+ * A table that has reported again, in the current dissection of a frame,
+ * what was thrown away in the frame; see reassembly_show_evictions().
+ */
+typedef struct _reassembly_shown {
+	const reassembly_table		*table;
+	struct _reassembly_shown	*next;
+} reassembly_shown;
+
+/*
+ * All the tables that have been initialized, for reassembly_table_foreach().
+ */
+static GSList *reassembly_tables = NULL;
+
+static gsize
+reassembly_table_max_bytes(const reassembly_table *table)
+{
+	if (table->max_bytes == REASSEMBLY_LIMIT_FROM_PREFS)
+		return (gsize)prefs.reassembly_memory_limit * 1024;
+	return table->max_bytes;
+}
+
+static guint32
+reassembly_table_timeout(const reassembly_table *table)
+{
+	if (table->timeout == REASSEMBLY_LIMIT_FROM_PREFS)
+		return prefs.reassembly_timeout;
+	return table->timeout;
+}
+
+/*
+ * The memory held by a reassembly: the fragment_data structures and the
+ * fragment data they own.
+ */
+static gsize
+fragment_chain_bytes(const fragment_data *fd_head)
+{
+	const fragment_data *fd;
+	gsize bytes = sizeof(fragment_data);
+
+	for (fd = fd_head->next; fd != NULL; fd = fd->next) {
+		bytes += sizeof(fragment_data);
+		if (fd->data && !(fd->flags & FD_NOT_MALLOCED))
+			bytes += fd->len;
+	}
+	return bytes;
+}
+
+static void
+reassembly_pending_unlink(reassembly_table *table, reassembly_pending *pending)
+{
+	if (pending->prev)
+		pending->prev->next = pending->next;
+	else
+		table->pending_oldest = pending->next;
+	if (pending->next)
+		pending->next->prev = pending->prev;
+	else
+		table->pending_newest = pending->prev;
+	table->pending_bytes -= pending->bytes;
+}
+
+/*
+ * Stop keeping track of a reassembly, because it's complete or has been
+ * deleted.
+ */
+static void
+reassembly_forget(reassembly_table *table, fragment_data *fd_head)
+{
+	reassembly_pending *pending;
+
+	if (table->pending_table == NULL || fd_head == NULL)
+		return;
+
+	pending = (reassembly_pending *)g_hash_table_lookup(table->pending_table, fd_head);
+	if (pending == NULL)
+		return;
+
+	reassembly_pending_unlink(table, pending);
+	g_hash_table_remove(table->pending_table, fd_head);
+	g_slice_free(reassembly_pending, pending);
+}
+
+static void
+reassembly_forget_all(reassembly_table *table)
+{
+	reassembly_pending *pending, *next;
+
+	for (pending = table->pending_oldest; pending != NULL; pending = next) {
+		next = pending->next;
+		g_slice_free(reassembly_pending, pending);
+	}
+	table->pending_oldest = NULL;
+	table->pending_newest = NULL;
+	table->pending_bytes = 0;
+	if (table->pending_table != NULL) {
+		g_hash_table_destroy(table->pending_table);
+		table->pending_table = NULL;
+	}
+	if (table->eviction_table != NULL) {
+		g_hash_table_destroy(table->eviction_table);
+		table->eviction_table = NULL;
+	}
+}
+
+static void
+reassembly_report_eviction(reassembly_table *table, const packet_info *pinfo,
+			   const guint count, const guint64 bytes)
+{
+	expert_add_info_format((packet_info *)pinfo, NULL, PI_REASSEMBLE, PI_WARN,
+	    "%u incomplete %s reassembl%s (%" G_GINT64_MODIFIER "u bytes) discarded to stay within the reassembly limits",
+	    count, table->name ? table->name : "", count == 1 ? "y" : "ies",
+	    bytes);
+}
+
+/*
+ * On a later pass, report again what was thrown away in this frame on the
+ * first one.  A frame can add several fragments to a table; it's reported
+ * once per dissection, which pinfo keeps track of.
+ */
+static void
+reassembly_show_evictions(reassembly_table *table, const packet_info *pinfo)
+{
+	/* pinfo is const in the reassembly API; see reassembly_report_eviction() */
+	packet_info *mpinfo = (packet_info *)pinfo;
+	reassembly_eviction *eviction;
+	reassembly_shown *shown;
+
+	if (table->eviction_table == NULL)
+		return;
+
+	eviction = (reassembly_eviction *)g_hash_table_lookup(table->eviction_table,
+	    GUINT_TO_POINTER(pinfo->fd->num));
+	if (eviction == NULL)
+		return;
+
+	for (shown = mpinfo->reassembly_evictions_shown; shown != NULL;
+	     shown = shown->next) {
+		if (shown->table == table)
+			return;
+	}
+	/* packet_info is cleared, and ep memory freed, for every dissection */
+	shown = ep_new(reassembly_shown);
+	shown->table = table;
+	shown->next = mpinfo->reassembly_evictions_shown;
+	mpinfo->reassembly_evictions_shown = shown;
+	reassembly_report_eviction(table, pinfo, eviction->count,
+	    eviction->bytes);
+}
+
+/*
+ * Throw away a reassembly in progress, as fragment_delete() would.
+ */
+static void
+reassembly_evict(reassembly_table *table, reassembly_pending *pending)
+{
+	fragment_data *fd_head = pending->fd_head;
+
+	reassembly_pending_unlink(table, pending);
+	g_hash_table_remove(table->pending_table, fd_head);
+
+	/*
+	 * A reassembly that got more fragments after it was complete is
+	 * back in the list; it has to stay for later passes.
+	 */
+	if (!(fd_head->flags & FD_DEFRAGMENTED)) {
+		table->evicted++;
+		table->evicted_bytes += pending->bytes;
+
+		/* This frees the key */
+		g_hash_table_remove(table->fragment_table, pending->key);
+		free_all_fragments(NULL, fd_head, NULL);
+	}
+
+	g_slice_free(reassembly_pending, pending);
+}
+
+/*
+ * A fragment of "frag_data_len" bytes is about to be added to the
+ * reassembly in progress "fd_head" on the first pass.  If the table has
+ * limits, move the reassembly to the end of the list and throw away the
+ * ones at the front that are past them.
+ *
+ * The bytes of a reassembly are counted again every time a fragment is
+ * added to it, with an estimate for the new fragment; adding it walks the
+ * list of fragments anyway, and it may throw an exception.
+ */
+static void
+reassembly_touch(reassembly_table *table, fragment_data *fd_head,
+		 gpointer key, const packet_info *pinfo,
+		 const guint32 frag_data_len)
+{
+	reassembly_pending *pending;
+	reassembly_eviction *eviction;
+	gsize max_bytes = reassembly_table_max_bytes(table);
+	guint32 timeout = reassembly_table_timeout(table);
+	guint count = 0;
+	guint64 bytes = 0;
+
+	if (max_bytes == 0 && timeout == 0)
+		return;
+
+	if (table->pending_table == NULL)
+		table->pending_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	pending = (reassembly_pending *)g_hash_table_lookup(table->pending_table, fd_head);
+	if (pending == NULL) {
+		pending = g_slice_new(reassembly_pending);
+		pending->fd_head = fd_head;
+		g_hash_table_insert(table->pending_table, fd_head, pending);
+	} else {
+		reassembly_pending_unlink(table, pending);
+	}
+	pending->key = key;
+	pending->last_added = pinfo->fd->abs_ts.secs;
+	pending->bytes = fragment_chain_bytes(fd_head) +
+	    sizeof(fragment_data) + frag_data_len;
+
+	pending->prev = table->pending_newest;
+	pending->next = NULL;
+	if (table->pending_newest)
+		table->pending_newest->next = pending;
+	else
+		table->pending_oldest = pending;
+	table->pending_newest = pending;
+	table->pending_bytes += pending->bytes;
+
+	/*
+	 * Never throw away the reassembly we're adding to; our caller is
+	 * about to use it.
+	 */
+	while (table->pending_oldest != pending) {
+		reassembly_pending *oldest = table->pending_oldest;
+
+		if (!(timeout != 0 &&
+		      pending->last_added - oldest->last_added > (time_t)timeout) &&
+		    !(max_bytes != 0 && table->pending_bytes > max_bytes))
+			break;
+
+		if (!(oldest->fd_head->flags & FD_DEFRAGMENTED)) {
+			count++;
+			bytes += oldest->bytes;
+		}
+		reassembly_evict(table, oldest);
+	}
+
+	if (count == 0)
+		return;
+
+	if (table->eviction_table == NULL)
+		table->eviction_table = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, NULL, g_free);
+	eviction = (reassembly_eviction *)g_hash_table_lookup(table->eviction_table,
+	    GUINT_TO_POINTER(pinfo->fd->num));
+	if (eviction == NULL) {
+		eviction = g_new0(reassembly_eviction, 1);
+		g_hash_table_insert(table->eviction_table,
+		    GUINT_TO_POINTER(pinfo->fd->num), eviction);
+	}
+	eviction->count += count;
+	eviction->bytes += bytes;
+
+	reassembly_report_eviction(table, pinfo, count, bytes);
+}
+
+void
+reassembly_table_set_limits(reassembly_table *table, const gsize max_bytes,
+			    const guint32 timeout)
+{
+	table->max_bytes = max_bytes;
+	table->timeout = timeout;
+}
+
+static void
+count_pending_fragments(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	const fragment_data *fd_head = (const fragment_data *)value;
+	reassembly_table_stats_t *stats = (reassembly_table_stats_t *)user_data;
+
+	if (fd_head->flags & FD_DEFRAGMENTED)
+		return;
+
+	stats->live++;
+	stats->bytes += fragment_chain_bytes(fd_head);
+}
+
+void
+reassembly_table_get_stats(reassembly_table *table,
+			   reassembly_table_stats_t *stats)
+{
+	stats->name = table->name;
+	stats->live = 0;
+	stats->bytes = 0;
+	stats->evicted = table->evicted;
+	stats->evicted_bytes = table->evicted_bytes;
+
+	/*
+	 * Count what's in the table rather than keeping counts up to
+	 * date, so that tables without limits don't pay for this.
+	 */
+	if (table->fragment_table != NULL)
+		g_hash_table_foreach(table->fragment_table,
+		    count_pending_fragments, stats);
+}
+
+void
+reassembly_table_foreach(reassembly_table_func func, void *user_data)
+{
+	GSList *item;
+
+	for (item = reassembly_tables; item != NULL; item = item->next)
+		func((reassembly_table *)item->data, user_data);
+}
+
 /*
  * Initialize a reassembly table, with specified functions.
  */
@@ -417,6 +757,11 @@ reassembly_table_init(reassembly_table *table,
 		table->persistent_key_func = funcs->persistent_key_func;
 	if (table->free_temporary_key_func == NULL)
 		table->free_temporary_key_func = funcs->free_temporary_key_func;
+	if (g_slist_find(reassembly_tables, table) == NULL)
+		reassembly_tables = g_slist_prepend(reassembly_tables, table);
+	reassembly_forget_all(table);
+	table->evicted = 0;
+	table->evicted_bytes = 0;
 	if (table->fragment_table != NULL) {
 		/*
 		 * The fragment hash table exists.
@@ -470,6 +815,8 @@ reassembly_table_destroy(reassembly_table *table)
 	table->temporary_key_func = NULL;
 	table->persistent_key_func = NULL;
 	table->free_temporary_key_func = NULL;
+	reassembly_tables = g_slist_remove(reassembly_tables, table);
+	reassembly_forget_all(table);
 	if (table->fragment_table != NULL) {
 		/*
 		 * The fragment hash table exists.
@@ -555,6 +902,10 @@ insert_fd_head(reassembly_table *table, fragment_data *fd_head,
 	 */
 	key = table->persistent_key_func(pinfo, id, data);
 	g_hash_table_insert(table->fragment_table, key, fd_head);
+
+	/* Name the table after the first protocol to use it */
+	if (table->name == NULL)
+		table->name = pinfo->current_proto;
 	return key;
 }
 
@@ -584,7 +935,9 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		return NULL;
 	}
 
-	fd_data=fd_head->data; 
+	reassembly_forget(table, fd_head);
+
+	fd_data=fragment_get_data(fd_head);
 	/* loop over all partial fragments and free any buffers */
 	for(fd=fd_head->next;fd;){
 		fragment_data *tmp_fd;
@@ -775,6 +1128,9 @@ fragment_set_partial_reassembly(reassembly_table *table,
 static void
 fragment_unhash(reassembly_table *table, gpointer key)
 {
+	reassembly_forget(table,
+	    (fragment_data *)g_hash_table_lookup(table->fragment_table, key));
+
 	/*
 	 * Remove the entry from the fragment table.
 	 */
@@ -833,6 +1189,155 @@ LINK_FRAG(fragment_data *fd_head,fragment_data *fd)
 	fd_i->next=fd;
 }
 
+/*
+ * Reassemblies done by fragment_add_work() keep their data in the
+ * fragments; fd_head->data is only filled in when somebody asks for a
+ * contiguous copy.  This calls "func" for each piece of fragment data
+ * that makes up such a reassembly, in order, stopping at "upto" if it's
+ * not NULL.  Where fragments overlap, the data is taken from the one
+ * with the lowest offset, and data past the end of the reassembly is
+ * left out, as fragment_add_work() does when it checks the fragments.
+ */
+typedef void (*fragment_piece_func)(const guint8 *data, const guint32 pos,
+				    const guint32 len, gpointer user_data);
+
+static void
+fragment_foreach_piece(const fragment_data *fd_head, const fragment_data *upto,
+		       fragment_piece_func func, gpointer user_data)
+{
+	const fragment_data *fd_i;
+	guint32 dfpos, fraglen;
+
+	dfpos = 0;
+	for (fd_i = fd_head->next; fd_i && fd_i != upto; fd_i = fd_i->next) {
+		if (!fd_i->len || !fd_i->data)
+			continue;
+		if (fd_i->offset + fd_i->len <= dfpos ||
+		    fd_i->offset >= fd_head->datalen ||
+		    fd_i->offset > dfpos)
+			continue;
+		fraglen = fd_i->len;
+		if (fd_i->offset + fraglen > fd_head->datalen)
+			fraglen = fd_head->datalen - fd_i->offset;
+		if (fd_i->offset + fraglen > dfpos) {
+			func(fd_i->data + (dfpos - fd_i->offset), dfpos,
+			     fd_i->offset + fraglen - dfpos, user_data);
+			dfpos = fd_i->offset + fraglen;
+		}
+	}
+}
+
+typedef struct {
+	guint32	offset;
+	const guint8 *data;
+	guint32	len;
+	gboolean differs;
+} fragment_compare_t;
+
+static void
+fragment_compare_piece(const guint8 *data, const guint32 pos,
+		       const guint32 len, gpointer user_data)
+{
+	fragment_compare_t *cmp = (fragment_compare_t *)user_data;
+	guint32 start, end;
+
+	start = MAX(pos, cmp->offset);
+	end = MIN(pos + len, cmp->offset + cmp->len);
+	if (start < end &&
+	    memcmp(data + (start - pos), cmp->data + (start - cmp->offset), end - start))
+		cmp->differs = TRUE;
+}
+
+/*
+ * Check whether "len" bytes of "data" differ from the reassembled data
+ * at "offset", looking only at the fragments before "upto".
+ */
+static gboolean
+fragment_data_differs(const fragment_data *fd_head, const fragment_data *upto,
+		      const guint32 offset, const guint8 *data, const guint32 len)
+{
+	fragment_compare_t cmp;
+
+	cmp.offset = offset;
+	cmp.data = data;
+	cmp.len = len;
+	cmp.differs = FALSE;
+	fragment_foreach_piece(fd_head, upto, fragment_compare_piece, &cmp);
+	return cmp.differs;
+}
+
+static void
+fragment_copy_piece(const guint8 *data, const guint32 pos,
+		    const guint32 len, gpointer user_data)
+{
+	memcpy((guint8 *)user_data + pos, data, len);
+}
+
+typedef struct {
+	tvbuff_t *parent;
+	tvbuff_t *composite;
+	guint32	length;
+} fragment_composite_t;
+
+static void
+fragment_composite_piece(const guint8 *data, const guint32 pos _U_,
+			 const guint32 len, gpointer user_data)
+{
+	fragment_composite_t *comp = (fragment_composite_t *)user_data;
+
+	tvb_composite_append(comp->composite,
+		tvb_new_child_real_data(comp->parent, data, len, len));
+	comp->length += len;
+}
+
+guint8 *
+fragment_get_data(fragment_data *fd_head)
+{
+	if (fd_head->data == NULL && (fd_head->flags & FD_DEFRAGMENTED) &&
+	    !(fd_head->flags & FD_BLOCKSEQUENCE) && fd_head->datalen) {
+		fd_head->data = (guint8 *)g_malloc(fd_head->datalen);
+		fragment_foreach_piece(fd_head, NULL, fragment_copy_piece,
+				       fd_head->data);
+	}
+	return fd_head->data;
+}
+
+tvbuff_t *
+fragment_new_reassembled_tvb(tvbuff_t *tvb, fragment_data *fd_head)
+{
+	fragment_composite_t comp;
+
+	if (fd_head->flags & FD_BLOCKSEQUENCE) {
+		return tvb_new_child_real_data(tvb, fd_head->data,
+			fd_head->len, fd_head->len);
+	}
+
+	if (fd_head->data == NULL && fd_head->datalen) {
+		/*
+		 * Hand out the fragments themselves, unless a reassembly
+		 * with errors left a gap; the composite would then be
+		 * shorter than the reassembled data.
+		 */
+		comp.parent = tvb;
+		comp.composite = tvb_new_composite();
+		comp.length = 0;
+		fragment_foreach_piece(fd_head, NULL, fragment_composite_piece,
+				       &comp);
+		if (comp.length == fd_head->datalen) {
+			tvb_composite_finalize(comp.composite);
+			return comp.composite;
+		}
+		/*
+		 * The member tvbuffs are chained to "tvb", and freed
+		 * with it; the unfinished composite has to be freed here.
+		 */
+		tvb_free(comp.composite);
+	}
+
+	return tvb_new_child_real_data(tvb, fragment_get_data(fd_head),
+		fd_head->datalen, fd_head->datalen);
+}
+
 /*
  * This function adds a new fragment to the fragment hash table.
  * If this is the first fragment seen for this datagram, a new entry
@@ -891,14 +1396,10 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 			 */
 			if (fd_head->flags & FD_PARTIAL_REASSEMBLY) {
 				/*
-				 * Yes.  Set flag in already empty fds &
-				 * point old fds to malloc'ed data.
+				 * Yes.  The old fds still hold their
+				 * data, so just reset their flags.
 				 */
 				for(fd_i=fd_head->next; fd_i; fd_i=fd_i->next){
-					if( !fd_i->data ) {
-						fd_i->data = fd_head->data + fd_i->offset;
-						fd_i->flags |= FD_NOT_MALLOCED;
-					}
 					fd_i->flags &= (~FD_TOOLONGFRAGMENT) & (~FD_MULTIPLETAILS);
 				}
 				fd_head->flags &= ~(FD_DEFRAGMENTED|FD_PARTIAL_REASSEMBLY|FD_DATALEN_SET);
@@ -980,7 +1481,7 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 
 
 	/* If the packet is already defragmented, this MUST be an overlap.
-	 * The entire defragmented packet is in fd_head->data.
+	 * The entire defragmented packet is in the fragments.
 	 * Even if we have previously defragmented this packet, we still
 	 * check it. Someone might play overlap and TTL games.
 	 */
@@ -994,7 +1495,7 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 			fd_head->flags |= FD_TOOLONGFRAGMENT;
 		}
 		/* make sure it doesn't conflict with previous data */
-		else if ( memcmp(fd_head->data+fd->offset,
+		else if ( fragment_data_differs(fd_head, NULL, fd->offset,
 			tvb_get_ptr(tvb,offset,fd->len),fd->len) ){
 			fd->flags	   |= FD_OVERLAPCONFLICT;
 			fd_head->flags |= FD_OVERLAPCONFLICT;
@@ -1051,8 +1552,10 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 		return FALSE;
 	}
 
-	/* we have received an entire packet, defragment it and
-	 * free all fragments
+	/* we have received an entire packet; check the fragments.
+	 * The data stays in the fragments: fragment_new_reassembled_tvb()
+	 * hands it out as a composite tvbuff, and fragment_get_data()
+	 * copies it into fd_head->data if somebody wants it flat.
 	 */
 	/* A slightly different fix for
 	 * https://bugs.wireshark.org/bugzilla/show_bug.cgi?id=9027
@@ -1064,12 +1567,14 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 
 		old_tvb_data = tvb_new_child_real_data(tvb, fd_head->data, 0, 0);
 		tvb_set_free_cb(old_tvb_data, g_free);
+		fd_head->data = NULL;
 	}
-	fd_head->data = (unsigned char *)g_malloc(fd_head->datalen);
 
-	/* add all data fragments */
+	/* check all data fragments; fragments that were linked in as
+	 * overlaps of an earlier, completed, reassembly have no data
+	 * of their own, and the data they overlap is in the others */
 	for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
-		if (fd_i->len) {
+		if (fd_i->len && fd_i->data) {
 			/*
 			 * The loop above that calculates max also
 			 * ensures that the only gaps that exist here
@@ -1085,7 +1590,7 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 			 *
 			 * Note that the "overlap" compare must only be
 			 * done for fragments with (offset+len) <= fd_head->datalen
-			 * and thus within the newly g_malloc'd buffer.
+			 * and thus within the reassembled data.
 			 */
 			if (fd_i->offset + fd_i->len > dfpos) {
 				if (fd_i->offset >= fd_head->datalen) {
@@ -1121,8 +1626,6 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 					fd_head->error = "dfpos < offset";
 				} else if (dfpos - fd_i->offset > fd_i->len)
 					fd_head->error = "dfpos - offset > len";
-				else if (!fd_head->data)
-					fd_head->error = "no data";
 				else {
 					fraglen = fd_i->len;
 					if (fd_i->offset + fraglen > fd_head->datalen) {
@@ -1137,7 +1640,7 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 						 * added to the reassembly.
 						 *
 						 * Mark it as such, and only
-						 * copy from it what fits in
+						 * use from it what fits in
 						 * the packet.
 						 */
 						fd_i->flags    |= FD_TOOLONGFRAGMENT;
@@ -1147,7 +1650,8 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 					if (fd_i->offset < dfpos) {
 						fd_i->flags    |= FD_OVERLAP;
 						fd_head->flags |= FD_OVERLAP;
-						if ( memcmp(fd_head->data+fd_i->offset,
+						if ( fragment_data_differs(fd_head, fd_i,
+								fd_i->offset,
 								fd_i->data,
 								MIN(fd_i->len,(dfpos-fd_i->offset))
 								 ) ) {
@@ -1161,9 +1665,6 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 						 */
 						fd_head->error = "fraglen < dfpos - offset";
 					} else {
-						memcpy(fd_head->data+dfpos,
-							fd_i->data+(dfpos-fd_i->offset),
-							fraglen-(dfpos-fd_i->offset));
 						dfpos=MAX(dfpos, (fd_i->offset + fraglen));
 					}
 				}
@@ -1173,11 +1674,6 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 					fd_head->error = "offset + len < offset";
 				}
 			}
-			if (fd_i->flags & FD_NOT_MALLOCED)
-				fd_i->flags &= ~FD_NOT_MALLOCED;
-			else
-				g_free(fd_i->data);
-			fd_i->data=NULL;
 		}
 	}
 
@@ -1204,12 +1700,13 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	fragment_data *fd_head;
 	fragment_data *fd_item;
 	gboolean already_added;
+	gpointer orig_key;
 
 
 	/* dissector shouldn't give us garbage tvb info */
 	DISSECTOR_ASSERT(tvb_bytes_exist(tvb, offset, frag_data_len));
 
-	fd_head = lookup_fd_head(table, pinfo, id, data, NULL);
+	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
 
 #if 0
 	/* debug output of associated fragments. */
@@ -1289,6 +1786,8 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 			}
 		}
 	} else {
+		reassembly_show_evictions(table, pinfo);
+
 		/*
 		 * No, so we've already done all the reassembly and added
 		 * all the fragments.  Do we have a reassembly and, if so,
@@ -1361,14 +1860,17 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		/*
 		 * Insert it into the hash table.
 		 */
-		insert_fd_head(table, fd_head, pinfo, id, data);
+		orig_key = insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
+	reassembly_touch(table, fd_head, orig_key, pinfo, frag_data_len);
+
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
 		frag_data_len, more_frags)) {
 		/*
 		 * Reassembly is complete.
 		 */
+		reassembly_forget(table, fd_head);
 		return fd_head;
 	} else {
 		/*
@@ -1418,6 +1920,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	 * of reassembled packets.
 	 */
 	if (pinfo->fd->flags.visited) {
+		reassembly_show_evictions(table, pinfo);
 		reass_key.frame = pinfo->fd->num;
 		reass_key.id = id;
 		return (fragment_data *)g_hash_table_lookup(table->reassembled_table, &reass_key);
@@ -1440,6 +1943,8 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		orig_key = insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
+	reassembly_touch(table, fd_head, orig_key, pinfo, frag_data_len);
+
 	/*
 	 * If this is a short frame, then we can't, and don't, do
 	 * reassembly on it.  We just give up.
@@ -1799,6 +2304,7 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 
 	/* have we already seen this frame ?*/
 	if (pinfo->fd->flags.visited) {
+		reassembly_show_evictions(table, pinfo);
 		if (fd_head != NULL && fd_head->flags & FD_DEFRAGMENTED) {
 			if (orig_keyp != NULL)
 				*orig_keyp = orig_key;
@@ -1864,6 +2370,8 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 		}
 	}
 
+	reassembly_touch(table, fd_head, orig_key, pinfo, frag_data_len);
+
 	/*
 	 * XXX I've copied this over from the old separate
 	 * fragment_add_seq_check_work, but I'm not convinced it's doing the
@@ -1897,6 +2405,7 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 		/*
 		 * Reassembly is complete.
 		 */
+		reassembly_forget(table, fd_head);
 		return fd_head;
 	} else {
 		/*
@@ -1968,6 +2477,7 @@ fragment_add_seq_check_work(reassembly_table *table, tvbuff_t *tvb,
 	 * If so, look for it in the table of reassembled packets.
 	 */
 	if (pinfo->fd->flags.visited) {
+		reassembly_show_evictions(table, pinfo);
 		reass_key.frame = pinfo->fd->num;
 		reass_key.id = id;
 		return (fragment_data *)g_hash_table_lookup(table->reassembled_table, &reass_key);
@@ -2052,6 +2562,7 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 			 const guint32 tot_len)
 {
 	fragment_data *fd_head;
+	gpointer orig_key;
 
 	/* Have we already seen this frame ?*/
 	if (pinfo->fd->flags.visited) {
@@ -2074,7 +2585,8 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head->reassembled_in = 0;
 		fd_head->error = NULL;
 
-		insert_fd_head(table, fd_head, pinfo, id, data);
+		orig_key = insert_fd_head(table, fd_head, pinfo, id, data);
+		reassembly_touch(table, fd_head, orig_key, pinfo, 0);
 	}
 }
 
@@ -2092,6 +2604,7 @@ fragment_end_seq_next(reassembly_table *table, const packet_info *pinfo,
 	 * If so, look for it in the table of reassembled packets.
 	 */
 	if (pinfo->fd->flags.visited) {
+		reassembly_show_evictions(table, pinfo);
 		reass_key.frame = pinfo->fd->num;
 		reass_key.id = id;
 		return (fragment_data *)g_hash_table_lookup(table->reassembled_table, &reass_key);
@@ -2161,22 +2674,11 @@ process_reassembled_data(tvbuff_t *tvb, const int offset, packet_info *pinfo,
 			/*
 			 * Yes.
 			 * Allocate a new tvbuff, referring to the
-			 * reassembled payload.
-			 */
-			if (fd_head->flags & FD_BLOCKSEQUENCE) {
-				next_tvb = tvb_new_real_data(fd_head->data,
-					  fd_head->len, fd_head->len);
-			} else {
-				next_tvb = tvb_new_real_data(fd_head->data,
-					  fd_head->datalen, fd_head->datalen);
-			}
-
-			/*
-			 * Add the tvbuff to the list of tvbuffs to which
-			 * the tvbuff we were handed refers, so it'll get
-			 * cleaned up when that tvbuff is cleaned up.
+			 * reassembled payload; it's chained to the
+			 * tvbuff we were handed, so it'll get cleaned
+			 * up when that tvbuff is cleaned up.
 			 */
-			tvb_set_child_real_data_tvbuff(tvb, next_tvb);
+			next_tvb = fragment_new_reassembled_tvb(tvb, fd_head);
 
 			/* Add the defragmented data to the data source list. */
 			add_new_data_source(pinfo, next_tvb, name);
@@ -89,7 +89,9 @@ typedef struct _fragment_data {
 	guint32 flags;	/* XXX - do some of these apply only to reassembly
 			   heads and others only to fragments within
 			   a reassembly? */
-	guint8  *data;
+	guint8  *data;	/* for reassembly heads built by fragment_add() and
+			 * friends, only set once fragment_get_data() has
+			 * been called */
 
 	/*
 	 * Null if the reassembly had no error; non-null if it had
@@ -135,6 +137,22 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+
+	/*
+	 * Limits on the reassemblies in progress; see
+	 * reassembly_table_set_limits().  The rest is private to
+	 * reassemble.c.
+	 */
+	gsize max_bytes;
+	guint32 timeout;
+	const char *name;				/* protocol that first added a fragment */
+	struct _reassembly_pending *pending_oldest;	/* reassemblies in progress, least */
+	struct _reassembly_pending *pending_newest;	/* recently added to first */
+	GHashTable *pending_table;			/* fd_head -> reassembly_pending */
+	gsize pending_bytes;
+	GHashTable *eviction_table;			/* frame -> reassemblies evicted in it */
+	guint evicted;
+	guint64 evicted_bytes;
 } reassembly_table;
 
 /*
@@ -172,6 +190,52 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * Limit the reassemblies a table keeps in progress.  A reassembly that
+ * hasn't had a fragment added for more than "timeout" seconds of packet
+ * time, or the least recently added to one while the table's reassemblies
+ * in progress hold more than "max_bytes", is thrown away (as if
+ * fragment_delete() had been called for it) when a fragment is added to
+ * another one, and an expert info item reports it in that frame.
+ *
+ * A limit of 0 means no limit, which is what a table starts with.
+ * REASSEMBLY_LIMIT_FROM_PREFS opts the table in to the
+ * "protocols.reassembly_memory_limit" or "protocols.reassembly_timeout"
+ * preference, which is off by default.  Dissectors that keep pointers to
+ * the fragment_data of a reassembly in progress from one frame to the
+ * next must not set limits, as the reassembly may go away under them.
+ */
+#define REASSEMBLY_LIMIT_FROM_PREFS	G_MAXUINT32
+
+WS_DLL_PUBLIC void
+reassembly_table_set_limits(reassembly_table *table, const gsize max_bytes,
+			    const guint32 timeout);
+
+/*
+ * Usage statistics for a reassembly table.
+ */
+typedef struct {
+	const char *name;	/* protocol that first added a fragment, or NULL */
+	guint	live;		/* reassemblies in progress */
+	gsize	bytes;		/* bytes of fragment data and fragment_data they hold */
+	guint	evicted;	/* reassemblies thrown away because of the limits */
+	guint64	evicted_bytes;	/* bytes they held */
+} reassembly_table_stats_t;
+
+WS_DLL_PUBLIC void
+reassembly_table_get_stats(reassembly_table *table,
+			   reassembly_table_stats_t *stats);
+
+/*
+ * Call a function for every reassembly table that has been initialized
+ * and not destroyed.
+ */
+typedef void (*reassembly_table_func)(reassembly_table *table,
+				      void *user_data);
+
+WS_DLL_PUBLIC void
+reassembly_table_foreach(reassembly_table_func func, void *user_data);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
@@ -346,6 +410,23 @@ WS_DLL_PUBLIC unsigned char *
 fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		const guint32 id, const void *data);
 
+/* Return the data of a completed reassembly as one contiguous buffer.
+ * fragment_add(), fragment_add_check() and fragment_add_multiple_ok()
+ * leave the data in the fragments; the buffer is only built, and stored
+ * in fd_head->data, the first time this is called.  Use this, rather
+ * than fd_head->data, for reassemblies done with those routines.
+ */
+WS_DLL_PUBLIC guint8 *
+fragment_get_data(fragment_data *fd_head);
+
+/* Return a tvbuff with the data of a completed reassembly, chained to
+ * "tvb".  If the data is still in the fragments, this is a composite
+ * tvbuff made up of them, so the data isn't copied unless a dissector
+ * asks for a range that crosses fragments.
+ */
+WS_DLL_PUBLIC tvbuff_t *
+fragment_new_reassembled_tvb(tvbuff_t *tvb, fragment_data *fd_head);
+
 /* This struct holds references to all the tree and field handles used when
  * displaying the reassembled fragment tree in the packet details view. A
  * dissector will populate this structure with its own tree and field handles
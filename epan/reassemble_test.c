@@ -64,6 +64,7 @@
 #include <epan/packet.h>
 #include <epan/packet_info.h>
 #include <epan/proto.h>
+#include <epan/prefs.h>
 #include <epan/tvbuff.h>
 #include <epan/reassemble.h>
 
@@ -1522,6 +1523,220 @@ test_missing_data_fragment_add_seq_next_3(void)
 }
 
 
+/**********************************************************************************
+ *
+ * reassembly limits
+ *
+ *********************************************************************************/
+
+/* A reassembly that got no fragment for longer than the timeout is thrown
+ * away when a fragment is added to another one.
+ */
+/*   id  frame  time  frag  len  more
+     12     1    100     0   50   T
+     13     2    105     0   60   T
+     13     3    112     1   60   T     (12 times out)
+     12     4    113     1   50   F
+     13     5    114     2   60   F
+*/
+static void
+test_reassembly_timeout(void)
+{
+    fragment_data *fd_head;
+    reassembly_table_stats_t stats;
+
+    printf("Starting test test_reassembly_timeout\n");
+
+    reassembly_table_set_limits(&test_reassembly_table, 0, 10);
+
+    pinfo.fd->num = 1;
+    pinfo.fd->abs_ts.secs = 100;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 2;
+    pinfo.fd->abs_ts.secs = 105;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 60, TRUE);
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 3;
+    pinfo.fd->abs_ts.secs = 112;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 5, &pinfo, 13, NULL,
+                                   1, 60, TRUE);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(NULL,fragment_get(&test_reassembly_table, &pinfo, 12, NULL));
+    ASSERT_NE(NULL,fragment_get(&test_reassembly_table, &pinfo, 13, NULL));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(1,stats.live);
+    ASSERT_EQ(1,stats.evicted);
+
+    /* the rest of 12 starts a new reassembly */
+    pinfo.fd->num = 4;
+    pinfo.fd->abs_ts.secs = 113;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                                   1, 50, FALSE);
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 5;
+    pinfo.fd->abs_ts.secs = 114;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 20, &pinfo, 13, NULL,
+                                   2, 60, FALSE);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(3,g_hash_table_size(test_reassembly_table.reassembled_table));
+    ASSERT_NE(NULL,fd_head);
+    ASSERT_EQ(180,fd_head->len);
+    ASSERT_EQ(5,fd_head->reassembled_in);
+    ASSERT(!memcmp(fd_head->data,data+15,60));
+    ASSERT(!memcmp(fd_head->data+60,data+5,60));
+    ASSERT(!memcmp(fd_head->data+120,data+20,60));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(1,stats.live);
+    ASSERT_EQ(1,stats.evicted);
+
+    reassembly_table_set_limits(&test_reassembly_table, 0, 0);
+}
+
+/* The oldest reassembly is thrown away when the memory held by all of them
+ * goes over the limit.
+ */
+static void
+test_reassembly_memory_limit(void)
+{
+    fragment_data *fd_head;
+    reassembly_table_stats_t stats;
+    const int frag_bytes = 2*(int)sizeof(fragment_data) + 50;
+    struct _reassembly_shown *shown;
+
+    printf("Starting test test_reassembly_memory_limit\n");
+
+    /* room for one 50-byte fragment and its head, but not two */
+    reassembly_table_set_limits(&test_reassembly_table, frag_bytes + 100, 0);
+    pinfo.fd->abs_ts.secs = 0;
+
+    pinfo.fd->num = 1;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(1,stats.live);
+    ASSERT_EQ(frag_bytes,(int)stats.bytes);
+    ASSERT_EQ(0,stats.evicted);
+
+    pinfo.fd->num = 2;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(NULL,fragment_get(&test_reassembly_table, &pinfo, 12, NULL));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(1,stats.live);
+    ASSERT_EQ(frag_bytes,(int)stats.bytes);
+    ASSERT_EQ(1,stats.evicted);
+    ASSERT_EQ(frag_bytes,(int)stats.evicted_bytes);
+
+    /* revisiting gives the same answers without touching the tables */
+    pinfo.fd->flags.visited = TRUE;
+    pinfo.fd->num = 1;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT(pinfo.reassembly_evictions_shown == NULL);
+
+    /* frame 2 threw 12 away; every dissection of it says so, once */
+    pinfo.fd->num = 2;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 50, TRUE);
+    ASSERT(pinfo.reassembly_evictions_shown != NULL);
+    shown = pinfo.reassembly_evictions_shown;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 50, TRUE);
+    ASSERT(pinfo.reassembly_evictions_shown == shown);
+
+    pinfo.reassembly_evictions_shown = NULL;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 50, TRUE);
+    ASSERT(pinfo.reassembly_evictions_shown != NULL);
+    pinfo.reassembly_evictions_shown = NULL;
+
+    reassembly_table_set_limits(&test_reassembly_table, 0, 0);
+}
+
+/* The preferences only limit tables that opt in to them; a table that
+ * sets no limits keeps all of its reassemblies.
+ */
+static void
+test_reassembly_limit_prefs(void)
+{
+    fragment_data *fd_head;
+    reassembly_table_stats_t stats;
+
+    printf("Starting test test_reassembly_limit_prefs\n");
+
+    prefs.reassembly_timeout = 10;
+
+    pinfo.fd->num = 1;
+    pinfo.fd->abs_ts.secs = 100;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                                   0, 50, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 2;
+    pinfo.fd->abs_ts.secs = 200;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 15, &pinfo, 13, NULL,
+                                   0, 60, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.fragment_table));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(0,stats.evicted);
+
+    /* once the table opts in, the preference applies */
+    reassembly_table_set_limits(&test_reassembly_table,
+                                REASSEMBLY_LIMIT_FROM_PREFS, REASSEMBLY_LIMIT_FROM_PREFS);
+
+    pinfo.fd->num = 3;
+    pinfo.fd->abs_ts.secs = 300;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 20, &pinfo, 14, NULL,
+                                   0, 60, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 5, &pinfo, 15, NULL,
+                                   0, 60, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(4,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_NE(NULL,fragment_get(&test_reassembly_table, &pinfo, 14, NULL));
+    ASSERT_NE(NULL,fragment_get(&test_reassembly_table, &pinfo, 15, NULL));
+
+    pinfo.fd->num = 4;
+    pinfo.fd->abs_ts.secs = 320;
+    fd_head=fragment_add_seq_check(&test_reassembly_table, tvb, 25, &pinfo, 16, NULL,
+                                   0, 60, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+    ASSERT_EQ(NULL,fragment_get(&test_reassembly_table, &pinfo, 14, NULL));
+    ASSERT_EQ(NULL,fragment_get(&test_reassembly_table, &pinfo, 15, NULL));
+    /* the ones added before the table opted in are not tracked */
+    ASSERT_NE(NULL,fragment_get(&test_reassembly_table, &pinfo, 12, NULL));
+    ASSERT_EQ(3,g_hash_table_size(test_reassembly_table.fragment_table));
+
+    reassembly_table_get_stats(&test_reassembly_table, &stats);
+    ASSERT_EQ(2,stats.evicted);
+
+    prefs.reassembly_timeout = 0;
+    reassembly_table_set_limits(&test_reassembly_table, 0, 0);
+}
+
+
 /**********************************************************************************
  *
  * main
@@ -1549,6 +1764,9 @@ main(int argc _U_, char **argv _U_)
         test_missing_data_fragment_add_seq_next,
         test_missing_data_fragment_add_seq_next_2,
         test_missing_data_fragment_add_seq_next_3,
+        test_reassembly_timeout,                   /* limits            */
+        test_reassembly_memory_limit,
+        test_reassembly_limit_prefs,
 #if 0
         test_fragment_add_seq_check_multiple
 #endif
@@ -27,6 +27,7 @@
 
 #include <glib.h>
 #include <epan/stats_tree_priv.h>
+#include <epan/emem.h>
 #include <string.h>
 
 #include "stats_tree.h"
@@ -40,6 +41,38 @@ TODO:
 /* used to contain the registered stat trees */
 static GHashTable *registry = NULL;
 
+/* key of a node created with stats_tree_create_keyed_node() */
+typedef struct _st_node_key {
+	int		parent_id;
+	guint		len;
+	const guint8	*data;
+} st_node_key;
+
+static guint
+st_node_key_hash(gconstpointer k)
+{
+	const st_node_key *key = (const st_node_key *)k;
+	guint h = 2166136261U ^ (guint)key->parent_id;
+	guint i;
+
+	/* FNV-1a */
+	for (i = 0; i < key->len; i++) {
+		h ^= key->data[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static gboolean
+st_node_key_equal(gconstpointer a, gconstpointer b)
+{
+	const st_node_key *ka = (const st_node_key *)a;
+	const st_node_key *kb = (const st_node_key *)b;
+
+	return ka->parent_id == kb->parent_id && ka->len == kb->len &&
+		memcmp(ka->data, kb->data, ka->len) == 0;
+}
+
 /* writes into the buffers pointed by value, rate and percent
    the string representations of a node*/
 extern void
@@ -182,6 +215,8 @@ stats_tree_free(stats_tree *st)
 	g_free(st->filter);
 	g_hash_table_destroy(st->names);
 	g_ptr_array_free(st->parents,TRUE);
+	g_array_free(st->pending,TRUE);
+	g_hash_table_destroy(st->keys);
 
 	for (child = st->root.children; child; child = next ) {
 		/* child->next will be gone after free_stat_node, so cache it here */
@@ -228,6 +263,7 @@ stats_tree_reset(void *p)
 	st->elapsed = 0.0;
 
 	reset_stat_node(&st->root);
+	memset(st->pending->data, 0, st->pending->len * sizeof(gint));
 
 	if (st->cfg->reset_tree) {
 		st->cfg->reset_tree(st);
@@ -250,6 +286,13 @@ stats_tree_reinit(void *p)
 	st->root.children = NULL;
 	st->root.counter = 0;
 
+	/* the nodes are gone, and so are their names and ids */
+	g_hash_table_remove_all(st->names);
+	g_ptr_array_set_size(st->parents,1);
+	g_array_set_size(st->pending,0);
+	g_array_set_size(st->pending,1);
+	g_hash_table_remove_all(st->keys);
+
 	if (st->cfg->init) {
 		st->cfg->init(st);
 	}
@@ -335,6 +378,8 @@ stats_tree_new(stats_tree_cfg *cfg, tree_pres *pr, const char *filter)
 
 	st->names = g_hash_table_new(g_str_hash,g_str_equal);
 	st->parents = g_ptr_array_new();
+	st->pending = g_array_new(FALSE,TRUE,sizeof(gint));
+	st->keys = g_hash_table_new_full(st_node_key_hash,st_node_key_equal,g_free,NULL);
 	st->filter = g_strdup(filter);
 
 	st->start = -1.0;
@@ -350,6 +395,7 @@ stats_tree_new(stats_tree_cfg *cfg, tree_pres *pr, const char *filter)
 	st->root.pr = NULL;
 
 	g_ptr_array_add(st->parents,&st->root);
+	g_array_set_size(st->pending,1);
 
 	return st;
 }
@@ -443,6 +489,16 @@ stats_tree_presentation(void (*registry_iterator)(gpointer,gpointer,gpointer),
 }
 
 
+/* gives a node an id, by which it can be found in st->parents */
+static void
+set_stat_node_id(stats_tree *st, stat_node *node)
+{
+	g_ptr_array_add(st->parents,node);
+	g_array_set_size(st->pending,st->parents->len);
+
+	node->id = st->parents->len - 1;
+}
+
 /* creates a stat_tree node
 *    name: the name of the stats_tree node
 *    parent_name: the name of the ALREADY REGISTERED parent
@@ -471,9 +527,7 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id,
 							node->name,
 							node);
 
-		g_ptr_array_add(st->parents,node);
-
-		node->id = st->parents->len - 1;
+		set_stat_node_id(st,node);
 	} else {
 		node->id = -1;
 	}
@@ -562,7 +616,11 @@ stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
 
 	switch (mode) {
 		case MN_INCREASE: node->counter += value; break;
-		case MN_SET: node->counter = value; break;
+		case MN_SET:
+			node->counter = value;
+			if (node->id >= 0)
+				g_array_index(st->pending,gint,node->id) = 0;
+			break;
 	}
 
 	if (node)
@@ -571,6 +629,132 @@ stats_tree_manip_node(manip_node_mode mode, stats_tree *st, const char *name,
 		return -1;
 }
 
+extern int
+stats_tree_get_node_id(stats_tree *st, const gchar *name, int parent_id,
+		       gboolean with_hash)
+{
+	stat_node *node = NULL;
+	stat_node *parent = NULL;
+
+	g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+	parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+	if( parent->hash ) {
+		node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+	} else {
+		node = (stat_node *)g_hash_table_lookup(st->names,name);
+	}
+
+	if ( node == NULL )
+		node = new_stat_node(st,name,parent_id,with_hash,with_hash);
+
+	/* a node created by a tick doesn't need an id until now */
+	if (node->id < 0)
+		set_stat_node_id(st,node);
+
+	return node->id;
+}
+
+extern int
+stats_tree_node_id_by_key(stats_tree *st, int parent_id, const void *key, guint key_len)
+{
+	st_node_key k;
+	stat_node *node;
+
+	k.parent_id = parent_id;
+	k.len = key_len;
+	k.data = (const guint8 *)key;
+
+	node = (stat_node *)g_hash_table_lookup(st->keys,&k);
+
+	if (node)
+		return node->id;
+	else
+		return -1;
+}
+
+extern int
+stats_tree_create_keyed_node(stats_tree *st, const gchar *name, int parent_id,
+			     const void *key, guint key_len, gboolean with_hash)
+{
+	st_node_key *k;
+	int id = stats_tree_node_id_by_key(st,parent_id,key,key_len);
+
+	if (id >= 0)
+		return id;
+
+	/* a node of that name may have been ticked by name already */
+	id = stats_tree_get_node_id(st,name,parent_id,with_hash);
+
+	/* the key's data is kept right after it */
+	k = (st_node_key *)g_malloc(sizeof(st_node_key) + key_len);
+	k->parent_id = parent_id;
+	k->len = key_len;
+	k->data = (const guint8 *)(k + 1);
+	memcpy(k + 1, key, key_len);
+
+	g_hash_table_insert(st->keys,k,g_ptr_array_index(st->parents,id));
+
+	return id;
+}
+
+extern int
+stats_tree_address_node(stats_tree *st, const address *addr, int parent_id,
+			gboolean with_children)
+{
+	guint key_len = (guint)(sizeof addr->type + addr->len);
+	guint8 *key = (guint8 *)ep_alloc(key_len);
+	int id;
+
+	/* addresses of different types can have the same bytes */
+	memcpy(key, &addr->type, sizeof addr->type);
+	memcpy(key + sizeof addr->type, addr->data, addr->len);
+
+	id = stats_tree_node_id_by_key(st,parent_id,key,key_len);
+	if (id < 0)
+		id = stats_tree_create_keyed_node(st,ep_address_to_str(addr),parent_id,
+						  key,key_len,with_children);
+	return id;
+}
+
+/*
+ * Increases by value, or sets to value, the counter of the node with the
+ * given id.  Increases only go to st->pending, which is cheaper to write
+ * to than the node, and are added to the counter by
+ * stats_tree_merge_counts() when the tree is drawn.
+ */
+extern void
+stats_tree_manip_node_by_id(manip_node_mode mode, stats_tree *st, int node_id,
+			    gint value)
+{
+	g_assert( node_id >= 0 && node_id < (int) st->pending->len );
+
+	switch (mode) {
+		case MN_INCREASE:
+			g_array_index(st->pending,gint,node_id) += value;
+			break;
+		case MN_SET:
+			g_array_index(st->pending,gint,node_id) = 0;
+			((stat_node *)g_ptr_array_index(st->parents,node_id))->counter = value;
+			break;
+	}
+}
+
+extern void
+stats_tree_merge_counts(stats_tree *st)
+{
+	gint *pending = (gint *)(void *)st->pending->data;
+	guint i;
+
+	for (i = 0; i < st->pending->len; i++) {
+		if (pending[i]) {
+			((stat_node *)g_ptr_array_index(st->parents,i))->counter += pending[i];
+			pending[i] = 0;
+		}
+	}
+}
+
 
 extern char*
 stats_tree_get_abbr(const char *optarg)
@@ -756,6 +940,26 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
 	return node->id;
 }
 
+extern int
+stats_tree_tick_range_by_id(stats_tree *st, int node_id, int value_in_range)
+{
+	stat_node *node = NULL;
+	stat_node *child = NULL;
+
+	g_assert( node_id >= 0 && node_id < (int) st->parents->len );
+
+	node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+
+	for ( child = node->children; child; child = child->next) {
+		if ( value_in_range >= child->rng->floor && value_in_range <= child->rng->ceil ) {
+			child->counter++;
+			break;
+		}
+	}
+
+	return node_id;
+}
+
 extern int
 stats_tree_create_pivot(stats_tree *st, const gchar *name, int parent_id)
 {
@@ -147,6 +147,11 @@ WS_DLL_PUBLIC int stats_tree_tick_range(stats_tree *st,
 				 int parent_id,
 				 int value_in_range);
 
+/* same as stats_tree_tick_range() for the ranged node with the given id */
+WS_DLL_PUBLIC int stats_tree_tick_range_by_id(stats_tree *st,
+				 int node_id,
+				 int value_in_range);
+
 #define stats_tree_tick_range_by_pname(st,name,parent_name,value_in_range) \
      stats_tree_tick_range((st),(name),stats_tree_parent_id_by_name((st),(parent_name),(value_in_range))
 
@@ -189,4 +194,59 @@ WS_DLL_PUBLIC int stats_tree_manip_node(manip_node_mode mode,
 #define zero_stat_node(st,name,parent_id,with_children) \
 (stats_tree_manip_node(MN_SET,(st),(name),(parent_id),(with_children),0))
 
+/*
+ * Nodes ticked for every packet are best looked up once and then ticked
+ * by id: looking a node up by name hashes the name, which often has to be
+ * formatted for the packet first.
+ */
+
+/* returns the id of the node whose name is given, creating it (with
+ * counter=0) if it does not exist yet, using parent_id as parent node.
+ * with_children=TRUE to indicate that the node will be a parent
+ */
+WS_DLL_PUBLIC int stats_tree_get_node_id(stats_tree *st,
+				  const gchar *name,
+				  int parent_id,
+				  gboolean with_children);
+
+/* returns the id of the node created under parent_id with the given
+ * binary key (e.g. the bytes of an address), or -1 if there is none yet */
+WS_DLL_PUBLIC int stats_tree_node_id_by_key(stats_tree *st,
+				     int parent_id,
+				     const void *key,
+				     guint key_len);
+
+/* creates a node named name under parent_id, to be found by its binary key
+ * with stats_tree_node_id_by_key(), so that its name only has to be
+ * formatted once; returns its id */
+WS_DLL_PUBLIC int stats_tree_create_keyed_node(stats_tree *st,
+					const gchar *name,
+					int parent_id,
+					const void *key,
+					guint key_len,
+					gboolean with_children);
+
+/* returns the id of the node for an address under parent_id, creating it
+ * if it does not exist yet; it is keyed by the address type and data, so
+ * the address is only converted to a string the first time it's seen */
+WS_DLL_PUBLIC int stats_tree_address_node(stats_tree *st,
+				   const address *addr,
+				   int parent_id,
+				   gboolean with_children);
+
+/* manipulates the value of the node with the given id */
+WS_DLL_PUBLIC void stats_tree_manip_node_by_id(manip_node_mode mode,
+					stats_tree *st,
+					int node_id,
+					gint value);
+
+#define increase_stat_node_by_id(st,node_id,value) \
+(stats_tree_manip_node_by_id(MN_INCREASE,(st),(node_id),(value)))
+
+#define tick_stat_node_by_id(st,node_id) \
+(stats_tree_manip_node_by_id(MN_INCREASE,(st),(node_id),1))
+
+#define set_stat_node_by_id(st,node_id,value) \
+(stats_tree_manip_node_by_id(MN_SET,(st),(node_id),(value)))
+
 #endif /* __STATS_TREE_H */
@@ -94,8 +94,19 @@ struct _stats_tree {
 	*/
 	GHashTable		*names;
 	
-   /** used for quicker lookups of parent nodes */
+   /** used for quicker lookups of parent nodes, and of any node
+	*  by the id it was given */
 	GPtrArray		*parents;
+
+   /** counts added to nodes by id and not yet added to their counters,
+	*  indexed like parents; see stats_tree_merge_counts() */
+	GArray			*pending;
+
+   /** used to lookup nodes created with stats_tree_create_keyed_node():
+	*    key: parent id and binary key
+	*  value: node
+	*/
+	GHashTable		*keys;
 		
 	/**
 	 *  tree representation
@@ -173,6 +184,10 @@ WS_DLL_PUBLIC void stats_tree_reset(void *p_st);
 /** callback for clear */
 WS_DLL_PUBLIC void stats_tree_reinit(void *p_st);
 
+/** adds the counts given to nodes by id to their counters;
+   to be called before drawing the tree */
+WS_DLL_PUBLIC void stats_tree_merge_counts(stats_tree *st);
+
 /* callback for destoy */
 WS_DLL_PUBLIC void stats_tree_free(stats_tree *st);
 
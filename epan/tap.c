@@ -70,6 +70,7 @@ typedef struct _tap_listener_t {
 	gboolean needs_redraw;
 	guint flags;
 	dfilter_t *code;
+	dfilter_t *prime;	/* only used to prime the tree, see set_tap_prime_dfilter() */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -206,6 +207,25 @@ void tap_build_interesting (epan_dissect_t *edt)
 		if(tl->code){
 			epan_dissect_prime_dfilter(edt, tl->code);
 		}
+		if(tl->prime){
+			epan_dissect_prime_dfilter(edt, tl->prime);
+		}
+	}
+}
+
+/* The same, adding the fields to a set of interesting fields built once
+   for all the packets */
+void tap_build_interest (proto_interest_t *interest)
+{
+	tap_listener_t *tl;
+
+	for(tl=(tap_listener_t *)tap_listener_queue;tl;tl=tl->next){
+		if(tl->code){
+			dfilter_prime_interest(tl->code, interest);
+		}
+		if(tl->prime){
+			dfilter_prime_interest(tl->prime, interest);
+		}
 	}
 }
 
@@ -401,6 +421,7 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 
 	tl=(tap_listener_t *)g_malloc(sizeof(tap_listener_t));
 	tl->code=NULL;
+	tl->prime=NULL;
 	tl->needs_redraw=TRUE;
 	tl->flags=flags;
 	if(fstring){
@@ -470,6 +491,27 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	return NULL;
 }
 
+/* this function gives a tap listener a dfilter that its packet routine
+   applies itself, e.g. one made by dfilter_combine().  The tree is primed
+   with the fields the dfilter uses, but the tap doesn't apply it.  The tap
+   listener owns the dfilter from then on.
+ */
+void
+set_tap_prime_dfilter(void *tapdata, dfilter_t *code)
+{
+	tap_listener_t *tl;
+
+	for(tl=(tap_listener_t *)tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			if(tl->prime){
+				dfilter_free(tl->prime);
+			}
+			tl->prime=code;
+			return;
+		}
+	}
+}
+
 /* this function removes a tap listener
  */
 void
@@ -499,6 +541,9 @@ remove_tap_listener(void *tapdata)
 		if(tl->code){
 			dfilter_free(tl->code);
 		}
+		if(tl->prime){
+			dfilter_free(tl->prime);
+		}
 		g_free(tl);
 	}
 
@@ -550,7 +595,7 @@ have_filtering_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=(tap_listener_t *)tap_listener_queue;tl;tl=tl->next){
-		if(tl->code)
+		if(tl->code || tl->prime)
 			return TRUE;
 	}
 	return FALSE;
@@ -51,6 +51,7 @@ WS_DLL_PUBLIC int register_tap(const char *name);
 WS_DLL_PUBLIC int find_tap_id(const char *name);
 WS_DLL_PUBLIC void tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data);
 WS_DLL_PUBLIC void tap_build_interesting(epan_dissect_t *edt);
+WS_DLL_PUBLIC void tap_build_interest(proto_interest_t *interest);
 extern void tap_queue_init(epan_dissect_t *edt);
 extern void tap_push_tapped_queue(epan_dissect_t *edt);
 WS_DLL_PUBLIC void reset_tap_listeners(void);
@@ -59,6 +60,7 @@ WS_DLL_PUBLIC GString *register_tap_listener(const char *tapname, void *tapdata,
     const char *fstring, guint flags, tap_reset_cb tap_reset,
     tap_packet_cb tap_packet, tap_draw_cb tap_draw);
 WS_DLL_PUBLIC GString *set_tap_dfilter(void *tapdata, const char *fstring);
+WS_DLL_PUBLIC void set_tap_prime_dfilter(void *tapdata, dfilter_t *code);
 WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
 WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 extern gboolean have_tap_listener(int tap_id);
@@ -1,6 +1,6 @@
 /* Standalone program to test functionality of tvbuffs.
  *
- * tvbtest : tvbtest.o tvbuff.o except.o
+ * tvbtest : tvbtest.o tvbuff.o except.o ../wsutil/ws_mempbrk.o
  *
  * $Id$
  *
@@ -293,6 +293,194 @@ skip(tvbuff_t *tvb _U_, gchar* name,
 	return FALSE;
 }
 
+static const char *pbrk_impls[] = { "c", "sse2", "avx2" };
+
+/* Check that every implementation of tvb_pbrk_pattern_guint8() finds
+ * the first needle at every position in buffers of every length up to
+ * 100 bytes, and at every starting offset */
+gboolean
+test_pbrk(void)
+{
+	guint8			data[100];
+	ws_mempbrk_pattern	pattern;
+	tvbuff_t		*tvb;
+	guint			impl, len, pos, offset;
+	gint			found, expected;
+	guchar			needle;
+
+	ws_mempbrk_compile(&pattern, "\r\n\"");
+	for (impl = 0; impl < G_N_ELEMENTS(pbrk_impls); impl++) {
+		if (!ws_mempbrk_set_impl(pbrk_impls[impl])) {
+			printf("Skipping pbrk implementation %s\n", pbrk_impls[impl]);
+			continue;
+		}
+		for (len = 1; len <= sizeof(data); len++) {
+			for (pos = 0; pos <= len; pos++) {
+				memset(data, 'a', len);
+				if (pos < len)
+					data[pos] = (pos % 2) ? '\n' : '"';
+				tvb = tvb_new_real_data(data, len, len);
+				for (offset = 0; offset < len; offset++) {
+					needle = 0;
+					found = tvb_pbrk_pattern_guint8(tvb, offset, -1,
+					    &pattern, &needle);
+					expected = (pos < len && pos >= offset) ? (gint)pos : -1;
+					if (found != expected ||
+					    (found != -1 && needle != data[pos])) {
+						printf("03: Failed pbrk %s length=%u needle at %u offset=%u: found %d\n",
+						    pbrk_impls[impl], len, pos, offset, found);
+						failed = TRUE;
+						tvb_free(tvb);
+						return FALSE;
+					}
+				}
+				tvb_free(tvb);
+			}
+		}
+		printf("Passed pbrk implementation %s\n", pbrk_impls[impl]);
+	}
+	return TRUE;
+}
+
+/* Build a composite out of many short members and check that copies,
+ * pointers and searches give the same results as on the flat data,
+ * whether or not the range crosses member boundaries */
+gboolean
+test_composite_members(void)
+{
+	guint8			data[250];
+	guint8			copy[sizeof(data)];
+	const guint8		*ptr;
+	tvbuff_t		*tvb_members[25];
+	tvbuff_t		*tvb_comp;
+	guint			i, offset, len;
+	gint			found, expected;
+	guchar			needle;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = 'a' + (i % 7);
+	data[133] = '\n';
+	data[201] = '"';
+
+	for (i = 0; i < G_N_ELEMENTS(tvb_members); i++)
+		tvb_members[i] = tvb_new_real_data(&data[i * 10], 10, 10);
+	tvb_comp = tvb_new_composite();
+	for (i = 0; i < G_N_ELEMENTS(tvb_members); i++)
+		tvb_composite_append(tvb_comp, tvb_members[i]);
+	tvb_composite_finalize(tvb_comp);
+
+	/* A range within one member is handed out without copying */
+	ptr = tvb_get_ptr(tvb_comp, 42, 8);
+	if (ptr != &data[42]) {
+		printf("04: Failed composite: range within a member was copied\n");
+		failed = TRUE;
+		return FALSE;
+	}
+
+	for (offset = 0; offset < sizeof(data); offset++) {
+		for (len = 0; offset + len <= sizeof(data); len += 13) {
+			tvb_memcpy(tvb_comp, copy, offset, len);
+			if (memcmp(copy, &data[offset], len) != 0) {
+				printf("04: Failed composite memcpy offset=%u length=%u\n",
+				    offset, len);
+				failed = TRUE;
+				return FALSE;
+			}
+		}
+
+		found = tvb_find_guint8(tvb_comp, offset, -1, '\n');
+		expected = offset <= 133 ? 133 : -1;
+		if (found != expected) {
+			printf("04: Failed composite find offset=%u: found %d\n",
+			    offset, found);
+			failed = TRUE;
+			return FALSE;
+		}
+
+		needle = 0;
+		found = tvb_pbrk_guint8(tvb_comp, offset, -1, (const guint8 *)"\"", &needle);
+		expected = offset <= 201 ? 201 : -1;
+		if (found != expected || (found != -1 && needle != '"')) {
+			printf("04: Failed composite pbrk offset=%u: found %d\n",
+			    offset, found);
+			failed = TRUE;
+			return FALSE;
+		}
+	}
+
+	/* A range across members flattens the composite once */
+	ptr = tvb_get_ptr(tvb_comp, 5, 100);
+	if (memcmp(ptr, &data[5], 100) != 0 ||
+	    tvb_get_ptr(tvb_comp, 195, 10) != ptr + 190) {
+		printf("04: Failed composite: range across members\n");
+		failed = TRUE;
+		return FALSE;
+	}
+
+	printf("Passed composite with %u members\n", (guint)G_N_ELEMENTS(tvb_members));
+	/* The composite is chained to, and freed with, its first member */
+	for (i = 0; i < G_N_ELEMENTS(tvb_members); i++)
+		tvb_free(tvb_members[i]);
+	return TRUE;
+}
+
+/* Print the throughput of the search routines on buffers of 64 bytes to
+ * 64 KB with no line end before the last two bytes, for each
+ * implementation of the needle search */
+void
+run_benchmarks(void)
+{
+	static const guint	sizes[] = { 64, 256, 1024, 4096, 16384, 65536 };
+	const guint64		total = G_GUINT64_CONSTANT(256) * 1024 * 1024;
+	ws_mempbrk_pattern	pattern;
+	guint8			*data;
+	tvbuff_t		*tvb;
+	GTimer			*timer;
+	guint			impl, i, n, iters;
+	gint			next_offset;
+	volatile gint		sink = 0;
+	double			line_end, pbrk, pbrk_pattern, find, memeql;
+
+	timer = g_timer_new();
+	ws_mempbrk_compile(&pattern, "\r\n");
+	printf("Throughput in MB/s; the default implementation is %s\n", ws_mempbrk_impl());
+	printf("%-5s %6s %14s %10s %14s %10s %10s\n", "impl", "bytes",
+	    "find_line_end", "pbrk", "pbrk_pattern", "find_u8", "memeql");
+
+	for (impl = 0; impl < G_N_ELEMENTS(pbrk_impls); impl++) {
+		if (!ws_mempbrk_set_impl(pbrk_impls[impl]))
+			continue;
+		for (i = 0; i < G_N_ELEMENTS(sizes); i++) {
+			data = (guint8 *)g_malloc(sizes[i]);
+			memset(data, 'a', sizes[i]);
+			data[sizes[i] - 2] = '\r';
+			data[sizes[i] - 1] = '\n';
+			tvb = tvb_new_real_data(data, sizes[i], sizes[i]);
+			iters = (guint)(total / sizes[i]);
+
+#define BENCH(result, expr) \
+			g_timer_start(timer); \
+			for (n = 0; n < iters; n++) \
+				sink += (expr); \
+			result = (double)total / (1024 * 1024) / g_timer_elapsed(timer, NULL);
+
+			BENCH(line_end, tvb_find_line_end(tvb, 0, -1, &next_offset, FALSE));
+			BENCH(pbrk, tvb_pbrk_guint8(tvb, 0, -1, (const guint8 *)"\r\n", NULL));
+			BENCH(pbrk_pattern, tvb_pbrk_pattern_guint8(tvb, 0, -1, &pattern, NULL));
+			BENCH(find, tvb_find_guint8(tvb, 0, -1, '\r'));
+			BENCH(memeql, tvb_memeql(tvb, 0, data, sizes[i]));
+#undef BENCH
+
+			printf("%-5s %6u %14.0f %10.0f %14.0f %10.0f %10.0f\n",
+			    pbrk_impls[impl], sizes[i],
+			    line_end, pbrk, pbrk_pattern, find, memeql);
+			tvb_free(tvb);
+			g_free(data);
+		}
+	}
+	g_timer_destroy(timer);
+}
+
 
 void
 run_tests(void)
@@ -495,16 +683,26 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
-/* Note: valgrind can be used to check for tvbuff memory leaks */
+/* Note: valgrind can be used to check for tvbuff memory leaks.
+ * "tvbtest -b" runs the search benchmarks instead of the tests. */
 int
-main(void)
+main(int argc, char **argv)
 {
+	if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+		except_init();
+		run_benchmarks();
+		except_deinit();
+		exit(0);
+	}
+
 	/* For valgrind: See GLib documentation: "Running GLib Applications" */
 	g_setenv("G_DEBUG", "gc-friendly", 1);
 	g_setenv("G_SLICE", "always-malloc", 1);
 
 	except_init();
 	run_tests();
+	test_pbrk();
+	test_composite_members();
 	except_deinit();
 	exit(failed?1:0);
 }
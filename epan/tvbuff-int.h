@@ -38,11 +38,18 @@ typedef struct {
 } tvb_backing_t;
 
 typedef struct {
+	/** The member tvbuffs, while the composite is being built */
 	GSList		*tvbs;
 
+	/** The member tvbuffs, once the composite has been finalized */
+	struct tvbuff	**members;
+	guint		num_members;
+
 	/* Used for quick testing to see if this
 	 * is the tvbuff that a COMPOSITE is
-	 * interested in. */
+	 * interested in.  Both are in ascending order,
+	 * so the member holding an offset can be found
+	 * with a binary search of end_offsets. */
 	guint		*start_offsets;
 	guint		*end_offsets;
 
@@ -98,6 +98,8 @@ tvb_new(const tvbuff_type type)
 		case TVBUFF_COMPOSITE:
 			composite 		 = &tvb->tvbuffs.composite;
 			composite->tvbs		 = NULL;
+			composite->members	 = NULL;
+			composite->num_members	 = 0;
 			composite->start_offsets = NULL;
 			composite->end_offsets	 = NULL;
 			break;
@@ -135,6 +137,7 @@ tvb_free_internal(tvbuff_t *tvb)
 			composite = &tvb->tvbuffs.composite;
 
 			g_slist_free(composite->tvbs);
+			g_free(composite->members);
 
 			g_free(composite->start_offsets);
 			g_free(composite->end_offsets);
@@ -610,8 +613,8 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->type == TVBUFF_COMPOSITE);
 
-	/* Don't allow zero-length TVBs: composite_memcpy() can't handle them
-	 * and anyway it makes no sense.
+	/* Don't allow zero-length TVBs: composite_find_member() can't
+	 * handle them and anyway it makes no sense.
 	 */
 	DISSECTOR_ASSERT(member->length);
 
@@ -627,8 +630,8 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->type == TVBUFF_COMPOSITE);
 
-	/* Don't allow zero-length TVBs: composite_memcpy() can't handle them
-	 * and anyway it makes no sense.
+	/* Don't allow zero-length TVBs: composite_find_member() can't
+	 * handle them and anyway it makes no sense.
 	 */
 	DISSECTOR_ASSERT(member->length);
 
@@ -644,7 +647,7 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	guint	    num_members;
 	tvbuff_t   *member_tvb;
 	tvb_comp_t *composite;
-	int	    i = 0;
+	guint	    i = 0;
 
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->type == TVBUFF_COMPOSITE);
@@ -660,20 +663,34 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
 	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
-		DISSECTOR_ASSERT((guint) i < num_members);
+		DISSECTOR_ASSERT(i < num_members);
 		member_tvb = (tvbuff_t *)slist->data;
+		composite->members[i] = member_tvb;
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
 		composite->end_offsets[i] = tvb->length - 1;
 		i++;
 	}
-	add_to_chain((tvbuff_t *)composite->tvbs->data, tvb); /* chain composite tvb to first member */
+
+	/* From now on the members are only looked up in the array */
+	g_slist_free(composite->tvbs);
+	composite->tvbs = NULL;
+
+	add_to_chain(composite->members[0], tvb); /* chain composite tvb to first member */
 	tvb->initialized = TRUE;
+
+	/*
+	 * The members' data only appears in this order here,
+	 * so the composite is a data source of its own.
+	 */
+	tvb->ds_tvb = tvb;
 }
 
 
@@ -853,7 +870,7 @@ first_real_data_ptr(tvbuff_t *tvb)
 			member = tvb->tvbuffs.subset.tvb;
 			return first_real_data_ptr(member);
 		case TVBUFF_COMPOSITE:
-			member = tvb->tvbuffs.composite.tvbs->data;
+			member = tvb->tvbuffs.composite.members[0];
 			return first_real_data_ptr(member);
 	}
 
@@ -874,7 +891,7 @@ offset_from_real_beginning(const tvbuff_t *tvb, const guint counter)
 			member = tvb->tvbuffs.subset.tvb;
 			return offset_from_real_beginning(member, counter + tvb->tvbuffs.subset.offset);
 		case TVBUFF_COMPOSITE:
-			member = (tvbuff_t *)tvb->tvbuffs.composite.tvbs->data;
+			member = tvb->tvbuffs.composite.members[0];
 			return offset_from_real_beginning(member, counter);
 	}
 
@@ -888,42 +905,61 @@ tvb_offset_from_real_beginning(const tvbuff_t *tvb)
 	return offset_from_real_beginning(tvb, 0);
 }
 
+/*
+ * Find the member of a finalized composite tvbuff that holds abs_offset,
+ * i.e. the first member whose end offset is at or past abs_offset.
+ * An offset past the end of the composite maps to its last member.
+ */
+static guint
+composite_find_member(const tvb_comp_t *composite, const guint abs_offset)
+{
+	guint low, high, mid;
+
+	low  = 0;
+	high = composite->num_members - 1;
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (abs_offset > composite->end_offsets[mid])
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
 static const guint8*
 composite_ensure_contiguous_no_exception(tvbuff_t *tvb, const guint abs_offset, const guint abs_length)
 {
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	DISSECTOR_ASSERT(tvb->type == TVBUFF_COMPOSITE);
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
-	composite = &tvb->tvbuffs.composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
-	DISSECTOR_ASSERT(member_tvb);
+	composite  = &tvb->tvbuffs.composite;
+	i          = composite_find_member(composite, abs_offset);
+	member_tvb = composite->members[i];
 
 	if (check_offset_length_no_exception(member_tvb,
 					     abs_offset - composite->start_offsets[i],
 					     abs_length, &member_offset, &member_length, NULL)) {
 
 		/*
-		 * The range is, in fact, contiguous within member_tvb.
+		 * The range is, in fact, contiguous within member_tvb,
+		 * so hand out a pointer into it rather than copying.
 		 */
 		DISSECTOR_ASSERT(!tvb->real_data);
 		return ensure_contiguous_no_exception(member_tvb, member_offset, member_length, NULL);
 	}
 	else {
+		/*
+		 * The range straddles members; flatten the whole composite
+		 * once.  The copy becomes our real_data, so every later
+		 * access is served from it without going to the members.
+		 */
 		tvb->real_data = (guint8 *)tvb_memdup(tvb, 0, -1);
 		return tvb->real_data + abs_offset;
 	}
@@ -1013,90 +1049,41 @@ fast_ensure_contiguous(tvbuff_t *tvb, const gint offset, const guint length)
 	return NULL;
 }
 
-static const guint8*
-guint8_pbrk(const guint8* haystack, size_t haystacklen, const guint8 *needles, guchar *found_needle)
-{
-	gchar         tmp[256] = { 0 };
-	const guint8 *haystack_end;
-
-	while (*needles)
-		tmp[*needles++] = 1;
-
-	haystack_end = haystack + haystacklen;
-	while (haystack < haystack_end) {
-		if (tmp[*haystack]) {
-			if (found_needle)
-				*found_needle = *haystack;
-			return haystack;
-		}
-		haystack++;
-	}
-
-	return NULL;
-}
-
-
-
 /************** ACCESSORS **************/
 
 static void *
 composite_memcpy(tvbuff_t *tvb, guint8* target, guint abs_offset, size_t abs_length)
 {
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	gboolean    retval;
-	GSList	   *slist;
+	guint8	   *dest = target;
 
 	DISSECTOR_ASSERT(tvb->type == TVBUFF_COMPOSITE);
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &tvb->tvbuffs.composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
-	DISSECTOR_ASSERT(member_tvb);
-
-	if (check_offset_length_no_exception(member_tvb, abs_offset - composite->start_offsets[i],
-				(gint) abs_length, &member_offset, &member_length, NULL)) {
-
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, member_length);
-	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
-		retval = compute_offset_length(member_tvb, abs_offset - composite->start_offsets[i], -1,
-				&member_offset, &member_length, NULL);
-		DISSECTOR_ASSERT(retval);
-
-		/* composite_memcpy() can't handle a member_length of zero.  */
-		DISSECTOR_ASSERT(member_length);
-
-		tvb_memcpy(member_tvb, target, member_offset, member_length);
+	/* Copy the part of the range that's in the member holding
+	 * abs_offset, then the parts in the following members,
+	 * until we have copied all data. */
+	composite = &tvb->tvbuffs.composite;
+	i         = composite_find_member(composite, abs_offset);
+
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb    = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = member_tvb->length - member_offset;
+		if (member_length > abs_length)
+			member_length = (guint) abs_length;
+
+		tvb_memcpy(member_tvb, dest, member_offset, member_length);
+		dest		+= member_length;
 		abs_offset	+= member_length;
 		abs_length	-= member_length;
-
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
-
-		return target;
+		i++;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return target;
 }
 
 void *
@@ -1134,7 +1121,7 @@ tvb_memcpy(tvbuff_t *tvb, void *target, const gint offset, size_t length)
 					abs_length);
 
 		case TVBUFF_COMPOSITE:
-			return composite_memcpy(tvb, (guint8 *)target, offset, length);
+			return composite_memcpy(tvb, (guint8 *)target, abs_offset, abs_length);
 	}
 
 	DISSECTOR_ASSERT_NOT_REACHED();
@@ -1891,6 +1878,72 @@ tvb_get_bits(tvbuff_t *tvb, const guint bit_offset, const gint no_of_bits, const
 	return (guint32)_tvb_get_bits64(tvb, bit_offset, no_of_bits);
 }
 
+/* Search the members of a composite tvbuff in turn, starting with the
+ * one holding abs_offset; limit must not go past the end of the tvbuff. */
+static gint
+composite_find_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const guint8 needle)
+{
+	guint	    i;
+	tvb_comp_t *composite;
+	tvbuff_t   *member_tvb;
+	guint	    member_offset, member_length;
+	gint	    result;
+
+	composite = &tvb->tvbuffs.composite;
+	i         = composite_find_member(composite, abs_offset);
+
+	while (limit > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb    = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = member_tvb->length - member_offset;
+		if (member_length > limit)
+			member_length = limit;
+
+		result = tvb_find_guint8(member_tvb, member_offset, member_length, needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+		i++;
+	}
+
+	return -1;
+}
+
+static gint
+composite_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern *pattern, guchar *found_needle)
+{
+	guint	    i;
+	tvb_comp_t *composite;
+	tvbuff_t   *member_tvb;
+	guint	    member_offset, member_length;
+	gint	    result;
+
+	composite = &tvb->tvbuffs.composite;
+	i         = composite_find_member(composite, abs_offset);
+
+	while (limit > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb    = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
+		member_length = member_tvb->length - member_offset;
+		if (member_length > limit)
+			member_length = limit;
+
+		result = tvb_pbrk_pattern_guint8(member_tvb, member_offset, member_length, pattern, found_needle);
+		if (result != -1)
+			return composite->start_offsets[i] + result;
+
+		abs_offset += member_length;
+		limit      -= member_length;
+		i++;
+	}
+
+	return -1;
+}
+
 /* Find first occurrence of needle in tvbuff, starting at offset. Searches
  * at most maxlength number of bytes; if maxlength is -1, searches to
  * end of tvbuff.
@@ -1948,8 +2001,7 @@ tvb_find_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 					limit, needle);
 
 		case TVBUFF_COMPOSITE:
-			DISSECTOR_ASSERT_NOT_REACHED();
-			/* XXX - return composite_find_guint8(tvb, offset, limit, needle); */
+			return composite_find_guint8(tvb, abs_offset, limit, needle);
 	}
 
 	DISSECTOR_ASSERT_NOT_REACHED();
@@ -1964,7 +2016,7 @@ tvb_find_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
  * in that case, -1 will be returned if the boundary is reached before
  * finding needle. */
 gint
-tvb_pbrk_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const guint8 *needles, guchar *found_needle)
+tvb_pbrk_pattern_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const ws_mempbrk_pattern *pattern, guchar *found_needle)
 {
 	const guint8 *result;
 	guint	      abs_offset, junk_length;
@@ -1994,7 +2046,7 @@ tvb_pbrk_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 
 	/* If we have real data, perform our search now. */
 	if (tvb->real_data) {
-		result = guint8_pbrk(tvb->real_data + abs_offset, limit, needles, found_needle);
+		result = ws_mempbrk_exec(tvb->real_data + abs_offset, limit, pattern, found_needle);
 		if (result == NULL) {
 			return -1;
 		}
@@ -2008,19 +2060,31 @@ tvb_pbrk_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 			DISSECTOR_ASSERT_NOT_REACHED();
 
 		case TVBUFF_SUBSET:
-			return tvb_pbrk_guint8(tvb->tvbuffs.subset.tvb,
+			return tvb_pbrk_pattern_guint8(tvb->tvbuffs.subset.tvb,
 					abs_offset - tvb->tvbuffs.subset.offset,
-					limit, needles, found_needle);
+					limit, pattern, found_needle);
 
 		case TVBUFF_COMPOSITE:
-			DISSECTOR_ASSERT_NOT_REACHED();
-			/* XXX - return composite_pbrk_guint8(tvb, offset, limit, needle); */
+			return composite_pbrk_guint8(tvb, abs_offset, limit, pattern, found_needle);
 	}
 
 	DISSECTOR_ASSERT_NOT_REACHED();
 	return -1;
 }
 
+/* Find first occurrence of any of the needles in tvbuff, starting at offset.
+ * The needles are compiled on every call; callers that search for the
+ * same needles over and over should compile them once, and use
+ * tvb_pbrk_pattern_guint8(). */
+gint
+tvb_pbrk_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const guint8 *needles, guchar *found_needle)
+{
+	ws_mempbrk_pattern pattern;
+
+	ws_mempbrk_compile(&pattern, (const gchar *)needles);
+	return tvb_pbrk_pattern_guint8(tvb, offset, maxlength, &pattern, found_needle);
+}
+
 /* Find size of stringz (NUL-terminated string) by looking for terminating
  * NUL.  The size of the string includes the terminating NUL.
  *
@@ -2964,6 +3028,13 @@ tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset,
 	gint   eol_offset;
 	int    linelen;
 	guchar found_needle = 0;
+	static gboolean compiled = FALSE;
+	static ws_mempbrk_pattern pbrk_crlf;
+
+	if (!compiled) {
+		ws_mempbrk_compile(&pbrk_crlf, "\r\n");
+		compiled = TRUE;
+	}
 
 	if (len == -1)
 		len = tvb_length_remaining(tvb, offset);
@@ -2976,7 +3047,7 @@ tvb_find_line_end(tvbuff_t *tvb, const gint offset, int len, gint *next_offset,
 	/*
 	 * Look either for a CR or an LF.
 	 */
-	eol_offset = tvb_pbrk_guint8(tvb, offset, len, "\r\n", &found_needle);
+	eol_offset = tvb_pbrk_pattern_guint8(tvb, offset, len, &pbrk_crlf, &found_needle);
 	if (eol_offset == -1) {
 		/*
 		 * No CR or LF - line is presumably continued in next packet.
@@ -3080,6 +3151,13 @@ tvb_find_line_end_unquoted(tvbuff_t *tvb, const gint offset, int len, gint *next
 	guchar   c = 0;
 	gint     eob_offset;
 	int      linelen;
+	static gboolean compiled = FALSE;
+	static ws_mempbrk_pattern pbrk_crlf_dquote;
+
+	if (!compiled) {
+		ws_mempbrk_compile(&pbrk_crlf_dquote, "\r\n\"");
+		compiled = TRUE;
+	}
 
 	if (len == -1)
 		len = tvb_length_remaining(tvb, offset);
@@ -3105,7 +3183,7 @@ tvb_find_line_end_unquoted(tvbuff_t *tvb, const gint offset, int len, gint *next
 			/*
 			 * Look either for a CR, an LF, or a '"'.
 			 */
-			char_offset = tvb_pbrk_guint8(tvb, cur_offset, len, "\r\n\"", &c);
+			char_offset = tvb_pbrk_pattern_guint8(tvb, cur_offset, len, &pbrk_crlf_dquote, &c);
 		}
 		if (char_offset == -1) {
 			/*
@@ -38,6 +38,7 @@
 #include <glib.h>
 #include <epan/ipv6-utils.h>
 #include <epan/guid-utils.h>
+#include <wsutil/ws_mempbrk.h>
 #include "exceptions.h"
 
 #ifdef __cplusplus
@@ -390,6 +391,11 @@ WS_DLL_PUBLIC gint tvb_find_guint8(tvbuff_t*, const gint offset, const gint maxl
 WS_DLL_PUBLIC gint tvb_pbrk_guint8(tvbuff_t *, const gint offset, const gint maxlength,
     const guint8 *needles, guchar *found_needle);
 
+/** Like tvb_pbrk_guint8(), with needles that were compiled once with
+ * ws_mempbrk_compile(), rather than on every call. */
+WS_DLL_PUBLIC gint tvb_pbrk_pattern_guint8(tvbuff_t *, const gint offset,
+    const gint maxlength, const ws_mempbrk_pattern *pattern, guchar *found_needle);
+
 /** Find size of stringz (NUL-terminated string) by looking for terminating
  * NUL.  The size of the string includes the terminating NUL.
  *
@@ -28,6 +28,8 @@
 
 #include <string.h>
 
+#include "wmem_core.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -46,10 +48,17 @@ struct _wmem_allocator_t {
     void  (*free)(void *private_data, void *ptr);
     void *(*realloc)(void *private_data, void *ptr, const size_t size);
 
+    /* Returns the usable size of a chunk returned by alloc/realloc; only
+     * called by the core to keep the stats below exact across free/realloc */
+    size_t (*chunk_size)(void *private_data, const void *ptr);
+
     /* Producer/Manager functions */
     void  (*free_all)(void *private_data);
     void  (*gc)(void *private_data);
     void  (*destroy)(struct _wmem_allocator_t *allocator);
+
+    /* Usage counters, maintained by wmem_core.c */
+    wmem_allocator_stats_t       stats;
 };
 
 #ifdef __cplusplus
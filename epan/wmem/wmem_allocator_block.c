@@ -793,6 +793,16 @@ wmem_block_realloc(void *private_data, void *ptr, const size_t size)
     return ptr;
 }
 
+static size_t
+wmem_block_chunk_size(void *private_data _U_, const void *ptr)
+{
+    const wmem_block_chunk_t *chunk;
+
+    chunk = WMEM_DATA_TO_CHUNK(ptr);
+
+    return WMEM_CHUNK_DATA_LEN(chunk);
+}
+
 static void
 wmem_block_free_all(void *private_data)
 {
@@ -870,7 +880,7 @@ wmem_block_allocator_new(void)
     wmem_allocator_t       *allocator;
     wmem_block_allocator_t *block_allocator;
 
-    allocator       = g_slice_new(wmem_allocator_t);
+    allocator       = g_slice_new0(wmem_allocator_t);
     block_allocator = g_slice_new(wmem_block_allocator_t);
 
     allocator->private_data = (void*) block_allocator;
@@ -879,6 +889,8 @@ wmem_block_allocator_new(void)
     allocator->realloc = &wmem_block_realloc;
     allocator->free    = &wmem_block_free;
 
+    allocator->chunk_size = &wmem_block_chunk_size;
+
     allocator->free_all = &wmem_block_free_all;
     allocator->gc       = &wmem_block_gc;
     allocator->destroy  = &wmem_block_allocator_destroy;
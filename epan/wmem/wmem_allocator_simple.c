@@ -33,7 +33,7 @@
 #include "wmem_allocator.h"
 
 /* In this trivial allocator, we just store a GHashTable of g_malloc()ed
- * blocks in the private_data pointer. We could just set the private_data
+ * blocks (mapped to their sizes) in the private_data pointer. We could just set the private_data
  * pointer directly to the GHashTable, but we use a separate structure here
  * to demonstrate the pattern that most other allocators should follow. */
 typedef struct _wmem_simple_allocator_t {
@@ -50,7 +50,7 @@ wmem_simple_alloc(void *private_data, const size_t size)
     
     buf = g_malloc(size);
 
-    g_hash_table_insert(allocator->block_table, buf, buf);
+    g_hash_table_insert(allocator->block_table, buf, GSIZE_TO_POINTER(size));
 
     return buf;
 }
@@ -80,18 +80,27 @@ wmem_simple_realloc(void *private_data, void *ptr, const size_t size)
     
     newptr = g_realloc(ptr, size);
 
-    if (ptr != newptr) {
-        /* Realloc actually moved the memory block, so we need to replace the
-         * value in our hash table. Calling g_hash_table_remove() would trigger
-         * a g_free() which is incorrect since realloc already reclaimed the old
-         * block, so use g_hash_table_steal() instead. */
-        g_hash_table_steal(allocator->block_table, ptr);
-        g_hash_table_insert(allocator->block_table, newptr, newptr);
-    }
+    /* Realloc may have moved the memory block, and has certainly changed its
+     * size, so we need to replace the entry in our hash table. Calling
+     * g_hash_table_remove() would trigger a g_free() which is incorrect since
+     * realloc already reclaimed the old block, so use g_hash_table_steal()
+     * instead. */
+    g_hash_table_steal(allocator->block_table, ptr);
+    g_hash_table_insert(allocator->block_table, newptr, GSIZE_TO_POINTER(size));
 
     return newptr;
 }
 
+static size_t
+wmem_simple_chunk_size(void *private_data, const void *ptr)
+{
+    wmem_simple_allocator_t *allocator;
+
+    allocator = (wmem_simple_allocator_t*) private_data;
+
+    return GPOINTER_TO_SIZE(g_hash_table_lookup(allocator->block_table, ptr));
+}
+
 static void
 wmem_simple_free_all(void *private_data)
 {
@@ -128,7 +137,7 @@ wmem_simple_allocator_new(void)
     wmem_allocator_t        *allocator;
     wmem_simple_allocator_t *simple_allocator;
 
-    allocator        = g_slice_new(wmem_allocator_t);
+    allocator        = g_slice_new0(wmem_allocator_t);
     simple_allocator = g_slice_new(wmem_simple_allocator_t);
 
     allocator->private_data = (void*) simple_allocator;
@@ -137,12 +146,14 @@ wmem_simple_allocator_new(void)
     allocator->realloc = &wmem_simple_realloc;
     allocator->free    = &wmem_simple_free;
 
+    allocator->chunk_size = &wmem_simple_chunk_size;
+
     allocator->free_all = &wmem_simple_free_all;
     allocator->gc       = &wmem_simple_gc;
     allocator->destroy  = &wmem_simple_allocator_destroy;
 
     simple_allocator->block_table = g_hash_table_new_full(
-            &g_direct_hash, &g_direct_equal, NULL, &g_free);
+            &g_direct_hash, &g_direct_equal, &g_free, NULL);
 
     return allocator;
 }
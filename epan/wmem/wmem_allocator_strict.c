@@ -186,6 +186,20 @@ wmem_strict_realloc(void *private_data, void *ptr, const size_t size)
     return newblock->real_data;
 }
 
+static size_t
+wmem_strict_chunk_size(void *private_data, const void *ptr)
+{
+    wmem_strict_allocator_t       *allocator;
+    wmem_strict_allocator_block_t *block;
+
+    allocator = (wmem_strict_allocator_t*) private_data;
+
+    block = (wmem_strict_allocator_block_t *)g_hash_table_lookup(allocator->block_table, ptr);
+    g_assert(block);
+
+    return block->data_len;
+}
+
 void
 wmem_strict_check_canaries(wmem_allocator_t *allocator)
 {
@@ -239,13 +253,15 @@ wmem_strict_allocator_new(void)
     wmem_allocator_t        *allocator;
     wmem_strict_allocator_t *strict_allocator;
 
-    allocator        = g_slice_new(wmem_allocator_t);
+    allocator        = g_slice_new0(wmem_allocator_t);
     strict_allocator = g_slice_new(wmem_strict_allocator_t);
 
     allocator->alloc   = &wmem_strict_alloc;
     allocator->realloc = &wmem_strict_realloc;
     allocator->free    = &wmem_strict_free;
 
+    allocator->chunk_size = &wmem_strict_chunk_size;
+
     allocator->free_all = &wmem_strict_free_all;
     allocator->gc       = &wmem_strict_gc;
     allocator->destroy  = &wmem_strict_allocator_destroy;
@@ -34,9 +34,39 @@
 #include "wmem_allocator_block.h"
 #include "wmem_allocator_strict.h"
 
+/* The in-use byte counts use the allocator's idea of each chunk's size
+ * rather than the requested size, so that the same figure can be taken off
+ * again when the chunk is freed or reallocated. */
+static void
+wmem_stats_add_chunk(wmem_allocator_t *allocator, const void *ptr)
+{
+    wmem_allocator_stats_t *stats = &allocator->stats;
+
+    stats->in_use_chunks++;
+    stats->in_use_bytes += allocator->chunk_size(allocator->private_data, ptr);
+
+    if (stats->in_use_chunks > stats->peak_chunks) {
+        stats->peak_chunks = stats->in_use_chunks;
+    }
+    if (stats->in_use_bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->in_use_bytes;
+    }
+}
+
+static void
+wmem_stats_remove_chunk(wmem_allocator_t *allocator, const void *ptr)
+{
+    wmem_allocator_stats_t *stats = &allocator->stats;
+
+    stats->in_use_chunks--;
+    stats->in_use_bytes -= allocator->chunk_size(allocator->private_data, ptr);
+}
+
 void *
 wmem_alloc(wmem_allocator_t *allocator, const size_t size)
 {
+    void *buf;
+
     if (allocator == NULL) {
         return g_malloc(size);
     }
@@ -45,7 +75,13 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
-    return allocator->alloc(allocator->private_data, size);
+    buf = allocator->alloc(allocator->private_data, size);
+
+    allocator->stats.total_allocs++;
+    allocator->stats.total_bytes += size;
+    wmem_stats_add_chunk(allocator, buf);
+
+    return buf;
 }
 
 void *
@@ -76,6 +112,7 @@ wmem_free(wmem_allocator_t *allocator, void *ptr)
         return;
     }
 
+    wmem_stats_remove_chunk(allocator, ptr);
     allocator->free(allocator->private_data, ptr);
 }
 
@@ -95,13 +132,21 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
         return NULL;
     }
 
-    return allocator->realloc(allocator->private_data, ptr, size);
+    wmem_stats_remove_chunk(allocator, ptr);
+    ptr = allocator->realloc(allocator->private_data, ptr, size);
+    wmem_stats_add_chunk(allocator, ptr);
+
+    return ptr;
 }
 
 void
 wmem_free_all(wmem_allocator_t *allocator)
 {
     allocator->free_all(allocator->private_data);
+
+    allocator->stats.in_use_chunks = 0;
+    allocator->stats.in_use_bytes  = 0;
+    allocator->stats.free_all_count++;
 }
 
 void
@@ -170,6 +215,13 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     return allocator;
 }
 
+void
+wmem_allocator_get_stats(wmem_allocator_t *allocator,
+        wmem_allocator_stats_t *stats)
+{
+    *stats = allocator->stats;
+}
+
 void
 wmem_init(void)
 {
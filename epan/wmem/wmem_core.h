@@ -27,6 +27,7 @@
 #define __WMEM_CORE_H__
 
 #include <string.h>
+#include <glib.h>
 #include <ws_symbol_export.h>
 
 #ifdef __cplusplus
@@ -43,6 +44,19 @@ struct _wmem_allocator_t;
 
 typedef struct _wmem_allocator_t wmem_allocator_t;
 
+/* Usage counters kept by every allocator. "Chunks" are the individual
+ * allocations handed out by wmem_alloc() and friends; the in-use figures
+ * drop back to zero on every wmem_free_all(), the peaks and totals do not. */
+typedef struct _wmem_allocator_stats_t {
+    guint64 total_allocs;   /* allocations made since creation */
+    guint64 total_bytes;    /* bytes requested since creation */
+    guint   in_use_chunks;
+    gsize   in_use_bytes;
+    guint   peak_chunks;
+    gsize   peak_bytes;
+    guint   free_all_count; /* number of wmem_free_all() calls */
+} wmem_allocator_stats_t;
+
 WS_DLL_PUBLIC
 void *
 wmem_alloc(wmem_allocator_t *allocator, const size_t size);
@@ -79,6 +93,11 @@ WS_DLL_PUBLIC
 wmem_allocator_t *
 wmem_allocator_new(const wmem_allocator_type_t type);
 
+WS_DLL_PUBLIC
+void
+wmem_allocator_get_stats(wmem_allocator_t *allocator,
+        wmem_allocator_stats_t *stats);
+
 WS_DLL_LOCAL
 void
 wmem_init(void);
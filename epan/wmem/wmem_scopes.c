@@ -142,6 +142,24 @@ wmem_epan_scope(void)
     return epan_scope;
 }
 
+/* Statistics */
+
+/* Unlike the scope accessors above this may be called at any time, e.g.
+ * from a tap's draw routine after the file has been closed. */
+void
+wmem_scopes_get_stats(wmem_allocator_stats_t *packet_stats,
+        wmem_allocator_stats_t *file_stats,
+        wmem_allocator_stats_t *epan_stats)
+{
+    g_assert(packet_scope);
+    g_assert(file_scope);
+    g_assert(epan_scope);
+
+    wmem_allocator_get_stats(packet_scope, packet_stats);
+    wmem_allocator_get_stats(file_scope, file_stats);
+    wmem_allocator_get_stats(epan_scope, epan_stats);
+}
+
 /* Scope Management */
 
 void
@@ -76,6 +76,14 @@ WS_DLL_LOCAL
 void
 wmem_cleanup_scopes(void);
 
+/* Statistics */
+
+WS_DLL_PUBLIC
+void
+wmem_scopes_get_stats(wmem_allocator_stats_t *packet_stats,
+        wmem_allocator_stats_t *file_stats,
+        wmem_allocator_stats_t *epan_stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
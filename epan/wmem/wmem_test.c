@@ -47,6 +47,7 @@ main()
 #define MAX_SIMULTANEOUS_ALLOCS 1024
 #define MAX_ALLOC_SIZE (1024*64)
 #define LIST_ITERS 10000
+#define TREE_ITERS 10000
 
 typedef void (*wmem_verify_func)(wmem_allocator_t *allocator);
 
@@ -249,6 +250,63 @@ wmem_test_allocator_strict(void)
     wmem_test_allocator(WMEM_ALLOCATOR_STRICT, &wmem_strict_check_canaries);
 }
 
+static void
+wmem_test_allocator_stats(void)
+{
+    wmem_allocator_t       *allocator;
+    wmem_allocator_stats_t  stats;
+    char                   *ptrs[8];
+    int                     i;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_STRICT);
+
+    for (i=0; i<8; i++) {
+        ptrs[i] = (char *)wmem_alloc(allocator, 100);
+    }
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert(stats.total_allocs == 8);
+    g_assert(stats.in_use_chunks == 8);
+    g_assert(stats.in_use_bytes == 800);
+
+    wmem_free(allocator, ptrs[0]);
+    ptrs[1] = (char *)wmem_realloc(allocator, ptrs[1], 300);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert(stats.in_use_chunks == 7);
+    g_assert(stats.in_use_bytes == 900);
+    g_assert(stats.peak_chunks == 8);
+    g_assert(stats.peak_bytes == 900);
+
+    wmem_free_all(allocator);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert(stats.in_use_chunks == 0);
+    g_assert(stats.in_use_bytes == 0);
+    g_assert(stats.peak_bytes == 900);
+    g_assert(stats.free_all_count == 1);
+    g_assert(stats.total_bytes == 800);
+
+    wmem_destroy_allocator(allocator);
+
+    /* the block allocator rounds sizes up, but whatever it adds it must
+     * take off again */
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_BLOCK);
+
+    for (i=0; i<8; i++) {
+        ptrs[i] = (char *)wmem_alloc(allocator, 1 + i * 37);
+    }
+    for (i=0; i<8; i++) {
+        ptrs[i] = (char *)wmem_realloc(allocator, ptrs[i], 500 - i * 13);
+    }
+    for (i=0; i<8; i++) {
+        wmem_free(allocator, ptrs[i]);
+    }
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert(stats.in_use_chunks == 0);
+    g_assert(stats.in_use_bytes == 0);
+    g_assert(stats.peak_bytes >= 8 * 409);
+
+    wmem_destroy_allocator(allocator);
+}
+
 static void
 wmem_test_strutls(void)
 {
@@ -379,6 +437,124 @@ wmem_test_strbuf(void)
     wmem_destroy_allocator(allocator);
 }
 
+static gboolean
+wmem_test_foreach_cb(void *value, void *userdata)
+{
+    guint32 *expected = (guint32 *)userdata;
+
+    g_assert(GPOINTER_TO_UINT(value) == *expected);
+    (*expected)++;
+
+    return FALSE;
+}
+
+static void
+wmem_test_tree(void)
+{
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree;
+    wmem_tree_stats_t   stats;
+    wmem_tree_key_t     keys[3];
+    guint32             i, j, key[2], expected;
+
+    allocator = wmem_allocator_force_new(WMEM_ALLOCATOR_STRICT);
+
+    tree = wmem_tree_new(allocator);
+    memset(&stats, 0, sizeof(stats));
+    wmem_tree_set_stats(tree, &stats);
+    g_assert(wmem_tree_is_empty(tree));
+    g_assert(wmem_tree_lookup32(tree, 5) == NULL);
+    g_assert(wmem_tree_lookup32_le(tree, 5) == NULL);
+
+    /* insert the even numbers in a scrambled order, enough of them to
+     * make the tree several levels deep */
+    for (i=0; i<TREE_ITERS; i++) {
+        j = (i * 7919) % TREE_ITERS;
+        wmem_tree_insert32(tree, 2*j, GUINT_TO_POINTER(j));
+    }
+    g_assert(!wmem_tree_is_empty(tree));
+    g_assert(stats.keys == TREE_ITERS);
+    wmem_strict_check_canaries(allocator);
+
+    for (i=0; i<TREE_ITERS; i++) {
+        g_assert(wmem_tree_lookup32(tree, 2*i) == GUINT_TO_POINTER(i));
+        g_assert(wmem_tree_lookup32(tree, 2*i+1) == NULL);
+        g_assert(wmem_tree_lookup32_le(tree, 2*i) == GUINT_TO_POINTER(i));
+        g_assert(wmem_tree_lookup32_le(tree, 2*i+1) == GUINT_TO_POINTER(i));
+    }
+    g_assert(wmem_tree_lookup32_le(tree, G_MAXUINT32) ==
+             GUINT_TO_POINTER(TREE_ITERS-1));
+
+    expected = 0;
+    wmem_tree_foreach(tree, wmem_test_foreach_cb, &expected);
+    g_assert(expected == TREE_ITERS);
+
+    /* replacing doesn't add keys */
+    wmem_tree_insert32(tree, 0, GUINT_TO_POINTER(12345));
+    g_assert(wmem_tree_lookup32(tree, 0) == GUINT_TO_POINTER(12345));
+    g_assert(stats.keys == TREE_ITERS);
+
+    wmem_free_all(allocator);
+
+    /* array keys */
+    tree = wmem_tree_new(allocator);
+    keys[0].length = 1;
+    keys[0].key    = &key[0];
+    keys[1].length = 1;
+    keys[1].key    = &key[1];
+    keys[2].length = 0;
+    for (i=0; i<64; i++) {
+        for (j=0; j<64; j++) {
+            key[0] = i;
+            key[1] = j;
+            wmem_tree_insert32_array(tree, keys, GUINT_TO_POINTER(i*64 + j));
+        }
+    }
+    for (i=0; i<64; i++) {
+        for (j=0; j<64; j++) {
+            key[0] = i;
+            key[1] = j;
+            g_assert(wmem_tree_lookup32_array(tree, keys) ==
+                     GUINT_TO_POINTER(i*64 + j));
+            key[1] = j + 1000;
+            g_assert(wmem_tree_lookup32_array_le(tree, keys) ==
+                     GUINT_TO_POINTER(i*64 + 63));
+        }
+    }
+    key[0] = 1000;
+    key[1] = 0;
+    g_assert(wmem_tree_lookup32_array(tree, keys) == NULL);
+
+    expected = 0;
+    wmem_tree_foreach(tree, wmem_test_foreach_cb, &expected);
+    g_assert(expected == 64*64);
+    wmem_strict_check_canaries(allocator);
+
+    wmem_free_all(allocator);
+
+    /* string keys, including ones too long for the on-stack buffer */
+    tree = wmem_tree_new(allocator);
+    wmem_tree_insert_string(tree, "foo", GINT_TO_POINTER(1), 0);
+    wmem_tree_insert_string(tree, "Bar", GINT_TO_POINTER(2),
+            WMEM_TREE_STRING_NOCASE);
+    wmem_tree_insert_string(tree,
+            "a string that is quite a lot longer than sixty-four characters, "
+            "which is what fits in the packing buffer", GINT_TO_POINTER(3), 0);
+    g_assert(wmem_tree_lookup_string(tree, "foo", 0) == GINT_TO_POINTER(1));
+    g_assert(wmem_tree_lookup_string(tree, "FOO", 0) == NULL);
+    g_assert(wmem_tree_lookup_string(tree, "BAR", WMEM_TREE_STRING_NOCASE) ==
+             GINT_TO_POINTER(2));
+    g_assert(wmem_tree_lookup_string(tree, "bar", 0) == GINT_TO_POINTER(2));
+    g_assert(wmem_tree_lookup_string(tree,
+            "a string that is quite a lot longer than sixty-four characters, "
+            "which is what fits in the packing buffer", 0) ==
+             GINT_TO_POINTER(3));
+    g_assert(wmem_tree_lookup_string(tree, "fo", 0) == NULL);
+    wmem_strict_check_canaries(allocator);
+
+    wmem_destroy_allocator(allocator);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -388,11 +564,13 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/simple", wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict", wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/times",  wmem_time_allocators);
+    g_test_add_func("/wmem/allocator/stats",  wmem_test_allocator_stats);
 
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
 
     g_test_add_func("/wmem/datastruct/slist",  wmem_test_slist);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
+    g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
 
     return g_test_run();
 }
@@ -0,0 +1,629 @@
+/* wmem_tree.c
+ * Wireshark Memory Manager B-Tree
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <glib.h>
+
+#include "config.h"
+
+#include "wmem_core.h"
+#include "wmem_tree.h"
+
+/* The old emem trees were red/black trees with one node (three pointers,
+ * the key, the data and the colour) per value. Here every node holds up to
+ * WMEM_TREE_MAX_KEYS keys in sorted arrays, and leaves (which is where most
+ * of the keys live) don't carry child pointers at all, so a value costs
+ * between a third and two thirds of what it used to and lookups touch far
+ * fewer cache lines.
+ *
+ * Nothing is ever removed from a tree, so only insertion is implemented.
+ * Full nodes are split on the way down (the "preemptive split" variant of
+ * the algorithm) so that an insertion never has to walk back up. */
+#define WMEM_TREE_MIN_DEGREE 8
+#define WMEM_TREE_MAX_KEYS   (2 * WMEM_TREE_MIN_DEGREE - 1)
+
+typedef struct _wmem_tree_node_t {
+    guint8  num_keys;
+    guint8  leaf;
+    guint16 subtree_mask;   /* bit i is set if data[i] is a wmem_tree_t */
+    guint32 keys[WMEM_TREE_MAX_KEYS];
+    void   *data[WMEM_TREE_MAX_KEYS];
+    /* inner nodes only, leaves are allocated without this */
+    struct _wmem_tree_node_t *children[WMEM_TREE_MAX_KEYS + 1];
+} wmem_tree_node_t;
+
+#define WMEM_TREE_LEAF_SIZE (offsetof(wmem_tree_node_t, children))
+
+#define WMEM_TREE_IS_SUBTREE(NODE, I) (((NODE)->subtree_mask >> (I)) & 1)
+
+struct _wmem_tree_t {
+    wmem_allocator_t  *allocator;
+    wmem_tree_node_t  *root;
+    wmem_tree_stats_t *stats;
+};
+
+static void
+wmem_tree_account(wmem_tree_t *tree, gsize bytes)
+{
+    if (tree->stats) {
+        tree->stats->nodes++;
+        tree->stats->bytes += bytes;
+    }
+}
+
+wmem_tree_t *
+wmem_tree_new(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_new(allocator, wmem_tree_t);
+    tree->allocator = allocator;
+    tree->root      = NULL;
+    tree->stats     = NULL;
+
+    return tree;
+}
+
+void
+wmem_tree_set_stats(wmem_tree_t *tree, wmem_tree_stats_t *stats)
+{
+    tree->stats = stats;
+    wmem_tree_account(tree, sizeof(wmem_tree_t));
+}
+
+gboolean
+wmem_tree_is_empty(const wmem_tree_t *tree)
+{
+    return tree->root == NULL;
+}
+
+static wmem_tree_node_t *
+wmem_tree_new_node(wmem_tree_t *tree, gboolean leaf)
+{
+    wmem_tree_node_t *node;
+    gsize             size;
+
+    size = leaf ? WMEM_TREE_LEAF_SIZE : sizeof(wmem_tree_node_t);
+
+    node = (wmem_tree_node_t *)wmem_alloc(tree->allocator, size);
+    node->num_keys     = 0;
+    node->leaf         = leaf;
+    node->subtree_mask = 0;
+
+    wmem_tree_account(tree, size);
+
+    return node;
+}
+
+/* Returns the index of the first key in the node that is >= key */
+static guint
+wmem_tree_node_search(const wmem_tree_node_t *node, guint32 key)
+{
+    guint lo = 0, hi = node->num_keys, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (node->keys[mid] < key) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* Finds the node and index holding key, or returns NULL */
+static wmem_tree_node_t *
+wmem_tree_find(const wmem_tree_t *tree, guint32 key, guint *idx)
+{
+    wmem_tree_node_t *node = tree->root;
+    guint             i;
+
+    while (node) {
+        i = wmem_tree_node_search(node, key);
+        if (i < node->num_keys && node->keys[i] == key) {
+            *idx = i;
+            return node;
+        }
+        if (node->leaf) {
+            break;
+        }
+        node = node->children[i];
+    }
+
+    return NULL;
+}
+
+/* Opens a gap at position i of the key/data arrays (and the subtree mask)
+ * of a node that isn't full */
+static void
+wmem_tree_node_make_room(wmem_tree_node_t *node, guint i)
+{
+    guint16 low;
+
+    memmove(&node->keys[i + 1], &node->keys[i],
+            (node->num_keys - i) * sizeof(node->keys[0]));
+    memmove(&node->data[i + 1], &node->data[i],
+            (node->num_keys - i) * sizeof(node->data[0]));
+
+    low = node->subtree_mask & ((1 << i) - 1);
+    node->subtree_mask = low | ((node->subtree_mask >> i) << (i + 1));
+
+    node->num_keys++;
+}
+
+/* Splits the full child i of a node that isn't full around its key m: the
+ * keys above m move to a new sibling and m itself moves up into parent */
+static void
+wmem_tree_split_child(wmem_tree_t *tree, wmem_tree_node_t *parent, guint i,
+        guint m)
+{
+    wmem_tree_node_t *child, *sibling;
+
+    child   = parent->children[i];
+    sibling = wmem_tree_new_node(tree, child->leaf);
+
+    sibling->num_keys = WMEM_TREE_MAX_KEYS - 1 - m;
+    memcpy(sibling->keys, &child->keys[m + 1],
+            sibling->num_keys * sizeof(child->keys[0]));
+    memcpy(sibling->data, &child->data[m + 1],
+            sibling->num_keys * sizeof(child->data[0]));
+    sibling->subtree_mask = child->subtree_mask >> (m + 1);
+    if (!child->leaf) {
+        memcpy(sibling->children, &child->children[m + 1],
+                (sibling->num_keys + 1) * sizeof(child->children[0]));
+    }
+
+    wmem_tree_node_make_room(parent, i);
+    memmove(&parent->children[i + 2], &parent->children[i + 1],
+            (parent->num_keys - 1 - i) * sizeof(parent->children[0]));
+    parent->children[i + 1] = sibling;
+    parent->keys[i] = child->keys[m];
+    parent->data[i] = child->data[m];
+    parent->subtree_mask |= WMEM_TREE_IS_SUBTREE(child, m) << i;
+
+    child->num_keys = m;
+    child->subtree_mask &= (1 << m) - 1;
+}
+
+/* Where to split the full child i of parent before inserting key below it.
+ * Keys usually arrive in ascending order (frame numbers, sequence numbers),
+ * so when the key goes past the right edge of the tree the child is left
+ * full and the new sibling starts out empty; otherwise every node on the
+ * right edge would stay half empty for good. Nothing is ever deleted, so
+ * nodes with fewer than the usual minimum of keys don't hurt. */
+static guint
+wmem_tree_split_point(const wmem_tree_node_t *parent, guint i, guint32 key)
+{
+    const wmem_tree_node_t *child = parent->children[i];
+
+    if (i == parent->num_keys && key > child->keys[WMEM_TREE_MAX_KEYS - 1]) {
+        return WMEM_TREE_MAX_KEYS - 1;
+    }
+
+    return WMEM_TREE_MIN_DEGREE - 1;
+}
+
+/* Adds a slot for a key that is not in the tree yet and returns its node
+ * and index; the caller fills in the data */
+static wmem_tree_node_t *
+wmem_tree_add_key(wmem_tree_t *tree, guint32 key, guint *idx)
+{
+    wmem_tree_node_t *node;
+    guint             i;
+
+    if (!tree->root) {
+        tree->root = wmem_tree_new_node(tree, TRUE);
+    }
+    else if (tree->root->num_keys == WMEM_TREE_MAX_KEYS) {
+        node = wmem_tree_new_node(tree, FALSE);
+        node->children[0] = tree->root;
+        tree->root = node;
+        wmem_tree_split_child(tree, node, 0,
+                wmem_tree_split_point(node, 0, key));
+    }
+
+    node = tree->root;
+    while (!node->leaf) {
+        i = wmem_tree_node_search(node, key);
+        if (node->children[i]->num_keys == WMEM_TREE_MAX_KEYS) {
+            wmem_tree_split_child(tree, node, i,
+                    wmem_tree_split_point(node, i, key));
+            if (key > node->keys[i]) {
+                i++;
+            }
+        }
+        node = node->children[i];
+    }
+
+    i = wmem_tree_node_search(node, key);
+    wmem_tree_node_make_room(node, i);
+    node->keys[i] = key;
+    node->data[i] = NULL;
+
+    if (tree->stats) {
+        tree->stats->keys++;
+    }
+
+    *idx = i;
+    return node;
+}
+
+void
+wmem_tree_insert32(wmem_tree_t *tree, guint32 key, void *data)
+{
+    wmem_tree_node_t *node;
+    guint             i;
+
+    node = wmem_tree_find(tree, key, &i);
+    if (!node) {
+        node = wmem_tree_add_key(tree, key, &i);
+    }
+
+    node->data[i] = data;
+    node->subtree_mask &= ~(1 << i);
+}
+
+void *
+wmem_tree_lookup32(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_tree_node_t *node;
+    guint             i;
+
+    node = wmem_tree_find(tree, key, &i);
+
+    return node ? node->data[i] : NULL;
+}
+
+void *
+wmem_tree_lookup32_le(const wmem_tree_t *tree, guint32 key)
+{
+    wmem_tree_node_t *node = tree->root;
+    void             *best = NULL;
+    guint             i;
+
+    /* Every step down the tree narrows the range of keys below us, so the
+     * last key smaller than the search key seen on the way down is the
+     * largest one in the whole tree. */
+    while (node) {
+        i = wmem_tree_node_search(node, key);
+        if (i < node->num_keys && node->keys[i] == key) {
+            return node->data[i];
+        }
+        if (i > 0) {
+            best = node->data[i - 1];
+        }
+        if (node->leaf) {
+            break;
+        }
+        node = node->children[i];
+    }
+
+    return best;
+}
+
+/* Returns the subtree stored under key, creating it if needed */
+static wmem_tree_t *
+wmem_tree_lookup_or_create_subtree(wmem_tree_t *tree, guint32 key)
+{
+    wmem_tree_node_t *node;
+    wmem_tree_t      *subtree;
+    guint             i;
+
+    node = wmem_tree_find(tree, key, &i);
+    if (node) {
+        return (wmem_tree_t *)node->data[i];
+    }
+
+    node = wmem_tree_add_key(tree, key, &i);
+
+    subtree = wmem_tree_new(tree->allocator);
+    if (tree->stats) {
+        wmem_tree_set_stats(subtree, tree->stats);
+    }
+
+    node->data[i] = subtree;
+    node->subtree_mask |= 1 << i;
+
+    return subtree;
+}
+
+void
+wmem_tree_insert32_array(wmem_tree_t *tree, wmem_tree_key_t *key, void *data)
+{
+    wmem_tree_t     *insert_tree = NULL;
+    wmem_tree_key_t *cur_key;
+    guint32          i, insert_key32 = 0;
+
+    for (cur_key = key; cur_key->length > 0; cur_key++) {
+        for (i = 0; i < cur_key->length; i++) {
+            /* Insert using the previous key32 */
+            if (!insert_tree) {
+                insert_tree = tree;
+            }
+            else {
+                insert_tree = wmem_tree_lookup_or_create_subtree(insert_tree,
+                        insert_key32);
+            }
+            insert_key32 = cur_key->key[i];
+        }
+    }
+
+    g_assert(insert_tree);
+
+    wmem_tree_insert32(insert_tree, insert_key32, data);
+}
+
+static void *
+wmem_tree_lookup32_array_helper(const wmem_tree_t *tree, wmem_tree_key_t *key,
+        void *(*lookup)(const wmem_tree_t *, guint32))
+{
+    const wmem_tree_t *lookup_tree = NULL;
+    wmem_tree_key_t   *cur_key;
+    guint32            i, lookup_key32 = 0;
+
+    for (cur_key = key; cur_key->length > 0; cur_key++) {
+        for (i = 0; i < cur_key->length; i++) {
+            /* Lookup using the previous key32 */
+            if (!lookup_tree) {
+                lookup_tree = tree;
+            }
+            else {
+                lookup_tree = (const wmem_tree_t *)(*lookup)(lookup_tree,
+                        lookup_key32);
+                if (!lookup_tree) {
+                    return NULL;
+                }
+            }
+            lookup_key32 = cur_key->key[i];
+        }
+    }
+
+    g_assert(lookup_tree);
+
+    return (*lookup)(lookup_tree, lookup_key32);
+}
+
+void *
+wmem_tree_lookup32_array(const wmem_tree_t *tree, wmem_tree_key_t *key)
+{
+    return wmem_tree_lookup32_array_helper(tree, key, &wmem_tree_lookup32);
+}
+
+void *
+wmem_tree_lookup32_array_le(const wmem_tree_t *tree, wmem_tree_key_t *key)
+{
+    return wmem_tree_lookup32_array_helper(tree, key, &wmem_tree_lookup32_le);
+}
+
+/* Strings are stored as an array of uint32 containing the string characters
+ * with 4 characters in each uint32. The first byte of the string is stored
+ * as the most significant byte. If the string is not a multiple of 4
+ * characters in length the last uint32 containing the string bytes is
+ * padded with 0 bytes. After the uint32s containing the string, there is
+ * one final terminator uint32 with the value 0x00000001.
+ *
+ * Short strings are packed into the caller's buffer of buf_len words, longer
+ * ones into a g_malloc()ed one that the caller must free. */
+#define WMEM_TREE_STRING_BUF_LEN 16
+
+static guint32 *
+wmem_tree_pack_string(const gchar *k, guint32 flags, guint32 *buf,
+        wmem_tree_key_t key[2])
+{
+    guint32  len  = (guint32) strlen(k);
+    guint32  divx = (len + 3) / 4 + 1;
+    guint32 *aligned;
+    guint32  i, tmp;
+
+    if (divx <= WMEM_TREE_STRING_BUF_LEN) {
+        aligned = buf;
+    }
+    else {
+        aligned = g_new(guint32, divx);
+    }
+
+    /* pack the bytes one one by one into guint32s */
+    tmp = 0;
+    for (i = 0; i < len; i++) {
+        unsigned char ch;
+
+        ch = (unsigned char)k[i];
+        if (flags & WMEM_TREE_STRING_NOCASE) {
+            if (isupper(ch)) {
+                ch = tolower(ch);
+            }
+        }
+        tmp <<= 8;
+        tmp |= ch;
+        if (i % 4 == 3) {
+            aligned[i / 4] = tmp;
+            tmp = 0;
+        }
+    }
+    /* add required padding to the last uint32 */
+    if (i % 4 != 0) {
+        while (i % 4 != 0) {
+            i++;
+            tmp <<= 8;
+        }
+        aligned[i / 4 - 1] = tmp;
+    }
+
+    /* add the terminator */
+    aligned[divx - 1] = 0x00000001;
+
+    key[0].length = divx;
+    key[0].key    = aligned;
+    key[1].length = 0;
+    key[1].key    = NULL;
+
+    return aligned;
+}
+
+void
+wmem_tree_insert_string(wmem_tree_t *tree, const gchar *k, void *data,
+        guint32 flags)
+{
+    wmem_tree_key_t  key[2];
+    guint32          buf[WMEM_TREE_STRING_BUF_LEN];
+    guint32         *aligned;
+
+    aligned = wmem_tree_pack_string(k, flags, buf, key);
+
+    wmem_tree_insert32_array(tree, key, data);
+
+    if (aligned != buf) {
+        g_free(aligned);
+    }
+}
+
+void *
+wmem_tree_lookup_string(const wmem_tree_t *tree, const gchar *k,
+        guint32 flags)
+{
+    wmem_tree_key_t  key[2];
+    guint32          buf[WMEM_TREE_STRING_BUF_LEN];
+    guint32         *aligned;
+    void            *ret;
+
+    aligned = wmem_tree_pack_string(k, flags, buf, key);
+
+    ret = wmem_tree_lookup32_array(tree, key);
+
+    if (aligned != buf) {
+        g_free(aligned);
+    }
+
+    return ret;
+}
+
+static gboolean
+wmem_tree_foreach_nodes(const wmem_tree_node_t *node,
+        wmem_foreach_func callback, void *user_data)
+{
+    guint i;
+
+    for (i = 0; i <= node->num_keys; i++) {
+        if (!node->leaf &&
+                wmem_tree_foreach_nodes(node->children[i], callback, user_data)) {
+            return TRUE;
+        }
+        if (i == node->num_keys) {
+            break;
+        }
+        if (WMEM_TREE_IS_SUBTREE(node, i)) {
+            if (wmem_tree_foreach((const wmem_tree_t *)node->data[i],
+                        callback, user_data)) {
+                return TRUE;
+            }
+        }
+        else if (callback(node->data[i], user_data)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+gboolean
+wmem_tree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback,
+        void *user_data)
+{
+    if (!tree || !tree->root) {
+        return FALSE;
+    }
+
+    return wmem_tree_foreach_nodes(tree->root, callback, user_data);
+}
+
+static void wmem_print_subtree(const wmem_tree_t *tree, guint32 level);
+
+static void
+wmem_tree_print_nodes(const wmem_tree_node_t *node, guint32 level)
+{
+    guint i, j;
+
+    for (i = 0; i <= node->num_keys; i++) {
+        if (!node->leaf) {
+            wmem_tree_print_nodes(node->children[i], level + 1);
+        }
+        if (i == node->num_keys) {
+            break;
+        }
+        for (j = 0; j < level; j++) {
+            printf("    ");
+        }
+        printf("NODE:%p key:%u %s:%p\n", (const void *)node, node->keys[i],
+                WMEM_TREE_IS_SUBTREE(node, i) ? "tree" : "data",
+                node->data[i]);
+        if (WMEM_TREE_IS_SUBTREE(node, i)) {
+            wmem_print_subtree((const wmem_tree_t *)node->data[i], level + 1);
+        }
+    }
+}
+
+static void
+wmem_print_subtree(const wmem_tree_t *tree, guint32 level)
+{
+    guint32 i;
+
+    if (!tree) {
+        return;
+    }
+
+    for (i = 0; i < level; i++) {
+        printf("    ");
+    }
+
+    printf("WMEM tree:%p root:%p\n", (const void *)tree,
+            (const void *)tree->root);
+    if (tree->root) {
+        wmem_tree_print_nodes(tree->root, level + 1);
+    }
+}
+
+void
+wmem_print_tree(const wmem_tree_t *tree)
+{
+    wmem_print_subtree(tree, 0);
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,147 @@
+/* wmem_tree.h
+ * Definitions for the Wireshark Memory Manager B-Tree
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __WMEM_TREE_H__
+#define __WMEM_TREE_H__
+
+#include <string.h>
+#include <glib.h>
+
+#include "wmem_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+struct _wmem_tree_t;
+
+typedef struct _wmem_tree_t wmem_tree_t;
+
+/* Memory used by a tree, including the subtrees created for array and
+ * string keys. Several trees may share one of these, see
+ * wmem_tree_set_stats(). */
+typedef struct _wmem_tree_stats_t {
+    guint   nodes;      /* B-tree nodes and subtree headers */
+    guint   keys;       /* values stored, at every level */
+    gsize   bytes;      /* bytes allocated for the above */
+} wmem_tree_stats_t;
+
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new(wmem_allocator_t *allocator)
+G_GNUC_MALLOC;
+
+/* Accumulate the memory used by the tree (and any subtree it creates from
+ * now on) into *stats. Call this before inserting anything. */
+WS_DLL_PUBLIC
+void
+wmem_tree_set_stats(wmem_tree_t *tree, wmem_tree_stats_t *stats);
+
+WS_DLL_PUBLIC
+gboolean
+wmem_tree_is_empty(const wmem_tree_t *tree);
+
+/* Insert data keyed by a 32-bit integer, replacing any data already stored
+ * under the same key. */
+WS_DLL_PUBLIC
+void
+wmem_tree_insert32(wmem_tree_t *tree, guint32 key, void *data);
+
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup32(const wmem_tree_t *tree, guint32 key);
+
+/* Returns the data stored under the largest key that is less than or equal
+ * to the search key, or NULL if there is none. */
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup32_le(const wmem_tree_t *tree, guint32 key);
+
+/* A key made of several arrays of 32-bit integers, terminated by an entry
+ * with a length of 0. Every key inserted below the same prefix must have
+ * the same total length; see emem_tree_insert32_array() in epan/emem.h. */
+typedef struct _wmem_tree_key_t {
+    guint32  length;    /* length in guint32 words */
+    guint32 *key;
+} wmem_tree_key_t;
+
+WS_DLL_PUBLIC
+void
+wmem_tree_insert32_array(wmem_tree_t *tree, wmem_tree_key_t *key, void *data);
+
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup32_array(const wmem_tree_t *tree, wmem_tree_key_t *key);
+
+/* As wmem_tree_lookup32_le(), one key word at a time: the result is "less"
+ * in key order and has to be verified by the caller. */
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup32_array_le(const wmem_tree_t *tree, wmem_tree_key_t *key);
+
+/* case insensitive strings as keys */
+#define WMEM_TREE_STRING_NOCASE 0x00000001
+
+WS_DLL_PUBLIC
+void
+wmem_tree_insert_string(wmem_tree_t *tree, const gchar *key, void *data,
+        guint32 flags);
+
+WS_DLL_PUBLIC
+void *
+wmem_tree_lookup_string(const wmem_tree_t *tree, const gchar *key,
+        guint32 flags);
+
+/* Calls the callback for every value in key order (array and string keyed
+ * values in the order of their key words). If the callback returns TRUE the
+ * traversal stops and TRUE is returned. */
+typedef gboolean (*wmem_foreach_func)(void *value, void *userdata);
+
+WS_DLL_PUBLIC
+gboolean
+wmem_tree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback,
+        void *user_data);
+
+WS_DLL_PUBLIC
+void
+wmem_print_tree(const wmem_tree_t *tree);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WMEM_TREE_H__ */
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -409,8 +409,8 @@ WSLUA_METHOD Dumper_dump_current(lua_State* L) {
     pkthdr.pkt_encap = lua_pinfo->fd->lnk_t;
     pkthdr.pseudo_header = *lua_pinfo->pseudo_header;
 
-    if (lua_pinfo->fd->opt_comment)
-        pkthdr.opt_comment = ep_strdup(lua_pinfo->fd->opt_comment);
+    if (frame_data_get_comment(lua_pinfo->fd))
+        pkthdr.opt_comment = ep_strdup(frame_data_get_comment(lua_pinfo->fd));
 
     data = (const guchar *)ep_tvb_memdup(tvb,0,pkthdr.caplen);
 
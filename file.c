@@ -114,7 +114,8 @@ static gulong computed_elapsed;
 static void cf_reset_state(capture_file *cf);
 
 static int read_packet(capture_file *cf, dfilter_t *dfcode,
-    gboolean create_proto_tree, column_info *cinfo, gint64 offset);
+    gboolean create_proto_tree, column_info *cinfo,
+    struct wtap_pkthdr *phdr, const guchar *buf, gint64 offset);
 
 static void rescan_packets(capture_file *cf, const char *action, const char *action_item, gboolean redissect);
 
@@ -520,6 +521,35 @@ calc_progbar_val(capture_file *cf, gint64 size, gint64 file_pos, gchar *status_s
   return progbar_val;
 }
 
+/*
+ * Read packet number "n" of a file with an up to date capture index.
+ * The index has the packet header; only the data, the pseudo-header and
+ * the comment have to be read, and that's done without reading through
+ * the file.
+ */
+static gboolean
+read_indexed_packet(capture_file *cf, wtap_index *idx, guint32 n,
+                    struct wtap_pkthdr *phdr, guint8 *pd,
+                    int *err, gchar **err_info, gint64 *data_offset)
+{
+  struct wtap_pkthdr rphdr;
+
+  *data_offset = wtap_index_get(idx, n, phdr);
+  if (phdr->caplen > WTAP_MAX_PACKET_SIZE) {
+    *err = WTAP_ERR_BAD_FILE;
+    *err_info = g_strdup_printf("capture index: packet %u is too big", n + 1);
+    return FALSE;
+  }
+  if (!wtap_seek_read(cf->wth, *data_offset, &rphdr, pd, phdr->caplen,
+                      err, err_info))
+    return FALSE;
+
+  phdr->pseudo_header = rphdr.pseudo_header;
+  if (phdr->presence_flags & WTAP_HAS_COMMENTS)
+    phdr->opt_comment = rphdr.opt_comment;
+  return TRUE;
+}
+
 cf_read_status_t
 cf_read(capture_file *cf, gboolean reloading)
 {
@@ -533,6 +563,8 @@ cf_read(capture_file *cf, gboolean reloading)
   volatile gboolean    create_proto_tree;
   guint                tap_flags;
   gboolean             compiled;
+  wtap_index          *idx;
+  guint8              *idx_pd         = NULL;
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -559,6 +591,20 @@ cf_read(capture_file *cf, gboolean reloading)
      XXX - do we know this at open time? */
   cf->iscompressed = wtap_iscompressed(cf->wth);
 
+  /* If the file has an up to date index, we know where every packet is
+     and what its header is, and only have to read the packet data; the
+     packets are still dissected in order, as the first pass needs. */
+  err = 0;
+  idx = wtap_index_open(cf->wth, cf->filename);
+  if (idx != NULL) {
+    idx_pd = (guint8 *)g_malloc(WTAP_MAX_PACKET_SIZE);
+  } else if (!cf->is_tempfile && getenv("WIRESHARK_CAPTURE_INDEX") != NULL) {
+    /* Save an index as the file is read through.  Not for a temporary
+       file, which is a capture we've just made; a file that's still
+       being captured to is read with cf_continue_tail(), never here. */
+    wtap_save_index(cf->wth, cf->filename);
+  }
+
   /* The packet list window will be empty until the file is completly loaded */
   packet_list_freeze();
 
@@ -570,11 +616,16 @@ cf_read(capture_file *cf, gboolean reloading)
     int     displayed_once    = 0;
 #endif
     int     count             = 0;
+    guint32 idx_next          = 0;
 
     gint64  size;
     gint64  file_pos;
     gint64  data_offset;
 
+    struct wtap_pkthdr  idx_phdr;
+    struct wtap_pkthdr *phdr;
+    const guchar       *pd;
+
     gint64  progbar_quantum;
     gint64  progbar_nextstep;
     float   progbar_val;
@@ -600,10 +651,24 @@ cf_read(capture_file *cf, gboolean reloading)
     /* Progress so far. */
     progbar_val = 0.0f;
 
-    while ((wtap_read(cf->wth, &err, &err_info, &data_offset))) {
+    for (;;) {
+      if (idx != NULL) {
+        if (idx_next == wtap_index_count(idx) ||
+            !read_indexed_packet(cf, idx, idx_next, &idx_phdr, idx_pd,
+                                 &err, &err_info, &data_offset))
+          break;
+        idx_next++;
+        phdr = &idx_phdr;
+        pd = idx_pd;
+      } else {
+        if (!wtap_read(cf->wth, &err, &err_info, &data_offset))
+          break;
+        phdr = wtap_phdr(cf->wth);
+        pd = wtap_buf_ptr(cf->wth);
+      }
       if (size >= 0) {
         count++;
-        file_pos = wtap_read_so_far(cf->wth);
+        file_pos = (idx != NULL) ? data_offset : wtap_read_so_far(cf->wth);
 
         /* Create the progress bar if necessary.
          * Check whether it should be created or not every MIN_NUMBER_OF_PACKET
@@ -650,7 +715,7 @@ cf_read(capture_file *cf, gboolean reloading)
            hours even on fast machines) just to see that it was the wrong file. */
         break;
       }
-      read_packet(cf, dfcode, create_proto_tree, cinfo, data_offset);
+      read_packet(cf, dfcode, create_proto_tree, cinfo, phdr, pd, data_offset);
     }
   }
   CATCH(OutOfMemoryError) {
@@ -670,6 +735,11 @@ cf_read(capture_file *cf, gboolean reloading)
   /* Free the display name */
   g_free(name_ptr);
 
+  if (idx != NULL) {
+    wtap_index_close(idx);
+    g_free(idx_pd);
+  }
+
   /* Cleanup and release all dfilter resources */
   if (dfcode != NULL) {
     dfilter_free(dfcode);
@@ -837,7 +907,8 @@ cf_continue_tail(capture_file *cf, volatile int to_read, int *err)
            aren't any packets left to read) exit. */
         break;
       }
-      if (read_packet(cf, dfcode, create_proto_tree, (column_info *) cinfo, data_offset) != -1) {
+      if (read_packet(cf, dfcode, create_proto_tree, (column_info *) cinfo,
+                      wtap_phdr(cf->wth), wtap_buf_ptr(cf->wth), data_offset) != -1) {
         newly_displayed_packets++;
       }
       to_read--;
@@ -947,7 +1018,8 @@ cf_finish_tail(capture_file *cf, int *err)
          aren't any packets left to read) exit. */
       break;
     }
-    read_packet(cf, dfcode, create_proto_tree, cinfo, data_offset);
+    read_packet(cf, dfcode, create_proto_tree, cinfo,
+                wtap_phdr(cf->wth), wtap_buf_ptr(cf->wth), data_offset);
   }
 
   /* Cleanup and release all dfilter resources */
@@ -1183,10 +1255,9 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
 /* returns the row of the new packet in the packet list or -1 if not displayed */
 static int
 read_packet(capture_file *cf, dfilter_t *dfcode,
-            gboolean create_proto_tree, column_info *cinfo, gint64 offset)
+            gboolean create_proto_tree, column_info *cinfo,
+            struct wtap_pkthdr *phdr, const guchar *buf, gint64 offset)
 {
-  struct wtap_pkthdr *phdr = wtap_phdr(cf->wth);
-  const guchar *buf = wtap_buf_ptr(cf->wth);
   frame_data    fdlocal;
   guint32       framenum;
   frame_data   *fdata;
@@ -1222,7 +1293,7 @@ read_packet(capture_file *cf, dfilter_t *dfcode,
     fdata = frame_data_sequence_add(cf->frames, &fdlocal);
 
     cf->count++;
-    if (fdlocal.opt_comment != NULL)
+    if (frame_data_get_comment(&fdlocal) != NULL)
       cf->packet_comment_count++;
     cf->f_datalen = offset + fdlocal.cap_len;
 
@@ -3868,17 +3939,15 @@ cf_update_capture_comment(capture_file *cf, gchar *comment)
 void
 cf_update_packet_comment(capture_file *cf, frame_data *fdata, gchar *comment)
 {
-  if (fdata->opt_comment != NULL) {
+  if (frame_data_get_comment(fdata) != NULL) {
     /* OK, remove the old comment. */
-    g_free(fdata->opt_comment);
-    fdata->opt_comment = NULL;
     cf->packet_comment_count--;
   }
   if (comment != NULL) {
     /* Add the new comment. */
-    fdata->opt_comment = comment;
     cf->packet_comment_count++;
   }
+  frame_data_set_comment(fdata, comment);
 
   /* OK, we have unsaved changes. */
   cf->unsaved_changes = TRUE;
@@ -3951,7 +4020,7 @@ save_packet(capture_file *cf _U_, frame_data *fdata,
   hdr.interface_id = fdata->interface_id;   /* identifier of the interface. */
   /* options */
   hdr.pack_flags   = fdata->pack_flags;
-  hdr.opt_comment  = fdata->opt_comment; /* NULL if not available */
+  hdr.opt_comment  = (gchar *)frame_data_get_comment(fdata); /* NULL if not available */
   /* pseudo */
   hdr.pseudo_header = phdr->pseudo_header;
 #if 0
@@ -4612,9 +4681,8 @@ cf_save_packets(capture_file *cf, const char *fname, guint save_format,
       /* Remove packet comments. */
       for (framenum = 1; framenum <= cf->count; framenum++) {
         fdata = frame_data_sequence_find(cf->frames, framenum);
-        if (fdata->opt_comment) {
-          g_free(fdata->opt_comment);
-          fdata->opt_comment = NULL;
+        if (frame_data_get_comment(fdata)) {
+          frame_data_set_comment(fdata, NULL);
           cf->packet_comment_count--;
         }
       }
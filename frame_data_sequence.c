@@ -31,36 +31,27 @@
 #include "frame_data_sequence.h"
 
 /*
- * We store the frame_data structures in a radix tree, with 1024
- * elements per level.  The leaf nodes are arrays of 1024 frame_data
- * structures; the nodes above them are arrays of 1024 pointers to
- * the nodes below them.  The capture_file structure has a pointer
- * to the root node.
- *
- * As frame numbers are 32 bits, and as 1024 is 2^10, that gives us
- * up to 4 levels of tree.
+ * We store the frame_data structures in chunks of FRAMES_PER_CHUNK
+ * elements; the frame_data_sequence structure has an array of pointers
+ * to the chunks, which is grown, by doubling it, as chunks are added.
+ * Finding a frame is thus two array lookups, whatever the number of
+ * frames, and only the (small) array of chunk pointers is ever
+ * reallocated, so pointers to frame_data structures remain valid
+ * until the sequence is freed.
  */
-#define LOG2_NODES_PER_LEVEL	10
-#define NODES_PER_LEVEL		(1<<LOG2_NODES_PER_LEVEL)
+#define LOG2_FRAMES_PER_CHUNK	10
+#define FRAMES_PER_CHUNK	(1<<LOG2_FRAMES_PER_CHUNK)
+
+#define CHUNK_INDEX(index)	((index) >> LOG2_FRAMES_PER_CHUNK)
+#define FRAME_INDEX(index)	((index) & (FRAMES_PER_CHUNK - 1))
 
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
-  void        *ptree_root;      /* Pointer to the root node */
+  guint32      chunk_count;     /* Number of chunks allocated */
+  guint32      chunk_slots;     /* Number of elements of chunks */
+  frame_data **chunks;          /* Pointers to the chunks */
 };
 
-/*
- * For a given frame number, calculate the indices into a level 3
- * node, a level 2 node, a level 1 node, and a leaf node.
- */
-#define LEVEL_3_INDEX(framenum) \
-	((framenum) >> (3*LOG2_NODES_PER_LEVEL))
-#define LEVEL_2_INDEX(framenum) \
-	(((framenum) >> (2*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
-#define LEVEL_1_INDEX(framenum) \
-	(((framenum) >> (1*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
-#define LEAF_INDEX(framenum) \
-	(((framenum) >> (0*LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1))
-
 frame_data_sequence *
 new_frame_data_sequence(void)
 {
@@ -68,7 +59,9 @@ new_frame_data_sequence(void)
 
 	fds = (frame_data_sequence *)g_malloc(sizeof *fds);
 	fds->count = 0;
-	fds->ptree_root = NULL;
+	fds->chunk_count = 0;
+	fds->chunk_slots = 0;
+	fds->chunks = NULL;
 	return fds;
 }
 
@@ -78,10 +71,6 @@ new_frame_data_sequence(void)
 frame_data *
 frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
 {
-  frame_data *leaf;
-  frame_data **level1;
-  frame_data ***level2;
-  frame_data ****level3;
   frame_data *node;
 
   /*
@@ -91,96 +80,17 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
    * the last frame in the collection is fds->count, so its index value
    * is fds->count - 1.
    */
-  if (fds->count == 0) {
-    /* The tree is empty; allocate the first leaf node, which will be
-       the root node. */
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    node = &leaf[0];
-    fds->ptree_root = leaf;
-  } else if (fds->count < NODES_PER_LEVEL) {
-    /* It's a 1-level tree, and is going to stay that way for now. */
-    leaf = (frame_data *)fds->ptree_root;
-    node = &leaf[fds->count];
-  } else if (fds->count == NODES_PER_LEVEL) {
-    /* It's a 1-level tree that will turn into a 2-level tree. */
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level1[0] = (frame_data *)fds->ptree_root;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[1] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level1;
-  } else if (fds->count < NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree, and is going to stay that way for now. */
-    level1 = (frame_data **)fds->ptree_root;
-    leaf = level1[fds->count >> LOG2_NODES_PER_LEVEL];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[fds->count >> LOG2_NODES_PER_LEVEL] = leaf;
-    }
-    node = &leaf[LEAF_INDEX(fds->count)];
-  } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree that will turn into a 3-level tree */
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-    level2[0] = (frame_data **)fds->ptree_root;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level2[1] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[0] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level2;
-  } else if (fds->count < NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree, and is going to stay that way for now. */
-    level2 = (frame_data ***)fds->ptree_root;
-    level1 = level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-    if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-      level2[fds->count >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)] = level1;
-    }
-    leaf = level1[LEVEL_1_INDEX(fds->count)];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[LEVEL_1_INDEX(fds->count)] = leaf;
-    }
-    node = &leaf[LEAF_INDEX(fds->count)];
-  } else if (fds->count == NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree that will turn into a 4-level tree */
-    level3 = (frame_data ****)g_malloc0((sizeof *level3)*NODES_PER_LEVEL);
-    level3[0] = (frame_data ***)fds->ptree_root;
-    level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-    level3[1] = level2;
-    level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-    level2[0] = level1;
-    leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-    level1[0] = leaf;
-    node = &leaf[0];
-    fds->ptree_root = level3;
-  } else {
-    /* fds->count is 2^32-1 at most, and NODES_PER_LEVEL^4
-       2^(LOG2_NODES_PER_LEVEL*4), and LOG2_NODES_PER_LEVEL is 10,
-       so fds->count is always less < NODES_PER_LEVEL^4.
-
-       XXX - we should fail if fds->count is 2^31-1, or should
-       make the frame numbers 64-bit and just let users run
-       themselves out of address space or swap space. :-) */
-    /* It's a 4-level tree, and is going to stay that way forever. */
-    level3 = (frame_data ****)fds->ptree_root;
-    level2 = level3[LEVEL_3_INDEX(fds->count)];
-    if (level2 == NULL) {
-      level2 = (frame_data ***)g_malloc0((sizeof *level2)*NODES_PER_LEVEL);
-      level3[LEVEL_3_INDEX(fds->count)] = level2;
+  if (CHUNK_INDEX(fds->count) == fds->chunk_count) {
+    /* The last chunk is full, or there isn't one yet; add a chunk. */
+    if (fds->chunk_count == fds->chunk_slots) {
+      fds->chunk_slots = fds->chunk_slots ? fds->chunk_slots * 2 : 16;
+      fds->chunks = (frame_data **)g_realloc(fds->chunks,
+          (sizeof *fds->chunks)*fds->chunk_slots);
     }
-    level1 = level2[LEVEL_2_INDEX(fds->count)];
-    if (level1 == NULL) {
-      level1 = (frame_data **)g_malloc0((sizeof *level1)*NODES_PER_LEVEL);
-      level2[LEVEL_2_INDEX(fds->count)] = level1;
-    }
-    leaf = level1[LEVEL_1_INDEX(fds->count)];
-    if (leaf == NULL) {
-      leaf = (frame_data *)g_malloc((sizeof *leaf)*NODES_PER_LEVEL);
-      level1[LEVEL_1_INDEX(fds->count)] = leaf;
-    }
-    node = &leaf[LEAF_INDEX(fds->count)];
+    fds->chunks[fds->chunk_count++] =
+        (frame_data *)g_malloc((sizeof **fds->chunks)*FRAMES_PER_CHUNK);
   }
+  node = &fds->chunks[CHUNK_INDEX(fds->count)][FRAME_INDEX(fds->count)];
   *node = *fdata;
   fds->count++;
   return node;
@@ -192,11 +102,6 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
 frame_data *
 frame_data_sequence_find(frame_data_sequence *fds, guint32 num)
 {
-  frame_data *leaf;
-  frame_data **level1;
-  frame_data ***level2;
-  frame_data ****level3;
-
   if (num == 0) {
     /* There is no frame number 0 */
     return NULL;
@@ -209,82 +114,7 @@ frame_data_sequence_find(frame_data_sequence *fds, guint32 num)
     return NULL;
   }
 
-  if (fds->count <= NODES_PER_LEVEL) {
-    /* It's a 1-level tree. */
-    leaf = (frame_data *)fds->ptree_root;
-    return &leaf[num];
-  }
-  if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 2-level tree. */
-    level1 = (frame_data **)fds->ptree_root;
-    leaf = level1[num >> LOG2_NODES_PER_LEVEL];
-    return &leaf[LEAF_INDEX(num)];
-  }
-  if (fds->count <= NODES_PER_LEVEL*NODES_PER_LEVEL*NODES_PER_LEVEL) {
-    /* It's a 3-level tree. */
-    level2 = (frame_data ***)fds->ptree_root;
-    level1 = level2[num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-    leaf = level1[(num >> LOG2_NODES_PER_LEVEL) & (NODES_PER_LEVEL - 1)];
-    return &leaf[LEAF_INDEX(num)];
-  }
-  /* fds->count is 2^32-1 at most, and NODES_PER_LEVEL^4
-     2^(LOG2_NODES_PER_LEVEL*4), and LOG2_NODES_PER_LEVEL is 10,
-     so fds->count is always less < NODES_PER_LEVEL^4. */
-  /* It's a 4-level tree, and is going to stay that way forever. */
-  level3 = (frame_data ****)fds->ptree_root;
-  level2 = level3[num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)];
-  level1 = level2[(num >> (LOG2_NODES_PER_LEVEL+LOG2_NODES_PER_LEVEL)) & (NODES_PER_LEVEL - 1)];
-  leaf = level1[(num >> LOG2_NODES_PER_LEVEL) & (NODES_PER_LEVEL - 1)];
-  return &leaf[LEAF_INDEX(num)];
-}
-
-/* recursively frees a frame_data radix level */
-void
-free_frame_data_array(void *array, guint count, guint level, gboolean last)
-{
-  guint i, level_count;
-
-  if (last) {
-    /* if we are the last in our given parent's row, we may not have
-     * exactly a full row, so do the bit twiddling to figure out exactly
-     * how many fields we have */
-    level_count = (count >> ((level - 1) * LOG2_NODES_PER_LEVEL)) &
-                  (NODES_PER_LEVEL - 1);
-    /* the above calculation rounds down, so make sure we count correctly
-     * if count is not an even multiple of NODES_PER_LEVEL */
-    if (count & ((1 << ((level - 1) * LOG2_NODES_PER_LEVEL)) - 1)) {
-      level_count++;
-    }
-  }
-  else {
-    /* if we're not the last in our parent, then we're guaranteed to have
-     * a full array */
-    level_count = NODES_PER_LEVEL;
-  }
-
-
-  if (level > 1) {
-    /* recurse on every sub-array, passing on our own 'last' value
-     * specially to our last child */
-    frame_data **real_array = (frame_data **) array;
-
-    for (i=0; i < level_count-1; i++) {
-      free_frame_data_array(real_array[i], count, level-1, FALSE);
-    }
-
-    free_frame_data_array(real_array[level_count-1], count, level-1, last);
-  }
-  else if (level == 1) {
-    /* bottom level, so just clean up all the frame data */
-    frame_data *real_array = (frame_data *) array;
-
-    for (i=0; i < level_count; i++) {
-      frame_data_destroy(&real_array[i]);
-    }
-  }
-
-  /* free the array itself */
-  g_free(array);
+  return &fds->chunks[CHUNK_INDEX(num)][FRAME_INDEX(num)];
 }
 
 /*
@@ -293,19 +123,15 @@ free_frame_data_array(void *array, guint count, guint level, gboolean last)
 void
 free_frame_data_sequence(frame_data_sequence *fds)
 {
-  guint32 count  = fds->count;
-  guint   levels = 0;
+  guint32 i;
 
-  /* calculate how many levels we have */
-  while (count) {
-    levels++;
-    count >>= LOG2_NODES_PER_LEVEL;
+  for (i = 0; i < fds->count; i++) {
+    frame_data_destroy(&fds->chunks[CHUNK_INDEX(i)][FRAME_INDEX(i)]);
   }
-
-  /* call the recursive free function */
-  if (levels > 0) {
-    free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
+  for (i = 0; i < fds->chunk_count; i++) {
+    g_free(fds->chunks[i]);
   }
+  g_free(fds->chunks);
 
   /* free the header struct */
   g_free(fds);
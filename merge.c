@@ -45,47 +45,247 @@
 #include "wtap.h"
 #include "merge.h"
 
+/*
+ * State shared by all the input files of one merge.
+ */
+typedef struct merge_state_s {
+  int               in_file_count;
+  merge_in_file_t **heap;         /* min-heap of files with a pending packet */
+  int               heap_count;   /* number of entries in heap */
+  gboolean          heap_primed;  /* heap has been filled with every file's first packet */
+  int               max_open;     /* maximum number of open files, 0 for no limit */
+  int               open_count;   /* number of files currently open */
+  merge_in_file_t  *in_files;
+} merge_state_t;
+
+/*
+ * Record the per-file information callers may need while the file is
+ * parked.
+ */
+static void
+merge_in_file_cache_info(merge_in_file_t *in_file)
+{
+  in_file->file_type       = wtap_file_type(in_file->wth);
+  in_file->file_encap      = wtap_file_encap(in_file->wth);
+  in_file->snapshot_length = wtap_snapshot_length(in_file->wth);
+}
+
+/* Number of interfaces wiretap knows of in an open input file */
+static guint
+merge_in_file_ifaces(merge_in_file_t *in_file)
+{
+  wtapng_iface_descriptions_t *idb_inf;
+  guint ifaces;
+
+  idb_inf = wtap_file_get_idb_info(in_file->wth);
+  ifaces = idb_inf->number_of_interfaces;
+  g_free(idb_inf);
+  return ifaces;
+}
+
+/*
+ * Close an input file to free its descriptor; it will be reopened by
+ * merge_in_file_unpark() when it's needed again.  If the file type
+ * allows it, remember where to resume reading: at the pending packet,
+ * which has to be read again, or else at the next record.
+ */
+static void
+merge_in_file_park(merge_state_t *state, merge_in_file_t *in_file)
+{
+  in_file->resume_offset = wtap_tell_next(in_file->wth);
+  if (in_file->resume_offset != -1 && in_file->state == PACKET_PRESENT)
+    in_file->resume_offset = in_file->data_offset;
+  in_file->resume_ifaces = merge_in_file_ifaces(in_file);
+  wtap_close(in_file->wth);
+  in_file->wth = NULL;
+  state->open_count--;
+}
+
+/*
+ * If we're at the open file limit, park the open file whose pending
+ * packet is furthest in the future, as it's the one we'll need last.
+ * Files without a pending packet and not yet at EOF are preferred, as
+ * they have no packet that would have to be re-read.
+ *
+ * This is a linear scan, but it's only done when we're at the limit.
+ */
+static void
+merge_make_room(merge_state_t *state, merge_in_file_t *keep)
+{
+  int i;
+  merge_in_file_t *victim = NULL;
+
+  if (state->max_open == 0 || state->open_count < state->max_open)
+    return;
+
+  for (i = 0; i < state->in_file_count; i++) {
+    merge_in_file_t *in_file = &state->in_files[i];
+
+    if (in_file == keep || in_file->wth == NULL)
+      continue;
+    if (in_file->state != PACKET_PRESENT) {
+      victim = in_file;
+      break;
+    }
+    if (victim == NULL ||
+        in_file->ts.secs > victim->ts.secs ||
+        (in_file->ts.secs == victim->ts.secs && in_file->ts.nsecs > victim->ts.nsecs))
+      victim = in_file;
+  }
+  if (victim != NULL)
+    merge_in_file_park(state, victim);
+}
+
+/*
+ * Reopen a parked file and get back to where it was parked, so that
+ * the next wtap_read() returns the next unread record or, if a packet
+ * is pending, so that the pending packet is back in the wtap's buffer.
+ *
+ * That's a seek to where reading left off, unless the file type doesn't
+ * allow that or the skipped records included pcapng interface
+ * descriptions that reopening it doesn't see; then the records already
+ * read are read again.
+ */
+static gboolean
+merge_in_file_unpark(merge_state_t *state, merge_in_file_t *in_file,
+                     int *err, gchar **err_info)
+{
+  guint32 records, i;
+
+  merge_make_room(state, in_file);
+  in_file->wth = wtap_open_offline(in_file->filename, err, err_info, FALSE);
+  if (in_file->wth == NULL)
+    return FALSE;
+  state->open_count++;
+
+  if (in_file->resume_offset != -1 &&
+      merge_in_file_ifaces(in_file) == in_file->resume_ifaces) {
+    if (!wtap_seek_next(in_file->wth, in_file->resume_offset, err))
+      return FALSE;
+    records = (in_file->state == PACKET_PRESENT) ? 1 : 0;
+  } else
+    records = in_file->records_read;
+  for (i = 0; i < records; i++) {
+    if (!wtap_read(in_file->wth, err, err_info, &in_file->data_offset)) {
+      if (*err == 0) {
+        /* The file shrank underneath us. */
+        *err = WTAP_ERR_SHORT_READ;
+      }
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/*
+ * Read the next record from an input file, setting its state and,
+ * if we got a packet, the time stamp used to order it.
+ */
+static gboolean
+merge_in_file_read(merge_state_t *state, merge_in_file_t *in_file,
+                   int *err, gchar **err_info)
+{
+  if (in_file->wth == NULL &&
+      !merge_in_file_unpark(state, in_file, err, err_info)) {
+    in_file->state = GOT_ERROR;
+    return FALSE;
+  }
+  if (!wtap_read(in_file->wth, err, err_info, &in_file->data_offset)) {
+    if (*err != 0) {
+      in_file->state = GOT_ERROR;
+      return FALSE;
+    }
+    in_file->state = AT_EOF;
+    if (state->max_open != 0) {
+      /* We won't need this one again. */
+      merge_in_file_park(state, in_file);
+    }
+    return TRUE;
+  }
+  in_file->records_read++;
+  in_file->ts = wtap_phdr(in_file->wth)->ts;
+  in_file->state = PACKET_PRESENT;
+  return TRUE;
+}
+
 /*
  * Scan through the arguments and open the input files
  */
 gboolean
-merge_open_in_files(int in_file_count, char *const *in_file_names,
-                    merge_in_file_t **in_files, int *err, gchar **err_info,
-                    int *err_fileno)
+merge_open_in_files_limited(int in_file_count, char *const *in_file_names,
+                            merge_in_file_t **in_files, int max_open,
+                            int *err, gchar **err_info, int *err_fileno)
 {
   int i, j;
   size_t files_size = in_file_count * sizeof(merge_in_file_t);
   merge_in_file_t *files;
+  merge_state_t *state;
   gint64 size;
 
   files = (merge_in_file_t *)g_malloc(files_size);
   *in_files = files;
 
+  state = g_new(merge_state_t, 1);
+  state->in_file_count = in_file_count;
+  state->heap          = g_new(merge_in_file_t *, in_file_count);
+  state->heap_count    = 0;
+  state->heap_primed   = FALSE;
+  state->max_open      = max_open;
+  state->open_count    = 0;
+  state->in_files      = files;
+
   for (i = 0; i < in_file_count; i++) {
-    files[i].filename    = in_file_names[i];
-    files[i].wth         = wtap_open_offline(in_file_names[i], err, err_info, FALSE);
-    files[i].data_offset = 0;
-    files[i].state       = PACKET_NOT_PRESENT;
-    files[i].packet_num  = 0;
+    files[i].filename     = in_file_names[i];
+    files[i].wth          = wtap_open_offline(in_file_names[i], err, err_info, FALSE);
+    files[i].data_offset  = 0;
+    files[i].state        = PACKET_NOT_PRESENT;
+    files[i].packet_num   = 0;
+    files[i].records_read = 0;
+    files[i].resume_offset = -1;
+    files[i].resume_ifaces = 0;
+    files[i].merge_state  = state;
     if (!files[i].wth) {
       /* Close the files we've already opened. */
-      for (j = 0; j < i; j++)
-        wtap_close(files[j].wth);
+      for (j = 0; j < i; j++) {
+        if (files[j].wth)
+          wtap_close(files[j].wth);
+      }
       *err_fileno = i;
+      g_free(state->heap);
+      g_free(state);
       return FALSE;
     }
     size = wtap_file_size(files[i].wth, err);
     if (size == -1) {
-      for (j = 0; j <= i; j++)
-        wtap_close(files[j].wth);
+      for (j = 0; j <= i; j++) {
+        if (files[j].wth)
+          wtap_close(files[j].wth);
+      }
       *err_fileno = i;
+      g_free(state->heap);
+      g_free(state);
       return FALSE;
     }
     files[i].size = size;
+    merge_in_file_cache_info(&files[i]);
+    state->open_count++;
+    if (max_open != 0 && state->open_count > max_open) {
+      /* Nothing has been read from it yet; reopening it is cheap. */
+      merge_in_file_park(state, &files[i]);
+    }
   }
   return TRUE;
 }
 
+gboolean
+merge_open_in_files(int in_file_count, char *const *in_file_names,
+                    merge_in_file_t **in_files, int *err, gchar **err_info,
+                    int *err_fileno)
+{
+  return merge_open_in_files_limited(in_file_count, in_file_names, in_files,
+                                     0, err, err_info, err_fileno);
+}
+
 /*
  * Scan through and close each input file
  */
@@ -93,8 +293,18 @@ void
 merge_close_in_files(int count, merge_in_file_t in_files[])
 {
   int i;
+  merge_state_t *state = NULL;
+
   for (i = 0; i < count; i++) {
-    wtap_close(in_files[i].wth);
+    if (in_files[i].wth)
+      wtap_close(in_files[i].wth);
+    in_files[i].wth = NULL;
+    state = in_files[i].merge_state;
+    in_files[i].merge_state = NULL;
+  }
+  if (state != NULL) {
+    g_free(state->heap);
+    g_free(state);
   }
 }
 
@@ -112,10 +322,10 @@ merge_select_frame_type(int count, merge_in_file_t files[])
   int i;
   int selected_frame_type;
 
-  selected_frame_type = wtap_file_encap(files[0].wth);
+  selected_frame_type = files[0].file_encap;
 
   for (i = 1; i < count; i++) {
-    int this_frame_type = wtap_file_encap(files[i].wth);
+    int this_frame_type = files[i].file_encap;
     if (selected_frame_type != this_frame_type) {
       selected_frame_type = WTAP_ENCAP_PER_PACKET;
       break;
@@ -136,7 +346,7 @@ merge_max_snapshot_length(int count, merge_in_file_t in_files[])
   int snapshot_length;
 
   for (i = 0; i < count; i++) {
-    snapshot_length = wtap_snapshot_length(in_files[i].wth);
+    snapshot_length = in_files[i].snapshot_length;
     if (snapshot_length == 0) {
       /* Snapshot length of input file not known. */
       snapshot_length = WTAP_MAX_PACKET_SIZE;
@@ -148,27 +358,63 @@ merge_max_snapshot_length(int count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * returns TRUE if the pending packet of the first file should be written
+ * before that of the second.  Ties go to the file later in the list, as
+ * they always have.
  */
 static gboolean
-is_earlier(struct wtap_nstime *l, struct wtap_nstime *r) {
-  if (l->secs > r->secs) {  /* left is later */
-    return FALSE;
-  } else if (l->secs < r->secs) { /* left is earlier */
-    return TRUE;
-  } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
-    return FALSE;
+is_earlier(const merge_in_file_t *l, const merge_in_file_t *r) {
+  if (l->ts.secs != r->ts.secs)
+    return l->ts.secs < r->ts.secs;
+  if (l->ts.nsecs != r->ts.nsecs)
+    return l->ts.nsecs < r->ts.nsecs;
+  return l > r;
+}
+
+static void
+heap_sift_up(merge_in_file_t **heap, int i)
+{
+  merge_in_file_t *in_file = heap[i];
+
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+
+    if (!is_earlier(in_file, heap[parent]))
+      break;
+    heap[i] = heap[parent];
+    i = parent;
   }
-  /* either one < two or one == two
-   * either way, return one
-   */
-  return TRUE;
+  heap[i] = in_file;
+}
+
+static void
+heap_sift_down(merge_in_file_t **heap, int count, int i)
+{
+  merge_in_file_t *in_file = heap[i];
+
+  for (;;) {
+    int child = 2 * i + 1;
+
+    if (child >= count)
+      break;
+    if (child + 1 < count && is_earlier(heap[child + 1], heap[child]))
+      child++;
+    if (!is_earlier(heap[child], in_file))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = in_file;
 }
 
 /*
  * Read the next packet, in chronological order, from the set of files
  * to be merged.
  *
+ * The file whose packet we returned last time is at the top of the heap
+ * with no packet pending; we read its next packet and sift it down, so
+ * only that one file is touched per call.
+ *
  * On success, set *err to 0 and return a pointer to the merge_in_file_t
  * for the file from which the packet was read.
  *
@@ -182,59 +428,71 @@ merge_in_file_t *
 merge_read_packet(int in_file_count, merge_in_file_t in_files[],
                   int *err, gchar **err_info)
 {
+  merge_state_t *state = in_files[0].merge_state;
+  merge_in_file_t **heap = state->heap;
+  merge_in_file_t *in_file;
   int i;
-  int ei = -1;
-  struct wtap_nstime tv = { sizeof(time_t) > sizeof(int) ? LONG_MAX : INT_MAX, INT_MAX };
-  struct wtap_pkthdr *phdr;
 
-  /*
-   * Make sure we have a packet available from each file, if there are any
-   * packets left in the file in question, and search for the packet
-   * with the earliest time stamp.
-   */
-  for (i = 0; i < in_file_count; i++) {
-    if (in_files[i].state == PACKET_NOT_PRESENT) {
-      /*
-       * No packet available, and we haven't seen an error or EOF yet,
-       * so try to read the next packet.
-       */
-      if (!wtap_read(in_files[i].wth, err, err_info, &in_files[i].data_offset)) {
-        if (*err != 0) {
-          in_files[i].state = GOT_ERROR;
-          return &in_files[i];
-        }
-        in_files[i].state = AT_EOF;
-      } else
-        in_files[i].state = PACKET_PRESENT;
-    }
-
-    if (in_files[i].state == PACKET_PRESENT) {
-      phdr = wtap_phdr(in_files[i].wth);
-      if (is_earlier(&phdr->ts, &tv)) {
-        tv = phdr->ts;
-        ei = i;
+  if (!state->heap_primed) {
+    /*
+     * Get the first packet from each file, if it has any, and build
+     * the heap from them.
+     */
+    for (i = 0; i < in_file_count; i++) {
+      if (in_files[i].state != PACKET_NOT_PRESENT)
+        continue;
+      if (!merge_in_file_read(state, &in_files[i], err, err_info))
+        return &in_files[i];
+      if (in_files[i].state == PACKET_PRESENT) {
+        heap[state->heap_count] = &in_files[i];
+        heap_sift_up(heap, state->heap_count);
+        state->heap_count++;
       }
     }
+    state->heap_primed = TRUE;
+  } else if (state->heap_count > 0 && heap[0]->state == PACKET_NOT_PRESENT) {
+    /*
+     * Replace the packet we returned last time with the next one from
+     * the same file, or drop the file from the heap if it's at EOF.
+     */
+    in_file = heap[0];
+    if (!merge_in_file_read(state, in_file, err, err_info))
+      return in_file;
+    if (in_file->state != PACKET_PRESENT) {
+      state->heap_count--;
+      heap[0] = heap[state->heap_count];
+    }
+    if (state->heap_count > 0)
+      heap_sift_down(heap, state->heap_count, 0);
   }
 
-  if (ei == -1) {
+  if (state->heap_count == 0) {
     /* All the streams are at EOF.  Return an EOF indication. */
     *err = 0;
     return NULL;
   }
 
+  in_file = heap[0];
+  if (in_file->wth == NULL) {
+    /* Parked while its packet was pending; get that packet back. */
+    if (!merge_in_file_unpark(state, in_file, err, err_info)) {
+      in_file->state = GOT_ERROR;
+      return in_file;
+    }
+  }
+
   /* We'll need to read another packet from this file. */
-  in_files[ei].state = PACKET_NOT_PRESENT;
+  in_file->state = PACKET_NOT_PRESENT;
 
   /* Count this packet. */
-  in_files[ei].packet_num++;
+  in_file->packet_num++;
 
   /*
    * Return a pointer to the merge_in_file_t of the file from which the
    * packet was read.
    */
   *err = 0;
-  return &in_files[ei];
+  return in_file;
 }
 
 /*
@@ -262,15 +520,14 @@ merge_append_read_packet(int in_file_count, merge_in_file_t in_files[],
   for (i = 0; i < in_file_count; i++) {
     if (in_files[i].state == AT_EOF)
       continue; /* This file is already at EOF */
-    if (wtap_read(in_files[i].wth, err, err_info, &in_files[i].data_offset))
-      break; /* We have a packet */
-    if (*err != 0) {
+    if (!merge_in_file_read(in_files[i].merge_state, &in_files[i], err,
+                            err_info)) {
       /* Read error - quit immediately. */
-      in_files[i].state = GOT_ERROR;
       return &in_files[i];
     }
-    /* EOF - flag this file as being at EOF, and try the next one. */
-    in_files[i].state = AT_EOF;
+    if (in_files[i].state == PACKET_PRESENT)
+      break; /* We have a packet */
+    /* EOF - the file has been flagged as being at EOF; try the next one. */
   }
   if (i == in_file_count) {
     /* All the streams are at EOF.  Return an EOF indication. */
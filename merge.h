@@ -36,18 +36,30 @@ typedef enum {
   GOT_ERROR
 } in_file_state_e;
 
+/* Ordering and open-file bookkeeping shared by all the input files of
+ * one merge; private to merge.c. */
+struct merge_state_s;
+
 /**
  * Structures to manage our input files.
  */
 typedef struct merge_in_file_s {
   const char     *filename;
-  wtap           *wth;
+  wtap           *wth;            /* NULL while the file is parked (see merge_open_in_files_limited) */
   gint64          data_offset;
   in_file_state_e state;
   guint32         packet_num;	  /* current packet number */
   gint64          size;		      /* file size */
   guint32         interface_id;   /* identifier of the interface. 
 								   * Used for fake interfaces when writing WTAP_ENCAP_PER_PACKET */
+  int             file_type;      /* WTAP_FILE_ type, valid even while parked */
+  int             file_encap;     /* WTAP_ENCAP_ type, valid even while parked */
+  int             snapshot_length; /* snapshot length, valid even while parked */
+  struct wtap_nstime ts;          /* time stamp of the pending packet, if PACKET_PRESENT */
+  guint32         records_read;   /* records read from the file so far */
+  gint64          resume_offset;  /* while parked, where to resume reading, or -1 to skip records_read records */
+  guint           resume_ifaces;  /* while parked, number of interfaces known when it was parked */
+  struct merge_state_s *merge_state; /* shared merge state, private to merge.c */
 } merge_in_file_t;
 
 /** Open a number of input files to merge.
@@ -65,7 +77,36 @@ merge_open_in_files(int in_file_count, char *const *in_file_names,
                     merge_in_file_t **in_files, int *err, gchar **err_info,
                     int *err_fileno);
 
-/** Close the input files again.
+/** Open a number of input files to merge, keeping at most max_open of
+ * them open at any time.
+ *
+ * Every file is opened once to check that it can be read and to record
+ * its type, encapsulation and snapshot length; files beyond the limit
+ * are then "parked" (closed, with wth set to NULL) and reopened on demand
+ * by merge_read_packet() and merge_append_read_packet().  A reopened
+ * pcap or pcapng file is read from where it left off; other files have
+ * to be re-read up to there, so max_open should be at least the number
+ * of input files that overlap in time.
+ *
+ * The packet returned by merge_read_packet() or merge_append_read_packet()
+ * always comes from an open file, but callers must not otherwise assume
+ * that in_files[i].wth is non-NULL.
+ *
+ * @param in_file_count number of entries in in_file_names and in_files
+ * @param in_file_names filenames of the input files
+ * @param in_files input file array to be filled (>= sizeof(merge_in_file_t) * in_file_count)
+ * @param max_open maximum number of files kept open, 0 for no limit
+ * @param err wiretap error, if failed
+ * @param err_info wiretap error string, if failed
+ * @param err_fileno file on which open failed, if failed
+ * @return TRUE if all files could be opened, FALSE otherwise
+ */
+extern gboolean
+merge_open_in_files_limited(int in_file_count, char *const *in_file_names,
+                            merge_in_file_t **in_files, int max_open,
+                            int *err, gchar **err_info, int *err_fileno);
+
+/** Close the input files again, and free the merge state shared by them.
  * 
  * @param in_file_count number of entries in in_files
  * @param in_files input file array to be closed
@@ -93,6 +134,9 @@ merge_max_snapshot_length(int in_file_count, merge_in_file_t in_files[]);
 
 /** Read the next packet, in chronological order, from the set of files to
  * be merged.
+ *
+ * The files are kept in a binary min-heap keyed on the time stamp of
+ * their pending packet, so each call costs O(log in_file_count).
  * 
  * @param in_file_count number of entries in in_files
  * @param in_files input file array
@@ -128,6 +128,10 @@ usage(void)
   fprintf(stderr, "                    default is the same as the first input file.\n");
   fprintf(stderr, "                    an empty \"-T\" option will list the encapsulation types.\n");
   fprintf(stderr, "\n");
+  fprintf(stderr, "Input:\n");
+  fprintf(stderr, "  -M <max open>     keep at most <max open> input files open at once;\n");
+  fprintf(stderr, "                    default is to keep all of them open.\n");
+  fprintf(stderr, "\n");
   fprintf(stderr, "Miscellaneous:\n");
   fprintf(stderr, "  -h                display this help and exit.\n");
   fprintf(stderr, "  -v                verbose output.\n");
@@ -220,6 +224,7 @@ main(int argc, char *argv[])
   char        *out_filename = NULL;
   gboolean     got_read_error = FALSE, got_write_error = FALSE;
   int          count;
+  int          max_open = 0;
 
 #ifdef _WIN32
   arg_list_utf_16to8(argc, argv);
@@ -227,7 +232,7 @@ main(int argc, char *argv[])
 #endif /* _WIN32 */
 
   /* Process the options first */
-  while ((opt = getopt(argc, argv, "hvas:T:F:w:")) != -1) {
+  while ((opt = getopt(argc, argv, "hvaM:s:T:F:w:")) != -1) {
 
     switch (opt) {
     case 'w':
@@ -262,6 +267,10 @@ main(int argc, char *argv[])
       verbose = TRUE;
       break;
 
+    case 'M':
+      max_open = get_positive_int(optarg, "maximum number of open files");
+      break;
+
     case 's':
       snaplen = get_positive_int(optarg, "snapshot length");
       break;
@@ -304,8 +313,9 @@ main(int argc, char *argv[])
   }
 
   /* open the input files */
-  if (!merge_open_in_files(in_file_count, &argv[optind], &in_files,
-                           &open_err, &err_info, &err_fileno)) {
+  if (!merge_open_in_files_limited(in_file_count, &argv[optind], &in_files,
+                                   max_open, &open_err, &err_info,
+                                   &err_fileno)) {
     fprintf(stderr, "mergecap: Can't open %s: %s\n", argv[optind + err_fileno],
         wtap_strerror(open_err));
     switch (open_err) {
@@ -323,7 +333,7 @@ main(int argc, char *argv[])
   if (verbose) {
     for (i = 0; i < in_file_count; i++)
       fprintf(stderr, "mergecap: %s is type %s.\n", argv[optind + i],
-              wtap_file_type_string(wtap_file_type(in_files[i].wth)));
+              wtap_file_type_string(in_files[i].file_type));
   }
 
   if (snaplen == 0) {
@@ -347,9 +357,9 @@ main(int argc, char *argv[])
          */
         int first_frame_type, this_frame_type;
 
-        first_frame_type = wtap_file_encap(in_files[0].wth);
+        first_frame_type = in_files[0].file_encap;
         for (i = 1; i < in_file_count; i++) {
-          this_frame_type = wtap_file_encap(in_files[i].wth);
+          this_frame_type = in_files[i].file_encap;
           if (first_frame_type != this_frame_type) {
             fprintf(stderr, "mergecap: multiple frame encapsulation types detected\n");
             fprintf(stderr, "          defaulting to WTAP_ENCAP_PER_PACKET\n");
@@ -9,30 +9,38 @@
 #include <string.h>
 
 #include <epan/packet.h>
-#include <epan/wmem/wmem.h>
+#include <epan/expert.h>
+#include <epan/emem.h>
+#include <epan/tap.h>
+#include <plugins/efcp/packet-efcp.h>
+
+#include "packet-cdap.h"
+#include "protobuf.h"
 
 static const value_string opcodes[] = {
-        { 0, "M_CONNECT" },
-        { 1, "M_CONNECT_R" }, 
-        { 2, "M_RELEASE" }, 
-        { 3, "M_RELEASE_R" }, 
-        { 4, "M_CREATE" }, 
-        { 5, "M_CREATE_R" }, 
-        { 6, "M_DELETE" }, 
-        { 7, "M_DELETE_R" }, 
-        { 8, "M_READ" }, 
-        { 9, "M_READ_R" }, 
-        { 10, "M_CANCELREAD" }, 
-        { 11, "M_CANCELREAD_R" }, 
-        { 12, "M_WRITE" }, 
-        { 13, "M_WRITE_R" }, 
-        { 14, "M_START" }, 
-        { 15, "M_START_R" }, 
-        { 16, "M_STOP" }, 
-        { 17, "M_STOP_R" } 
+        { CDAP_M_CONNECT,      "M_CONNECT" },
+        { CDAP_M_CONNECT_R,    "M_CONNECT_R" },
+        { CDAP_M_RELEASE,      "M_RELEASE" },
+        { CDAP_M_RELEASE_R,    "M_RELEASE_R" },
+        { CDAP_M_CREATE,       "M_CREATE" },
+        { CDAP_M_CREATE_R,     "M_CREATE_R" },
+        { CDAP_M_DELETE,       "M_DELETE" },
+        { CDAP_M_DELETE_R,     "M_DELETE_R" },
+        { CDAP_M_READ,         "M_READ" },
+        { CDAP_M_READ_R,       "M_READ_R" },
+        { CDAP_M_CANCELREAD,   "M_CANCELREAD" },
+        { CDAP_M_CANCELREAD_R, "M_CANCELREAD_R" },
+        { CDAP_M_WRITE,        "M_WRITE" },
+        { CDAP_M_WRITE_R,      "M_WRITE_R" },
+        { CDAP_M_START,        "M_START" },
+        { CDAP_M_START_R,      "M_START_R" },
+        { CDAP_M_STOP,         "M_STOP" },
+        { CDAP_M_STOP_R,       "M_STOP_R" },
+        { 0, NULL }
 };
 
 static int proto_cdap = -1;
+static int cdap_tap = -1;
 
 static int hf_cdap_abs_syntax   = -1;
 static int hf_cdap_opcode       = -1;
@@ -57,333 +65,298 @@ static int hf_cdap_srcapinst    = -1;
 static int hf_cdap_srcapname    = -1;
 static int hf_cdap_resultreason = -1;
 static int hf_cdap_version      = -1;
+static int hf_cdap_response_in  = -1;
+static int hf_cdap_response_to  = -1;
+static int hf_cdap_time         = -1;
 
 static gint ett_cdap = -1;
 
-static size_t 
-cdap_get_length_varint(size_t len, const guint8 *data)
+/*
+ * The header field of each CDAPMessage field, indexed by field number;
+ * NULL for numbers the message does not use.
+ */
+static int * const cdap_fields[] = {
+        NULL,
+        &hf_cdap_abs_syntax,            /*  1 */
+        &hf_cdap_opcode,                /*  2 */
+        &hf_cdap_invokeid,              /*  3 */
+        &hf_cdap_flags,                 /*  4 */
+        &hf_cdap_objclass,              /*  5 */
+        &hf_cdap_objname,               /*  6 */
+        &hf_cdap_objinst,               /*  7 */
+        &hf_cdap_objvalue,              /*  8 */
+        &hf_cdap_result,                /*  9 */
+        &hf_cdap_scope,                 /* 10 */
+        &hf_cdap_filter,                /* 11 */
+        NULL, NULL, NULL, NULL, NULL,   /* 12 - 16 */
+        &hf_cdap_authmech,              /* 17 */
+        &hf_cdap_authvalue,             /* 18 */
+        &hf_cdap_dstaeinst,             /* 19 */
+        &hf_cdap_dstaename,             /* 20 */
+        &hf_cdap_dstapinst,             /* 21 */
+        &hf_cdap_dstapname,             /* 22 */
+        &hf_cdap_srcaeinst,             /* 23 */
+        &hf_cdap_srcaename,             /* 24 */
+        &hf_cdap_srcapinst,             /* 25 */
+        &hf_cdap_srcapname,             /* 26 */
+        &hf_cdap_resultreason,          /* 27 */
+        &hf_cdap_version                /* 28 */
+};
+
+#define CDAP_FIELD_OPCODE       2
+#define CDAP_FIELD_INVOKEID     3
+#define CDAP_FIELD_RESULT       9
+
+/*
+ * Request/response matching.  A request and its response carry the same
+ * invoke id on the same EFCP connection, and the response opcode is the
+ * request opcode + 1.  The table only holds the latest request for each
+ * key and is used on the first pass; after that every message finds its
+ * transaction through the frame's protocol data.
+ */
+typedef struct _cdap_txn_key {
+        efcp_conn_key conn;
+        gint32  invoke_id;
+} cdap_txn_key;
+
+typedef struct _cdap_txn {
+        cdap_txn_key key;
+        guint32  opcode;                /* of the request */
+        guint32  req_frame;
+        guint32  rsp_frame;
+        nstime_t req_time;
+} cdap_txn;
+
+static GHashTable *cdap_txn_table = NULL;
+
+static guint
+cdap_txn_hash(gconstpointer k)
 {
-        size_t i;
-        
-        for (i = 0; i < len; i++) {
-                if ((data[i] & 0x80) == 0)
-                        break;
-        }
+        const cdap_txn_key *key = (const cdap_txn_key *)k;
 
-        return i+1;
+        return efcp_conn_key_hash(&key->conn) ^
+                ((guint32)key->invoke_id * 2654435761U);
 }
 
-/* Caller needs to free the return value */
-static guint8 *
-cdap_parse_int32(size_t len, const guint8 *data)
+static gint
+cdap_txn_equal(gconstpointer k1, gconstpointer k2)
 {
-        guint8 *rv;
-        guint i;
+        return memcmp(k1, k2, sizeof(cdap_txn_key)) == 0;
+}
 
-        rv = (guint8 *) wmem_alloc0(wmem_packet_scope(), 32);
-        for (i = 0; i < len; i++) {
-                rv[i] = (data[i] & 0x7f);
+static void
+cdap_init(void)
+{
+        if (cdap_txn_table)
+                g_hash_table_destroy(cdap_txn_table);
+        /* The transactions themselves are in se memory */
+        cdap_txn_table = g_hash_table_new(cdap_txn_hash, cdap_txn_equal);
+}
+
+static void
+cdap_txn_key_init(cdap_txn_key *key, const efcp_tap_info *efcpinfo,
+                  gint32 invoke_id)
+{
+        memset(key, 0, sizeof(*key));
+        if (efcpinfo)
+                key->conn = efcpinfo->conn;
+        key->invoke_id = invoke_id;
+}
+
+/* Find the transaction of a message seen for the first time */
+static cdap_txn *
+cdap_match_txn(packet_info *pinfo, const efcp_tap_info *efcpinfo,
+               guint32 opcode, gint32 invoke_id)
+{
+        cdap_txn_key key;
+        cdap_txn *txn;
+
+        cdap_txn_key_init(&key, efcpinfo, invoke_id);
+
+        if (CDAP_IS_REQUEST(opcode)) {
+                txn = se_new0(cdap_txn);
+                txn->key       = key;
+                txn->opcode    = opcode;
+                txn->req_frame = pinfo->fd->num;
+                txn->req_time  = pinfo->fd->abs_ts;
+                g_hash_table_replace(cdap_txn_table, &txn->key, txn);
+                return txn;
         }
 
-        return rv;
+        txn = (cdap_txn *)g_hash_table_lookup(cdap_txn_table, &key);
+        if (!txn || txn->opcode + 1 != opcode || txn->rsp_frame)
+                return NULL;
+        txn->rsp_frame = pinfo->fd->num;
+        return txn;
 }
 
-/* Caller needs to free the return value */
-static guint8 *
-cdap_parse_int64(size_t len, const guint8 *data)
+/* Add a field to the tree according to the type of its header field */
+static void
+cdap_add_field(proto_tree *tree, packet_info *pinfo, tvbuff_t *tvb,
+               const pb_field_t *field)
 {
-        guint8 *rv;
-        guint i;
+        proto_item *item;
+        int hf = -1;
+        enum ftenum type;
+
+        if (field->number < array_length(cdap_fields) && cdap_fields[field->number])
+                hf = *cdap_fields[field->number];
+        if (hf == -1) {
+                proto_tree_add_text(tree, tvb, field->offset, field->length,
+                                    "Unknown field %u (wire type %u)",
+                                    field->number, field->wire_type);
+                return;
+        }
 
-        rv = (guint8 *) wmem_alloc0(wmem_packet_scope(), 64);
-        for (i = 0; i < len; i++) {
-                rv[i] = (data[i] & 0x7f);
+        type = proto_registrar_get_ftype(hf);
+        if (field->wire_type == PB_WIRETYPE_VARINT) {
+                switch (type) {
+                case FT_INT32:
+                        proto_tree_add_int(tree, hf, tvb, field->offset, field->length,
+                                           pb_field_int32(field));
+                        return;
+                case FT_UINT32:
+                        proto_tree_add_uint(tree, hf, tvb, field->offset, field->length,
+                                            (guint32)field->value);
+                        return;
+                case FT_INT64:
+                        proto_tree_add_int64(tree, hf, tvb, field->offset, field->length,
+                                             pb_field_int64(field));
+                        return;
+                default:
+                        break;
+                }
+        } else if (field->wire_type == PB_WIRETYPE_LENGTH) {
+                switch (type) {
+                case FT_STRING:
+                        proto_tree_add_item(tree, hf, tvb, field->value_offset,
+                                            field->value_length, ENC_UTF_8|ENC_NA);
+                        return;
+                case FT_BYTES:
+                        proto_tree_add_item(tree, hf, tvb, field->value_offset,
+                                            field->value_length, ENC_NA);
+                        return;
+                default:
+                        break;
+                }
         }
 
-        return rv;
+        item = proto_tree_add_text(tree, tvb, field->offset, field->length,
+                                   "%s: unexpected wire type %u",
+                                   proto_registrar_get_name(hf), field->wire_type);
+        expert_add_info_format(pinfo, item, PI_MALFORMED, PI_WARN,
+                               "Field %u has an unexpected wire type", field->number);
 }
 
-
 static void
 dissect_cdap(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
 {
+        proto_item *ti;
+        proto_tree *cdap_tree = NULL;
+        const efcp_tap_info *efcpinfo;
+        cdap_tap_info *cdapinfo;
+        cdap_txn *txn;
+        pb_field_t field;
+        gint offset, end;
+        gboolean have_opcode = FALSE, have_invoke_id = FALSE;
+        guint32 opcode = 0;
+        gint32 invoke_id = 0, result = 0;
+        nstime_t delta;
+
+        /* Set by EFCP, which is the only caller */
+        efcpinfo = (const efcp_tap_info *)pinfo->private_data;
+
         col_set_str(pinfo->cinfo, COL_PROTOCOL, "CDAP");
-        if (tree) { /* we are being asked for details */
-                proto_item *ti = NULL;
-                proto_tree *cdap_tree = NULL;
-                guint buff_length;
-                guint offset;
-                guint8 protofield;
-                gboolean stop;
-                /* Contains either the string length, or the varint length */
-                volatile size_t len;
-                guint8 *buf;
-                guint8 *buf2;
-                tvbuff_t *new_tvb;
-                guint i;
-                guint8 *str;
-
-                ti = proto_tree_add_item(tree, proto_cdap, tvb, 0, -1, ENC_NA);
+
+        ti = proto_tree_add_item(tree, proto_cdap, tvb, 0, -1, ENC_NA);
+        if (ti)
                 cdap_tree = proto_item_add_subtree(ti, ett_cdap);
 
-                /* Add them to the tree here */
-                offset = 0;
-                buff_length = tvb_length(tvb);
-                stop = FALSE;
-                protofield = 0;
-                len = 0;
-                i = 0;
-                new_tvb = NULL;
-                str = NULL;
-                buf = (guint8 *) wmem_alloc0(wmem_packet_scope(), 8);
-                while (!stop && offset < buff_length) {
-                        /*
-                         * Each key in the streamed message is a varint with 
-                         * the value (field_number << 3) | wire_type – in 
-                         * other words, the last three bits of the number 
-                         * store the wire type. 
-                         */
-                        TRY {
-                                protofield = tvb_get_guint8(tvb, offset);
-                                offset++;
-                                protofield = protofield >> 3;
-
-                                /* Check if the MSB is 1, in which case we need the second byte too */
-                                if (protofield & 0x10) {
-                                        protofield = (tvb_get_guint8(tvb, offset) << 4) | protofield;
-                                        offset++;
-                                }
-
-                                /* String */
-                                if ((protofield >= 19 && protofield <= 27) ||
-                                    (protofield >= 5 && protofield <= 6)) {  
-                                        for (i = 0; i < 4; i++) { 
-                                                /* TODO: Check if we don't go beyond the packet length */
-                                                buf[i] = tvb_get_guint8(tvb, offset+i);
-                                        }
-                                        len = cdap_get_length_varint(4, buf);
-                                        offset += len;
-
-                                        buf2 = cdap_parse_int32(len, buf);
-                                        len = (buf2[3] << 24) | (buf2[2] << 16) | (buf2[1] << 8) | buf2[0]; 
-                                        
-                                        str = (guint8 *) wmem_alloc0(wmem_packet_scope(), len+1);
-                                        str[len]= '\0';
-
-                                        for (i = 0; i < len; i++) {
-                                                str[i] = tvb_get_guint8(tvb, offset+i);
-                                        }
-                                }
-                                /* Int 32 */        
-                                else if (protofield <= 4 ||
-                                         protofield == 9 ||
-                                         protofield == 10 ||
-                                         protofield == 17) {
-                                        /* Get data from tvbuff */
-                                        /* TODO: Use tvb_memcpy or tvp_ptr */
-                                        for (i = 0; i < 4; i++) { 
-                                                /* TODO: Check if we don't go beyond the packet length */
-                                                buf[i] = tvb_get_guint8(tvb, offset+i);
-                                        }
-                                        len = cdap_get_length_varint(4, buf);
-                                        buf2 = cdap_parse_int32(len, buf);
-                                        offset+= len;
-
-                                        new_tvb = tvb_new_child_real_data(tvb, buf2, 4, 4);
-                                        add_new_data_source(pinfo, new_tvb, "Decoded Int32");
-                                } 
-                                /* Int 64 */
-                                else if (protofield == 7 ||
-                                         protofield == 28) {
-                                        /* Get data from tvbuff */
-                                        /* TODO: Use tvb_memcpy */
-                                        for (i = 0; i < 8; i++) { 
-                                                /* TODO: Check if we don't go beyond the packet length */
-                                                buf[i] = tvb_get_guint8(tvb, offset+i);
-                                        }
-                                        len = cdap_get_length_varint(8, buf);
-                                        buf2 = cdap_parse_int64(len, buf);
-                                        new_tvb = tvb_new_child_real_data(tvb, buf2, 8, 8);
-                                        add_new_data_source(pinfo, new_tvb, "Decoded Int64");
-                                        offset+= len;
-                                } 
-                                /* Message in message or bytes */
-                                else if (protofield == 8 ||
-                                         protofield == 11 ||
-                                         protofield == 18) {
-                                        for (i = 0; i < 4; i++) { 
-                                                /* TODO: Check if we don't go beyond the packet length */
-                                                buf[i] = tvb_get_guint8(tvb, offset+i);
-                                        }
-                                        len = cdap_get_length_varint(4, buf);
-                                        offset += len;
-
-                                        buf2 = cdap_parse_int32(len, buf);
-                                        len = (buf2[3] << 24) | (buf2[2] << 16) | (buf2[1] << 8) | buf2[0]; 
-                                        offset += len;
-                                }
-                        }
-                        CATCH_ALL {
-                                stop = TRUE;
-                                break;
-                        }
-                        ENDTRY;
-
-                        printf("Protofield: %d\n", protofield);
-                       
-                        /* Processing based on field */
-                        switch (protofield) {
-                        case 1:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_abs_syntax, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 2:
-                                /* Enum are also gint32 */
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_opcode, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 3:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_invokeid, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 4:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_flags, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 5:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_objclass, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;                       
-                                break;
-                        case 6:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_objname, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 7:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_objinst, 
-                                                    new_tvb, 0, 8, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 8:
-                                /* For now just increase the offset */
-                                break;
-                        case 9:  
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_result, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 10:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_scope, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 11:
-                                /* For now just increase the offset */
-                                break; 
-                        case 17:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_authmech, 
-                                                    new_tvb, 0, 4, 
-                                                    ENC_LITTLE_ENDIAN);
-                                break;
-                        case 18:
-                                /* For now just increase the offset */
-                                break;
-                        case 19:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_dstaeinst, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 20:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_dstaename, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 21:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_dstapinst, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 22:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_dstapname, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 23:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_srcaeinst, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 24:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_srcaename, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 25:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_srcapinst, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
-                                break;
-                        case 26: 
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_srcapname, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
+        /*
+         * Walk the message once; the fields the Info column, the matching
+         * and the tap need are picked up on the way, tree or no tree.
+         */
+        offset = 0;
+        end = tvb_reported_length(tvb);
+        while (offset < end) {
+                if (!pb_get_field(tvb, offset, end, &field)) {
+                        ti = proto_tree_add_text(cdap_tree, tvb, offset, -1,
+                                                 "Malformed field");
+                        expert_add_info_format(pinfo, ti, PI_MALFORMED, PI_ERROR,
+                                               "Malformed or truncated protobuf field");
+                        break;
+                }
+
+                if (field.wire_type == PB_WIRETYPE_VARINT) {
+                        switch (field.number) {
+                        case CDAP_FIELD_OPCODE:
+                                opcode = (guint32)field.value;
+                                have_opcode = TRUE;
                                 break;
-                        case 27:
-                                proto_tree_add_string(cdap_tree, 
-                                                      hf_cdap_resultreason, 
-                                                      tvb, offset, len, 
-                                                      str);
-                                offset+= len;
+                        case CDAP_FIELD_INVOKEID:
+                                invoke_id = pb_field_int32(&field);
+                                have_invoke_id = TRUE;
                                 break;
-                        case 28:
-                                proto_tree_add_item(cdap_tree, 
-                                                    hf_cdap_version, 
-                                                    new_tvb, 0, 8, 
-                                                    ENC_LITTLE_ENDIAN);
+                        case CDAP_FIELD_RESULT:
+                                result = pb_field_int32(&field);
                                 break;
                         default:
-                                stop = TRUE;
-                                printf("CDAP got an unknown field, stopping\n");
-                                printf("Field: %d\n\n", protofield);
                                 break;
                         }
+                }
+
+                if (cdap_tree)
+                        cdap_add_field(cdap_tree, pinfo, tvb, &field);
+                offset += field.length;
+        }
 
-                         
+        if (!have_opcode)
+                return;
+
+        col_append_fstr(pinfo->cinfo, COL_INFO, "%s",
+                        val_to_str(opcode, opcodes, "Unknown opcode (%u)"));
+        if (have_invoke_id)
+                col_append_fstr(pinfo->cinfo, COL_INFO, " (invoke id %d)", invoke_id);
+        if (result != 0)
+                col_append_fstr(pinfo->cinfo, COL_INFO, " result %d", result);
+
+        txn = NULL;
+        if (have_invoke_id && opcode < CDAP_NUM_OPCODES) {
+                if (!pinfo->fd->flags.visited) {
+                        txn = cdap_match_txn(pinfo, efcpinfo, opcode, invoke_id);
+                        if (txn)
+                                p_add_proto_data(pinfo->fd, proto_cdap, 0, txn);
+                } else {
+                        txn = (cdap_txn *)p_get_proto_data(pinfo->fd, proto_cdap, 0);
                 }
         }
+
+        cdapinfo = ep_new0(cdap_tap_info);
+        cdapinfo->opcode      = opcode;
+        cdapinfo->opcode_name = val_to_str_const(opcode, opcodes, "Unknown");
+        cdapinfo->invoke_id   = invoke_id;
+        cdapinfo->result      = result;
+        cdapinfo->is_request  = CDAP_IS_REQUEST(opcode);
+
+        if (txn && cdapinfo->is_request) {
+                if (txn->rsp_frame) {
+                        ti = proto_tree_add_uint(cdap_tree, hf_cdap_response_in,
+                                                 tvb, 0, 0, txn->rsp_frame);
+                        PROTO_ITEM_SET_GENERATED(ti);
+                }
+        } else if (txn) {
+                cdapinfo->req_frame = txn->req_frame;
+                cdapinfo->req_time  = txn->req_time;
+                ti = proto_tree_add_uint(cdap_tree, hf_cdap_response_to,
+                                         tvb, 0, 0, txn->req_frame);
+                PROTO_ITEM_SET_GENERATED(ti);
+                nstime_delta(&delta, &pinfo->fd->abs_ts, &txn->req_time);
+                ti = proto_tree_add_time(cdap_tree, hf_cdap_time,
+                                         tvb, 0, 0, &delta);
+                PROTO_ITEM_SET_GENERATED(ti);
+        }
+
+        tap_queue_packet(cdap_tap, pinfo, cdapinfo);
 }
 
 void
@@ -529,6 +502,24 @@ proto_register_cdap(void)
                 FT_INT64, BASE_DEC,
                 NULL, 0x0,
                 NULL, HFILL }
+            },
+            { &hf_cdap_response_in,
+              { "Response in", "cdap.response_in",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "The response to this CDAP request is in this frame", HFILL }
+            },
+            { &hf_cdap_response_to,
+              { "Request in", "cdap.response_to",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "This is a response to the CDAP request in this frame", HFILL }
+            },
+            { &hf_cdap_time,
+              { "Time", "cdap.time",
+                FT_RELATIVE_TIME, BASE_NONE,
+                NULL, 0x0,
+                "The time between the request and the response", HFILL }
             }
     };
 
@@ -547,6 +538,10 @@ proto_register_cdap(void)
     proto_register_subtree_array(ett, array_length(ett));
 
     register_dissector("cdap", dissect_cdap, proto_cdap);
+
+    register_init_routine(cdap_init);
+
+    cdap_tap = register_tap("cdap");
 }
 
 void
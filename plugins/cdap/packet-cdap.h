@@ -0,0 +1,62 @@
+/* packet-cdap.h
+ * Definitions shared by the CDAP dissector and its taps
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_CDAP_H__
+#define __PACKET_CDAP_H__
+
+/* Opcodes; every request is even and its response is the next odd value */
+#define CDAP_M_CONNECT          0
+#define CDAP_M_CONNECT_R        1
+#define CDAP_M_RELEASE          2
+#define CDAP_M_RELEASE_R        3
+#define CDAP_M_CREATE           4
+#define CDAP_M_CREATE_R         5
+#define CDAP_M_DELETE           6
+#define CDAP_M_DELETE_R         7
+#define CDAP_M_READ             8
+#define CDAP_M_READ_R           9
+#define CDAP_M_CANCELREAD       10
+#define CDAP_M_CANCELREAD_R     11
+#define CDAP_M_WRITE            12
+#define CDAP_M_WRITE_R          13
+#define CDAP_M_START            14
+#define CDAP_M_START_R          15
+#define CDAP_M_STOP             16
+#define CDAP_M_STOP_R           17
+#define CDAP_NUM_OPCODES        18
+
+#define CDAP_IS_REQUEST(opcode) (((opcode) & 1) == 0)
+
+/* Passed to listeners of the "cdap" tap, one per message */
+typedef struct _cdap_tap_info {
+        guint32  opcode;
+        const char *opcode_name;        /* static string owned by the dissector */
+        gint32   invoke_id;
+        gint32   result;                /* 0 if the message has no result */
+        gboolean is_request;
+        guint32  req_frame;             /* responses: matching request, 0 if not seen */
+        nstime_t req_time;              /* responses: arrival time of the request */
+} cdap_tap_info;
+
+#endif /* __PACKET_CDAP_H__ */
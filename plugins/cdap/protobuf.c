@@ -0,0 +1,138 @@
+/* protobuf.c
+ * Google Protocol Buffers wire format decoding helpers
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* The decoder walks the message in place: every field is described by
+ * offsets into the tvbuff, so a message can be decoded field by field
+ * without copying or allocating anything, with or without a tree.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "protobuf.h"
+
+gint
+pb_get_varint(tvbuff_t *tvb, gint offset, guint64 *value)
+{
+        const guint8 *p;
+        gint avail, i;
+        guint64 v = 0;
+
+        avail = tvb_length_remaining(tvb, offset);
+        if (avail <= 0)
+                return 0;
+        if (avail > PB_VARINT_MAX_LEN)
+                avail = PB_VARINT_MAX_LEN;
+
+        /* One bounds check for the whole varint instead of one per byte */
+        p = tvb_get_ptr(tvb, offset, avail);
+        for (i = 0; i < avail; i++) {
+                v |= (guint64)(p[i] & 0x7f) << (7 * i);
+                if ((p[i] & 0x80) == 0) {
+                        *value = v;
+                        return i + 1;
+                }
+        }
+
+        return 0;
+}
+
+gboolean
+pb_get_field(tvbuff_t *tvb, gint offset, gint end, pb_field_t *field)
+{
+        guint64 key, value;
+        gint len, vlen;
+
+        len = pb_get_varint(tvb, offset, &key);
+        if (len == 0 || offset + len > end)
+                return FALSE;
+        if ((key >> 3) == 0 || (key >> 3) > G_MAXUINT32)
+                return FALSE;
+
+        field->number    = (guint32)(key >> 3);
+        field->wire_type = (guint)(key & 0x07);
+        field->offset    = offset;
+        offset += len;
+
+        switch (field->wire_type) {
+        case PB_WIRETYPE_VARINT:
+                vlen = pb_get_varint(tvb, offset, &value);
+                if (vlen == 0)
+                        return FALSE;
+                field->value_offset = offset;
+                field->value_length = vlen;
+                field->value = value;
+                break;
+
+        case PB_WIRETYPE_FIXED64:
+                if (end - offset < 8)
+                        return FALSE;
+                field->value_offset = offset;
+                field->value_length = 8;
+                field->value = tvb_get_letoh64(tvb, offset);
+                break;
+
+        case PB_WIRETYPE_FIXED32:
+                if (end - offset < 4)
+                        return FALSE;
+                field->value_offset = offset;
+                field->value_length = 4;
+                field->value = tvb_get_letohl(tvb, offset);
+                break;
+
+        case PB_WIRETYPE_LENGTH:
+                vlen = pb_get_varint(tvb, offset, &value);
+                if (vlen == 0 || offset + vlen > end ||
+                    value > (guint64)(end - offset - vlen))
+                        return FALSE;
+                field->value_offset = offset + vlen;
+                field->value_length = (gint)value;
+                field->value = value;
+                break;
+
+        default:
+                /* Groups are deprecated and CDAP does not use them */
+                return FALSE;
+        }
+
+        if (field->value_offset + field->value_length > end)
+                return FALSE;
+        field->length = field->value_offset + field->value_length - field->offset;
+
+        return TRUE;
+}
+
+/*
+ * Editor modelines  -  http://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,81 @@
+/* protobuf.h
+ * Google Protocol Buffers wire format decoding helpers
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROTOBUF_H__
+#define __PROTOBUF_H__
+
+#include <epan/tvbuff.h>
+
+/* Wire types, the low three bits of a field key */
+#define PB_WIRETYPE_VARINT      0
+#define PB_WIRETYPE_FIXED64     1
+#define PB_WIRETYPE_LENGTH      2
+#define PB_WIRETYPE_START_GROUP 3       /* deprecated, not supported */
+#define PB_WIRETYPE_END_GROUP   4       /* deprecated, not supported */
+#define PB_WIRETYPE_FIXED32     5
+
+/* A 64 bit varint takes at most 10 bytes */
+#define PB_VARINT_MAX_LEN       10
+
+/* One decoded field; filled in place, nothing is allocated */
+typedef struct _pb_field_t {
+        guint32 number;         /**< field number from the key */
+        guint   wire_type;      /**< PB_WIRETYPE_ value from the key */
+        gint    offset;         /**< offset of the key */
+        gint    length;         /**< length of key and value */
+        gint    value_offset;   /**< offset of the value, after the length prefix if any */
+        gint    value_length;   /**< length of the value, without the length prefix */
+        guint64 value;          /**< varint or fixed value; the payload length for PB_WIRETYPE_LENGTH */
+} pb_field_t;
+
+/** Decode the varint at offset.
+ *
+ * @param tvb the buffer
+ * @param offset where the varint starts
+ * @param value set to the decoded value
+ * @return the number of bytes used, or 0 if the varint is truncated or
+ * longer than PB_VARINT_MAX_LEN
+ */
+extern gint pb_get_varint(tvbuff_t *tvb, gint offset, guint64 *value);
+
+/** Decode the key and locate the value of the field at offset.
+ *
+ * @param tvb the buffer
+ * @param offset where the field key starts
+ * @param end offset just past the enclosing message
+ * @param field filled in with the field
+ * @return TRUE on success, FALSE if the field is malformed, uses an
+ * unsupported wire type or does not fit before end
+ */
+extern gboolean pb_get_field(tvbuff_t *tvb, gint offset, gint end, pb_field_t *field);
+
+/** The value of a PB_WIRETYPE_VARINT field as a signed 32 bit protobuf
+ * int32; negative numbers are sign extended to 64 bits on the wire.
+ */
+#define pb_field_int32(field)   ((gint32)(guint32)(field)->value)
+
+/** The value of a PB_WIRETYPE_VARINT field as a signed 64 bit protobuf int64 */
+#define pb_field_int64(field)   ((gint64)(field)->value)
+
+#endif /* __PROTOBUF_H__ */
@@ -5,10 +5,18 @@
 #include "config.h"
 
 #include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/expert.h>
+#include <epan/emem.h>
+#include <epan/tap.h>
+
+#include "packet-efcp.h"
 
 #define ETH_P_RINA 0xD1F0
+#define EFCP_HEADER_LEN 56
 
 static int proto_rina = -1;
+static int efcp_tap = -1;
 
 static int hf_rina_pdu_type     = -1;
 static int hf_rina_dst_addr     = -1;
@@ -24,8 +32,20 @@ static int hf_rina_new_lt_win   = -1;
 static int hf_rina_lt_win       = -1;
 static int hf_rina_rt_win       = -1;
 static int hf_rina_ctrl_seq     = -1;
+static int hf_rina_analysis                 = -1;
+static int hf_rina_analysis_retransmission  = -1;
+static int hf_rina_analysis_retrans_frame   = -1;
+static int hf_rina_analysis_out_of_order    = -1;
+static int hf_rina_analysis_lost_segment    = -1;
+static int hf_rina_analysis_lost_count      = -1;
+static int hf_rina_analysis_window_full     = -1;
+static int hf_rina_analysis_acks_frame      = -1;
+static int hf_rina_analysis_ack_rtt         = -1;
 
 static gint ett_rina = -1;
+static gint ett_rina_analysis = -1;
+
+static gboolean rina_analyze_seq = TRUE;
 
 static dissector_handle_t cdap_handle;
 
@@ -35,26 +55,295 @@ static const value_string pdutypenames[] = {
         { 0, NULL }
 };
 
+/*
+ * Sequence number analysis.
+ *
+ * A connection is identified by both endpoints' address and
+ * connection-endpoint id plus the QoS id, and is looked up in a hash
+ * table on the first pass, so the cost per PDU doesn't depend on the
+ * number of connections or on the length of the capture.  Each direction
+ * remembers the highest sequence number seen, the right window edge its
+ * sender advertised, and the last EFCP_SENT_SLOTS data transfer PDUs,
+ * indexed by sequence number, so that retransmissions can be told apart
+ * from out-of-order PDUs and ACKs can be matched to the PDU they
+ * acknowledge.  The results are attached to the frame, so later passes
+ * don't need the connection state.
+ */
+#define EFCP_SENT_SLOTS 64      /* must be a power of 2 */
+
+/* Sequence number comparison, allowing for wraparound */
+#define EFCP_SEQ_LT(a, b)       ((gint32)((a) - (b)) < 0)
+
+typedef struct _efcp_sent_pdu {
+        guint32  seq_num;
+        guint32  frame;         /* 0 if the slot is unused */
+        nstime_t ts;
+} efcp_sent_pdu;
+
+typedef struct _efcp_flow {
+        gboolean      seq_valid;        /* seen a data transfer PDU */
+        guint32       next_seq;         /* highest sequence number seen + 1 */
+        guint32       rt_win;           /* right window edge advertised by this side, 0 if none */
+        guint32       last_ack;
+        efcp_sent_pdu sent[EFCP_SENT_SLOTS];
+} efcp_flow;
+
+typedef struct _efcp_conv {
+        efcp_conn_key key;
+        efcp_flow     flow[2];          /* indexed by direction, 0 is from key.addr[0] */
+} efcp_conv;
+
+typedef struct _efcp_pdu_analysis {
+        guint32  flags;
+        guint32  retrans_frame;         /* frame that first carried this sequence number */
+        guint32  lost_count;            /* PDUs missing before this one */
+        guint32  acks_frame;            /* frame carrying the PDU this one acknowledges */
+        nstime_t ack_rtt;
+} efcp_pdu_analysis;
+
+static GHashTable *efcp_conv_table = NULL;
+
+static void
+efcp_init(void)
+{
+        if (efcp_conv_table)
+                g_hash_table_destroy(efcp_conv_table);
+        /* The connections themselves are in se memory */
+        efcp_conv_table = g_hash_table_new(efcp_conn_key_hash, efcp_conn_key_equal);
+}
+
+/*
+ * Work out which connection a PDU belongs to and which direction it's
+ * going in; returns the direction.
+ */
+static int
+efcp_conn_key_init(efcp_conn_key *key, guint32 src_addr, gint32 src_cep,
+                   guint32 dst_addr, gint32 dst_cep, guint32 qos_id)
+{
+        int dir;
+
+        memset(key, 0, sizeof(*key));
+        if (src_addr < dst_addr ||
+            (src_addr == dst_addr && src_cep <= dst_cep)) {
+                dir = 0;
+                key->addr[0] = src_addr;
+                key->cep[0]  = src_cep;
+                key->addr[1] = dst_addr;
+                key->cep[1]  = dst_cep;
+        } else {
+                dir = 1;
+                key->addr[0] = dst_addr;
+                key->cep[0]  = dst_cep;
+                key->addr[1] = src_addr;
+                key->cep[1]  = src_cep;
+        }
+        key->qos_id = qos_id;
+
+        return dir;
+}
+
+/* Find or create a connection */
+static efcp_conv *
+efcp_find_conv(const efcp_conn_key *key)
+{
+        efcp_conv *conv;
+
+        conv = (efcp_conv *)g_hash_table_lookup(efcp_conv_table, key);
+        if (!conv) {
+                conv = se_new0(efcp_conv);
+                conv->key = *key;
+                g_hash_table_insert(efcp_conv_table, &conv->key, conv);
+        }
+        return conv;
+}
+
+/*
+ * Update the connection state with a PDU seen for the first time, and
+ * return what we found out about it.
+ */
+static void
+efcp_analyze_pdu(packet_info *pinfo, const efcp_tap_info *efcpinfo,
+                 guint32 ack_nack_seq, guint32 rt_win,
+                 efcp_pdu_analysis *pa)
+{
+        efcp_conv     *conv;
+        efcp_flow     *flow, *peer;
+        efcp_sent_pdu *slot;
+        guint32        seq_num = efcpinfo->seq_num;
+
+        conv = efcp_find_conv(&efcpinfo->conn);
+        flow = &conv->flow[efcpinfo->dir];
+        peer = &conv->flow[1 - efcpinfo->dir];
+
+        if (efcpinfo->pdu_type == EFCP_PDU_TYPE_DT) {
+                slot = &flow->sent[seq_num & (EFCP_SENT_SLOTS - 1)];
+                if (!flow->seq_valid) {
+                        flow->seq_valid = TRUE;
+                        flow->next_seq = seq_num + 1;
+                } else if (slot->frame && slot->seq_num == seq_num) {
+                        pa->flags |= EFCP_A_RETRANSMISSION;
+                        pa->retrans_frame = slot->frame;
+                } else if (EFCP_SEQ_LT(seq_num, flow->next_seq)) {
+                        pa->flags |= EFCP_A_OUT_OF_ORDER;
+                } else {
+                        if (seq_num != flow->next_seq) {
+                                pa->flags |= EFCP_A_LOST_SEGMENT;
+                                pa->lost_count = seq_num - flow->next_seq;
+                        }
+                        flow->next_seq = seq_num + 1;
+                }
+                /* The receiver won't accept anything past its right window edge */
+                if (peer->rt_win && !EFCP_SEQ_LT(seq_num, peer->rt_win))
+                        pa->flags |= EFCP_A_WINDOW_FULL;
+
+                slot->seq_num = seq_num;
+                slot->frame   = pinfo->fd->num;
+                slot->ts      = pinfo->fd->abs_ts;
+        }
+
+        /* Match the first ACK of a sequence number with the PDU it acknowledges */
+        if (ack_nack_seq && ack_nack_seq != flow->last_ack) {
+                slot = &peer->sent[ack_nack_seq & (EFCP_SENT_SLOTS - 1)];
+                if (slot->frame && slot->seq_num == ack_nack_seq) {
+                        pa->acks_frame = slot->frame;
+                        nstime_delta(&pa->ack_rtt, &pinfo->fd->abs_ts, &slot->ts);
+                }
+                flow->last_ack = ack_nack_seq;
+        }
+        if (rt_win)
+                flow->rt_win = rt_win;
+}
+
+static void
+efcp_print_analysis(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
+                    efcp_pdu_analysis *pa)
+{
+        proto_item *item;
+        proto_tree *analysis_tree;
+
+        item = proto_tree_add_item(tree, hf_rina_analysis, tvb, 0, 0, ENC_NA);
+        PROTO_ITEM_SET_GENERATED(item);
+        analysis_tree = proto_item_add_subtree(item, ett_rina_analysis);
+
+        if (pa->acks_frame) {
+                item = proto_tree_add_uint(analysis_tree, hf_rina_analysis_acks_frame,
+                                           tvb, 0, 0, pa->acks_frame);
+                PROTO_ITEM_SET_GENERATED(item);
+                item = proto_tree_add_time(analysis_tree, hf_rina_analysis_ack_rtt,
+                                           tvb, 0, 0, &pa->ack_rtt);
+                PROTO_ITEM_SET_GENERATED(item);
+        }
+        if (pa->flags & EFCP_A_RETRANSMISSION) {
+                item = proto_tree_add_none_format(analysis_tree, hf_rina_analysis_retransmission,
+                                                  tvb, 0, 0, "This PDU is a retransmission");
+                PROTO_ITEM_SET_GENERATED(item);
+                expert_add_info_format(pinfo, item, PI_SEQUENCE, PI_NOTE,
+                                       "Retransmission (suspected)");
+                col_append_str(pinfo->cinfo, COL_INFO, "[Retransmission] ");
+                item = proto_tree_add_uint(analysis_tree, hf_rina_analysis_retrans_frame,
+                                           tvb, 0, 0, pa->retrans_frame);
+                PROTO_ITEM_SET_GENERATED(item);
+        }
+        if (pa->flags & EFCP_A_OUT_OF_ORDER) {
+                item = proto_tree_add_none_format(analysis_tree, hf_rina_analysis_out_of_order,
+                                                  tvb, 0, 0, "This PDU is out of order");
+                PROTO_ITEM_SET_GENERATED(item);
+                expert_add_info_format(pinfo, item, PI_SEQUENCE, PI_WARN,
+                                       "Out-of-order PDU");
+                col_append_str(pinfo->cinfo, COL_INFO, "[Out-Of-Order] ");
+        }
+        if (pa->flags & EFCP_A_LOST_SEGMENT) {
+                item = proto_tree_add_none_format(analysis_tree, hf_rina_analysis_lost_segment,
+                                                  tvb, 0, 0, "A previous PDU was not captured");
+                PROTO_ITEM_SET_GENERATED(item);
+                expert_add_info_format(pinfo, item, PI_SEQUENCE, PI_WARN,
+                                       "Previous PDU(s) not captured (%u missing)",
+                                       pa->lost_count);
+                col_append_str(pinfo->cinfo, COL_INFO, "[Previous PDU not captured] ");
+                item = proto_tree_add_uint(analysis_tree, hf_rina_analysis_lost_count,
+                                           tvb, 0, 0, pa->lost_count);
+                PROTO_ITEM_SET_GENERATED(item);
+        }
+        if (pa->flags & EFCP_A_WINDOW_FULL) {
+                item = proto_tree_add_none_format(analysis_tree, hf_rina_analysis_window_full,
+                                                  tvb, 0, 0, "This PDU reaches the right window edge advertised by the receiver");
+                PROTO_ITEM_SET_GENERATED(item);
+                expert_add_info_format(pinfo, item, PI_SEQUENCE, PI_WARN,
+                                       "Window exhausted");
+                col_append_str(pinfo->cinfo, COL_INFO, "[Window Full] ");
+        }
+}
+
 static void
 dissect_rina(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
 {
         gint offset = 0;
         guint pdu_type = 0;
         tvbuff_t *next_tvb = NULL; 
-
-        pdu_type = tvb_get_letoh24(tvb, 0);
+        proto_tree *rina_tree = NULL;
+        efcp_pdu_analysis *pa = NULL;
+        efcp_tap_info *efcpinfo;
+        void *pd_save;
 
         col_set_str(pinfo->cinfo, COL_PROTOCOL, "EFCP");
         /* Clear out stuff in the info column */
         col_clear(pinfo->cinfo,COL_INFO);
+
+        /* The analysis and the tap read the header whether or not there's a tree */
+        if (tvb_reported_length(tvb) < EFCP_HEADER_LEN) {
+                proto_item *ti;
+
+                col_set_str(pinfo->cinfo, COL_INFO, "Malformed PDU");
+                ti = proto_tree_add_item(tree, proto_rina, tvb, 0, -1, ENC_NA);
+                expert_add_info_format(pinfo, ti, PI_MALFORMED, PI_ERROR,
+                                       "PDU shorter than the %d byte header",
+                                       EFCP_HEADER_LEN);
+                return;
+        }
+
+        pdu_type = tvb_get_letoh24(tvb, 0);
+
         col_add_fstr(pinfo->cinfo, COL_INFO, "%s PDU ",
                      val_to_str(pdu_type, pdutypenames, "Unknown (0x%02x)"));
 
+        efcpinfo = ep_new(efcp_tap_info);
+        efcpinfo->pdu_type       = pdu_type;
+        efcpinfo->dst_addr       = tvb_get_letohl(tvb, 4);
+        efcpinfo->src_addr       = tvb_get_letohl(tvb, 8);
+        efcpinfo->dst_cep        = (gint32)tvb_get_letohl(tvb, 12);
+        efcpinfo->src_cep        = (gint32)tvb_get_letohl(tvb, 16);
+        efcpinfo->qos_id         = tvb_get_letohl(tvb, 20);
+        efcpinfo->pdu_flags      = tvb_get_letohl(tvb, 24);
+        efcpinfo->seq_num        = tvb_get_letohl(tvb, 28);
+        efcpinfo->length         = tvb_reported_length(tvb);
+        efcpinfo->dir = efcp_conn_key_init(&efcpinfo->conn,
+                                           efcpinfo->src_addr, efcpinfo->src_cep,
+                                           efcpinfo->dst_addr, efcpinfo->dst_cep,
+                                           efcpinfo->qos_id);
+
+        if (rina_analyze_seq) {
+                if (!pinfo->fd->flags.visited) {
+                        efcp_pdu_analysis analysis;
+
+                        memset(&analysis, 0, sizeof(analysis));
+                        efcp_analyze_pdu(pinfo, efcpinfo,
+                                         tvb_get_letohl(tvb, 32),   /* ack_nack_seq */
+                                         tvb_get_letohl(tvb, 48),   /* rt_win */
+                                         &analysis);
+                        /* Only keep something for PDUs there's something to say about */
+                        if (analysis.flags || analysis.acks_frame) {
+                                pa = (efcp_pdu_analysis *)se_memdup(&analysis, sizeof(analysis));
+                                p_add_proto_data(pinfo->fd, proto_rina, 0, pa);
+                        }
+                } else {
+                        pa = (efcp_pdu_analysis *)p_get_proto_data(pinfo->fd, proto_rina, 0);
+                }
+        }
+
         if (tree) { /* we are being asked for details */
                 proto_item *ti = NULL;
-                proto_tree *rina_tree = NULL;
 
-                ti = proto_tree_add_item(tree, proto_rina, tvb, 0, 56, ENC_NA);
+                ti = proto_tree_add_item(tree, proto_rina, tvb, 0, EFCP_HEADER_LEN, ENC_NA);
                 proto_item_append_text(ti, ", %s PDU",
                                        val_to_str(pdu_type, 
                                                   pdutypenames, 
@@ -102,12 +391,28 @@ dissect_rina(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
                 proto_tree_add_item(rina_tree, hf_rina_ctrl_seq, 
                                     tvb, offset, 4, ENC_LITTLE_ENDIAN);
         }
-        if (pdu_type ==  0xC000) {
-                next_tvb = tvb_new_subset(tvb, 56, -1, 0);
-                call_dissector(cdap_handle, 
-                               next_tvb, 
-                               pinfo, 
-                               tree);
+        /* Expert info and the Info column want the analysis even without a tree */
+        if (pa)
+                efcp_print_analysis(tvb, pinfo, rina_tree, pa);
+
+        efcpinfo->analysis_flags = pa ? pa->flags : 0;
+        tap_queue_packet(efcp_tap, pinfo, efcpinfo);
+        if (pdu_type == EFCP_PDU_TYPE_MGMT) {
+                /* CDAP matches requests and responses per connection */
+                pd_save = pinfo->private_data;
+                pinfo->private_data = efcpinfo;
+                next_tvb = tvb_new_subset_remaining(tvb, EFCP_HEADER_LEN);
+                TRY {
+                        call_dissector(cdap_handle, 
+                                       next_tvb, 
+                                       pinfo, 
+                                       tree);
+                }
+                /* Restore it even if CDAP threw */
+                FINALLY {
+                        pinfo->private_data = pd_save;
+                }
+                ENDTRY;
         }
 }
 
@@ -198,14 +503,71 @@ proto_register_rina(void)
                     FT_UINT32, BASE_DEC,
                     NULL, 0x0,
                     NULL, HFILL }
+                },
+                { &hf_rina_analysis,
+                  { "SEQ/ACK analysis", "rina.analysis",
+                    FT_NONE, BASE_NONE,
+                    NULL, 0x0,
+                    "This frame has some of the EFCP analysis shown", HFILL }
+                },
+                { &hf_rina_analysis_retransmission,
+                  { "Retransmission", "rina.analysis.retransmission",
+                    FT_NONE, BASE_NONE,
+                    NULL, 0x0,
+                    "This PDU has a sequence number that was already sent", HFILL }
+                },
+                { &hf_rina_analysis_retrans_frame,
+                  { "Original transmission in frame", "rina.analysis.retransmitted_frame",
+                    FT_FRAMENUM, BASE_NONE,
+                    NULL, 0x0,
+                    "The frame in which this sequence number was last sent", HFILL }
+                },
+                { &hf_rina_analysis_out_of_order,
+                  { "Out Of Order", "rina.analysis.out_of_order",
+                    FT_NONE, BASE_NONE,
+                    NULL, 0x0,
+                    "This PDU arrived after one with a higher sequence number", HFILL }
+                },
+                { &hf_rina_analysis_lost_segment,
+                  { "Previous PDU not captured", "rina.analysis.lost_segment",
+                    FT_NONE, BASE_NONE,
+                    NULL, 0x0,
+                    "Sequence numbers were skipped before this PDU", HFILL }
+                },
+                { &hf_rina_analysis_lost_count,
+                  { "Missing PDUs", "rina.analysis.lost_count",
+                    FT_UINT32, BASE_DEC,
+                    NULL, 0x0,
+                    "Number of sequence numbers skipped before this PDU", HFILL }
+                },
+                { &hf_rina_analysis_window_full,
+                  { "Window full", "rina.analysis.window_full",
+                    FT_NONE, BASE_NONE,
+                    NULL, 0x0,
+                    "This PDU reaches the right window edge advertised by the receiver", HFILL }
+                },
+                { &hf_rina_analysis_acks_frame,
+                  { "This is an ACK to the PDU in frame", "rina.analysis.acks_frame",
+                    FT_FRAMENUM, BASE_NONE,
+                    NULL, 0x0,
+                    "Which previous PDU is this an ACK for", HFILL }
+                },
+                { &hf_rina_analysis_ack_rtt,
+                  { "The RTT to ACK the PDU was", "rina.analysis.ack_rtt",
+                    FT_RELATIVE_TIME, BASE_NONE,
+                    NULL, 0x0,
+                    "How long it took to ACK the PDU (RTT)", HFILL }
                 }
         };
 
         /* Setup protocol subtree array */
         static gint *ett[] = {
-                &ett_rina
+                &ett_rina,
+                &ett_rina_analysis
         };
 
+        module_t *rina_module;
+
         proto_rina = proto_register_protocol (
                                               "Error and Flow Control Protocol",     /* name       */
                                               "EFCP",                                /* short name */
@@ -214,6 +576,18 @@ proto_register_rina(void)
 
         proto_register_field_array(proto_rina, hf, array_length(hf));
         proto_register_subtree_array(ett, array_length(ett));
+
+        rina_module = prefs_register_protocol(proto_rina, NULL);
+        prefs_register_bool_preference(rina_module, "analyze_sequence_numbers",
+                                       "Analyze EFCP sequence numbers",
+                                       "Track each EFCP connection to flag retransmissions, "
+                                       "out-of-order and lost PDUs and window exhaustion, "
+                                       "and to measure the ACK round trip time",
+                                       &rina_analyze_seq);
+
+        register_init_routine(efcp_init);
+
+        efcp_tap = register_tap("efcp");
 }
 
 void
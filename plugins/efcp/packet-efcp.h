@@ -0,0 +1,79 @@
+/* packet-efcp.h
+ * Definitions shared by the EFCP dissector and its taps
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PACKET_EFCP_H__
+#define __PACKET_EFCP_H__
+
+#include <string.h>
+
+#define EFCP_PDU_TYPE_DT   0x8001
+#define EFCP_PDU_TYPE_MGMT 0xC000
+
+/* Sequence number analysis flags */
+#define EFCP_A_RETRANSMISSION   0x01
+#define EFCP_A_OUT_OF_ORDER     0x02
+#define EFCP_A_LOST_SEGMENT     0x04
+#define EFCP_A_WINDOW_FULL      0x08
+
+/* A connection: both endpoints, the lower one first, and its QoS id */
+typedef struct _efcp_conn_key {
+        guint32 addr[2];
+        gint32  cep[2];
+        guint32 qos_id;
+} efcp_conn_key;
+
+/* Passed to listeners of the "efcp" tap, one per PDU */
+typedef struct _efcp_tap_info {
+        guint32 pdu_type;
+        guint32 src_addr;
+        guint32 dst_addr;
+        gint32  src_cep;
+        gint32  dst_cep;
+        guint32 qos_id;
+        guint32 pdu_flags;
+        guint32 seq_num;
+        guint32 length;                 /* reported length of the PDU */
+        guint32 analysis_flags;         /* EFCP_A_ flags, 0 if the analysis is off */
+        efcp_conn_key conn;             /* the connection the PDU belongs to */
+        int     dir;                    /* 0 if the PDU is from conn.addr[0] */
+} efcp_tap_info;
+
+/* For hash tables keyed by connection */
+static inline guint
+efcp_conn_key_hash(gconstpointer k)
+{
+        const efcp_conn_key *key = (const efcp_conn_key *)k;
+
+        return key->addr[0] ^ (key->addr[1] << 7) ^
+                ((guint32)key->cep[0] << 13) ^ ((guint32)key->cep[1] << 19) ^
+                (key->qos_id << 25);
+}
+
+static inline gint
+efcp_conn_key_equal(gconstpointer k1, gconstpointer k2)
+{
+        return memcmp(k1, k2, sizeof(efcp_conn_key)) == 0;
+}
+
+#endif /* __PACKET_EFCP_H__ */
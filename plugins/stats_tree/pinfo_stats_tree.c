@@ -131,9 +131,9 @@ static void ip_hosts_stats_tree_init(stats_tree* st) {
 }
 
 static int ip_hosts_stats_tree_packet(stats_tree *st  , packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	tick_stat_node(st, st_str_ip, 0, FALSE);
-	tick_stat_node(st, ep_address_to_str(&pinfo->net_src), st_node_ip, FALSE);
-	tick_stat_node(st, ep_address_to_str(&pinfo->net_dst), st_node_ip, FALSE);
+	tick_stat_node_by_id(st, st_node_ip);
+	tick_stat_node_by_id(st, stats_tree_address_node(st, &pinfo->net_src, st_node_ip, FALSE));
+	tick_stat_node_by_id(st, stats_tree_address_node(st, &pinfo->net_dst, st_node_ip, FALSE));
 
 	return 1;
 }
@@ -173,8 +173,8 @@ static void plen_stats_tree_init(stats_tree* st) {
 }
 
 static int plen_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	tick_stat_node(st, st_str_plen, 0, FALSE);
-	stats_tree_tick_range(st, st_str_plen, 0, pinfo->fd->pkt_len);
+	tick_stat_node_by_id(st, st_node_plen);
+	stats_tree_tick_range_by_id(st, st_node_plen, pinfo->fd->pkt_len);
 
 	return 1;
 }
@@ -196,15 +196,26 @@ static int dsts_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_disse
 	static gchar str[128];
 	int ip_dst_node;
 	int protocol_node;
+	int port_node;
 
-	tick_stat_node(st, st_str_dsts, 0, FALSE);
+	tick_stat_node_by_id(st, st_node_dsts);
 
-	ip_dst_node = tick_stat_node(st, ep_address_to_str(&pinfo->net_src), st_node_dsts, TRUE);
+	ip_dst_node = stats_tree_address_node(st, &pinfo->net_src, st_node_dsts, TRUE);
+	tick_stat_node_by_id(st, ip_dst_node);
 
-	protocol_node = tick_stat_node(st,port_type_to_str(pinfo->ptype),ip_dst_node,TRUE);
+	protocol_node = stats_tree_node_id_by_key(st, ip_dst_node, &pinfo->ptype, sizeof pinfo->ptype);
+	if (protocol_node < 0)
+		protocol_node = stats_tree_create_keyed_node(st, port_type_to_str(pinfo->ptype), ip_dst_node,
+							     &pinfo->ptype, sizeof pinfo->ptype, TRUE);
+	tick_stat_node_by_id(st, protocol_node);
 
-	g_snprintf(str, sizeof(str),"%u",pinfo->destport);
-	tick_stat_node(st,str,protocol_node,TRUE);
+	port_node = stats_tree_node_id_by_key(st, protocol_node, &pinfo->destport, sizeof pinfo->destport);
+	if (port_node < 0) {
+		g_snprintf(str, sizeof(str),"%u",pinfo->destport);
+		port_node = stats_tree_create_keyed_node(st, str, protocol_node,
+							 &pinfo->destport, sizeof pinfo->destport, TRUE);
+	}
+	tick_stat_node_by_id(st, port_node);
 
 	return 1;
 }
@@ -33,6 +33,7 @@
 
 #include <epan/epan.h>
 #include <epan/epan_dissect.h>
+#include <epan/ipv4.h>
 #include <epan/tvbuff.h>
 #include <epan/packet.h>
 #include <epan/emem.h>
@@ -85,6 +86,8 @@ struct _output_fields {
     GPtrArray  **field_values;
     gchar        quote;
     gboolean     includes_col_fields;
+    struct _output_column *columns;     /* "-T columns" buffers */
+    guint32      column_rows;           /* rows in the buffers */
 };
 
 GHashTable *output_only_tables = NULL;
@@ -105,6 +108,7 @@ static void print_escaped_xml(FILE *fh, const char *unescaped_string);
 static void print_pdml_geninfo(proto_tree *tree, FILE *fh);
 
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data);
+static void output_columns_free(output_fields_t *fields);
 
 static FILE *
 open_print_dest(gboolean to_file, const char *dest)
@@ -1338,6 +1342,8 @@ output_fields_t* output_fields_new(void)
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->columns             = NULL;
+    fields->column_rows         = 0;
     return fields;
 }
 
@@ -1370,6 +1376,10 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        if (NULL != fields->columns) {
+            output_columns_free(fields);
+        }
+
         for(i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -1707,6 +1717,431 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+/*
+ * "-T columns": the values of the "-e" fields are kept in one typed buffer
+ * per field, with integers, addresses and time stamps in binary form, and
+ * the buffers are written out as a block every COLUMNS_BLOCK_ROWS packets.
+ * Nothing is formatted as a string unless the field is a string or has no
+ * binary column type, which makes it much cheaper than "-T fields" for
+ * exporting a few fields of a large capture.
+ *
+ * Every integer in the output is in the byte order of the machine that
+ * wrote it; a reader finds out which from the byte order mark.
+ *
+ * Header:
+ *     8 bytes    magic, "WSCOLS\0\0"
+ *     guint32    byte order mark, 0x1a2b3c4d
+ *     guint32    format version, 1
+ *     guint32    number of columns
+ *     per column:
+ *       guint32  type, see output_column_type_e
+ *       guint32  length of the field name, followed by the name (no NUL)
+ *
+ * Blocks:
+ *     guint32    number of rows, 0 for the block that ends the output
+ *                (which has nothing else)
+ *     per column:
+ *       guint32  number of values
+ *       guint32  rows + 1 value indices: the first value of every row,
+ *                then the number of values.  A row for a packet without
+ *                the field has no values; with "-E occurrence=a" a row
+ *                has a value for every occurrence of the field.
+ *       variable length types only:
+ *       guint32  the end of every value in the data
+ *       guint32  length of the data, followed by the values one after the
+ *                other, without any padding
+ */
+#define COLUMNS_MAGIC           "WSCOLS\0\0"
+#define COLUMNS_BYTE_ORDER_MARK 0x1a2b3c4d
+#define COLUMNS_VERSION         1
+#define COLUMNS_BLOCK_ROWS      65536
+
+typedef enum {
+    COLUMN_PRESENT = 0, /* FT_NONE, FT_PROTOCOL; no data, just the indices */
+    COLUMN_UINT32  = 1, /* FT_BOOLEAN, FT_UINT8 to FT_UINT32, FT_FRAMENUM, FT_IPXNET */
+    COLUMN_INT32   = 2, /* FT_INT8 to FT_INT32 */
+    COLUMN_UINT64  = 3, /* FT_UINT64, FT_EUI64 */
+    COLUMN_INT64   = 4, /* FT_INT64 */
+    COLUMN_DOUBLE  = 5, /* FT_FLOAT, FT_DOUBLE */
+    COLUMN_IPV4    = 6, /* 4 bytes, network byte order */
+    COLUMN_IPV6    = 7, /* 16 bytes */
+    COLUMN_ETHER   = 8, /* 6 bytes */
+    COLUMN_TIME    = 9, /* gint64 nanoseconds, since the epoch for FT_ABSOLUTE_TIME */
+    COLUMN_BYTES   = 10, /* variable length */
+    COLUMN_STRING  = 11  /* variable length; every other type, "col." fields,
+                            and fields whose same-name registrations differ,
+                            as "-T fields" would print them */
+} output_column_type_e;
+
+/* Bytes per value, 0 for the variable length types */
+static const guint32 column_type_width[] = {
+    0, 4, 4, 8, 8, 8, 4, 16, 6, 8, 0, 0
+};
+
+#define COLUMN_IS_VARIABLE(type) \
+    ((type) == COLUMN_BYTES || (type) == COLUMN_STRING)
+
+typedef struct _output_column {
+    output_column_type_e type;
+    GArray      *hfids;         /* int, every field registered with the name */
+    gint         col;           /* column of a "col." field, -1 if there's
+                                   none, -2 until the first packet */
+    guint32      num_values;
+    GArray      *rows;          /* guint32, the first value of every row */
+    GArray      *ends;          /* guint32, the end of every value in data,
+                                   variable length types only */
+    GByteArray  *data;
+} output_column_t;
+
+static output_column_type_e output_column_type(ftenum_t type)
+{
+    switch (type) {
+    case FT_NONE:
+    case FT_PROTOCOL:
+        return COLUMN_PRESENT;
+    case FT_BOOLEAN:
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_FRAMENUM:
+    case FT_IPXNET:
+        return COLUMN_UINT32;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return COLUMN_INT32;
+    case FT_UINT64:
+    case FT_EUI64:
+        return COLUMN_UINT64;
+    case FT_INT64:
+        return COLUMN_INT64;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return COLUMN_DOUBLE;
+    case FT_IPv4:
+        return COLUMN_IPV4;
+    case FT_IPv6:
+        return COLUMN_IPV6;
+    case FT_ETHER:
+        return COLUMN_ETHER;
+    case FT_ABSOLUTE_TIME:
+    case FT_RELATIVE_TIME:
+        return COLUMN_TIME;
+    case FT_BYTES:
+    case FT_UINT_BYTES:
+        return COLUMN_BYTES;
+    default:
+        return COLUMN_STRING;
+    }
+}
+
+/* Calls func for every field registered with the name of an "-e" field */
+static void output_fields_foreach_hfinfo(const gchar *field,
+                                         void (*func)(header_field_info *, gpointer),
+                                         gpointer data)
+{
+    header_field_info *hfinfo;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+        return;
+
+    hfinfo = proto_registrar_get_byname(field);
+    if (hfinfo == NULL)
+        return;
+
+    while (hfinfo->same_name_prev != NULL)
+        hfinfo = hfinfo->same_name_prev;
+    for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next)
+        func(hfinfo, data);
+}
+
+static void output_column_add_hfinfo(header_field_info *hfinfo, gpointer data)
+{
+    output_column_t *column = (output_column_t *)data;
+
+    if (column->hfids->len == 0)
+        column->type = output_column_type(hfinfo->type);
+    else if (output_column_type(hfinfo->type) != column->type)
+        column->type = COLUMN_STRING;
+
+    g_array_append_val(column->hfids, hfinfo->id);
+}
+
+static void output_columns_init(output_fields_t *fields)
+{
+    gsize i;
+
+    fields->columns = g_new0(output_column_t, fields->fields->len);
+    fields->column_rows = 0;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        output_column_t *column = &fields->columns[i];
+
+        /* Like "-T fields", a field that doesn't exist is never present */
+        column->type = COLUMN_STRING;
+        column->hfids = g_array_new(FALSE, FALSE, sizeof(int));
+        column->col = -1;
+        if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+            column->col = -2;
+        else
+            output_fields_foreach_hfinfo(field, output_column_add_hfinfo, column);
+
+        column->rows = g_array_sized_new(FALSE, FALSE, sizeof(guint32), COLUMNS_BLOCK_ROWS + 1);
+        column->ends = COLUMN_IS_VARIABLE(column->type) ?
+            g_array_new(FALSE, FALSE, sizeof(guint32)) : NULL;
+        column->data = g_byte_array_new();
+    }
+}
+
+static void output_columns_free(output_fields_t *fields)
+{
+    gsize i;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        output_column_t *column = &fields->columns[i];
+
+        g_array_free(column->hfids, TRUE);
+        g_array_free(column->rows, TRUE);
+        if (column->ends != NULL)
+            g_array_free(column->ends, TRUE);
+        g_byte_array_free(column->data, TRUE);
+    }
+    g_free(fields->columns);
+    fields->columns = NULL;
+}
+
+static void output_column_add_string(output_column_t *column, const gchar *value)
+{
+    guint32 end;
+
+    if (value != NULL)
+        g_byte_array_append(column->data, (const guint8 *)value, (guint)strlen(value));
+    end = column->data->len;
+    g_array_append_val(column->ends, end);
+    column->num_values++;
+}
+
+static void output_column_add_value(output_column_t *column, field_info *fi, epan_dissect_t *edt)
+{
+    union {
+        guint32 u32;
+        gint32  i32;
+        guint64 u64;
+        gint64  i64;
+        gdouble dbl;
+    } v;
+    const guint8 *value = (const guint8 *)&v;
+    guint32 end;
+
+    switch (column->type) {
+    case COLUMN_PRESENT:
+        break;
+    case COLUMN_UINT32:
+        v.u32 = fvalue_get_uinteger(&fi->value);
+        break;
+    case COLUMN_INT32:
+        v.i32 = fvalue_get_sinteger(&fi->value);
+        break;
+    case COLUMN_UINT64:
+        v.u64 = fvalue_get_integer64(&fi->value);
+        break;
+    case COLUMN_INT64:
+        v.i64 = (gint64)fvalue_get_integer64(&fi->value);
+        break;
+    case COLUMN_DOUBLE:
+        v.dbl = fvalue_get_floating(&fi->value);
+        break;
+    case COLUMN_IPV4:
+        v.u32 = ipv4_get_net_order_addr((ipv4_addr *)fvalue_get(&fi->value));
+        break;
+    case COLUMN_IPV6:
+    case COLUMN_ETHER:
+        value = (const guint8 *)fvalue_get(&fi->value);
+        break;
+    case COLUMN_TIME:
+        {
+            const nstime_t *ts = (const nstime_t *)fvalue_get(&fi->value);
+            v.i64 = (gint64)ts->secs * 1000000000 + ts->nsecs;
+        }
+        break;
+    case COLUMN_BYTES:
+        g_byte_array_append(column->data, (const guint8 *)fvalue_get(&fi->value),
+                            fvalue_length(&fi->value));
+        end = column->data->len;
+        g_array_append_val(column->ends, end);
+        column->num_values++;
+        return;
+    case COLUMN_STRING:
+        if (IS_FT_STRING(fi->hfinfo->type) || fi->hfinfo->type == FT_UINT_STRING)
+            output_column_add_string(column, (const gchar *)fvalue_get(&fi->value));
+        else
+            output_column_add_string(column, get_node_field_value(fi, edt));
+        return;
+    }
+
+    g_byte_array_append(column->data, value, column_type_width[column->type]);
+    column->num_values++;
+}
+
+static void write_columns_block(output_fields_t *fields, FILE *fh)
+{
+    gsize i;
+
+    fwrite(&fields->column_rows, sizeof(guint32), 1, fh);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        output_column_t *column = &fields->columns[i];
+        guint32 data_len = column->data->len;
+
+        fwrite(&column->num_values, sizeof(guint32), 1, fh);
+        fwrite(column->rows->data, sizeof(guint32), column->rows->len, fh);
+        fwrite(&column->num_values, sizeof(guint32), 1, fh);
+        if (column->ends != NULL) {
+            if (column->ends->len != 0)
+                fwrite(column->ends->data, sizeof(guint32), column->ends->len, fh);
+            g_array_set_size(column->ends, 0);
+        }
+        fwrite(&data_len, sizeof(guint32), 1, fh);
+        if (data_len != 0)
+            fwrite(column->data->data, 1, data_len, fh);
+
+        /* value indices and ends start at 0 in every block */
+        column->num_values = 0;
+        g_array_set_size(column->rows, 0);
+        g_byte_array_set_size(column->data, 0);
+    }
+
+    fields->column_rows = 0;
+}
+
+static void output_fields_prime_hfinfo(header_field_info *hfinfo, gpointer data)
+{
+    proto_interest_add_hfid((proto_interest_t *)data, hfinfo->id);
+}
+
+void output_fields_prime_interest(output_fields_t *fields, proto_interest_t *interest)
+{
+    gsize i;
+
+    g_assert(fields);
+
+    if (NULL == fields->fields)
+        return;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        output_fields_foreach_hfinfo((const gchar *)g_ptr_array_index(fields->fields, i),
+                                     output_fields_prime_hfinfo, interest);
+    }
+}
+
+void write_columns_preamble(output_fields_t* fields, FILE *fh)
+{
+    guint32 header[3];
+    gsize i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    if (NULL == fields->columns)
+        output_columns_init(fields);
+
+    fwrite(COLUMNS_MAGIC, 1, 8, fh);
+    header[0] = COLUMNS_BYTE_ORDER_MARK;
+    header[1] = COLUMNS_VERSION;
+    header[2] = fields->fields->len;
+    fwrite(header, sizeof(guint32), 3, fh);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        header[0] = fields->columns[i].type;
+        header[1] = (guint32)strlen(field);
+        fwrite(header, sizeof(guint32), 2, fh);
+        fwrite(field, 1, header[1], fh);
+    }
+}
+
+void proto_tree_write_columns(output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh)
+{
+    gsize i;
+    guint j;
+
+    g_assert(fields);
+    g_assert(fields->columns);
+    g_assert(edt);
+    g_assert(fh);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        output_column_t *column = &fields->columns[i];
+        field_info *last = NULL;
+
+        g_array_append_val(column->rows, column->num_values);
+
+        if (column->col != -1) {
+            if (column->col == -2 && cinfo != NULL) {
+                const gchar *title = (const gchar *)g_ptr_array_index(fields->fields, i) +
+                                     strlen(COLUMN_FIELD_FILTER);
+                gint col;
+
+                column->col = -1;
+                for (col = 0; col < cinfo->num_cols; col++) {
+                    if (strcmp(cinfo->col_title[col], title) == 0) {
+                        column->col = col;
+                        break;
+                    }
+                }
+            }
+            if (column->col >= 0 && cinfo != NULL)
+                output_column_add_string(column, cinfo->col_data[column->col]);
+            continue;
+        }
+
+        /* XXX - with several fields registered under one name, the
+         * values are in the order of the registrations, not in the
+         * order in which they are in the tree. */
+        for (j = 0; j < column->hfids->len; j++) {
+            GPtrArray *finfos = proto_get_finfo_ptr_array(edt->tree,
+                                                          g_array_index(column->hfids, int, j));
+            guint k;
+
+            if (finfos == NULL)
+                continue;
+
+            if (fields->occurrence == 'f') {
+                output_column_add_value(column, (field_info *)g_ptr_array_index(finfos, 0), edt);
+                break;
+            } else if (fields->occurrence == 'l') {
+                last = (field_info *)g_ptr_array_index(finfos, finfos->len - 1);
+            } else {
+                for (k = 0; k < finfos->len; k++)
+                    output_column_add_value(column, (field_info *)g_ptr_array_index(finfos, k), edt);
+            }
+        }
+        if (last != NULL)
+            output_column_add_value(column, last, edt);
+    }
+
+    if (++fields->column_rows == COLUMNS_BLOCK_ROWS)
+        write_columns_block(fields, fh);
+}
+
+void write_columns_finale(output_fields_t* fields, FILE *fh)
+{
+    guint32 end = 0;
+
+    g_assert(fields);
+    g_assert(fields->columns);
+    g_assert(fh);
+
+    if (fields->column_rows != 0)
+        write_columns_block(fields, fh);
+    fwrite(&end, sizeof(guint32), 1, fh);
+}
+
 /* Returns an ep_alloced string or a static constant*/
 const gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -158,6 +158,12 @@ extern void write_fields_preamble(output_fields_t* fields, FILE *fh);
 extern void proto_tree_write_fields(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 extern void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+/* "-T columns": the fields in typed, binary columns, see print.c */
+extern void output_fields_prime_interest(output_fields_t* fields, proto_interest_t *interest);
+extern void write_columns_preamble(output_fields_t* fields, FILE *fh);
+extern void proto_tree_write_columns(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
+extern void write_columns_finale(output_fields_t* fields, FILE *fh);
+
 extern const gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 #ifdef __cplusplus
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <glib.h>
 
 #ifdef HAVE_UNISTD_H
@@ -35,6 +36,7 @@
 #endif
 
 #include "wtap.h"
+#include <wsutil/file_util.h>
 
 #ifndef HAVE_GETOPT
 #include "wsutil/wsgetopt.h"
@@ -55,6 +57,9 @@ static void usage(void)
     fprintf(stderr, "\n");
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(stderr, "  -w <frames>  reorder in a window of this many frames instead of\n");
+    fprintf(stderr, "               sorting the whole file.\n");
+    fprintf(stderr, "  -W <seconds> reorder in a window of this many seconds.\n");
 }
 
 /* Remember where this frame was in the file */
@@ -161,6 +166,571 @@ frames_compare(gconstpointer a, gconstpointer b)
 }
 
 
+static void
+report_read_error(const char *filename, int err, gchar *err_info)
+{
+    fprintf(stderr,
+            "reordercap: An error occurred while reading \"%s\": %s.\n",
+            filename, wtap_strerror(err));
+    switch (err) {
+
+    case WTAP_ERR_UNSUPPORTED:
+    case WTAP_ERR_UNSUPPORTED_ENCAP:
+    case WTAP_ERR_BAD_FILE:
+        fprintf(stderr, "(%s)\n", err_info);
+        g_free(err_info);
+        break;
+    }
+}
+
+
+/********************************************************************/
+/* Windowed reordering.                                             */
+/*                                                                  */
+/* Out-of-order captures are usually only locally disordered, so    */
+/* the frames are read into a min-heap of a bounded size and the    */
+/* earliest one is written out whenever the window is full: the     */
+/* file is read once, sequentially, and the output is written as we */
+/* go.                                                              */
+/*                                                                  */
+/* If a frame turns up that is older than one that has already been */
+/* written, the window was too small.  The file is then sorted with */
+/* an external merge sort instead: the same heap produces sorted    */
+/* runs ("replacement selection"; a frame that is too late for the  */
+/* current run goes into the next one), which are written to spill  */
+/* files next to the output file and merged at the end.             */
+/********************************************************************/
+
+/* Most spill files that are merged at once */
+#define MAX_MERGE_RUNS 64
+
+/* A frame in the reorder window, with a copy of its data */
+typedef struct HeldFrame_t {
+    guint                num;
+    guint                run;   /* the sorted run it goes into */
+    struct wtap_pkthdr   phdr;
+    guint8              *data;
+} HeldFrame_t;
+
+/* A sorted run of frames written to a spill file.  The frame numbers
+ * are kept in a second file, as the capture file format may have no
+ * room for them. */
+typedef struct SpillRun_t {
+    char                *path;
+    char                *num_path;
+    wtap_dumper         *pdh;
+    wtap                *wth;   /* while merging */
+    FILE                *num_fh;
+    guint32              num;   /* of the frame read last */
+} SpillRun_t;
+
+/* Binary min-heap of pointers */
+typedef struct Heap_t {
+    gpointer            *items;
+    guint                count;
+    guint                size;
+    GCompareFunc         compare;
+} Heap_t;
+
+typedef struct Reorder_t {
+    const char                  *infile;
+    const char                  *outfile;
+    wtap                        *wth;
+    int                          file_type;
+    int                          encap;
+    wtapng_section_t            *shb_hdr;
+    wtapng_iface_descriptions_t *idb_inf;
+
+    guint                        window_frames; /* 0 for no limit */
+    double                       window_secs;   /* 0 for no limit */
+
+    Heap_t                       held;          /* of HeldFrame_t */
+    GPtrArray                   *runs;          /* of SpillRun_t */
+    guint                        spill_count;   /* spill files created */
+
+    /* Statistics */
+    guint                        frames;
+    guint                        wrong_order_count;
+    guint                        written;
+    guint                        max_displacement;  /* frames */
+    double                       max_lateness;      /* seconds */
+} Reorder_t;
+
+static void
+heap_init(Heap_t *heap, GCompareFunc compare)
+{
+    heap->items = NULL;
+    heap->count = 0;
+    heap->size = 0;
+    heap->compare = compare;
+}
+
+static void
+heap_push(Heap_t *heap, gpointer item)
+{
+    guint i, parent;
+
+    if (heap->count == heap->size) {
+        heap->size = heap->size ? 2 * heap->size : 256;
+        heap->items = (gpointer *)g_realloc(heap->items,
+                                            heap->size * sizeof(gpointer));
+    }
+
+    for (i = heap->count++; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (heap->compare(item, heap->items[parent]) >= 0)
+            break;
+        heap->items[i] = heap->items[parent];
+    }
+    heap->items[i] = item;
+}
+
+static gpointer
+heap_pop(Heap_t *heap)
+{
+    gpointer top, last;
+    guint i, child;
+
+    top = heap->items[0];
+    last = heap->items[--heap->count];
+
+    for (i = 0; (child = 2 * i + 1) < heap->count; i = child) {
+        if (child + 1 < heap->count &&
+            heap->compare(heap->items[child + 1], heap->items[child]) < 0)
+            child++;
+        if (heap->compare(heap->items[child], last) >= 0)
+            break;
+        heap->items[i] = heap->items[child];
+    }
+    if (heap->count > 0)
+        heap->items[i] = last;
+
+    return top;
+}
+
+static int
+nstime_compare(const struct wtap_nstime *time1, const struct wtap_nstime *time2)
+{
+    if (time1->secs != time2->secs)
+        return time1->secs > time2->secs ? 1 : -1;
+    if (time1->nsecs != time2->nsecs)
+        return time1->nsecs > time2->nsecs ? 1 : -1;
+    return 0;
+}
+
+static double
+nstime_seconds(const struct wtap_nstime *later, const struct wtap_nstime *earlier)
+{
+    return (double)(later->secs - earlier->secs) +
+           ((double)later->nsecs - (double)earlier->nsecs) / 1000000000.0;
+}
+
+/* Same order as frames_compare() */
+static int
+held_frames_compare(gconstpointer a, gconstpointer b)
+{
+    const HeldFrame_t *frame1 = (const HeldFrame_t *)a;
+    const HeldFrame_t *frame2 = (const HeldFrame_t *)b;
+    int ret;
+
+    if (frame1->run != frame2->run)
+        return frame1->run > frame2->run ? 1 : -1;
+    if ((ret = nstime_compare(&frame1->phdr.ts, &frame2->phdr.ts)) != 0)
+        return ret;
+    if (frame1->num != frame2->num)
+        return frame1->num > frame2->num ? 1 : -1;
+    return 0;
+}
+
+/* Orders runs being merged by the frame each has read last */
+static int
+spill_runs_compare(gconstpointer a, gconstpointer b)
+{
+    const SpillRun_t *run1 = (const SpillRun_t *)a;
+    const SpillRun_t *run2 = (const SpillRun_t *)b;
+    int ret;
+
+    if ((ret = nstime_compare(&wtap_phdr(run1->wth)->ts,
+                              &wtap_phdr(run2->wth)->ts)) != 0)
+        return ret;
+    if (run1->num != run2->num)
+        return run1->num > run2->num ? 1 : -1;
+    return 0;
+}
+
+static void
+held_frame_free(HeldFrame_t *frame)
+{
+    g_free(frame->phdr.opt_comment);
+    g_free(frame->data);
+    g_slice_free(HeldFrame_t, frame);
+}
+
+/* Writes a frame, and records how far forward it moved */
+static void
+frame_write_data(Reorder_t *r, wtap_dumper *pdh, const struct wtap_pkthdr *phdr,
+                 const guint8 *data, guint num, FILE *num_fh)
+{
+    int     err;
+    guint32 num32 = num;
+
+    if (!wtap_dump(pdh, phdr, data, &err)) {
+        fprintf(stderr, "reordercap: Error (%s) writing frame to outfile\n",
+                wtap_strerror(err));
+        exit(1);
+    }
+
+    if (num_fh != NULL) {
+        /* To a spill file */
+        if (fwrite(&num32, sizeof num32, 1, num_fh) != 1) {
+            fprintf(stderr, "reordercap: Error writing to a spill file: %s\n",
+                    g_strerror(errno));
+            exit(1);
+        }
+        return;
+    }
+
+    if (num - 1 > r->written && num - 1 - r->written > r->max_displacement)
+        r->max_displacement = num - 1 - r->written;
+    r->written++;
+}
+
+static SpillRun_t *
+spill_run_new(Reorder_t *r)
+{
+    SpillRun_t *run;
+    int err;
+
+    run = g_new0(SpillRun_t, 1);
+    run->path = g_strdup_printf("%s.spill%u", r->outfile, r->spill_count++);
+    run->num_path = g_strdup_printf("%s.num", run->path);
+
+    run->pdh = wtap_dump_open_ng(run->path, r->file_type, r->encap, 65535,
+                                 FALSE, r->shb_hdr, r->idb_inf, &err);
+    if (run->pdh == NULL) {
+        fprintf(stderr, "reordercap: Failed to open spill file: (%s) - error %s\n",
+                run->path, wtap_strerror(err));
+        exit(1);
+    }
+    run->num_fh = ws_fopen(run->num_path, "wb");
+    if (run->num_fh == NULL) {
+        fprintf(stderr, "reordercap: Failed to open spill file: (%s) - error %s\n",
+                run->num_path, g_strerror(errno));
+        exit(1);
+    }
+
+    g_ptr_array_add(r->runs, run);
+    return run;
+}
+
+static void
+spill_run_close(SpillRun_t *run)
+{
+    int err;
+
+    if (run->pdh != NULL) {
+        if (!wtap_dump_close(run->pdh, &err)) {
+            fprintf(stderr, "reordercap: Error closing %s: %s\n", run->path,
+                    wtap_strerror(err));
+            exit(1);
+        }
+        run->pdh = NULL;
+    }
+    if (run->wth != NULL) {
+        wtap_close(run->wth);
+        run->wth = NULL;
+    }
+    if (run->num_fh != NULL) {
+        if (fclose(run->num_fh) != 0) {
+            fprintf(stderr, "reordercap: Error closing %s: %s\n", run->num_path,
+                    g_strerror(errno));
+            exit(1);
+        }
+        run->num_fh = NULL;
+    }
+}
+
+static void
+spill_run_delete(SpillRun_t *run)
+{
+    spill_run_close(run);
+    ws_unlink(run->path);
+    ws_unlink(run->num_path);
+    g_free(run->path);
+    g_free(run->num_path);
+    g_free(run);
+}
+
+/* Reads the next frame of a run being merged */
+static gboolean
+spill_run_read(SpillRun_t *run)
+{
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+
+    if (!wtap_read(run->wth, &err, &err_info, &data_offset)) {
+        if (err != 0) {
+            report_read_error(run->path, err, err_info);
+            exit(1);
+        }
+        return FALSE;
+    }
+    if (fread(&run->num, sizeof run->num, 1, run->num_fh) != 1) {
+        fprintf(stderr, "reordercap: Spill file %s is short\n", run->num_path);
+        exit(1);
+    }
+    return TRUE;
+}
+
+/* Merges runs into pdh.  If num_fh isn't NULL, pdh is another spill file. */
+static void
+merge_runs(Reorder_t *r, SpillRun_t **runs, guint count, wtap_dumper *pdh,
+           FILE *num_fh)
+{
+    Heap_t heap;
+    SpillRun_t *run;
+    int err;
+    gchar *err_info;
+    guint i;
+
+    heap_init(&heap, spill_runs_compare);
+
+    for (i = 0; i < count; i++) {
+        run = runs[i];
+        spill_run_close(run);
+        run->wth = wtap_open_offline(run->path, &err, &err_info, FALSE);
+        if (run->wth == NULL) {
+            fprintf(stderr, "reordercap: Can't open %s: %s\n", run->path,
+                    wtap_strerror(err));
+            exit(1);
+        }
+        run->num_fh = ws_fopen(run->num_path, "rb");
+        if (run->num_fh == NULL) {
+            fprintf(stderr, "reordercap: Can't open %s: %s\n", run->num_path,
+                    g_strerror(errno));
+            exit(1);
+        }
+        if (spill_run_read(run))
+            heap_push(&heap, run);
+    }
+
+    while (heap.count > 0) {
+        run = (SpillRun_t *)heap_pop(&heap);
+        frame_write_data(r, pdh, wtap_phdr(run->wth), wtap_buf_ptr(run->wth),
+                         run->num, num_fh);
+        if (spill_run_read(run))
+            heap_push(&heap, run);
+    }
+
+    g_free(heap.items);
+}
+
+/* Is the window full, i.e. should the earliest frame be written? */
+static gboolean
+window_full(Reorder_t *r, const struct wtap_nstime *newest)
+{
+    const HeldFrame_t *earliest;
+
+    if (r->held.count == 0)
+        return FALSE;
+    if (r->window_frames > 0 && r->held.count > r->window_frames)
+        return TRUE;
+    if (r->window_secs > 0) {
+        earliest = (const HeldFrame_t *)r->held.items[0];
+        return nstime_seconds(newest, &earliest->phdr.ts) > r->window_secs;
+    }
+    return FALSE;
+}
+
+/*
+ * Reads the input file through the window.  Without spill, the frames
+ * are written to pdh, and FALSE is returned as soon as a frame is too late
+ * to be written in order.  With spill, they are written to sorted runs in
+ * spill files.
+ */
+static gboolean
+reorder_window(Reorder_t *r, wtap_dumper *pdh, gboolean spill)
+{
+    const struct wtap_pkthdr *phdr;
+    HeldFrame_t *frame, last;
+    SpillRun_t *run = NULL;
+    struct wtap_nstime newest, prev_ts;
+    gboolean have_last = FALSE;
+    guint cur_run = 0;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+
+    heap_init(&r->held, held_frames_compare);
+    r->frames = 0;
+    r->wrong_order_count = 0;
+    r->max_lateness = 0;
+    newest.secs = 0;
+    newest.nsecs = 0;
+    prev_ts = newest;
+
+    for (;;) {
+        if (wtap_read(r->wth, &err, &err_info, &data_offset)) {
+            phdr = wtap_phdr(r->wth);
+
+            frame = g_slice_new(HeldFrame_t);
+            frame->num = ++r->frames;
+            frame->phdr = *phdr;
+            frame->phdr.opt_comment = g_strdup(phdr->opt_comment);
+            frame->data = (guint8 *)g_memdup(wtap_buf_ptr(r->wth), phdr->caplen);
+            frame->run = cur_run;
+
+            if (r->frames > 1 && nstime_compare(&phdr->ts, &prev_ts) < 0)
+                r->wrong_order_count++;
+            prev_ts = phdr->ts;
+
+            /* How much older than the newest frame so far is it? */
+            if (r->frames > 1 && nstime_compare(&phdr->ts, &newest) < 0) {
+                if (nstime_seconds(&newest, &phdr->ts) > r->max_lateness)
+                    r->max_lateness = nstime_seconds(&newest, &phdr->ts);
+            } else {
+                newest = phdr->ts;
+            }
+
+            if (have_last && held_frames_compare(frame, &last) < 0) {
+                if (!spill) {
+                    /* It should have been written already */
+                    held_frame_free(frame);
+                    while (r->held.count > 0)
+                        held_frame_free((HeldFrame_t *)heap_pop(&r->held));
+                    g_free(r->held.items);
+                    return FALSE;
+                }
+                frame->run = cur_run + 1;
+            }
+            heap_push(&r->held, frame);
+
+            if (!window_full(r, &newest))
+                continue;
+        } else {
+            if (err != 0) {
+                report_read_error(r->infile, err, err_info);
+                exit(1);
+            }
+            if (r->held.count == 0)
+                break;
+        }
+
+        /* Write out the earliest frame */
+        frame = (HeldFrame_t *)heap_pop(&r->held);
+        if (spill && (run == NULL || frame->run != cur_run)) {
+            if (run != NULL)
+                spill_run_close(run);
+            run = spill_run_new(r);
+            cur_run = frame->run;
+        }
+        frame_write_data(r, spill ? run->pdh : pdh, &frame->phdr, frame->data,
+                         frame->num, spill ? run->num_fh : NULL);
+        last.run = frame->run;
+        last.num = frame->num;
+        last.phdr.ts = frame->phdr.ts;
+        have_last = TRUE;
+        held_frame_free(frame);
+    }
+
+    if (run != NULL)
+        spill_run_close(run);
+    g_free(r->held.items);
+    return TRUE;
+}
+
+/* Merges the spill files into pdh, a bounded number of them at a time */
+static void
+reorder_merge(Reorder_t *r, wtap_dumper *pdh)
+{
+    SpillRun_t *run;
+    guint i;
+
+    while (r->runs->len > MAX_MERGE_RUNS) {
+        run = spill_run_new(r);
+        merge_runs(r, (SpillRun_t **)r->runs->pdata, MAX_MERGE_RUNS, run->pdh,
+                   run->num_fh);
+        spill_run_close(run);
+        for (i = 0; i < MAX_MERGE_RUNS; i++)
+            spill_run_delete((SpillRun_t *)r->runs->pdata[i]);
+        g_ptr_array_remove_range(r->runs, 0, MAX_MERGE_RUNS);
+    }
+
+    merge_runs(r, (SpillRun_t **)r->runs->pdata, r->runs->len, pdh, NULL);
+    for (i = 0; i < r->runs->len; i++)
+        spill_run_delete((SpillRun_t *)r->runs->pdata[i]);
+    g_ptr_array_set_size(r->runs, 0);
+}
+
+/* Closes the output file and creates it again, empty */
+static wtap_dumper *
+outfile_reopen(Reorder_t *r, wtap_dumper *pdh)
+{
+    int err;
+
+    if (!wtap_dump_close(pdh, &err)) {
+        fprintf(stderr, "reordercap: Error closing %s: %s\n", r->outfile,
+                wtap_strerror(err));
+        exit(1);
+    }
+    pdh = wtap_dump_open_ng(r->outfile, r->file_type, r->encap, 65535,
+                            FALSE, r->shb_hdr, r->idb_inf, &err);
+    if (pdh == NULL) {
+        fprintf(stderr, "reordercap: Failed to open output file: (%s) - error %s\n",
+                r->outfile, wtap_strerror(err));
+        exit(1);
+    }
+    return pdh;
+}
+
+/* Reorders in the window, or falls back to the external sort; returns the
+ * (possibly reopened) output file */
+static wtap_dumper *
+reorder_windowed(Reorder_t *r, wtap_dumper *pdh, gboolean write_output_regardless)
+{
+    int err;
+    gchar *err_info;
+
+    r->runs = g_ptr_array_new();
+
+    if (!reorder_window(r, pdh, FALSE)) {
+        printf("Frame %u is outside the reordering window, sorting through spill files\n",
+               r->frames);
+
+        /* Start again from the beginning of both files */
+        pdh = outfile_reopen(r, pdh);
+        wtap_close(r->wth);
+        r->wth = wtap_open_offline(r->infile, &err, &err_info, TRUE);
+        if (r->wth == NULL) {
+            fprintf(stderr, "reordercap: Can't open %s: %s\n", r->infile,
+                    wtap_strerror(err));
+            exit(1);
+        }
+        r->written = 0;
+        r->max_displacement = 0;
+
+        reorder_window(r, NULL, TRUE);
+        reorder_merge(r, pdh);
+    }
+
+    printf("%u frames, %u out of order\n", r->frames, r->wrong_order_count);
+    printf("Largest displacement: %u frames, %.9f seconds\n",
+           r->max_displacement, r->max_lateness);
+    if (r->spill_count > 0)
+        printf("%u spill files\n", r->spill_count);
+
+    /* It's only known at the end whether the input was in order */
+    if (!write_output_regardless && (r->wrong_order_count == 0)) {
+        pdh = outfile_reopen(r, pdh);
+        printf("Not writing output file because input file is already in order!\n");
+    }
+
+    g_ptr_array_free(r->runs, TRUE);
+    return pdh;
+}
+
+
 /********************************************************************/
 /* Main function.                                                   */
 /********************************************************************/
@@ -180,6 +750,10 @@ int main(int argc, char *argv[])
 
     GPtrArray *frames;
     FrameRecord_t *prevFrame = NULL;
+    Reorder_t reorder;
+    guint window_frames = 0;
+    double window_secs = 0;
+    char *p;
 
     int opt;
     int file_count;
@@ -187,11 +761,27 @@ int main(int argc, char *argv[])
     char *outfile;
 
     /* Process the options first */
-    while ((opt = getopt(argc, argv, "n")) != -1) {
+    while ((opt = getopt(argc, argv, "nw:W:")) != -1) {
         switch (opt) {
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'w':
+                window_frames = (guint)strtoul(optarg, &p, 10);
+                if (p == optarg || *p != '\0' || window_frames == 0) {
+                    fprintf(stderr, "reordercap: \"%s\" isn't a valid window size\n",
+                            optarg);
+                    exit(1);
+                }
+                break;
+            case 'W':
+                window_secs = strtod(optarg, &p);
+                if (p == optarg || *p != '\0' || window_secs <= 0) {
+                    fprintf(stderr, "reordercap: \"%s\" isn't a valid window time\n",
+                            optarg);
+                    exit(1);
+                }
+                break;
             case '?':
                 usage();
                 exit(1);
@@ -233,14 +823,31 @@ int main(int argc, char *argv[])
     /* Open outfile (same filetype/encap as input file) */
     pdh = wtap_dump_open_ng(outfile, wtap_file_type(wth), wtap_file_encap(wth),
                             65535, FALSE, shb_hdr, idb_inf, &err);
-    g_free(idb_inf);
     if (pdh == NULL) {
         fprintf(stderr, "reordercap: Failed to open output file: (%s) - error %s\n",
                 outfile, wtap_strerror(err));
+        g_free(idb_inf);
         g_free(shb_hdr);
         exit(1);
     }
 
+    if (window_frames > 0 || window_secs > 0) {
+        memset(&reorder, 0, sizeof reorder);
+        reorder.infile = infile;
+        reorder.outfile = outfile;
+        reorder.wth = wth;
+        reorder.file_type = wtap_file_type(wth);
+        reorder.encap = wtap_file_encap(wth);
+        reorder.shb_hdr = shb_hdr;
+        reorder.idb_inf = idb_inf;
+        reorder.window_frames = window_frames;
+        reorder.window_secs = window_secs;
+
+        pdh = reorder_windowed(&reorder, pdh, write_output_regardless);
+        wth = reorder.wth;
+        goto done;
+    }
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -304,6 +911,9 @@ int main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+done:
+    g_free(idb_inf);
+
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err)) {
         fprintf(stderr, "reordercap: Error closing %s: %s\n", outfile,
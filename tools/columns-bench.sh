@@ -0,0 +1,96 @@
+#!/bin/bash
+#
+# $Id$
+
+# TShark "-T columns" benchmark script
+#
+# This script uses Randpkt to generate a capture, and times TShark
+# exporting a few fields and then more fields from it with "-T fields"
+# and with "-T columns".  Before timing, it checks that the "-T columns"
+# output, read back with wscols.py, is the same as the "-T fields"
+# output, and fails if it isn't.
+
+TEST_TYPE="columns-bench"
+. `dirname $0`/test-common.sh
+
+# The debugging allocators set up by test-common.sh would swamp what
+# we're trying to measure.
+unset G_SLICE MALLOC_CHECK_ WIRESHARK_DEBUG_WMEM_OVERRIDE
+
+WSCOLS="`dirname $0`/wscols.py"
+PYTHON=python
+PACKETS=1000000
+
+# Fields whose "-T fields" text wscols.py reproduces exactly.
+FEW_FIELDS="frame.number frame.len ip.src ip.dst"
+MANY_FIELDS="frame.number frame.len frame.cap_len frame.time_relative
+    frame.protocols eth.src eth.dst ip.src ip.dst ip.ttl ip.len ip.id
+    udp.srcport udp.dstport udp.length"
+
+while getopts ":d:p:" OPTCHAR ; do
+    case $OPTCHAR in
+        d) TMP_DIR=$OPTARG ;;
+        p) PACKETS=$OPTARG ;;
+    esac
+done
+shift $(($OPTIND - 1))
+
+NOTFOUND=0
+for i in "$TSHARK" "$RANDPKT" "$DATE" "$TMP_DIR" ; do
+    if [ ! -x $i ]; then
+        echo "Couldn't find $i"
+        NOTFOUND=1
+    fi
+done
+if [ $NOTFOUND -eq 1 ]; then
+    exit 1
+fi
+
+BENCH_DIR=$TMP_DIR/$BASE_NAME
+mkdir -p $BENCH_DIR || exit 1
+trap "rm -rf $BENCH_DIR" EXIT
+
+"$RANDPKT" -b 200 -c $PACKETS -t udp $BENCH_DIR/in.pcap \
+    > /dev/null 2>&1 || exit 1
+
+# Print the elapsed wall clock time of a command, in seconds.
+elapsed() {
+    local START END
+    START=`$DATE +%s.%N`
+    "$@" > /dev/null 2>&1 || return 1
+    END=`$DATE +%s.%N`
+    echo "$END - $START" | bc
+}
+
+# "-e field" for every field in $1
+field_args() {
+    local F ARGS=""
+    for F in $1 ; do
+        ARGS="$ARGS -e $F"
+    done
+    echo $ARGS
+}
+
+# Round trip: "-T columns" read back must match "-T fields".
+FIELD_ARGS=`field_args "$MANY_FIELDS"`
+"$TSHARK" -n -r $BENCH_DIR/in.pcap -c 100000 -T fields $FIELD_ARGS \
+    > $BENCH_DIR/fields.txt 2> /dev/null || exit 1
+"$TSHARK" -n -r $BENCH_DIR/in.pcap -c 100000 -T columns $FIELD_ARGS \
+    > $BENCH_DIR/columns.bin 2> /dev/null || exit 1
+"$PYTHON" "$WSCOLS" $BENCH_DIR/columns.bin > $BENCH_DIR/columns.txt || exit 1
+if ! cmp -s $BENCH_DIR/fields.txt $BENCH_DIR/columns.txt ; then
+    echo "The -T columns output doesn't match the -T fields output:"
+    diff $BENCH_DIR/fields.txt $BENCH_DIR/columns.txt | head -20
+    exit 1
+fi
+
+printf "%8s %10s %16s %16s\n" "fields" "packets" "-T fields (s)" "-T columns (s)"
+
+for FIELDS in "$FEW_FIELDS" "$MANY_FIELDS" ; do
+    FIELD_ARGS=`field_args "$FIELDS"`
+    COUNT=`echo $FIELDS | wc -w`
+    AS_TEXT=`elapsed "$TSHARK" -n -r $BENCH_DIR/in.pcap -T fields $FIELD_ARGS`
+    AS_COLUMNS=`elapsed "$TSHARK" -n -r $BENCH_DIR/in.pcap -T columns $FIELD_ARGS`
+    printf "%8d %10d %16s %16s\n" $COUNT $PACKETS \
+        "${AS_TEXT:-failed}" "${AS_COLUMNS:-failed}"
+done
@@ -0,0 +1,106 @@
+#!/bin/bash
+#
+# $Id$
+
+# Display filter optimizer benchmark script
+#
+# This script compiles a set of generated display filters with Dftest,
+# once with the optimizer enabled and once with it disabled through
+# WIRESHARK_DEBUG_DFILTER_NO_OPTIMIZE, and reports the number of
+# instructions, tree reads and comparisons in each program.  Since a
+# filter program never jumps backwards, the instruction count is an upper
+# bound on the number of instructions executed per packet.
+#
+# If a capture file is given with -r, TShark is also run over it with each
+# of the filters, and the elapsed time of each run is reported.
+
+TEST_TYPE="dfilter-optimize-bench"
+. `dirname $0`/test-common.sh
+
+# The debugging allocators set up by test-common.sh would swamp what
+# we're trying to measure.
+unset G_SLICE MALLOC_CHECK_ WIRESHARK_DEBUG_WMEM_OVERRIDE
+
+DFTEST="$BIN_DIR/dftest"
+TIME=/usr/bin/time
+TERM_COUNTS="10 100 500"
+CAPTURE=
+
+while getopts ":n:r:" OPTCHAR ; do
+    case $OPTCHAR in
+        n) TERM_COUNTS=$OPTARG ;;
+        r) CAPTURE=$OPTARG ;;
+    esac
+done
+shift $(($OPTIND - 1))
+
+NOTFOUND=0
+for i in "$DFTEST" "$TSHARK" "$TIME" ; do
+    if [ ! -x $i ]; then
+        echo "Couldn't find $i"
+        NOTFOUND=1
+    fi
+done
+if [ $NOTFOUND -eq 1 ]; then
+    exit 1
+fi
+
+# "or 10.0.0.1 or 10.0.0.2 ..." over one field, the worst case for the
+# unoptimized program.
+or_filter() {
+    local i FILTER="ip.addr == 10.0.0.0"
+    for (( i = 1; i < $1; i++ )) ; do
+        FILTER="$FILTER or ip.addr == 10.$(( i / 65536 % 256 )).$(( i / 256 % 256 )).$(( i % 256 ))"
+    done
+    echo "$FILTER"
+}
+
+# OR chains over ports and addresses, with an existence test at the end that
+# the optimizer moves to the front.
+and_filter() {
+    local i FILTER="(udp.port == 0"
+    for (( i = 1; i < $1; i++ )) ; do
+        FILTER="$FILTER or udp.port == $i"
+    done
+    echo "$FILTER) and ($(or_filter $1)) and tcp"
+}
+
+# "instructions reads comparisons"
+program_stats() {
+    "$DFTEST" "$1" 2>/dev/null | awk '
+        /^Instructions:/ { insns = 1; next }
+        insns && /^[0-9]+ / { n++ }
+        insns && / READ_TREE/ { reads++ }
+        insns && / ANY_/ { cmps++ }
+        END { printf "%d %d %d\n", n, reads, cmps }'
+}
+
+run_time() {
+    if [ -z "$CAPTURE" ] ; then
+        echo "-"
+        return
+    fi
+    $TIME -f "%e" "$TSHARK" -n -q -r "$CAPTURE" -Y "$1" 2>&1 >/dev/null | tail -1
+}
+
+printf "%-4s %6s | %8s %6s %6s %9s | %8s %6s %6s %9s\n" \
+    "" "" "unoptimized" "" "" "" "optimized" "" "" ""
+printf "%-4s %6s | %8s %6s %6s %9s | %8s %6s %6s %9s\n" \
+    "kind" "terms" "insns" "reads" "cmps" "time (s)" "insns" "reads" "cmps" "time (s)"
+
+for COUNT in $TERM_COUNTS ; do
+    for KIND in or and ; do
+        FILTER=`${KIND}_filter $COUNT`
+
+        export WIRESHARK_DEBUG_DFILTER_NO_OPTIMIZE=1
+        UNOPT=`program_stats "$FILTER"`
+        UNOPT_TIME=`run_time "$FILTER"`
+        unset WIRESHARK_DEBUG_DFILTER_NO_OPTIMIZE
+        OPT=`program_stats "$FILTER"`
+        OPT_TIME=`run_time "$FILTER"`
+
+        set -- $UNOPT $OPT
+        printf "%-4s %6d | %8d %6d %6d %9s | %8d %6d %6d %9s\n" \
+            $KIND $COUNT $1 $2 $3 "$UNOPT_TIME" $4 $5 $6 "$OPT_TIME"
+    done
+done
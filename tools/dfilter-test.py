@@ -227,6 +227,40 @@ class Test:
 			print "\nGot:", output
 			return FAILED
 
+	def DFilterCountAll(self, packet, dfilters, nums_expected):
+		"""Run several dfilters on a packet file at once, as
+		the columns of "-z io,csv", and expect each of them to
+		match a certain number of packets. An empty dfilter
+		matches every packet."""
+
+		packet_file = packet.Filename()
+
+		cmd = (TSHARK, "-n -q -r", packet_file,
+			"-z 'io,csv,0," + ",".join(dfilters) + "'")
+
+		try:
+			(output, retval) = run_cmd(cmd)
+		except RunCommandError:
+			print "\nGot:", output
+			return FAILED
+
+		if retval or len(output) != 2:
+			print "\nGot:", output
+			return FAILED
+
+		# One interval: its start and end, then the frames
+		# and bytes of each column
+		row = output[1].strip().split(",")
+		nums = [int(n) for n in row[2::2]]
+
+		if nums == nums_expected:
+			if VERBOSE:
+				print "\nGot:", output
+			return OK
+		else:
+			print "\nGot:", output
+			return FAILED
+
 
 ################################################################################
 # Add packets here
@@ -1337,6 +1371,119 @@ class Range(Test):
 		ck_slice_2_neg,
 		]
 
+class Membership(Test):
+	"""Tests the "in" operator"""
+
+	def ck_in_1(self):
+		return self.DFilterCount(pkt_ntp,
+			"ip.version in {4 6}", 1)
+
+	def ck_in_2(self):
+		return self.DFilterCount(pkt_ntp,
+			"ip.version in {5 6}", 0)
+
+	def ck_in_range_1(self):
+		return self.DFilterCount(pkt_ntp,
+			"ip.version in {1 3-5}", 1)
+
+	def ck_in_range_2(self):
+		return self.DFilterCount(pkt_ntp,
+			"ip.version in {1 5-7}", 0)
+
+	def ck_in_range_empty(self):
+		return self.DFilterCount(pkt_ntp,
+			"ip.version in {7-5}", None)
+
+	def ck_in_ipv4_1(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src in {10.0.0.1 172.25.100.14}", 1)
+
+	def ck_in_ipv4_2(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src in {10.0.0.1 198.95.230.20 172.25.100.14}", 2)
+
+	def ck_in_cidr_1(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src in {10.0.0.0/8 172.25.0.0/16}", 1)
+
+	def ck_in_cidr_2(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src in {10.0.0.0/8 172.16.0.0/16}", 0)
+
+	def ck_in_ipv4_range(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src in {172.25.100.1-172.25.100.20}", 1)
+
+	def ck_in_string_1(self):
+		return self.DFilterCount(pkt_http,
+			'http.request.method in {"GET" "HEAD"}', 1)
+
+	def ck_in_string_2(self):
+		return self.DFilterCount(pkt_http,
+			'http.request.method in {"GET" "POST"}', 0)
+
+	def ck_in_or_1(self):
+		return self.DFilterCount(pkt_nfs,
+			"ip.src == 10.0.0.1 or ip.src == 172.25.100.14 or ip.src in {10.0.0.2}", 1)
+
+	def ck_in_not_field(self):
+		return self.DFilterCount(pkt_ntp,
+			'"ip" in {4}', None)
+
+	tests = [
+		ck_in_1,
+		ck_in_2,
+		ck_in_range_1,
+		ck_in_range_2,
+		ck_in_range_empty,
+		ck_in_ipv4_1,
+		ck_in_ipv4_2,
+		ck_in_cidr_1,
+		ck_in_cidr_2,
+		ck_in_ipv4_range,
+		ck_in_string_1,
+		ck_in_string_2,
+		ck_in_or_1,
+		ck_in_not_field,
+		]
+
+
+class Combined(Test):
+	"""Tests dfilters run together as one program"""
+
+	def ck_shared_field_1(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["ip.src == 172.25.100.14", "ip.src == 198.95.230.20"], [1, 1])
+
+	def ck_shared_field_2(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["ip.src == 172.25.100.14", "ip.src == 172.25.100.14"], [1, 1])
+
+	def ck_match_then_no_match(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["ip.src == 172.25.100.14", "ip.src == 10.0.0.1"], [1, 0])
+
+	def ck_no_match_then_match(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["ip.src == 10.0.0.1", "ip.src in {172.25.100.14 198.95.230.20}"], [0, 2])
+
+	def ck_match_then_not(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["ip.src", "not ip.src == 172.25.100.14", "ip.src"], [2, 1, 2])
+
+	def ck_unfiltered(self):
+		return self.DFilterCountAll(pkt_nfs,
+			["", "ip.src == 198.95.230.20"], [2, 1])
+
+	tests = [
+		ck_shared_field_1,
+		ck_shared_field_2,
+		ck_match_then_no_match,
+		ck_no_match_then_match,
+		ck_match_then_not,
+		ck_unfiltered,
+		]
+
 
 ################################################################################
 
@@ -1345,9 +1492,11 @@ class Range(Test):
 # shows them in order.
 all_tests = [
 	Bytes(),
+	Combined(),
 	Double(),
 	Integer(),
 	IPv4(),
+	Membership(),
         Range(),
 	Scanner(),
 	String(),
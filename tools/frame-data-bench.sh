@@ -0,0 +1,73 @@
+#!/bin/bash
+#
+# $Id$
+
+# Frame data benchmark script
+#
+# This script uses Randpkt to generate captures of increasing size and
+# runs a two-pass TShark over each of them, which keeps a frame_data
+# structure for every frame.  For each capture it reports the elapsed
+# time, the peak resident set size, and the number of bytes per frame
+# that the peak resident set size grew by compared with the smallest
+# capture.
+
+TEST_TYPE="frame-data-bench"
+. `dirname $0`/test-common.sh
+
+# The debugging allocators set up by test-common.sh would swamp what
+# we're trying to measure.
+unset G_SLICE MALLOC_CHECK_ WIRESHARK_DEBUG_WMEM_OVERRIDE
+
+TIME=/usr/bin/time
+FRAME_COUNTS="10000 1000000 5000000"
+
+while getopts ":d:n:" OPTCHAR ; do
+    case $OPTCHAR in
+        d) TMP_DIR=$OPTARG ;;
+        n) FRAME_COUNTS=$OPTARG ;;
+    esac
+done
+shift $(($OPTIND - 1))
+
+NOTFOUND=0
+for i in "$TSHARK" "$RANDPKT" "$TIME" "$TMP_DIR" ; do
+    if [ ! -x $i ]; then
+        echo "Couldn't find $i"
+        NOTFOUND=1
+    fi
+done
+if [ $NOTFOUND -eq 1 ]; then
+    exit 1
+fi
+
+BENCH_DIR=$TMP_DIR/$BASE_NAME
+mkdir -p $BENCH_DIR || exit 1
+trap "rm -rf $BENCH_DIR" EXIT
+
+printf "%10s %12s %14s %12s\n" "frames" "elapsed (s)" "peak RSS (kB)" "bytes/frame"
+
+BASE_FRAMES=
+BASE_RSS=
+for COUNT in $FRAME_COUNTS ; do
+    # Small frames, so that the per-frame overhead dominates.
+    "$RANDPKT" -b 60 -c $COUNT -t udp $BENCH_DIR/in.pcap \
+        > /dev/null 2>&1 || exit 1
+
+    # "elapsed peak_rss_kB"
+    RESULT=`$TIME -f "%e %M" "$TSHARK" -2 -q -r $BENCH_DIR/in.pcap \
+        2>&1 >/dev/null | tail -1`
+    set -- $RESULT
+    ELAPSED=$1
+    RSS=$2
+
+    if [ -z "$BASE_RSS" ] ; then
+        BASE_FRAMES=$COUNT
+        BASE_RSS=$RSS
+        PER_FRAME="-"
+    else
+        PER_FRAME=$(( ($RSS - $BASE_RSS) * 1024 / ($COUNT - $BASE_FRAMES) ))
+    fi
+    printf "%10d %12s %14s %12s\n" $COUNT "$ELAPSED" "$RSS" "$PER_FRAME"
+
+    rm -f $BENCH_DIR/in.pcap
+done
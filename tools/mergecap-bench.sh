@@ -0,0 +1,73 @@
+#!/bin/bash
+#
+# $Id$
+
+# Mergecap benchmark script
+#
+# This script uses Randpkt to generate sets of 2, 32 and 512 capture
+# files whose time stamps all overlap, and times Mergecap merging each
+# set, both with all input files open and with at most 16 input files
+# open at once (-M).
+
+TEST_TYPE="mergecap-bench"
+. `dirname $0`/test-common.sh
+
+MERGECAP="$BIN_DIR/mergecap"
+
+INPUT_COUNTS="2 32 512"
+# Total number of packets merged for every input count, so the numbers
+# are comparable.
+TOTAL_PACKETS=1000000
+MAX_OPEN=16
+
+while getopts ":d:n:p:" OPTCHAR ; do
+    case $OPTCHAR in
+        d) TMP_DIR=$OPTARG ;;
+        n) INPUT_COUNTS=$OPTARG ;;
+        p) TOTAL_PACKETS=$OPTARG ;;
+    esac
+done
+shift $(($OPTIND - 1))
+
+NOTFOUND=0
+for i in "$MERGECAP" "$RANDPKT" "$DATE" "$TMP_DIR" ; do
+    if [ ! -x $i ]; then
+        echo "Couldn't find $i"
+        NOTFOUND=1
+    fi
+done
+if [ $NOTFOUND -eq 1 ]; then
+    exit 1
+fi
+
+BENCH_DIR=$TMP_DIR/$BASE_NAME
+mkdir -p $BENCH_DIR || exit 1
+trap "rm -rf $BENCH_DIR" EXIT
+
+# Print the elapsed wall clock time of a command, in seconds.
+elapsed() {
+    local START END
+    START=`$DATE +%s.%N`
+    "$@" > /dev/null 2>&1 || return 1
+    END=`$DATE +%s.%N`
+    echo "$END - $START" | bc
+}
+
+printf "%8s %12s %12s %12s\n" "inputs" "packets" "all open (s)" "-M $MAX_OPEN (s)"
+
+for COUNT in $INPUT_COUNTS ; do
+    PER_FILE=$(($TOTAL_PACKETS / $COUNT))
+    IN_FILES=""
+    for ((N = 0; N < $COUNT; N++)) ; do
+        "$RANDPKT" -b 100 -c $PER_FILE -t udp $BENCH_DIR/in-$N.pcap \
+            > /dev/null 2>&1 || exit 1
+        IN_FILES="$IN_FILES $BENCH_DIR/in-$N.pcap"
+    done
+
+    ALL_OPEN=`elapsed "$MERGECAP" -F pcap -w $BENCH_DIR/out.pcap $IN_FILES`
+    LIMITED=`elapsed "$MERGECAP" -F pcap -M $MAX_OPEN -w $BENCH_DIR/out.pcap $IN_FILES`
+    printf "%8d %12d %12s %12s\n" $COUNT $(($PER_FILE * $COUNT)) \
+        "${ALL_OPEN:-failed}" "${LIMITED:-failed}"
+
+    rm -f $BENCH_DIR/*.pcap
+done
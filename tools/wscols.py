@@ -0,0 +1,203 @@
+#!/usr/bin/env python
+#
+# Read the output of "tshark -T columns" and print it the way
+# "tshark -T fields" prints the same fields: one line per packet, the
+# fields separated by tabs and the occurrences of a field by commas.
+#
+# The format is described next to the writer, in print.c.
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+
+from optparse import OptionParser
+import struct
+import sys
+
+MAGIC = b"WSCOLS\0\0"
+BYTE_ORDER_MARK = 0x1a2b3c4d
+VERSION = 1
+
+# output_column_type_e in print.c
+COLUMN_PRESENT = 0
+COLUMN_UINT32 = 1
+COLUMN_INT32 = 2
+COLUMN_UINT64 = 3
+COLUMN_INT64 = 4
+COLUMN_DOUBLE = 5
+COLUMN_IPV4 = 6
+COLUMN_IPV6 = 7
+COLUMN_ETHER = 8
+COLUMN_TIME = 9
+COLUMN_BYTES = 10
+COLUMN_STRING = 11
+
+# struct format and width of the fixed-size types
+FIXED = {
+    COLUMN_UINT32: ("I", 4),
+    COLUMN_INT32: ("i", 4),
+    COLUMN_UINT64: ("Q", 8),
+    COLUMN_INT64: ("q", 8),
+    COLUMN_DOUBLE: ("d", 8),
+    COLUMN_IPV4: (None, 4),
+    COLUMN_IPV6: (None, 16),
+    COLUMN_ETHER: (None, 6),
+    COLUMN_TIME: ("q", 8),
+}
+
+class FormatError(Exception):
+    pass
+
+class Reader(object):
+    """Reads a "-T columns" stream: header() gives the columns, blocks()
+    the blocks, each a list with the values of every row of every
+    column."""
+
+    def __init__(self, f):
+        self.f = f
+        self.order = "<"
+        self.columns = None
+
+    def read(self, n):
+        data = self.f.read(n)
+        if len(data) != n:
+            raise FormatError("truncated file")
+        return data
+
+    def u32(self):
+        return struct.unpack(self.order + "I", self.read(4))[0]
+
+    def u32_array(self, count):
+        return list(struct.unpack(self.order + "%dI" % count, self.read(4 * count)))
+
+    def header(self):
+        if self.read(8) != MAGIC:
+            raise FormatError("not a \"-T columns\" file")
+        bom = self.read(4)
+        if struct.unpack("<I", bom)[0] == BYTE_ORDER_MARK:
+            self.order = "<"
+        elif struct.unpack(">I", bom)[0] == BYTE_ORDER_MARK:
+            self.order = ">"
+        else:
+            raise FormatError("bad byte order mark")
+        version = self.u32()
+        if version != VERSION:
+            raise FormatError("unsupported version %u" % version)
+        self.columns = []
+        for i in range(self.u32()):
+            col_type = self.u32()
+            name = self.read(self.u32()).decode("utf-8", "replace")
+            self.columns.append((name, col_type))
+        return self.columns
+
+    def values(self, col_type, count, data, ends):
+        if col_type == COLUMN_PRESENT:
+            return [None] * count
+        if col_type in (COLUMN_BYTES, COLUMN_STRING):
+            start = 0
+            values = []
+            for end in ends:
+                values.append(data[start:end])
+                start = end
+            return values
+        fmt, width = FIXED[col_type]
+        if len(data) != count * width:
+            raise FormatError("column data has the wrong length")
+        if fmt is None:
+            return [data[i * width:(i + 1) * width] for i in range(count)]
+        return list(struct.unpack(self.order + "%d%s" % (count, fmt), data))
+
+    def blocks(self):
+        if self.columns is None:
+            self.header()
+        while True:
+            rows = self.u32()
+            if rows == 0:
+                return
+            block = []
+            for name, col_type in self.columns:
+                num_values = self.u32()
+                starts = self.u32_array(rows + 1)
+                if starts[-1] != num_values:
+                    raise FormatError("column %s: bad value indices" % name)
+                ends = None
+                if col_type in (COLUMN_BYTES, COLUMN_STRING):
+                    ends = self.u32_array(num_values)
+                data = self.read(self.u32())
+                values = self.values(col_type, num_values, data, ends)
+                block.append([values[starts[r]:starts[r + 1]] for r in range(rows)])
+            yield block
+
+def format_value(col_type, value):
+    """Formats a value as "-T fields" does."""
+    if col_type == COLUMN_PRESENT:
+        return "1"
+    if col_type == COLUMN_DOUBLE:
+        return "%.9g" % value
+    if col_type == COLUMN_IPV4:
+        return ".".join([str(b) for b in bytearray(value)])
+    if col_type == COLUMN_IPV6:
+        words = struct.unpack(">8H", value)
+        return ":".join(["%x" % w for w in words])
+    if col_type in (COLUMN_ETHER, COLUMN_BYTES):
+        return ":".join(["%02x" % b for b in bytearray(value)])
+    if col_type == COLUMN_TIME:
+        secs, nsecs = divmod(abs(value), 1000000000)
+        return "%s%d.%09d" % ("-" if value < 0 else "", secs, nsecs)
+    if col_type == COLUMN_STRING:
+        return value.decode("utf-8", "replace")
+    return str(value)
+
+def main():
+    parser = OptionParser(usage="%prog [options] [file]")
+    parser.add_option("-H", "--header", action="store_true", default=False,
+                      help="print the field names and column types first")
+    parser.add_option("-s", "--separator", default="\t",
+                      help="separator between fields (default: tab)")
+    parser.add_option("-a", "--aggregator", default=",",
+                      help="separator between occurrences of a field (default: comma)")
+    (options, args) = parser.parse_args()
+
+    if len(args) > 1:
+        parser.error("at most one file can be given")
+    if args:
+        f = open(args[0], "rb")
+    elif hasattr(sys.stdin, "buffer"):
+        f = sys.stdin.buffer
+    else:
+        f = sys.stdin
+
+    reader = Reader(f)
+    try:
+        columns = reader.header()
+        if options.header:
+            print(options.separator.join(["%s(%d)" % c for c in columns]))
+        for block in reader.blocks():
+            for row in zip(*block):
+                print(options.separator.join(
+                    [options.aggregator.join([format_value(columns[i][1], v) for v in values])
+                     for i, values in enumerate(row)]))
+    except FormatError as e:
+        sys.stderr.write("wscols.py: %s\n" % e)
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -112,6 +112,7 @@ static frame_data prev_cap_frame;
 static const char* prev_display_dissector_name = NULL;
 
 static gboolean perform_two_pass_analysis;
+static int second_pass_readers = 0;     /* -j; 0 reads on the main thread */
 
 /*
  * The way the packet decode is to be written.
@@ -119,7 +120,8 @@ static gboolean perform_two_pass_analysis;
 typedef enum {
   WRITE_TEXT,   /* summary or detail text */
   WRITE_XML,    /* PDML or PSML */
-  WRITE_FIELDS  /* User defined list of fields */
+  WRITE_FIELDS, /* User defined list of fields */
+  WRITE_COLUMNS /* User defined list of fields, binary and columnar */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -137,6 +139,10 @@ static print_stream_t *print_stream;
 
 static output_fields_t* output_fields  = NULL;
 
+/* The fields the filters, custom columns and taps look at, compiled once
+   for all the packets */
+static proto_interest_t *tree_interest = NULL;
+
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
 
@@ -286,6 +292,8 @@ print_usage(gboolean print_ver)
   fprintf(output, "\n");
   fprintf(output, "Processing:\n");
   fprintf(output, "  -2                       perform a two-pass analysis\n");
+  fprintf(output, "  -j <threads>             with -2, read packets for the second pass\n");
+  fprintf(output, "                           in <threads> threads\n");
   fprintf(output, "  -R <read filter>         packet Read filter in Wireshark display filter syntax\n");
   fprintf(output, "  -Y <display filter>      packet displaY filter in Wireshark display filter syntax\n");
   fprintf(output, "  -n                       disable all name resolutions (def: all enabled)\n");
@@ -309,9 +317,10 @@ print_usage(gboolean print_ver)
   fprintf(output, "  -P                       print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|text|fields\n");
+  fprintf(output, "  -T pdml|ps|psml|text|fields|columns\n");
   fprintf(output, "                           format of text output (def: text)\n");
-  fprintf(output, "  -e <field>               field to print if -Tfields selected (e.g. tcp.port, col.Info);\n");
+  fprintf(output, "  -e <field>               field to print if -Tfields or -Tcolumns selected\n");
+  fprintf(output, "                           (e.g. tcp.port, col.Info);\n");
   fprintf(output, "                           this option can be repeated to print multiple fields\n");
   fprintf(output, "  -E<fieldsoption>=<value> set options for output when -Tfields selected:\n");
   fprintf(output, "     header=y|n            switch headers on and off\n");
@@ -888,6 +897,7 @@ main(int argc, char *argv[])
   gboolean             capture_option_specified = FALSE;
 #endif
   gboolean             quiet = FALSE;
+  gboolean             io_csv_requested = FALSE;
 #ifdef PCAP_NG_DEFAULT
   volatile int         out_file_type = WTAP_FILE_PCAPNG;
 #else
@@ -929,7 +939,7 @@ main(int argc, char *argv[])
 #define OPTSTRING_I ""
 #endif
 
-#define OPTSTRING "2a:" OPTSTRING_A "b:" OPTSTRING_B "c:C:d:De:E:f:F:gG:hH:i:" OPTSTRING_I "K:lLnN:o:O:pPqQr:R:s:S:t:T:u:vVw:W:xX:y:Y:z:"
+#define OPTSTRING "2a:" OPTSTRING_A "b:" OPTSTRING_B "c:C:d:De:E:f:F:gG:hH:i:" OPTSTRING_I "j:K:lLnN:o:O:pPqQr:R:s:S:t:T:u:vVw:W:xX:y:Y:z:"
 
   static const char    optstring[] = OPTSTRING;
 
@@ -1202,6 +1212,9 @@ main(int argc, char *argv[])
     case '2':        /* Perform two pass analysis */
       perform_two_pass_analysis = TRUE;
       break;
+    case 'j':        /* Second pass reader threads */
+      second_pass_readers = get_positive_int(optarg, "number of second pass reader threads");
+      break;
     case 'a':        /* autostop criteria */
     case 'b':        /* Ringbuffer option */
     case 'c':        /* Capture x packets */
@@ -1431,9 +1444,13 @@ main(int argc, char *argv[])
         output_action = WRITE_FIELDS;
         print_details = TRUE;   /* Need full tree info */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "columns") == 0) {
+        output_action = WRITE_COLUMNS;
+        print_details = FALSE;  /* The fields are looked up, the tree isn't walked */
+        print_summary = FALSE;  /* Don't allow summary */
       } else {
         cmdarg_err("Invalid -T parameter.");
-        cmdarg_err_cont("It must be \"ps\", \"text\", \"pdml\", \"psml\" or \"fields\".");
+        cmdarg_err_cont("It must be \"ps\", \"text\", \"pdml\", \"psml\", \"fields\" or \"columns\".");
         return 1;
       }
       break;
@@ -1492,6 +1509,9 @@ main(int argc, char *argv[])
         list_stat_cmd_args();
         return 1;
       }
+      /* It's written out while packets are being read */
+      if (strncmp(optarg, "io,csv,", 7) == 0)
+        io_csv_requested = TRUE;
       break;
     default:
     case '?':        /* Bad flag - print usage message */
@@ -1508,13 +1528,16 @@ main(int argc, char *argv[])
   }
 
   /* If we specified output fields, but not the output field type... */
-  if (WRITE_FIELDS != output_action && 0 != output_fields_num_fields(output_fields)) {
+  if (WRITE_FIELDS != output_action && WRITE_COLUMNS != output_action &&
+      0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tfields\" was not specified.");
+            "but neither \"-Tfields\" nor \"-Tcolumns\" was specified.");
         return 1;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_COLUMNS == output_action) &&
+             0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".",
+                    WRITE_FIELDS == output_action ? "fields" : "columns");
 
         return 1;
   }
@@ -1628,6 +1651,16 @@ main(int argc, char *argv[])
     }
   }
 
+  if (second_pass_readers > 0 && !perform_two_pass_analysis) {
+    cmdarg_err("-j requires -2");
+    return 1;
+  }
+
+  if (io_csv_requested && !quiet) {
+    cmdarg_err("-z io,csv requires -q");
+    return 1;
+  }
+
   if (rfilter != NULL && !perform_two_pass_analysis) {
     /* Just a warning, so we don't return */
     cmdarg_err("-R without -2 is deprecated. For single-pass filtering use -Y.");
@@ -1889,6 +1922,11 @@ main(int argc, char *argv[])
       return 2;
     }
 
+    /* Save an index of the packets if asked to; only here, where a
+       finished file is read, not for a file we're capturing to. */
+    if (getenv("WIRESHARK_CAPTURE_INDEX") != NULL)
+      wtap_save_index(cfile.wth, cf_name);
+
     /* Set timestamp precision; there should arguably be a command-line
        option to let the user set this. */
     switch(wtap_file_tsprecision(cfile.wth)) {
@@ -2034,6 +2072,10 @@ main(int argc, char *argv[])
 
   draw_tap_listeners(TRUE);
   funnel_dump_all_text_windows();
+  if (tree_interest != NULL) {
+    proto_interest_free(tree_interest);
+    tree_interest = NULL;
+  }
   epan_cleanup();
 
   output_fields_free(output_fields);
@@ -2657,6 +2699,23 @@ capture_cleanup(int signum _U_)
 #endif /* _WIN32 */
 #endif /* HAVE_LIBPCAP */
 
+static proto_interest_t *
+get_tree_interest(capture_file *cf)
+{
+  if (tree_interest == NULL) {
+    tree_interest = proto_interest_new();
+    if (cf->rfcode)
+      dfilter_prime_interest(cf->rfcode, tree_interest);
+    if (cf->dfcode)
+      dfilter_prime_interest(cf->dfcode, tree_interest);
+    col_custom_prime_interest(&cf->cinfo, tree_interest);
+    if (output_action == WRITE_COLUMNS)
+      output_fields_prime_interest(output_fields, tree_interest);
+    tap_build_interest(tree_interest);
+  }
+  return tree_interest;
+}
+
 static gboolean
 process_packet_first_pass(capture_file *cf,
                gint64 offset, struct wtap_pkthdr *whdr,
@@ -2696,6 +2755,7 @@ process_packet_first_pass(capture_file *cf,
     /* We're not going to display the protocol tree on this pass,
        so it's not going to be "visible". */
     epan_dissect_init(&edt, create_proto_tree, FALSE);
+    epan_dissect_set_interest(&edt, get_tree_interest(cf));
 
     /* If we're running a read filter, prime the epan_dissect_t with that
        filter. */
@@ -2762,7 +2822,8 @@ process_packet_second_pass(capture_file *cf, frame_data *fdata,
       host_name_lookup_process();
 
     if (cf->dfcode || print_details || filtering_tap_listeners ||
-        (tap_flags & TL_REQUIRES_PROTO_TREE) || have_custom_cols(&cf->cinfo))
+        (tap_flags & TL_REQUIRES_PROTO_TREE) || have_custom_cols(&cf->cinfo) ||
+        output_action == WRITE_COLUMNS)
       create_proto_tree = TRUE;
     else
       create_proto_tree = FALSE;
@@ -2772,6 +2833,7 @@ process_packet_second_pass(capture_file *cf, frame_data *fdata,
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     epan_dissect_init(&edt, create_proto_tree, print_packet_info && print_details);
+    epan_dissect_set_interest(&edt, get_tree_interest(cf));
 
     /* If we're running a display filter, prime the epan_dissect_t with that
        filter. */
@@ -2851,6 +2913,220 @@ process_packet_second_pass(capture_file *cf, frame_data *fdata,
   return passed || fdata->flags.dependent_of_displayed;
 }
 
+/*
+ * Second pass reader pool.
+ *
+ * Dissection isn't reentrant, so the second pass still dissects and
+ * prints every packet on the main thread, in frame order.  What can be
+ * spread over cores is getting the records back out of the file, which
+ * for compressed files is most of the cost of the second pass: each
+ * reader thread has its own random access wtap and reads every Nth frame
+ * into a ring of slots, at most a ring's worth ahead of the frame being
+ * dissected.
+ */
+#define SP_SLOTS_PER_READER 16
+
+typedef struct _sp_slot {
+  gboolean            ready;    /* read, waiting for the main thread */
+  gboolean            ok;       /* wtap_seek_read() succeeded */
+  int                 err;
+  gchar              *err_info;
+  struct wtap_pkthdr  phdr;
+  guint8             *pd;
+} sp_slot;
+
+struct _sp_pool;
+
+typedef struct _sp_reader {
+  struct _sp_pool *pool;
+  wtap            *wth;
+  guint32          first_frame;
+  GThread         *thread;
+} sp_reader;
+
+typedef struct _sp_pool {
+  capture_file *cf;
+  guint         nreaders;
+  guint         nslots;
+  sp_slot      *slots;
+  sp_reader    *readers;
+  guint32       next_frame;     /* the frame the main thread is waiting for or dissecting */
+  gboolean      stop;
+  GMutex       *mutex;
+  GCond        *cond;
+} sp_pool;
+
+static gpointer
+sp_reader_thread(gpointer data)
+{
+  sp_reader  *reader = (sp_reader *)data;
+  sp_pool    *pool = reader->pool;
+  frame_data *fdata;
+  sp_slot    *slot;
+  guint32     framenum;
+  gboolean    stop;
+
+  for (framenum = reader->first_frame; framenum <= pool->cf->count;
+       framenum += pool->nreaders) {
+    /* Wait until the slot has been handed back by the main thread */
+    g_mutex_lock(pool->mutex);
+    while (!pool->stop && framenum >= pool->next_frame + pool->nslots)
+      g_cond_wait(pool->cond, pool->mutex);
+    stop = pool->stop;
+    g_mutex_unlock(pool->mutex);
+    if (stop)
+      break;
+
+    fdata = frame_data_sequence_find(pool->cf->frames, framenum);
+    slot = &pool->slots[(framenum - 1) % pool->nslots];
+    slot->err = 0;
+    slot->err_info = NULL;
+    slot->ok = wtap_seek_read(reader->wth, fdata->file_off, &slot->phdr,
+                              slot->pd, fdata->cap_len, &slot->err, &slot->err_info);
+
+    g_mutex_lock(pool->mutex);
+    slot->ready = TRUE;
+    g_cond_broadcast(pool->cond);
+    g_mutex_unlock(pool->mutex);
+
+    /* The main thread stops at the first frame it can't read */
+    if (!slot->ok)
+      break;
+  }
+  return NULL;
+}
+
+static void sp_pool_free(sp_pool *pool);
+
+/*
+ * Start the reader threads.  Returns NULL, and the caller reads on its own
+ * thread, if the file can't be reopened or a thread can't be started.
+ */
+static sp_pool *
+sp_pool_new(capture_file *cf, guint nreaders)
+{
+  sp_pool *pool;
+  sp_reader *reader;
+  wtapng_iface_descriptions_t *idb_inf, *reader_idb_inf;
+  gboolean same_interfaces;
+  int err;
+  gchar *err_info;
+  guint i;
+
+  pool = g_new0(sp_pool, 1);
+  pool->cf = cf;
+  pool->nreaders = nreaders;
+  pool->nslots = nreaders * SP_SLOTS_PER_READER;
+  pool->next_frame = 1;
+  pool->slots = g_new0(sp_slot, pool->nslots);
+  for (i = 0; i < pool->nslots; i++)
+    pool->slots[i].pd = (guint8 *)g_malloc(WTAP_MAX_PACKET_SIZE);
+  pool->readers = g_new0(sp_reader, nreaders);
+#if GLIB_CHECK_VERSION(2,31,0)
+  pool->mutex = g_new(GMutex, 1);
+  g_mutex_init(pool->mutex);
+  pool->cond = g_new(GCond, 1);
+  g_cond_init(pool->cond);
+#else
+  pool->mutex = g_mutex_new();
+  pool->cond = g_cond_new();
+#endif
+
+  idb_inf = wtap_file_get_idb_info(cf->wth);
+  for (i = 0; i < nreaders; i++) {
+    reader = &pool->readers[i];
+    reader->pool = pool;
+    reader->first_frame = i + 1;
+    reader->wth = wtap_open_offline(cf->filename, &err, &err_info, TRUE);
+    if (reader->wth == NULL) {
+      g_free(err_info);
+      break;
+    }
+
+    /* A pcap-ng file may describe interfaces after its first packet;
+       a handle that hasn't seen them can't read the packets using them. */
+    reader_idb_inf = wtap_file_get_idb_info(reader->wth);
+    same_interfaces = reader_idb_inf->number_of_interfaces == idb_inf->number_of_interfaces;
+    g_free(reader_idb_inf);
+    if (!same_interfaces)
+      break;
+
+#if GLIB_CHECK_VERSION(2,31,0)
+    reader->thread = g_thread_try_new("second pass reader", sp_reader_thread, reader, NULL);
+#else
+    reader->thread = g_thread_create(sp_reader_thread, reader, TRUE, NULL);
+#endif
+    if (reader->thread == NULL)
+      break;
+  }
+  g_free(idb_inf);
+
+  if (i < nreaders) {
+    sp_pool_free(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+/* Wait for a frame; frames must be asked for in order */
+static sp_slot *
+sp_pool_get(sp_pool *pool, guint32 framenum)
+{
+  sp_slot *slot = &pool->slots[(framenum - 1) % pool->nslots];
+
+  g_mutex_lock(pool->mutex);
+  while (!slot->ready)
+    g_cond_wait(pool->cond, pool->mutex);
+  g_mutex_unlock(pool->mutex);
+  return slot;
+}
+
+/* Hand the slot of the current frame back to its reader */
+static void
+sp_pool_release(sp_pool *pool, guint32 framenum)
+{
+  sp_slot *slot = &pool->slots[(framenum - 1) % pool->nslots];
+
+  g_mutex_lock(pool->mutex);
+  slot->ready = FALSE;
+  pool->next_frame = framenum + 1;
+  g_cond_broadcast(pool->cond);
+  g_mutex_unlock(pool->mutex);
+}
+
+static void
+sp_pool_free(sp_pool *pool)
+{
+  guint i;
+
+  g_mutex_lock(pool->mutex);
+  pool->stop = TRUE;
+  g_cond_broadcast(pool->cond);
+  g_mutex_unlock(pool->mutex);
+
+  for (i = 0; i < pool->nreaders; i++) {
+    if (pool->readers[i].thread)
+      g_thread_join(pool->readers[i].thread);
+    if (pool->readers[i].wth)
+      wtap_close(pool->readers[i].wth);
+  }
+  for (i = 0; i < pool->nslots; i++)
+    g_free(pool->slots[i].pd);
+
+#if GLIB_CHECK_VERSION(2,31,0)
+  g_mutex_clear(pool->mutex);
+  g_free(pool->mutex);
+  g_cond_clear(pool->cond);
+  g_free(pool->cond);
+#else
+  g_mutex_free(pool->mutex);
+  g_cond_free(pool->cond);
+#endif
+  g_free(pool->readers);
+  g_free(pool->slots);
+  g_free(pool);
+}
+
 static int
 load_cap_file(capture_file *cf, char *save_file, int out_file_type,
     gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count)
@@ -2964,6 +3240,11 @@ load_cap_file(capture_file *cf, char *save_file, int out_file_type,
   if (perform_two_pass_analysis) {
     frame_data *fdata;
     int old_max_packet_count = max_packet_count;
+    sp_pool *pool = NULL;
+    sp_slot *slot;
+    struct wtap_pkthdr *phdr;
+    guint8 *pd;
+    gboolean read_ok;
 
     /* Allocate a frame_data_sequence for all the frames. */
     cf->frames = new_frame_data_sequence();
@@ -2994,18 +3275,37 @@ load_cap_file(capture_file *cf, char *save_file, int out_file_type,
 
     prev_dis = NULL;
     prev_cap = NULL;
+    if (second_pass_readers > 0 && cf->count > 0) {
+      pool = sp_pool_new(cf, second_pass_readers);
+      if (pool == NULL)
+        cmdarg_err("Couldn't start the second pass reader threads; reading on one thread.");
+    }
     for (framenum = 1; err == 0 && framenum <= cf->count; framenum++) {
       fdata = frame_data_sequence_find(cf->frames, framenum);
-      if (wtap_seek_read(cf->wth, fdata->file_off, &cf->phdr,
-          cf->pd, fdata->cap_len, &err, &err_info)) {
+      if (pool != NULL) {
+        slot = sp_pool_get(pool, framenum);
+        phdr = &slot->phdr;
+        pd = slot->pd;
+        read_ok = slot->ok;
+        if (!read_ok) {
+          err = slot->err;
+          err_info = slot->err_info;
+        }
+      } else {
+        phdr = &cf->phdr;
+        pd = cf->pd;
+        read_ok = wtap_seek_read(cf->wth, fdata->file_off, phdr,
+                                 pd, fdata->cap_len, &err, &err_info);
+      }
+      if (read_ok) {
         if (process_packet_second_pass(cf, fdata,
-                           &cf->phdr, cf->pd,
+                           phdr, pd,
                            filtering_tap_listeners, tap_flags)) {
           /* Either there's no read filtering or this packet passed the
              filter, so, if we're writing to a capture file, write
              this packet out. */
           if (pdh != NULL) {
-            if (!wtap_dump(pdh, &cf->phdr, cf->pd, &err)) {
+            if (!wtap_dump(pdh, phdr, pd, &err)) {
               /* Error writing to a capture file */
               switch (err) {
 
@@ -3043,7 +3343,11 @@ load_cap_file(capture_file *cf, char *save_file, int out_file_type,
           }
         }
       }
+      if (pool != NULL)
+        sp_pool_release(pool, framenum);
     }
+    if (pool != NULL)
+      sp_pool_free(pool);
   }
   else {
     framenum = 0;
@@ -3220,7 +3524,8 @@ process_packet(capture_file *cf, gint64 offset, struct wtap_pkthdr *whdr,
       host_name_lookup_process();
 
     if (cf->rfcode || cf->dfcode || print_details || filtering_tap_listeners ||
-        (tap_flags & TL_REQUIRES_PROTO_TREE) || have_custom_cols(&cf->cinfo))
+        (tap_flags & TL_REQUIRES_PROTO_TREE) || have_custom_cols(&cf->cinfo) ||
+        output_action == WRITE_COLUMNS)
       create_proto_tree = TRUE;
     else
       create_proto_tree = FALSE;
@@ -3230,6 +3535,7 @@ process_packet(capture_file *cf, gint64 offset, struct wtap_pkthdr *whdr,
        ("print_packet_info" is true) and we're in verbose mode
        ("packet_details" is true). */
     epan_dissect_init(&edt, create_proto_tree, print_packet_info && print_details);
+    epan_dissect_set_interest(&edt, get_tree_interest(cf));
 
     /* If we're running a filter, prime the epan_dissect_t with that
        filter. */
@@ -3339,6 +3645,10 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNS:
+    write_columns_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   default:
     g_assert_not_reached();
     return FALSE;
@@ -3607,11 +3917,18 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
         proto_tree_write_psml(edt, stdout);
         return !ferror(stdout);
       case WRITE_FIELDS: /*No non-verbose "fields" format */
+      case WRITE_COLUMNS:
         g_assert_not_reached();
         break;
       }
     }
   }
+  if (output_action == WRITE_COLUMNS) {
+    /* The fields are looked up in the (invisible) tree and buffered,
+       they're written out a block of packets at a time. */
+    proto_tree_write_columns(output_fields, edt, &cf->cinfo, stdout);
+    return !ferror(stdout);
+  }
   if (print_details) {
     /* Print the information in the protocol tree. */
     switch (output_action) {
@@ -3645,6 +3962,9 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
       proto_tree_write_fields(output_fields, edt, &cf->cinfo, stdout);
       printf("\n");
       return !ferror(stdout);
+    case WRITE_COLUMNS: /* handled above */
+      g_assert_not_reached();
+      break;
     }
   }
   if (print_hex) {
@@ -3679,6 +3999,10 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNS:
+    write_columns_finale(output_fields, stdout);
+    return !ferror(stdout);
+
   default:
     g_assert_not_reached();
     return FALSE;
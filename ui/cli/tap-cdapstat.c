@@ -0,0 +1,173 @@
+/* tap-cdapstat.c
+ * CDAP service response time statistics for tshark
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module provides "-z cdap,srt" statistics to tshark: the number of
+ * calls and the min/max/avg response time of every CDAP operation, as
+ * measured by the request/response matching in the CDAP dissector.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epan/packet_info.h"
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+#include <plugins/cdap/packet-cdap.h>
+#include "timestats.h"
+
+#define MICROSECS_PER_SEC   1000000
+#define NANOSECS_PER_SEC    1000000000
+
+typedef struct _cdapstat_t {
+	char *filter;
+	/* indexed by request opcode; the names come from the requests */
+	const char *name[CDAP_NUM_OPCODES];
+	timestat_t op[CDAP_NUM_OPCODES];
+	guint32 errors[CDAP_NUM_OPCODES];	/* responses with a non-zero result */
+	guint32 unmatched;			/* responses without a request */
+} cdapstat_t;
+
+static void
+cdapstat_reset(void *pcs)
+{
+	cdapstat_t *cs=(cdapstat_t *)pcs;
+	guint32 i;
+
+	for(i=0;i<CDAP_NUM_OPCODES;i++){
+		time_stat_init(&cs->op[i]);
+		cs->errors[i]=0;
+	}
+	cs->unmatched=0;
+}
+
+static int
+cdapstat_packet(void *pcs, packet_info *pinfo, epan_dissect_t *edt _U_, const void *pci)
+{
+	cdapstat_t *cs=(cdapstat_t *)pcs;
+	const cdap_tap_info *ci=(const cdap_tap_info *)pci;
+	nstime_t t, deltat;
+	guint32 req;
+
+	if(ci->opcode>=CDAP_NUM_OPCODES){
+		return 0;
+	}
+
+	if(ci->is_request){
+		if(!cs->name[ci->opcode]){
+			cs->name[ci->opcode]=ci->opcode_name;
+		}
+		return 0;
+	}
+
+	if(!ci->req_frame){
+		cs->unmatched++;
+		return 1;
+	}
+
+	req=ci->opcode-1;
+	t=pinfo->fd->abs_ts;
+	nstime_delta(&deltat, &t, &ci->req_time);
+	time_stat_update(&cs->op[req], &deltat, pinfo);
+	if(ci->result!=0){
+		cs->errors[req]++;
+	}
+
+	return 1;
+}
+
+static void
+cdapstat_draw(void *pcs)
+{
+	cdapstat_t *cs=(cdapstat_t *)pcs;
+	guint32 i;
+	guint64 td;
+
+	printf("\n");
+	printf("=================================================================\n");
+	printf("CDAP SRT Statistics:\n");
+	printf("Filter: %s\n",cs->filter?cs->filter:"");
+	printf("Operation                  Calls    Min SRT    Max SRT    Avg SRT  Errors\n");
+	for(i=0;i<CDAP_NUM_OPCODES;i++){
+		/* nothing seen, nothing to do */
+		if(cs->op[i].num==0){
+			continue;
+		}
+
+		/* Scale the average SRT in units of 1us and round to the nearest us. */
+		td = ((guint64)(cs->op[i].tot.secs)) * NANOSECS_PER_SEC + cs->op[i].tot.nsecs;
+		td = ((td / cs->op[i].num) + 500) / 1000;
+
+		printf("%-25s %6d %3d.%06d %3d.%06d %3" G_GINT64_MODIFIER "u.%06" G_GINT64_MODIFIER "u %7u\n",
+			cs->name[i]?cs->name[i]:"Unknown",
+			cs->op[i].num,
+			(int)(cs->op[i].min.secs),(cs->op[i].min.nsecs+500)/1000,
+			(int)(cs->op[i].max.secs),(cs->op[i].max.nsecs+500)/1000,
+			td/MICROSECS_PER_SEC, td%MICROSECS_PER_SEC,
+			cs->errors[i]
+		);
+	}
+	if(cs->unmatched){
+		printf("\n%u response(s) without a matching request\n", cs->unmatched);
+	}
+	printf("=================================================================\n");
+}
+
+static void
+cdapstat_init(const char *optarg, void* userdata _U_)
+{
+	cdapstat_t *cs;
+	const char *filter=NULL;
+	GString *error_string;
+
+	if(!strncmp(optarg,"cdap,srt,",9)){
+		filter=optarg+9;
+	} else {
+		filter=NULL;
+	}
+
+	cs=g_new0(cdapstat_t,1);
+	cs->filter=g_strdup(filter);
+	cdapstat_reset(cs);
+
+	error_string=register_tap_listener("cdap", cs, filter, 0, cdapstat_reset, cdapstat_packet, cdapstat_draw);
+	if(error_string){
+		/* error, we failed to attach to the tap. clean up */
+		g_free(cs->filter);
+		g_free(cs);
+
+		fprintf(stderr, "tshark: Couldn't register cdap,srt tap: %s\n",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+void
+register_tap_listener_cdapstat(void)
+{
+	register_stat_cmd_arg("cdap,srt", cdapstat_init, NULL);
+}
@@ -0,0 +1,273 @@
+/* tap-efcpstat.c
+ * EFCP connection and QoS cube statistics for tshark
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module provides "-z efcp,conv" and "-z efcp,qos" statistics to
+ * tshark.  Every PDU is accounted for with one or two hash table lookups,
+ * so the cost is linear in the number of PDUs; the connections or QoS
+ * cubes are only sorted once, when the statistics are printed.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet_info.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+#include <plugins/efcp/packet-efcp.h>
+
+typedef enum {
+	EFCPSTAT_CONV,
+	EFCPSTAT_QOS
+} efcpstat_mode_t;
+
+/* Statistics for a connection or a QoS cube; direction 0 is from key.addr[0] */
+typedef struct _efcpstat_item {
+	efcp_conn_key key;
+	guint32  pdus[2];
+	guint64  bytes[2];
+	guint32  retransmissions;
+	guint32  out_of_order;
+	guint32  lost;
+	guint32  connections;		/* QoS cubes only */
+	nstime_t start_rel_time;
+	nstime_t stop_rel_time;
+} efcpstat_item;
+
+typedef struct _efcpstat_t {
+	efcpstat_mode_t  mode;
+	char            *filter;
+	GHashTable      *conv_table;	/* efcp_conn_key -> efcpstat_item */
+	GHashTable      *qos_table;	/* QoS id -> efcpstat_item; QoS mode only */
+} efcpstat_t;
+
+static void
+efcpstat_reset(void *psp)
+{
+	efcpstat_t *sp = (efcpstat_t *)psp;
+
+	g_hash_table_remove_all(sp->conv_table);
+	if (sp->qos_table)
+		g_hash_table_remove_all(sp->qos_table);
+}
+
+static void
+efcpstat_update(efcpstat_item *item, int dir, packet_info *pinfo,
+		const efcp_tap_info *efcpinfo)
+{
+	if (item->pdus[0] + item->pdus[1] == 0) {
+		item->start_rel_time = pinfo->fd->rel_ts;
+	}
+	item->stop_rel_time = pinfo->fd->rel_ts;
+	item->pdus[dir]++;
+	item->bytes[dir] += efcpinfo->length;
+	if (efcpinfo->analysis_flags & EFCP_A_RETRANSMISSION)
+		item->retransmissions++;
+	if (efcpinfo->analysis_flags & EFCP_A_OUT_OF_ORDER)
+		item->out_of_order++;
+	if (efcpinfo->analysis_flags & EFCP_A_LOST_SEGMENT)
+		item->lost++;
+}
+
+static int
+efcpstat_packet(void *psp, packet_info *pinfo, epan_dissect_t *edt _U_, const void *pri)
+{
+	efcpstat_t *sp = (efcpstat_t *)psp;
+	const efcp_tap_info *efcpinfo = (const efcp_tap_info *)pri;
+	efcpstat_item *conv, *qos;
+
+	conv = (efcpstat_item *)g_hash_table_lookup(sp->conv_table, &efcpinfo->conn);
+	if (!conv) {
+		conv = g_new0(efcpstat_item, 1);
+		conv->key = efcpinfo->conn;
+		g_hash_table_insert(sp->conv_table, &conv->key, conv);
+		if (sp->mode == EFCPSTAT_QOS) {
+			qos = (efcpstat_item *)g_hash_table_lookup(sp->qos_table, GUINT_TO_POINTER(efcpinfo->qos_id));
+			if (!qos) {
+				qos = g_new0(efcpstat_item, 1);
+				qos->key.qos_id = efcpinfo->qos_id;
+				g_hash_table_insert(sp->qos_table, GUINT_TO_POINTER(efcpinfo->qos_id), qos);
+			}
+			qos->connections++;
+		}
+	}
+
+	if (sp->mode == EFCPSTAT_QOS) {
+		qos = (efcpstat_item *)g_hash_table_lookup(sp->qos_table, GUINT_TO_POINTER(efcpinfo->qos_id));
+		efcpstat_update(qos, efcpinfo->dir, pinfo, efcpinfo);
+	} else {
+		efcpstat_update(conv, efcpinfo->dir, pinfo, efcpinfo);
+	}
+
+	return 1;
+}
+
+static void
+efcpstat_collect(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	g_ptr_array_add((GPtrArray *)user_data, value);
+}
+
+/* Sort by total bytes, largest first */
+static gint
+efcpstat_compare(gconstpointer a, gconstpointer b)
+{
+	const efcpstat_item *ia = *(const efcpstat_item * const *)a;
+	const efcpstat_item *ib = *(const efcpstat_item * const *)b;
+	guint64 bytes_a = ia->bytes[0] + ia->bytes[1];
+	guint64 bytes_b = ib->bytes[0] + ib->bytes[1];
+
+	if (bytes_a > bytes_b)
+		return -1;
+	if (bytes_a < bytes_b)
+		return 1;
+	return 0;
+}
+
+static double
+efcpstat_duration(const efcpstat_item *item)
+{
+	return nstime_to_sec(&item->stop_rel_time) - nstime_to_sec(&item->start_rel_time);
+}
+
+/* Throughput in bits/s, 0 if all PDUs were seen at the same time */
+static double
+efcpstat_throughput(const efcpstat_item *item)
+{
+	double duration = efcpstat_duration(item);
+
+	if (duration <= 0.0)
+		return 0.0;
+	return (double)(item->bytes[0] + item->bytes[1]) * 8.0 / duration;
+}
+
+static void
+efcpstat_draw(void *psp)
+{
+	efcpstat_t *sp = (efcpstat_t *)psp;
+	GPtrArray *items;
+	efcpstat_item *item;
+	char name1[32], name2[32];
+	guint i;
+
+	items = g_ptr_array_new();
+	g_hash_table_foreach(sp->mode == EFCPSTAT_QOS ? sp->qos_table : sp->conv_table,
+			     efcpstat_collect, items);
+	g_ptr_array_sort(items, efcpstat_compare);
+
+	printf("================================================================================\n");
+	if (sp->mode == EFCPSTAT_QOS) {
+		printf("EFCP QoS Cubes\n");
+		printf("Filter:%s\n", sp->filter ? sp->filter : "<No Filter>");
+		printf("QoS id  Connections |     Total     | Retrans  Out-Of-Order   Lost | Relative Start |   Duration   |  Throughput  |\n");
+		printf("                    |  PDUs   Bytes |                              |                |              |    (bit/s)   |\n");
+		for (i = 0; i < items->len; i++) {
+			item = (efcpstat_item *)g_ptr_array_index(items, i);
+			printf("%6u  %11u  %6u %9" G_GINT64_MODIFIER "u  %7u  %12u %6u  %14.9f   %12.4f  %12.0f\n",
+			       item->key.qos_id, item->connections,
+			       item->pdus[0] + item->pdus[1],
+			       item->bytes[0] + item->bytes[1],
+			       item->retransmissions, item->out_of_order, item->lost,
+			       nstime_to_sec(&item->start_rel_time),
+			       efcpstat_duration(item),
+			       efcpstat_throughput(item));
+		}
+	} else {
+		printf("EFCP Connections\n");
+		printf("Filter:%s\n", sp->filter ? sp->filter : "<No Filter>");
+		printf("                                  QoS |       <-      | |       ->      | |     Total     | Retrans  Out-Of-Order   Lost | Relative Start |   Duration   |  Throughput  |\n");
+		printf("                                   id |  PDUs   Bytes | |  PDUs   Bytes | |  PDUs   Bytes |                              |                |              |    (bit/s)   |\n");
+		for (i = 0; i < items->len; i++) {
+			item = (efcpstat_item *)g_ptr_array_index(items, i);
+			g_snprintf(name1, sizeof(name1), "%u:%d", item->key.addr[0], item->key.cep[0]);
+			g_snprintf(name2, sizeof(name2), "%u:%d", item->key.addr[1], item->key.cep[1]);
+			printf("%-14s <-> %-14s %4u  %6u %9" G_GINT64_MODIFIER "u  %6u %9" G_GINT64_MODIFIER "u  %6u %9" G_GINT64_MODIFIER "u  %7u  %12u %6u  %14.9f   %12.4f  %12.0f\n",
+			       name1, name2, item->key.qos_id,
+			       item->pdus[1], item->bytes[1],
+			       item->pdus[0], item->bytes[0],
+			       item->pdus[0] + item->pdus[1],
+			       item->bytes[0] + item->bytes[1],
+			       item->retransmissions, item->out_of_order, item->lost,
+			       nstime_to_sec(&item->start_rel_time),
+			       efcpstat_duration(item),
+			       efcpstat_throughput(item));
+		}
+	}
+	printf("================================================================================\n");
+
+	g_ptr_array_free(items, TRUE);
+}
+
+static void
+efcpstat_init(const char *optarg, void *userdata _U_)
+{
+	efcpstat_t *sp;
+	const char *filter = NULL;
+	GString *error_string;
+
+	sp = g_new0(efcpstat_t, 1);
+	if (!strncmp(optarg, "efcp,qos", 8)) {
+		sp->mode = EFCPSTAT_QOS;
+		filter = optarg + 8;
+	} else {
+		sp->mode = EFCPSTAT_CONV;
+		filter = optarg + 9;
+	}
+	if (*filter == ',') {
+		filter++;
+	} else {
+		filter = NULL;
+	}
+	sp->filter = g_strdup(filter);
+	sp->conv_table = g_hash_table_new_full(efcp_conn_key_hash, efcp_conn_key_equal, NULL, g_free);
+	if (sp->mode == EFCPSTAT_QOS)
+		sp->qos_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+	error_string = register_tap_listener("efcp", sp, filter, 0,
+					     efcpstat_reset,
+					     efcpstat_packet,
+					     efcpstat_draw);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		g_free(sp->filter);
+		g_hash_table_destroy(sp->conv_table);
+		if (sp->qos_table)
+			g_hash_table_destroy(sp->qos_table);
+		g_free(sp);
+
+		fprintf(stderr, "tshark: Couldn't register efcp statistics tap: %s\n",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+void
+register_tap_listener_efcpstat(void)
+{
+	register_stat_cmd_arg("efcp,conv", efcpstat_init, NULL);
+	register_stat_cmd_arg("efcp,qos", efcpstat_init, NULL);
+}
@@ -67,7 +67,12 @@ typedef struct _io_stat_t {
     guint64 interval;     /* The user-specified time interval (us) */
     guint invl_prec;      /* Decimal precision of the time interval (1=10s, 2=100s etc) */
     guint32 num_cols;     /* The number of columns of statistics in the table */
-    struct _io_stat_item_t *items;  /* Each item is a single cell in the table */
+    struct _io_stat_item_t *items;  /* The statistic computed in each column */
+    GArray *cells;        /* The io_stat_cell_t of each column, interval after interval */
+    guint first_invl;     /* The interval of the first row of cells (>0 only for "io,csv") */
+    dfilter_t *code;      /* The filters of all columns combined, or NULL if none has one */
+    gboolean *matched;    /* The columns whose filter the current frame matched */
+    gboolean csv;         /* Write each interval as CSV as soon as it's complete */
     time_t start_time;    /* Time of first frame matching the filter */
     const char **filters; /* 'io,stat' cmd strings (e.g., "AVG(smb.time)smb.time") */
     guint64 *max_vals;    /* The max value sans the decimal or nsecs portion in each stat column */
@@ -76,93 +81,62 @@ typedef struct _io_stat_t {
 
 typedef struct _io_stat_item_t {
     io_stat_t *parent;
-    struct _io_stat_item_t *next;
-    struct _io_stat_item_t *prev;
-    guint64 time;         /* Time since start of capture (us)*/
     int calc_type;        /* The statistic type */
     int colnum;           /* Column number of this stat (0 to n) */
     int hf_index;
+    gboolean filtered;    /* Only frames matching the column's filter are counted */
+} io_stat_item_t;
+
+/* A single cell in the table */
+typedef struct _io_stat_cell_t {
     guint32 frames;
     guint32 num;          /* The sample size of a given statistic (only needed for AVG) */
     guint64 counter;      /* The accumulated data for the calculation of that statistic */
     gfloat float_counter;
     gdouble double_counter;
-} io_stat_item_t;
+} io_stat_cell_t;
+
+/* The cell of column colnum in interval invl; the interval must be in iot->cells */
+#define IOSTAT_CELL(iot, invl, colnum) \
+    (&g_array_index((iot)->cells, io_stat_cell_t, \
+                    ((invl) - (iot)->first_invl) * (iot)->num_cols + (colnum)))
 
 #define NANOSECS_PER_SEC 1000000000
 
-static int
-iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
+/* Adds a frame that fell into interval invl to the column of item */
+static void
+iostat_cell_packet(io_stat_t *parent, io_stat_item_t *item, guint invl, packet_info *pinfo, epan_dissect_t *edt)
 {
-    io_stat_t *parent;
-    io_stat_item_t *mit;
-    io_stat_item_t *it;
-    guint64 relative_time, rt;
+    io_stat_cell_t *it;
     nstime_t *new_time;
     GPtrArray *gp;
     guint i;
     int ftype;
 
-    mit = (io_stat_item_t *) arg;
-    parent = mit->parent;
-    relative_time = (guint64)((pinfo->fd->rel_ts.secs*1000000) + ((pinfo->fd->rel_ts.nsecs+500)/1000));
-    if (mit->parent->start_time == 0) {
-        mit->parent->start_time = pinfo->fd->abs_ts.secs - pinfo->fd->rel_ts.secs;
-    }
-
-    /* The prev item before the main one is always the last interval we saw packets for */
-    it = mit->prev;
-
-    /* XXX for the time being, just ignore all frames that are in the past.
-       should be fixed in the future but hopefully it is uncommon */
-    if(relative_time < it->time){
-        return FALSE;
-    }
-
-    /* If we have moved into a new interval (row), create a new io_stat_item_t struct for every interval
-    *  between the last struct and this one. If an item was not found in a previous interval, an empty
-    *  struct will be created for it. */
-    rt = relative_time;
-    while (rt >= it->time + parent->interval) {
-        it->next = (io_stat_item_t *)g_malloc(sizeof(io_stat_item_t));
-        it->next->prev = it;
-        it->next->next = NULL;
-        it = it->next;
-        mit->prev = it;
-
-        it->time = it->prev->time + parent->interval;
-        it->frames = 0;
-        it->counter = 0;
-        it->float_counter = 0;
-        it->double_counter = 0;
-        it->num = 0;
-        it->calc_type = it->prev->calc_type;
-        it->hf_index = it->prev->hf_index;
-        it->colnum = it->prev->colnum;
-    }
+    it = IOSTAT_CELL(parent, invl, item->colnum);
 
     /* Store info in the current structure */
     it->frames++;
 
-    switch(it->calc_type) {
+    switch(item->calc_type) {
     case CALC_TYPE_FRAMES:
     case CALC_TYPE_BYTES:
     case CALC_TYPE_FRAMES_AND_BYTES:
         it->counter += pinfo->fd->pkt_len;
         break;
     case CALC_TYPE_COUNT:
-        gp=proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp=proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if(gp){
             it->counter += gp->len;
         }
         break;
     case CALC_TYPE_SUM:
-        gp=proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp=proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if(gp){
             guint64 val;
 
             for(i=0;i<gp->len;i++){
-                switch(proto_registrar_get_ftype(it->hf_index)){
+                switch(proto_registrar_get_ftype(item->hf_index)){
                 case FT_UINT8:
                 case FT_UINT16:
                 case FT_UINT24:
@@ -205,13 +179,13 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_MIN:
-        gp=proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp=proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if(gp){
             guint64 val;
             gfloat float_val;
             gdouble double_val;
 
-            ftype=proto_registrar_get_ftype(it->hf_index);
+            ftype=proto_registrar_get_ftype(item->hf_index);
             for(i=0;i<gp->len;i++){
                 switch(ftype){
                 case FT_UINT8:
@@ -275,13 +249,13 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_MAX:
-        gp=proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp=proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if(gp){
             guint64 val;
             gfloat float_val;
             gdouble double_val;
 
-            ftype=proto_registrar_get_ftype(it->hf_index);
+            ftype=proto_registrar_get_ftype(item->hf_index);
             for(i=0;i<gp->len;i++){
                 switch(ftype){
                 case FT_UINT8:
@@ -338,11 +312,11 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_AVG:
-        gp=proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp=proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if(gp){
             guint64 val;
 
-            ftype=proto_registrar_get_ftype(it->hf_index);
+            ftype=proto_registrar_get_ftype(item->hf_index);
             for(i=0;i<gp->len;i++){
                 it->num++;
                 switch(ftype) {
@@ -388,9 +362,9 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     case CALC_TYPE_LOAD:
-        gp = proto_get_finfo_ptr_array(edt->tree, it->hf_index);
+        gp = proto_get_finfo_ptr_array(edt->tree, item->hf_index);
         if (gp) {
-            ftype = proto_registrar_get_ftype(it->hf_index);
+            ftype = proto_registrar_get_ftype(item->hf_index);
             if (ftype != FT_RELATIVE_TIME) {
                 fprintf(stderr,
                     "\ntshark: LOAD() is only supported for relative-time fields such as smb.time\n");
@@ -399,22 +373,24 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
             for(i=0;i<gp->len;i++){
                 guint64 val;
                 int tival;
-                io_stat_item_t *pit;
+                guint pinvl;
+                io_stat_cell_t *pit;
 
                 new_time = (nstime_t *)fvalue_get(&((field_info *)gp->pdata[i])->value);
                 val = (guint64)((new_time->secs*1000000) + (new_time->nsecs/1000));
                 tival = (int)(val % parent->interval);
                 it->counter += tival;
                 val -= tival;
-                pit = it->prev;
-                while (val > 0) {
+                /* The rest of the load falls into the intervals before this one
+                 * (but not those already written out by "io,csv") */
+                for (pinvl = invl; val > 0 && pinvl > parent->first_invl; pinvl--) {
+                    pit = IOSTAT_CELL(parent, pinvl - 1, item->colnum);
                     if (val < (guint64)parent->interval) {
                         pit->counter += val;
                         break;
                     }
                     pit->counter += parent->interval;
                     val -= parent->interval;
-                    pit = pit->prev;
                 }
             }
         }
@@ -426,69 +402,259 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
     *  calc the average, round it to the next second and store the seconds. For all other calc types
     *  of RELATIVE_TIME fields, store the counters without modification.
     *  fields. */
-    switch(it->calc_type) {
+    switch(item->calc_type) {
         case CALC_TYPE_FRAMES:
         case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (it->calc_type==CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
+            parent->max_frame[item->colnum] =
+                MAX(parent->max_frame[item->colnum], it->frames);
+            if (item->calc_type==CALC_TYPE_FRAMES_AND_BYTES)
+                parent->max_vals[item->colnum] =
+                    MAX(parent->max_vals[item->colnum], it->counter);
 
         case CALC_TYPE_BYTES:
         case CALC_TYPE_COUNT:
         case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            parent->max_vals[item->colnum] = MAX(parent->max_vals[item->colnum], it->counter);
             break;
         case CALC_TYPE_SUM:
         case CALC_TYPE_MIN:
         case CALC_TYPE_MAX:
-            ftype=proto_registrar_get_ftype(it->hf_index);
+            ftype=proto_registrar_get_ftype(item->hf_index);
             switch(ftype) {
                 case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], (guint64)(it->float_counter+0.5));
                     break;
                 case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum],(guint64)(it->double_counter+0.5));
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum],(guint64)(it->double_counter+0.5));
                     break;
                 case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], it->counter);
                     break;
                 default:
                     /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], it->counter);
                     break;
             }
             break;
         case CALC_TYPE_AVG:
             if (it->num==0) /* avoid division by zero */
                break;
-            ftype=proto_registrar_get_ftype(it->hf_index);
+            ftype=proto_registrar_get_ftype(item->hf_index);
             switch(ftype) {
                 case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], (guint64)it->float_counter/it->num);
                     break;
                 case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum],(guint64)it->double_counter/it->num);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum],(guint64)it->double_counter/it->num);
                     break;
                 case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/it->num) + 500000000) / NANOSECS_PER_SEC);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], ((it->counter/it->num) + 500000000) / NANOSECS_PER_SEC);
                     break;
                 default:
                     /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
+                    parent->max_vals[item->colnum] =
+                        MAX(parent->max_vals[item->colnum], it->counter/it->num);
                     break;
             }
     }
-    return TRUE;
+}
+
+static void
+iostat_free(io_stat_t *iot)
+{
+    /* iot->code belongs to the tap listener */
+    g_array_free(iot->cells, TRUE);
+    g_free(iot->matched);
+    g_free(iot->items);
+    g_free(iot->max_vals);
+    g_free(iot->max_frame);
+    g_free(iot);
+}
+
+/* Writes the header of "io,csv" */
+static void
+iostat_csv_header(io_stat_t *iot)
+{
+    guint j;
+    int type;
+
+    printf("Interval start,Interval end");
+    for (j=0; j<iot->num_cols; j++) {
+        type = iot->items[j].calc_type;
+        if (type==CALC_TYPE_FRAMES_AND_BYTES)
+            printf(",Frames %u,Bytes %u", j+1, j+1);
+        else
+            printf(",%s %u", calc_type_table[type].func_name, j+1);
+    }
+    printf("\n");
+}
+
+/* Writes interval invl, which is invl_len us long, as a CSV row */
+static void
+iostat_csv_row(io_stat_t *iot, guint invl, guint64 invl_len)
+{
+    static const io_stat_cell_t empty;
+    const io_stat_cell_t *it;
+    io_stat_item_t *item;
+    guint64 t, val;
+    guint32 num;
+    guint j;
+
+    t = (guint64)invl * iot->interval;
+    printf("%u.%06u,%u.%06u",
+           (guint32)(t/1000000), (guint32)(t%1000000),
+           (guint32)((t+invl_len)/1000000), (guint32)((t+invl_len)%1000000));
+
+    for (j=0; j<iot->num_cols; j++) {
+        item = &iot->items[j];
+        if ((invl - iot->first_invl + 1) * iot->num_cols <= iot->cells->len)
+            it = IOSTAT_CELL(iot, invl, j);
+        else
+            it = &empty;
+
+        switch(item->calc_type) {
+        case CALC_TYPE_FRAMES:
+            printf(",%u", it->frames);
+            break;
+        case CALC_TYPE_BYTES:
+        case CALC_TYPE_COUNT:
+            printf(",%" G_GINT64_MODIFIER "u", it->counter);
+            break;
+        case CALC_TYPE_FRAMES_AND_BYTES:
+            printf(",%u,%" G_GINT64_MODIFIER "u", it->frames, it->counter);
+            break;
+        case CALC_TYPE_LOAD:
+            printf(",%u.%06u", (guint32)(it->counter/invl_len),
+                   (guint32)((it->counter%invl_len)*1000000/invl_len));
+            break;
+        default:
+            /* SUM, MIN, MAX and AVG */
+            num = 1;
+            if (item->calc_type==CALC_TYPE_AVG && it->num > 0)
+                num = it->num;
+            switch(proto_registrar_get_ftype(item->hf_index)) {
+            case FT_FLOAT:
+                printf(",%f", it->float_counter/num);
+                break;
+            case FT_DOUBLE:
+                printf(",%f", it->double_counter/num);
+                break;
+            case FT_RELATIVE_TIME:
+                val = ((it->counter/num) + 500) / 1000;
+                printf(",%u.%06u", (guint32)(val/1000000), (guint32)(val%1000000));
+                break;
+            case FT_INT8:
+            case FT_INT16:
+            case FT_INT24:
+            case FT_INT32:
+            case FT_INT64:
+                printf(",%" G_GINT64_MODIFIER "d", (gint64)it->counter/(gint64)num);
+                break;
+            default:
+                printf(",%" G_GINT64_MODIFIER "u", it->counter/num);
+                break;
+            }
+            break;
+        }
+    }
+    printf("\n");
+}
+
+/* Writes the intervals before invl, which are complete, and drops their cells */
+static void
+iostat_csv_flush(io_stat_t *iot, guint invl)
+{
+    guint i, rows;
+
+    for (i=iot->first_invl; i<invl; i++)
+        iostat_csv_row(iot, i, iot->interval);
+
+    rows = MIN(invl - iot->first_invl, iot->cells->len / iot->num_cols);
+    g_array_remove_range(iot->cells, 0, rows * iot->num_cols);
+    iot->first_invl = invl;
+}
+
+static int
+iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
+{
+    io_stat_t *parent;
+    guint64 relative_time;
+    guint invl, rows;
+    guint j;
+    gboolean counted = FALSE;
+
+    parent = (io_stat_t *) arg;
+
+    /* XXX for the time being, just ignore all frames that are before the first one.
+       should be fixed in the future but hopefully it is uncommon */
+    if (pinfo->fd->rel_ts.secs < 0 || pinfo->fd->rel_ts.nsecs < 0) {
+        return FALSE;
+    }
+
+    relative_time = (guint64)((pinfo->fd->rel_ts.secs*1000000) + ((pinfo->fd->rel_ts.nsecs+500)/1000));
+    if (parent->start_time == 0) {
+        parent->start_time = pinfo->fd->abs_ts.secs - pinfo->fd->rel_ts.secs;
+    }
+
+    /* The intervals are all the same size, so the one the frame falls into
+    *  is found by dividing; the ones before it that "io,csv" has already
+    *  written out are gone. */
+    invl = (guint)(relative_time / parent->interval);
+    if (invl < parent->first_invl) {
+        return FALSE;
+    }
+    if (parent->csv && invl > parent->first_invl) {
+        iostat_csv_flush(parent, invl);
+    }
+
+    /* Run the filters of all columns at once */
+    if (parent->code) {
+        memset(parent->matched, 0, sizeof(gboolean) * parent->num_cols);
+        dfilter_apply_all_edt(parent->code, edt, parent->matched);
+    }
+
+    for (j=0; j<parent->num_cols; j++) {
+        if (parent->items[j].filtered && !parent->matched[j])
+            continue;
+
+        if (!counted) {
+            /* Grow the table to this interval; new cells are zeroed */
+            rows = invl - parent->first_invl + 1;
+            if (parent->cells->len < rows * parent->num_cols)
+                g_array_set_size(parent->cells, rows * parent->num_cols);
+            counted = TRUE;
+        }
+        iostat_cell_packet(parent, &parent->items[j], invl, pinfo, edt);
+    }
+
+    return counted;
+}
+
+/* Writes the intervals not written yet, up to the end of the capture, duration us */
+static void
+iostat_csv_finish(io_stat_t *iot, guint64 duration)
+{
+    guint last;
+    guint64 t;
+
+    last = duration > 0 ? (guint)((duration - 1) / iot->interval) : 0;
+    if (last < iot->first_invl)
+        last = iot->first_invl;
+
+    iostat_csv_flush(iot, last);
+
+    /* The last interval ends with the capture */
+    t = (guint64)last * iot->interval;
+    iostat_csv_row(iot, last, duration > t ? duration - t : iot->interval);
+
+    iostat_free(iot);
 }
 
 static int
@@ -543,19 +709,25 @@ iostat_draw(void *arg)
     char *spaces, *spaces_s, *filler_s=NULL, **fmts, *fmt=NULL;
     const char *filter;
     static gchar dur_mag_s[3], invl_mag_s[3], invl_prec_s[3], fr_mag_s[3], val_mag_s[3], *invl_fmt, *full_fmt;
-    io_stat_item_t *mit, **stat_cols, *item, **item_in_column;
+    io_stat_item_t **stat_cols, *item;
+    io_stat_cell_t *cell;
     gboolean last_row=FALSE;
     io_stat_t *iot;
     column_width *col_w;
     struct tm * tm_time;
     time_t the_time;
 
-    mit = (io_stat_item_t *)arg;
-    iot = mit->parent;
+    iot = (io_stat_t *)arg;
+    duration = (guint64)((cfile.elapsed_time.secs*1000000) + ((cfile.elapsed_time.nsecs+500)/1000));
+
+    if (iot->csv) {
+        iostat_csv_finish(iot, duration);
+        return;
+    }
+
     num_cols = iot->num_cols;
     col_w = (column_width *)g_malloc(sizeof(column_width) * num_cols);
     fmts = (char **)g_malloc(sizeof(char *) * num_cols);
-    duration = (guint64)((cfile.elapsed_time.secs*1000000) + ((cfile.elapsed_time.nsecs+500)/1000));
 
     /* Store the pointer to each stat column */
     stat_cols = (io_stat_item_t **) g_malloc(sizeof(io_stat_item_t *) * num_cols);
@@ -926,12 +1098,6 @@ iostat_draw(void *arg)
     full_fmt = g_strconcat("| ", invl_fmt, " <> ", invl_fmt, " |", NULL);
     num_rows = (int)(duration/interval) + (((duration%interval+500000)/1000000) > 0 ? 1 : 0);
 
-    /* Load item_in_column with the first item in each column */
-    item_in_column = (io_stat_item_t **) g_malloc(sizeof(io_stat_item_t *) * num_cols);
-    for (j=0; j<num_cols; j++) {
-        item_in_column[j] = stat_cols[j];
-    }
-
     /* Display the table values
     *
     * The outer loop is for time interval rows and the inner loop is for stat column items.*/
@@ -996,19 +1162,22 @@ iostat_draw(void *arg)
         /* Display stat values in each column for this row */
         for (j=0; j<num_cols; j++) {
             fmt = fmts[j];
-            item = item_in_column[j];
+            if ((guint)(i+1) * iot->num_cols <= iot->cells->len)
+                cell = IOSTAT_CELL(iot, i, j);
+            else
+                cell = NULL;
 
-            if (item) {
-                switch(item->calc_type) {
+            if (cell) {
+                switch(stat_cols[j]->calc_type) {
                 case CALC_TYPE_FRAMES:
-                    printf(fmt, item->frames);
+                    printf(fmt, cell->frames);
                     break;
                 case CALC_TYPE_BYTES:
                 case CALC_TYPE_COUNT:
-                    printf(fmt, item->counter);
+                    printf(fmt, cell->counter);
                     break;
                 case CALC_TYPE_FRAMES_AND_BYTES:
-                    printf(fmt, item->frames, item->counter);
+                    printf(fmt, cell->frames, cell->counter);
                     break;
 
                 case CALC_TYPE_SUM:
@@ -1017,40 +1186,40 @@ iostat_draw(void *arg)
                     ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
                     switch(ftype){
                     case FT_FLOAT:
-                        printf(fmt, item->float_counter);
+                        printf(fmt, cell->float_counter);
                         break;
                     case FT_DOUBLE:
-                        printf(fmt, item->double_counter);
+                        printf(fmt, cell->double_counter);
                         break;
                     case FT_RELATIVE_TIME:
-                        item->counter = (item->counter + 500) / 1000;
-                        printf(fmt, (int)(item->counter/1000000), (int)(item->counter%1000000));
+                        cell->counter = (cell->counter + 500) / 1000;
+                        printf(fmt, (int)(cell->counter/1000000), (int)(cell->counter%1000000));
                         break;
                     default:
-                        printf(fmt, item->counter);
+                        printf(fmt, cell->counter);
                         break;
                     }
                     break;
 
                 case CALC_TYPE_AVG:
-                    num = item->num;
+                    num = cell->num;
                     if(num==0)
                         num=1;
                     ftype = proto_registrar_get_ftype(stat_cols[j]->hf_index);
                     switch(ftype){
                     case FT_FLOAT:
-                        printf(fmt, item->float_counter/num);
+                        printf(fmt, cell->float_counter/num);
                         break;
                     case FT_DOUBLE:
-                        printf(fmt, item->double_counter/num);
+                        printf(fmt, cell->double_counter/num);
                         break;
                     case FT_RELATIVE_TIME:
-                        item->counter = ((item->counter/num) + 500) / 1000;
+                        cell->counter = ((cell->counter/num) + 500) / 1000;
                         printf(fmt,
-                            (int)(item->counter/1000000), (int)(item->counter%1000000));
+                            (int)(cell->counter/1000000), (int)(cell->counter%1000000));
                         break;
                     default:
-                        printf(fmt, item->counter/num);
+                        printf(fmt, cell->counter/num);
                         break;
                     }
                     break;
@@ -1061,27 +1230,24 @@ iostat_draw(void *arg)
                     case FT_RELATIVE_TIME:
                         if (!last_row) {
                             printf(fmt,
-                                (int) (item->counter/interval),
-                                (int)((item->counter%interval)*1000000 / interval));
+                                (int) (cell->counter/interval),
+                                (int)((cell->counter%interval)*1000000 / interval));
                         } else {
                             printf(fmt,
-                                (int) (item->counter/(invl_end-t)),
-                                (int)((item->counter%(invl_end-t))*1000000 / (invl_end-t)));
+                                (int) (cell->counter/(invl_end-t)),
+                                (int)((cell->counter%(invl_end-t))*1000000 / (invl_end-t)));
                         }
                         break;
                     }
                     break;
                 }
 
-                if (last_row) {
-                    if (fmt)
-                        g_free(fmt);
-                } else {
-                    item_in_column[j] = item_in_column[j]->next;
-                }
             } else {
                 printf(fmt, (guint64)0, (guint64)0);
             }
+
+            if (last_row && fmt)
+                g_free(fmt);
         }
         if (filler_s)
             printf("%s|", filler_s);
@@ -1093,24 +1259,20 @@ iostat_draw(void *arg)
         printf("=");
     }
     printf("\n");
-    g_free(iot->items);
-    g_free(iot->max_vals);
-    g_free(iot->max_frame);
-    g_free(iot);
+    iostat_free(iot);
     g_free(col_w);
     g_free(invl_fmt);
     g_free(full_fmt);
     g_free(fmts);
     g_free(spaces);
     g_free(stat_cols);
-    g_free(item_in_column);
 }
 
 
+/* Sets up column i; the filter it is left with is compiled into *dfp */
 static void
-register_io_tap(io_stat_t *io, int i, const char *filter)
+register_io_tap(io_stat_t *io, int i, const char *filter, dfilter_t **dfp)
 {
-    GString *error_string;
     const char *flt;
     int j;
     size_t namelen;
@@ -1118,14 +1280,9 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
     char *field;
     header_field_info *hfi;
 
-    io->items[i].prev=&io->items[i];
-    io->items[i].next=NULL;
     io->items[i].parent=io;
-    io->items[i].time=0;
     io->items[i].calc_type=CALC_TYPE_FRAMES_AND_BYTES;
-    io->items[i].frames=0;
-    io->items[i].counter=0;
-    io->items[i].num=0;
+    io->items[i].colnum=i;
 
     io->filters[i]=filter;
     flt=filter;
@@ -1256,41 +1413,43 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
         g_free(field);
     }
 
-    error_string=register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_PROTO_TREE, NULL,
-                                       iostat_packet, i?NULL:iostat_draw);
-    if(error_string){
-        g_free(io->items);
-        g_free(io);
-        fprintf(stderr, "\ntshark: Couldn't register io,stat tap: %s\n",
-            error_string->str);
-        g_string_free(error_string, TRUE);
+    *dfp=NULL;
+    if(flt && !dfilter_compile(flt, dfp)){
+        fprintf(stderr, "\ntshark: Couldn't register io,stat tap: Filter \"%s\" is invalid - %s\n",
+            flt, dfilter_error_msg);
         exit(1);
     }
+    io->items[i].filtered = (*dfp != NULL);
 }
 
 static void
-iostat_init(const char *optarg, void* userdata _U_)
+iostat_init(const char *optarg, void* userdata)
 {
     gdouble interval_float;
     guint32 idx=0, i;
     io_stat_t *io;
     const gchar *filters, *str, *pos;
+    const char *name = (const char *)userdata;   /* "io,stat" or "io,csv" */
+    size_t namelen = strlen(name);
+    dfilter_t **dfs;
+    GString *error_string;
 
     if ((*(optarg+(strlen(optarg)-1)) == ',') ||
-        (sscanf(optarg, "io,stat,%lf%n", &interval_float, (int *)&idx) != 1) ||
-        (idx < 8)) {
-        fprintf(stderr, "\ntshark: invalid \"-z io,stat,<interval>[,<filter>][,<filter>]...\" argument\n");
+        (optarg[namelen] != ',') ||
+        (sscanf(optarg+namelen+1, "%lf%n", &interval_float, (int *)&idx) != 1) ||
+        (idx < 1)) {
+        fprintf(stderr, "\ntshark: invalid \"-z %s,<interval>[,<filter>][,<filter>]...\" argument\n", name);
         exit(1);
     }
 
-    filters=optarg+idx;
+    filters=optarg+namelen+1+idx;
     if (*filters) {
         if (*filters != ',') {
             /* For locale's that use ',' instead of '.', the comma might
              * have been consumed during the floating point conversion. */
             --filters;
             if (*filters != ',') {
-                fprintf(stderr, "\ntshark: invalid \"-z io,stat,<interval>[,<filter>][,<filter>]...\" argument\n");
+                fprintf(stderr, "\ntshark: invalid \"-z %s,<interval>[,<filter>][,<filter>]...\" argument\n", name);
                 exit(1);
             }
         }
@@ -1303,7 +1462,7 @@ iostat_init(const char *optarg, void* userdata _U_)
     case TS_EPOCH:
     case TS_UTC:
     case TS_UTC_WITH_DATE:
-        fprintf(stderr, "\ntshark: invalid -t operand. io,stat only supports -t <r|a|ad>\n");
+        fprintf(stderr, "\ntshark: invalid -t operand. %s only supports -t <r|a|ad>\n", name);
         exit(1);
     default:
         break;
@@ -1346,6 +1505,10 @@ iostat_init(const char *optarg, void* userdata _U_)
         }
     }
 
+    io->csv = (strcmp(name, "io,csv") == 0);
+    io->cells = g_array_new(FALSE, TRUE, sizeof(io_stat_cell_t));
+    io->first_invl = 0;
+    io->matched = g_new0(gboolean, io->num_cols);
     io->items = (io_stat_item_t *) g_malloc(sizeof(io_stat_item_t) * io->num_cols);
     io->filters = (const char **)g_malloc(sizeof(char *) * io->num_cols);
     io->max_vals = (guint64 *) g_malloc(sizeof(guint64) * io->num_cols);
@@ -1356,9 +1519,10 @@ iostat_init(const char *optarg, void* userdata _U_)
         io->max_frame[i] = 0;
     }
 
-    /* Register a tap listener for each filter */
+    /* Set up a column for each filter */
+    dfs = g_new0(dfilter_t *, io->num_cols);
     if((!filters) || (filters[0]==0)) {
-        register_io_tap(io, 0, NULL);
+        register_io_tap(io, 0, NULL, &dfs[0]);
     } else {
         gchar *filter;
         i = 0;
@@ -1366,28 +1530,54 @@ iostat_init(const char *optarg, void* userdata _U_)
         do {
             pos = (gchar*) strchr(str, ',');
             if(pos==str){
-                register_io_tap(io, i, NULL);
+                register_io_tap(io, i, NULL, &dfs[i]);
             } else if (pos==NULL) {
                 str = (const char*) g_strstrip((gchar*)str);
                 filter = g_strdup((gchar*) str);
                 if (*filter)
-                    register_io_tap(io, i, filter);
+                    register_io_tap(io, i, filter, &dfs[i]);
                 else
-                    register_io_tap(io, i, NULL);
+                    register_io_tap(io, i, NULL, &dfs[i]);
             } else {
                 filter = (gchar *)g_malloc((pos-str)+1);
                 g_strlcpy( filter, str, (gsize) ((pos-str)+1));
                 filter = g_strstrip(filter);
-                register_io_tap(io, i, (char *) filter);
+                register_io_tap(io, i, (char *) filter, &dfs[i]);
             }
             str = pos+1;
             i++;
         } while(pos);
     }
+
+    /* The filters of all columns are run as one program, by a single tap
+    *  listener, so that each field is only looked up once per frame. */
+    io->code = NULL;
+    for (i=0; i<io->num_cols; i++) {
+        if (dfs[i]) {
+            io->code = dfilter_combine(dfs, io->num_cols);
+            break;
+        }
+    }
+    g_free(dfs);
+
+    error_string=register_tap_listener("frame", io, NULL, TL_REQUIRES_PROTO_TREE, NULL,
+                                       iostat_packet, iostat_draw);
+    if(error_string){
+        fprintf(stderr, "\ntshark: Couldn't register %s tap: %s\n",
+            name, error_string->str);
+        g_string_free(error_string, TRUE);
+        exit(1);
+    }
+    if (io->code)
+        set_tap_prime_dfilter(io, io->code);
+
+    if (io->csv)
+        iostat_csv_header(io);
 }
 
 void
 register_tap_listener_iostat(void)
 {
-    register_stat_cmd_arg("io,stat,", iostat_init, NULL);
+    register_stat_cmd_arg("io,stat,", iostat_init, (void *)"io,stat");
+    register_stat_cmd_arg("io,csv,", iostat_init, (void *)"io,csv");
 }
@@ -0,0 +1,288 @@
+/* tap-memstat.c
+ * Memory usage statistics for tshark
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module provides "-z mem[,interval]" statistics to tshark: the usage
+ * counters of the emem and wmem pools, how the memory that lives as long as
+ * the capture file grew over time, the memory held by every named se_/pe_
+ * tree, which is usually the quickest way to find the dissector responsible
+ * for a large session footprint, and the incomplete reassemblies held by
+ * every reassembly table.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epan/packet_info.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+#include <epan/emem.h>
+#include <epan/reassemble.h>
+#include <epan/wmem/wmem.h>
+
+/* Day-long captures are the ones this is meant for, so report hourly */
+#define MEMSTAT_DEFAULT_INTERVAL	3600
+
+/* Memory that lives as long as the capture file, after some frame */
+typedef struct _memstat_sample {
+	guint32 frames;
+	gsize   file_scope;
+	gsize   se;
+	gsize   se_trees;
+} memstat_sample;
+
+typedef struct _memstat_t {
+	guint32        interval;	/* seconds */
+	guint32        frames;
+	guint32        cur_interval;	/* index of the interval being filled */
+	memstat_sample last;		/* after the last frame seen */
+	GArray        *samples;		/* memstat_sample at the end of every
+					 * finished interval */
+} memstat_t;
+
+static void
+memstat_take_sample(memstat_t *ms)
+{
+	wmem_allocator_stats_t packet_stats, file_stats, epan_stats;
+	wmem_allocator_stats_t ep_stats, se_stats, se_tree_stats;
+
+	wmem_scopes_get_stats(&packet_stats, &file_stats, &epan_stats);
+	emem_get_stats(&ep_stats, &se_stats, &se_tree_stats);
+
+	ms->last.frames     = ms->frames;
+	ms->last.file_scope = file_stats.in_use_bytes;
+	ms->last.se         = se_stats.in_use_bytes;
+	ms->last.se_trees   = se_tree_stats.in_use_bytes;
+}
+
+static void
+memstat_reset(void *pms)
+{
+	memstat_t *ms = (memstat_t *)pms;
+
+	ms->frames = 0;
+	ms->cur_interval = 0;
+	memset(&ms->last, 0, sizeof(ms->last));
+	g_array_set_size(ms->samples, 0);
+}
+
+static int
+memstat_packet(void *pms, packet_info *pinfo, epan_dissect_t *edt _U_, const void *pri _U_)
+{
+	memstat_t *ms = (memstat_t *)pms;
+	guint32 idx = 0;
+
+	if (pinfo->fd->rel_ts.secs > 0)
+		idx = (guint32)(pinfo->fd->rel_ts.secs / ms->interval);
+
+	/* This frame starts a new interval: the state after the previous
+	 * frame closes the old one (and any empty ones in between) */
+	while (ms->cur_interval < idx) {
+		g_array_append_val(ms->samples, ms->last);
+		ms->cur_interval++;
+	}
+
+	ms->frames++;
+	memstat_take_sample(ms);
+
+	return 1;
+}
+
+static void
+memstat_print_pool(const char *name, const wmem_allocator_stats_t *stats)
+{
+	printf("%-14s %14" G_GSIZE_MODIFIER "u %10u %14" G_GSIZE_MODIFIER "u %11u %8u\n",
+	       name, stats->in_use_bytes, stats->in_use_chunks,
+	       stats->peak_bytes, stats->peak_chunks, stats->free_all_count);
+}
+
+static void
+memstat_collect_tree(const emem_tree_stats_t *stats, void *user_data)
+{
+	g_ptr_array_add((GPtrArray *)user_data, (gpointer)stats);
+}
+
+/* Sort by bytes in use, then by peak, largest first */
+static gint
+memstat_tree_compare(gconstpointer a, gconstpointer b)
+{
+	const emem_tree_stats_t *ta = *(const emem_tree_stats_t * const *)a;
+	const emem_tree_stats_t *tb = *(const emem_tree_stats_t * const *)b;
+
+	if (ta->mem.bytes != tb->mem.bytes)
+		return ta->mem.bytes > tb->mem.bytes ? -1 : 1;
+	if (ta->peak_bytes != tb->peak_bytes)
+		return ta->peak_bytes > tb->peak_bytes ? -1 : 1;
+	return strcmp(ta->name, tb->name);
+}
+
+static void
+memstat_collect_reassembly_table(reassembly_table *table, void *user_data)
+{
+	reassembly_table_stats_t stats;
+
+	reassembly_table_get_stats(table, &stats);
+
+	/* Tables no dissector has added a fragment to have no name */
+	if (stats.name != NULL)
+		g_array_append_val((GArray *)user_data, stats);
+}
+
+/* Sort by bytes held, then by bytes discarded, largest first */
+static gint
+memstat_reassembly_compare(gconstpointer a, gconstpointer b)
+{
+	const reassembly_table_stats_t *ra = (const reassembly_table_stats_t *)a;
+	const reassembly_table_stats_t *rb = (const reassembly_table_stats_t *)b;
+
+	if (ra->bytes != rb->bytes)
+		return ra->bytes > rb->bytes ? -1 : 1;
+	if (ra->evicted_bytes != rb->evicted_bytes)
+		return ra->evicted_bytes > rb->evicted_bytes ? -1 : 1;
+	return strcmp(ra->name, rb->name);
+}
+
+static void
+memstat_draw(void *pms)
+{
+	memstat_t *ms = (memstat_t *)pms;
+	wmem_allocator_stats_t packet_stats, file_stats, epan_stats;
+	wmem_allocator_stats_t ep_stats, se_stats, se_tree_stats;
+	const memstat_sample *sample;
+	const emem_tree_stats_t *tree;
+	const reassembly_table_stats_t *reassembly;
+	GPtrArray *trees;
+	GArray *reassemblies;
+	gsize total, prev_total = 0;
+	guint i;
+
+	wmem_scopes_get_stats(&packet_stats, &file_stats, &epan_stats);
+	emem_get_stats(&ep_stats, &se_stats, &se_tree_stats);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Memory Statistics:\n");
+	printf("\nPool           In use (bytes)     Chunks   Peak (bytes) Peak chunks Releases\n");
+	memstat_print_pool("ep", &ep_stats);
+	memstat_print_pool("se", &se_stats);
+	memstat_print_pool("se trees", &se_tree_stats);
+	memstat_print_pool("packet scope", &packet_stats);
+	memstat_print_pool("file scope", &file_stats);
+	memstat_print_pool("epan scope", &epan_stats);
+
+	/* the interval the last frame was in isn't finished, but report it */
+	g_array_append_val(ms->samples, ms->last);
+
+	printf("\nSession memory (file scope + se + se trees) every %u s:\n", ms->interval);
+	printf("Interval (s)              Frames     File scope             se       se trees          Total         Growth\n");
+	for (i = 0; i < ms->samples->len; i++) {
+		char interval[32];
+
+		sample = &g_array_index(ms->samples, memstat_sample, i);
+		total = sample->file_scope + sample->se + sample->se_trees;
+		g_snprintf(interval, sizeof(interval), "%u-%u",
+			   i * ms->interval, (i + 1) * ms->interval);
+		printf("%-20s %11u %14" G_GSIZE_MODIFIER "u %14" G_GSIZE_MODIFIER "u %14"
+		       G_GSIZE_MODIFIER "u %14" G_GSIZE_MODIFIER "u %+14" G_GINT64_MODIFIER "d\n",
+		       interval, sample->frames, sample->file_scope, sample->se,
+		       sample->se_trees, total, (gint64)total - (gint64)prev_total);
+		prev_total = total;
+	}
+	g_array_set_size(ms->samples, ms->samples->len - 1);
+
+	trees = g_ptr_array_new();
+	emem_tree_stats_foreach(memstat_collect_tree, trees);
+	g_ptr_array_sort(trees, memstat_tree_compare);
+
+	printf("\nTrees by memory in use:\n");
+	printf("Name                                     Scope  Trees       Keys      Nodes    Bytes in use     Peak bytes\n");
+	for (i = 0; i < trees->len; i++) {
+		tree = (const emem_tree_stats_t *)g_ptr_array_index(trees, i);
+		printf("%-40s %-5s %6u %10u %10u %15" G_GSIZE_MODIFIER "u %14" G_GSIZE_MODIFIER "u\n",
+		       tree->name, tree->persistent ? "pe" : "se", tree->trees,
+		       tree->mem.keys, tree->mem.nodes, tree->mem.bytes,
+		       tree->peak_bytes);
+	}
+
+	reassemblies = g_array_new(FALSE, FALSE, sizeof(reassembly_table_stats_t));
+	reassembly_table_foreach(memstat_collect_reassembly_table, reassemblies);
+	g_array_sort(reassemblies, memstat_reassembly_compare);
+
+	printf("\nReassembly tables by memory held by incomplete reassemblies:\n");
+	printf("Name                                 Incomplete   Bytes held  Discarded Discarded bytes\n");
+	for (i = 0; i < reassemblies->len; i++) {
+		reassembly = &g_array_index(reassemblies, reassembly_table_stats_t, i);
+		printf("%-36s %10u %12" G_GSIZE_MODIFIER "u %10u %15" G_GINT64_MODIFIER "u\n",
+		       reassembly->name, reassembly->live, reassembly->bytes,
+		       reassembly->evicted, reassembly->evicted_bytes);
+	}
+	printf("===================================================================\n");
+
+	g_ptr_array_free(trees, TRUE);
+	g_array_free(reassemblies, TRUE);
+}
+
+static void
+memstat_init(const char *optarg, void *userdata _U_)
+{
+	memstat_t *ms;
+	guint interval = MEMSTAT_DEFAULT_INTERVAL;
+	int pos = 0;
+	GString *error_string;
+
+	if (strcmp("mem", optarg) == 0) {
+		/* No arguments */
+	} else if (sscanf(optarg, "mem,%u%n", &interval, &pos) != 1 ||
+		   optarg[pos] != '\0' || interval == 0) {
+		fprintf(stderr, "tshark: invalid \"-z mem[,<interval>]\" argument\n");
+		exit(1);
+	}
+
+	ms = g_new0(memstat_t, 1);
+	ms->interval = interval;
+	ms->samples = g_array_new(FALSE, FALSE, sizeof(memstat_sample));
+
+	error_string = register_tap_listener("frame", ms, NULL, TL_REQUIRES_NOTHING,
+					     memstat_reset,
+					     memstat_packet,
+					     memstat_draw);
+	if (error_string) {
+		/* error, we failed to attach to the tap. clean up */
+		g_array_free(ms->samples, TRUE);
+		g_free(ms);
+
+		fprintf(stderr, "tshark: Couldn't register mem tap: %s\n",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+void
+register_tap_listener_memstat(void)
+{
+	register_stat_cmd_arg("mem", memstat_init, NULL);
+}
@@ -53,6 +53,8 @@ draw_stats_tree(void *psp)
 	gchar *fmt;
 	stat_node *child;
 	
+	stats_tree_merge_counts(st);
+
 	s = g_string_new("\n===================================================================\n");
 	fmt = g_strdup_printf(" %%s%%-%us%%12s\t%%12s\t%%12s\n",stats_tree_branch_max_namelen(&st->root,0));
 	g_string_append_printf(s,fmt,"",st->cfg->name,"value","rate","percent");
@@ -7,9 +7,11 @@ void register_all_tap_listeners(void) {
   {extern void register_tap_listener_ansi_astat (void); register_tap_listener_ansi_astat ();}
   {extern void register_tap_listener_camelcounter (void); register_tap_listener_camelcounter ();}
   {extern void register_tap_listener_camelsrt (void); register_tap_listener_camelsrt ();}
+  {extern void register_tap_listener_cdapstat (void); register_tap_listener_cdapstat ();}
   {extern void register_tap_listener_comparestat (void); register_tap_listener_comparestat ();}
   {extern void register_tap_listener_dcerpcstat (void); register_tap_listener_dcerpcstat ();}
   {extern void register_tap_listener_diameteravp (void); register_tap_listener_diameteravp ();}
+  {extern void register_tap_listener_efcpstat (void); register_tap_listener_efcpstat ();}
   {extern void register_tap_listener_expert_info (void); register_tap_listener_expert_info ();}
   {extern void register_tap_listener_follow (void); register_tap_listener_follow ();}
   {extern void register_tap_listener_gsm_astat (void); register_tap_listener_gsm_astat ();}
@@ -26,6 +28,7 @@ void register_all_tap_listeners(void) {
   {extern void register_tap_listener_iousers (void); register_tap_listener_iousers ();}
   {extern void register_tap_listener_mac_lte_stat (void); register_tap_listener_mac_lte_stat ();}
   {extern void register_tap_listener_megacostat (void); register_tap_listener_megacostat ();}
+  {extern void register_tap_listener_memstat (void); register_tap_listener_memstat ();}
   {extern void register_tap_listener_mgcpstat (void); register_tap_listener_mgcpstat ();}
   {extern void register_tap_listener_protocolinfo (void); register_tap_listener_protocolinfo ();}
   {extern void register_tap_listener_protohierstat (void); register_tap_listener_protohierstat ();}
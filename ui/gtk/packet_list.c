@@ -1657,7 +1657,7 @@ packet_list_get_packet_comment(void)
 
 	fdata = packet_list_get_record(model, &iter);
 
-	return fdata->opt_comment;
+	return frame_data_get_comment(fdata);
 }
 
 void
@@ -1669,8 +1669,8 @@ packet_list_return_all_comments(GtkTextBuffer *buffer)
 
 	for (framenum = 1; framenum <= cfile.count ; framenum++) {
 		fdata = frame_data_sequence_find(cfile.frames, framenum);
-		if (fdata->opt_comment) {
-			buf_str = g_strdup_printf("Frame %u: %s \n\n",framenum, fdata->opt_comment);
+		if (frame_data_get_comment(fdata)) {
+			buf_str = g_strdup_printf("Frame %u: %s \n\n",framenum, frame_data_get_comment(fdata));
 			gtk_text_buffer_insert_at_cursor (buffer, buf_str, -1);
 			g_free(buf_str);
 		}
@@ -1700,8 +1700,8 @@ packet_list_update_packet_comment(gchar *new_packet_comment)
 	fdata = packet_list_get_record(model, &iter);
 
 	/* Check if the comment has changed */
-	if (fdata->opt_comment) {
-		if (strcmp(fdata->opt_comment, new_packet_comment) == 0) {
+	if (frame_data_get_comment(fdata)) {
+		if (strcmp(frame_data_get_comment(fdata), new_packet_comment) == 0) {
 			g_free(new_packet_comment);
 			return;
 		}
@@ -1765,11 +1765,28 @@ packet_list_get_widget(void)
 	return packetlist->view;
 }
 
+/* Runs once the packet list has been redrawn after packet_list_colorize_packets() */
+static gboolean
+colorize_stats_cb(gpointer data _U_)
+{
+	guint packets, rules;
+	gdouble seconds;
+
+	color_filters_get_stats(&packets, &rules, &seconds);
+	if (packets > 0)
+		statusbar_push_temporary_msg("Colorized %u packets with %u coloring rules in %.1f ms",
+			packets, rules, seconds * 1000.0);
+	return FALSE;
+}
+
 void
 packet_list_colorize_packets(void)
 {
 	packet_list_reset_colorized(packetlist);
+	/* Rows are only colorized again when they are drawn */
+	color_filters_reset_stats();
 	gtk_widget_queue_draw (packetlist->view);
+	g_idle_add(colorize_stats_cb, NULL);
 }
 
 static gboolean
@@ -1798,8 +1815,8 @@ query_packet_list_tooltip_cb(GtkWidget *widget, gint x, gint y, gboolean keyboar
 		}
 
 		fdata = packet_list_get_record(model, &iter);
-		if (fdata->opt_comment != NULL) {
-			gtk_tooltip_set_markup (tooltip, fdata->opt_comment);
+		if (frame_data_get_comment(fdata) != NULL) {
+			gtk_tooltip_set_markup (tooltip, frame_data_get_comment(fdata));
 			renderer_list = gtk_cell_layout_get_cells(GTK_CELL_LAYOUT(column));
 			/* get the first renderer */
 			if (g_list_first(renderer_list)) {
@@ -123,6 +123,8 @@ draw_gtk_tree(void *psp)
 	stats_tree *st = (stats_tree *)psp;
 	stat_node* child;
 
+	stats_tree_merge_counts(st);
+
 	for (child = st->root.children; child; child = child->next ) {
 		draw_gtk_node(child);
 
@@ -623,7 +623,7 @@ QString PacketList::packetComment()
 
     if (!fdata) return NULL;
 
-    return QString(fdata->opt_comment);
+    return QString(frame_data_get_comment(fdata));
 }
 
 void PacketList::setPacketComment(QString new_comment)
@@ -639,8 +639,8 @@ void PacketList::setPacketComment(QString new_comment)
     if (!fdata) return;
 
     /* Check if the comment has changed */
-    if (fdata->opt_comment) {
-        if (strcmp(fdata->opt_comment, new_packet_comment) == 0) {
+    if (frame_data_get_comment(fdata)) {
+        if (strcmp(frame_data_get_comment(fdata), new_packet_comment) == 0) {
             return;
         }
     }
@@ -666,8 +666,8 @@ QString PacketList::allPacketComments()
 
     for (framenum = 1; framenum <= cap_file_->count ; framenum++) {
         fdata = frame_data_sequence_find(cap_file_->frames, framenum);
-        if (fdata->opt_comment) {
-            buf_str.append(QString(tr("Frame %1: %2 \n\n")).arg(framenum).arg(fdata->opt_comment));
+        if (frame_data_get_comment(fdata)) {
+            buf_str.append(QString(tr("Frame %1: %2 \n\n")).arg(framenum).arg(frame_data_get_comment(fdata)));
         }
         if (buf_str.length() > max_comments_to_fetch_) {
             buf_str.append(QString(tr("[ Comment text exceeds %1. Stopping. ]"))
@@ -85,12 +85,11 @@ static void
 modify_time_perform(frame_data *fd, int neg, nstime_t *offset, int settozero)
 {
   static frame_data *first_packet = NULL;
-  static nstime_t nulltime;
+  nstime_t shift_offset;
 
   /* Only for initializing */
   if (offset == NULL) {
     first_packet = fd;
-    nulltime.secs = nulltime.nsecs = 0;
     return;
   }
   if (first_packet == NULL) {
@@ -100,20 +99,22 @@ modify_time_perform(frame_data *fd, int neg, nstime_t *offset, int settozero)
 
   /* The actual shift */
 
+  frame_data_get_shift_offset(fd, &shift_offset);
   if (settozero == SHIFT_SETTOZERO) {
-    nstime_subtract(&(fd->abs_ts), &(fd->shift_offset));
-    nstime_copy(&(fd->shift_offset), &nulltime);
+    nstime_subtract(&(fd->abs_ts), &shift_offset);
+    nstime_set_zero(&shift_offset);
   }
 
   if (neg == SHIFT_POS) {
     nstime_add(&(fd->abs_ts), offset);
-    nstime_add(&(fd->shift_offset), offset);
+    nstime_add(&shift_offset, offset);
   } else if (neg == SHIFT_NEG) {
     nstime_subtract(&(fd->abs_ts), offset);
-    nstime_subtract(&(fd->shift_offset), offset);
+    nstime_subtract(&shift_offset, offset);
   } else {
     fprintf(stderr, "Modify_time_perform: neg = %d?\n", neg);
   }
+  frame_data_set_shift_offset(fd, &shift_offset);
 
   /*
    * rel_ts     - Relative timestamp to first packet
@@ -122,7 +123,7 @@ modify_time_perform(frame_data *fd, int neg, nstime_t *offset, int settozero)
     nstime_copy(&(fd->rel_ts), &(fd->abs_ts));
     nstime_subtract(&(fd->rel_ts), &(first_packet->abs_ts));
   } else
-    nstime_copy(&(fd->rel_ts), &nulltime);
+    nstime_set_zero(&(fd->rel_ts));
 }
 
 /*
@@ -350,7 +351,7 @@ time_shift_all(capture_file *cf, const gchar *offset_text)
 const gchar *
 time_shift_settime(capture_file *cf, guint packet_num, const gchar *time_text)
 {
-    nstime_t	set_time, diff_time, packet_time;
+    nstime_t	set_time, diff_time, packet_time, shift_offset;
     frame_data	*fd, *packetfd;
     guint32	i;
     const gchar *err_str;
@@ -367,7 +368,8 @@ time_shift_settime(capture_file *cf, guint packet_num, const gchar *time_text)
      */
     if ((packetfd = frame_data_sequence_find(cf->frames, packet_num)) == NULL)
         return "No packets found.";
-    nstime_delta(&packet_time, &(packetfd->abs_ts), &(packetfd->shift_offset));
+    frame_data_get_shift_offset(packetfd, &shift_offset);
+    nstime_delta(&packet_time, &(packetfd->abs_ts), &shift_offset);
 
     if ((err_str = time_string_to_nstime(time_text, &packet_time, &set_time)) != NULL)
         return err_str;
@@ -396,7 +398,7 @@ const gchar *
 time_shift_adjtime(capture_file *cf, guint packet1_num, const gchar *time1_text, guint packet2_num, const gchar *time2_text)
 {
     nstime_t	nt1, nt2, ot1, ot2, nt3;
-    nstime_t	dnt, dot, d3t;
+    nstime_t	dnt, dot, d3t, shift_offset;
     frame_data	*fd, *packet1fd, *packet2fd;
     guint32	i;
     const gchar *err_str;
@@ -427,7 +429,8 @@ time_shift_adjtime(capture_file *cf, guint packet1_num, const gchar *time1_text,
     if ((packet1fd = frame_data_sequence_find(cf->frames, packet1_num)) == NULL)
         return "No frames found.";
     nstime_copy(&ot1, &(packet1fd->abs_ts));
-    nstime_subtract(&ot1, &(packet1fd->shift_offset));
+    frame_data_get_shift_offset(packet1fd, &shift_offset);
+    nstime_subtract(&ot1, &shift_offset);
 
     if ((err_str = time_string_to_nstime(time1_text, &ot1, &nt1)) != NULL)
         return err_str;
@@ -439,7 +442,8 @@ time_shift_adjtime(capture_file *cf, guint packet1_num, const gchar *time1_text,
     if ((packet2fd = frame_data_sequence_find(cf->frames, packet2_num)) == NULL)
         return "No frames found.";
     nstime_copy(&ot2, &(packet2fd->abs_ts));
-    nstime_subtract(&ot2, &(packet2fd->shift_offset));
+    frame_data_get_shift_offset(packet2fd, &shift_offset);
+    nstime_subtract(&ot2, &shift_offset);
 
     if ((err_str = time_string_to_nstime(time2_text, &ot2, &nt2)) != NULL)
         return err_str;
@@ -460,8 +464,10 @@ time_shift_adjtime(capture_file *cf, guint packet1_num, const gchar *time1_text,
             continue;	/* Shouldn't happen */
 
         /* Set everything back to the original time */
-        nstime_subtract(&(fd->abs_ts), &(fd->shift_offset));
-        nstime_set_zero(&(fd->shift_offset));
+        frame_data_get_shift_offset(fd, &shift_offset);
+        nstime_subtract(&(fd->abs_ts), &shift_offset);
+        nstime_set_zero(&shift_offset);
+        frame_data_set_shift_offset(fd, &shift_offset);
 
         /* Add the difference to each packet */
         calcNT3(&ot1, &(fd->abs_ts), &nt1, &nt3, &dot, &dnt);
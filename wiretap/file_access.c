@@ -189,15 +189,19 @@ static GArray* open_routines_arr = NULL;
 
 
 /* initialize the open routines array if it has not been initialized yet */
+/* Files may be opened in several threads at once (capinfos -j) */
 static void init_open_routines(void) {
+	static volatile gsize initialized = 0;
 
-	if (open_routines_arr) return;
+	if (!g_once_init_enter(&initialized)) return;
 
 	open_routines_arr = g_array_new(FALSE,TRUE,sizeof(wtap_open_routine_t));
 
 	g_array_append_vals(open_routines_arr,open_routines_base,N_FILE_TYPES);
 
 	open_routines = (wtap_open_routine_t*)(void *)open_routines_arr->data;
+
+	g_once_init_leave(&initialized, 1);
 }
 
 void wtap_register_open_routine(wtap_open_routine_t open_routine, gboolean has_magic) {
@@ -368,6 +372,26 @@ wtap* wtap_open_offline(const char *filename, int *err, char **err_info,
 		file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
 	}
 
+	if (!use_stdin) {
+		/*
+		 * If asked to, save the seek points for a compressed
+		 * file next to it once it's been read through, so the
+		 * next open has random access to it right away; use
+		 * any such saved seek points now.
+		 */
+		gboolean save_index = getenv("WIRESHARK_GZIP_INDEX") != NULL;
+
+		if (save_index && wth->fast_seek == NULL) {
+			wth->fast_seek = g_ptr_array_new();
+			file_set_random_access(wth->fh, FALSE, wth->fast_seek);
+		}
+		if (wth->fast_seek != NULL)
+			file_set_index(wth->fh, filename, save_index);
+
+		/* decompress ahead of the reader in another thread */
+		file_set_read_ahead(wth->fh);
+	}
+
 	/* Try all file types */
 	for (i = 0; i < open_routines_arr->len; i++) {
 		/* Seek back to the beginning of the file; the open routine
@@ -434,6 +458,7 @@ success:
 		g_array_append_val(wth->interface_data, descr);
 
 	}
+
 	return wth;
 }
 
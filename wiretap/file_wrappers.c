@@ -53,6 +53,9 @@
 #include <fcntl.h>
 #endif /* HAVE_FCNTL_H */
 #include <string.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif /* HAVE_MMAP */
 #include "wtap-int.h"
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
@@ -147,12 +150,37 @@ struct wtap_reader {
 	/* fast seeking */
 	GPtrArray *fast_seek;
 	void *fast_seek_cur;
+	gboolean fast_seek_private; /* TRUE if fast_seek is our own, for seeking back while reading ahead */
+	char *index_path;          /* seek point sidecar, or NULL */
+	gboolean index_save;       /* TRUE to write the sidecar on close if it wasn't loaded */
+	gboolean index_complete;   /* TRUE if the seek points cover the whole file */
+	/* read-ahead decompression */
+	gboolean read_ahead;       /* TRUE if we may decompress in another thread */
+	gint64 read_ahead_pos;     /* don't start that thread before this position */
+	struct read_ahead *ra;     /* read-ahead state, NULL if the thread isn't running */
+	/* memory-mapped access to an uncompressed file */
+	guint8 *map;               /* mapping of the whole file, or NULL */
+	gint64 map_len;            /* size of the mapping */
+	gboolean mapped;           /* TRUE if reading from the mapping, at pos */
+	/* raw data tap */
+	wtap_raw_tap_func raw_tap; /* gets all of the raw file once, in order, or NULL */
+	void *raw_tap_data;        /* user data for raw_tap */
+	gint64 raw_tap_pos;        /* amount of the file handed to raw_tap so far */
+	int raw_tap_err;           /* error reading data for raw_tap */
 };
 
+#define RAW_TAP_CHUNK	(1024 * 1024)	/* most handed to the raw tap at once */
+
+static void raw_tap_catch_up(FILE_T state, gint64 end);
+#ifdef HAVE_LIBZ
+static gboolean fast_seek_load(FILE_T file, const char *index_path);
+#endif
+
 static int	/* gz_load */
 raw_read(FILE_T state, unsigned char *buf, unsigned int count, guint *have)
 {
 	ssize_t ret;
+	gint64 start = state->raw_pos;
 
 	*have = 0;
 	do {
@@ -162,6 +190,17 @@ raw_read(FILE_T state, unsigned char *buf, unsigned int count, guint *have)
 		*have += (unsigned)ret;
 		state->raw_pos += ret;
 	} while (*have < count);
+	if (state->raw_tap != NULL && state->raw_pos > state->raw_tap_pos) {
+		/* anything skipped by a seek first, then what we just read */
+		if (start > state->raw_tap_pos)
+			raw_tap_catch_up(state, start);
+		if (!state->raw_tap_err) {
+			guint done = (guint)(state->raw_tap_pos - start);
+
+			state->raw_tap(buf + done, *have - done, state->raw_tap_data);
+			state->raw_tap_pos = state->raw_pos;
+		}
+	}
 	if (ret < 0) {
 		state->err = errno;
 		state->err_info = NULL;
@@ -213,6 +252,30 @@ struct zlib_cur_seek_point {
 };
 
 #define SPAN G_GINT64_CONSTANT(1048576)
+
+/* Seek points kept in a private array, besides the one after the gzip
+   header; enough for the backward seeks of a sequential reader */
+#define PRIVATE_SEEK_POINTS	16
+
+/*
+ * The seek points are shared between the sequential and the random
+ * access stream, and the sequential one may be adding points from its
+ * read-ahead thread while the random one looks them up.  Points are
+ * never modified or removed once added, so only the array itself
+ * needs the lock.  (A private array isn't shared, and only looked at
+ * once the read-ahead thread has stopped, so its oldest points can be
+ * dropped.)
+ */
+#if GLIB_CHECK_VERSION(2,31,0)
+static GMutex fast_seek_mtx;
+#define FAST_SEEK_LOCK()	g_mutex_lock(&fast_seek_mtx)
+#define FAST_SEEK_UNLOCK()	g_mutex_unlock(&fast_seek_mtx)
+#else
+static GStaticMutex fast_seek_mtx = G_STATIC_MUTEX_INIT;
+#define FAST_SEEK_LOCK()	g_static_mutex_lock(&fast_seek_mtx)
+#define FAST_SEEK_UNLOCK()	g_static_mutex_unlock(&fast_seek_mtx)
+#endif
+
 static struct fast_seek_point *
 fast_seek_find(FILE_T file, gint64 pos)
 {
@@ -223,6 +286,7 @@ fast_seek_find(FILE_T file, gint64 pos)
 	if (!file->fast_seek)
 		return NULL;
 
+	FAST_SEEK_LOCK();
 	for (low = 0, max = file->fast_seek->len; low < max; ) {
 		i = (low + max) / 2;
 		item = (struct fast_seek_point *)file->fast_seek->pdata[i];
@@ -233,9 +297,11 @@ fast_seek_find(FILE_T file, gint64 pos)
 			smallest = item;
 			low = i + 1;
 		} else {
-			return item;
+			smallest = item;
+			break;
 		}
 	}
+	FAST_SEEK_UNLOCK();
 	return smallest;
 }
 
@@ -245,6 +311,7 @@ fast_seek_header(FILE_T file, gint64 in_pos, gint64 out_pos,
 {
 	struct fast_seek_point *item = NULL;
 
+	FAST_SEEK_LOCK();
 	if (file->fast_seek->len != 0)
 		item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
 
@@ -256,6 +323,7 @@ fast_seek_header(FILE_T file, gint64 in_pos, gint64 out_pos,
 
 		g_ptr_array_add(file->fast_seek, val);
 	}
+	FAST_SEEK_UNLOCK();
 }
 
 static void
@@ -402,14 +470,17 @@ gz_skipzstr(FILE_T state)
 static void
 zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gint64 in_pos, gint64 out_pos)
 {
-	/* it's for sure after gzip header, so file->fast_seek->len != 0 */
-	struct fast_seek_point *item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+	struct fast_seek_point *item;
 
 #ifndef HAVE_INFLATEPRIME
 	if (bits)
 		return;
 #endif
 
+	FAST_SEEK_LOCK();
+	/* it's for sure after gzip header, so file->fast_seek->len != 0 */
+	item = (struct fast_seek_point *)file->fast_seek->pdata[file->fast_seek->len - 1];
+
 	/* Glib has got Balanced Binary Trees (GTree) but I couldn't find a way to do quick search for nearest (and smaller) value to seek (It's what fast_seek_find() do)
 	 *      Inserting value in middle of sorted array is expensive, so we want to add only in the end.
 	 *      It's not big deal, cause first-read don't usually invoke seeking
@@ -446,7 +517,11 @@ zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gin
 		val->data.zlib.adler = (guint32) file->strm.adler;
 		val->data.zlib.total_out = (guint32) file->strm.total_out;
 		g_ptr_array_add(file->fast_seek, val);
+
+		if (file->fast_seek_private && file->fast_seek->len > PRIVATE_SEEK_POINTS + 1)
+			g_free(g_ptr_array_remove_index(file->fast_seek, 1));
 	}
+	FAST_SEEK_UNLOCK();
 }
 
 static void /* gz_decomp */
@@ -667,6 +742,10 @@ gz_head(FILE_T state)
 			state->strm.adler = crc32(0L, Z_NULL, 0);
 			state->compression = ZLIB;
 			state->is_compressed = TRUE;
+			/* only compressed files have a sidecar */
+			if (state->index_path && state->fast_seek->len == 0 &&
+			    fast_seek_load(state, state->index_path))
+				state->index_save = FALSE;
 #ifdef Z_BLOCK
 			if (state->fast_seek) {
 				struct zlib_cur_seek_point *cur = g_new(struct zlib_cur_seek_point,1);
@@ -692,6 +771,10 @@ gz_head(FILE_T state)
 #endif
 	if (state->fast_seek)
 		fast_seek_header(state, state->raw_pos - state->avail_in - state->have, state->pos, UNCOMPRESSED);
+	if (state->index_path && !state->is_compressed) {
+		g_free(state->index_path);
+		state->index_path = NULL;
+	}
 
 	/* doing raw i/o, save start of raw data for seeking, copy any leftover
 	   input to output -- this assumes that the output buffer is larger than
@@ -726,6 +809,10 @@ fill_out_buffer(FILE_T state)
 		zlib_read(state, state->out, state->size << 1);
 	}
 #endif
+	/* the seek points are complete once we've read through to the end */
+	if (state->index_path && state->eof && state->avail_in == 0 &&
+	    state->have == 0 && state->err == 0)
+		state->index_complete = TRUE;
 	return 0;
 }
 
@@ -798,6 +885,19 @@ file_fdopen(int fd)
 
 	state->fast_seek_cur = NULL;
 	state->fast_seek = NULL;
+	state->fast_seek_private = FALSE;
+	state->index_path = NULL;
+	state->index_save = FALSE;
+	state->index_complete = FALSE;
+	state->read_ahead = FALSE;
+	state->ra = NULL;
+	state->map = NULL;
+	state->map_len = 0;
+	state->mapped = FALSE;
+	state->raw_tap = NULL;
+	state->raw_tap_data = NULL;
+	state->raw_tap_pos = 0;
+	state->raw_tap_err = 0;
 
 	/* open the file with the appropriate mode (or just use fd) */
 	state->fd = fd;
@@ -854,6 +954,167 @@ file_fdopen(int fd)
 	return state;
 }
 
+#ifdef HAVE_MMAP
+/*
+ * Uncompressed regular files are read through a mapping of the whole
+ * file, so that reads and seeks don't need system calls or a copy
+ * through our own buffers, and so that file_read_map() can hand out
+ * pointers to the data where it is.
+ *
+ * The mapping is private and writable, so that callers can modify
+ * data they got from file_read_map() without it ending up in the file.
+ *
+ * Reading past the end of the mapping, as happens when reading a file
+ * that is still being written, stops using the mapping and goes back
+ * to reading the file; the mapping is kept until the file is closed,
+ * as pointers into it may still be in use.
+ */
+static void
+file_map(FILE_T state)
+{
+	ws_statb64 statb;
+	void *map;
+
+	if (ws_fstat64(state->fd, &statb) == -1 || !S_ISREG(statb.st_mode) ||
+	    statb.st_size < 2 || (guint64)statb.st_size > G_MAXSIZE)
+		return;
+	map = mmap(NULL, (size_t)statb.st_size, PROT_READ|PROT_WRITE,
+	    MAP_PRIVATE, state->fd, 0);
+	if (map == MAP_FAILED)
+		return;
+#ifdef HAVE_LIBZ
+	/* compressed files are read the usual way */
+	if (((guint8 *)map)[0] == 31 && ((guint8 *)map)[1] == 139) {
+		munmap(map, (size_t)statb.st_size);
+		return;
+	}
+#endif
+	state->map = (guint8 *)map;
+	state->map_len = statb.st_size;
+	state->mapped = TRUE;
+	state->compression = UNCOMPRESSED;
+	state->raw = 0;
+}
+
+/* Stop reading from the mapping, and read the file from where we are. */
+static void
+file_unmap(FILE_T state)
+{
+	state->mapped = FALSE;
+	if (ws_lseek64(state->fd, state->pos, SEEK_SET) == -1) {
+		state->err = errno;
+		state->err_info = NULL;
+	}
+	state->raw_pos = state->pos;
+	state->next = state->out;
+	state->have = 0;
+	state->avail_in = 0;
+	state->eof = FALSE;
+}
+#endif /* HAVE_MMAP */
+
+/*
+ * If the stream is reading from a mapping of the file and there are len
+ * bytes at the current position, return a pointer to them and move past
+ * them; otherwise return NULL without moving, and the caller should use
+ * file_read().  The data stays valid until the stream is closed.
+ */
+guint8 *
+file_read_map(FILE_T file, unsigned int len)
+{
+	guint8 *data;
+
+	if (!file->mapped || file->pos + len > file->map_len)
+		return NULL;
+	data = file->map + file->pos;
+	file->pos += len;
+	if (file->raw_tap != NULL && file->pos >= file->raw_tap_pos + RAW_TAP_CHUNK)
+		raw_tap_catch_up(file, file->pos);
+	return data;
+}
+
+/*
+ * Raw data tap.
+ *
+ * The tap is handed all of the (still compressed) file exactly once and
+ * in order, from the buffers it is read into, so that something like a
+ * hash of the file can be computed while it's read, without reading it
+ * a second time.  Data before the tap was set, and data that a seek
+ * skipped over, is read again from the file (or taken from the mapping)
+ * when the tap gets to it; data read again after seeking back is not
+ * handed to the tap twice.
+ */
+void
+file_set_raw_tap(FILE_T stream, wtap_raw_tap_func func, void *user_data)
+{
+	stream->raw_tap = func;
+	stream->raw_tap_data = user_data;
+	stream->raw_tap_pos = stream->start;
+	stream->raw_tap_err = 0;
+}
+
+/*
+ * Hand the file from where the tap got to up to end, or up to the end of
+ * the file if end is -1, to the tap.  Data is taken from the mapping if
+ * there is one, and read with the file descriptor otherwise; the file
+ * offset is put back afterwards.
+ */
+static void
+raw_tap_catch_up(FILE_T state, gint64 end)
+{
+	unsigned char *buf = NULL;
+	gboolean moved = FALSE;
+	ssize_t ret;
+	guint n;
+
+	while (!state->raw_tap_err && (end == -1 || state->raw_tap_pos < end)) {
+#ifdef HAVE_MMAP
+		if (state->map != NULL && state->raw_tap_pos < state->map_len) {
+			gint64 left = (end == -1 || end > state->map_len ?
+			    state->map_len : end) - state->raw_tap_pos;
+
+			n = left > RAW_TAP_CHUNK ? RAW_TAP_CHUNK : (guint)left;
+			state->raw_tap(state->map + state->raw_tap_pos, n, state->raw_tap_data);
+			state->raw_tap_pos += n;
+			continue;
+		}
+#endif
+		if (buf == NULL) {
+			/* on a pipe we're already there, and can't seek */
+			if (state->raw_tap_pos != state->raw_pos) {
+				if (ws_lseek64(state->fd, state->raw_tap_pos, SEEK_SET) == -1) {
+					state->raw_tap_err = errno;
+					break;
+				}
+				moved = TRUE;
+			}
+			buf = (unsigned char *)g_malloc(RAW_TAP_CHUNK);
+		}
+		n = RAW_TAP_CHUNK;
+		if (end != -1 && end - state->raw_tap_pos < RAW_TAP_CHUNK)
+			n = (guint)(end - state->raw_tap_pos);
+		ret = read(state->fd, buf, n);
+		if (ret < 0) {
+			state->raw_tap_err = errno;
+			break;
+		}
+		if (ret == 0) {
+			/* the file got shorter? */
+			if (end != -1)
+				state->raw_tap_err = WTAP_ERR_SHORT_READ;
+			break;
+		}
+		state->raw_tap(buf, (guint)ret, state->raw_tap_data);
+		state->raw_tap_pos += ret;
+	}
+
+	if (moved && ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+		state->err = errno;
+		state->err_info = NULL;
+	}
+	g_free(buf);
+}
+
 FILE_T
 file_open(const char *path)
 {
@@ -903,6 +1164,10 @@ file_open(const char *path)
 	}
 #endif
 
+#ifdef HAVE_MMAP
+	file_map(ft);
+#endif
+
 	return ft;
 }
 
@@ -912,6 +1177,615 @@ file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
 	stream->fast_seek = seek;
 }
 
+#ifdef HAVE_LIBZ
+/*
+ * Seek point sidecar.
+ *
+ * The seek points for a compressed file are only known after reading
+ * all of it once.  They can be saved next to the file, so that the next
+ * time it's opened, random access is available right away.  The sidecar
+ * records the size and modification time of the file it was built from
+ * and is ignored if they don't match.
+ *
+ * All values are little-endian; the 32K windows are stored deflated.
+ */
+#define INDEX_SUFFIX	".gzidx"
+#define INDEX_MAGIC	"WTGZIDX1"
+#define INDEX_HDR_LEN	28	/* magic, number of points, file size, mtime */
+#define INDEX_POINT_LEN	36	/* out, in, compression, bits, adler, total_out, window length */
+
+static gboolean
+fast_seek_load(FILE_T file, const char *index_path)
+{
+	ws_statb64 statb;
+	FILE *fp;
+	guint8 hdr[INDEX_HDR_LEN];
+	guint8 rec[INDEX_POINT_LEN];
+	unsigned char *zwin;
+	uLong zwin_size;
+	uLongf win_len;
+	guint32 count, i, zlen;
+	struct fast_seek_point *val, *prev = NULL;
+	GPtrArray *points;
+	gboolean ok = FALSE;
+
+	if (ws_fstat64(file->fd, &statb) == -1)
+		return FALSE;
+	if ((fp = ws_fopen(index_path, "rb")) == NULL)
+		return FALSE;
+
+	if (fread(hdr, 1, INDEX_HDR_LEN, fp) != INDEX_HDR_LEN ||
+	    memcmp(hdr, INDEX_MAGIC, 8) != 0 ||
+	    pletohll(&hdr[12]) != (guint64)statb.st_size ||
+	    pletohll(&hdr[20]) != (guint64)statb.st_mtime) {
+		fclose(fp);
+		return FALSE;
+	}
+	count = pletohl(&hdr[8]);
+
+	zwin_size = compressBound(ZLIB_WINSIZE);
+	zwin = (unsigned char *)g_malloc(zwin_size);
+	points = g_ptr_array_new();
+	for (i = 0; i < count; i++) {
+		if (fread(rec, 1, INDEX_POINT_LEN, fp) != INDEX_POINT_LEN)
+			goto done;
+		val = g_new(struct fast_seek_point, 1);
+		g_ptr_array_add(points, val);
+		val->out = (gint64)pletohll(&rec[0]);
+		val->in = (gint64)pletohll(&rec[8]);
+		switch (pletohl(&rec[16])) {
+
+		case UNCOMPRESSED:
+			val->compression = UNCOMPRESSED;
+			break;
+
+		case GZIP_AFTER_HEADER:
+			val->compression = GZIP_AFTER_HEADER;
+			break;
+
+		case ZLIB:
+			val->compression = ZLIB;
+#ifdef HAVE_INFLATEPRIME
+			val->data.zlib.bits = pletohl(&rec[20]);
+#else
+			if (pletohl(&rec[20]) != 0)
+				goto done;
+#endif
+			val->data.zlib.adler = pletohl(&rec[24]);
+			val->data.zlib.total_out = pletohl(&rec[28]);
+			zlen = pletohl(&rec[32]);
+			if (zlen > zwin_size || fread(zwin, 1, zlen, fp) != zlen)
+				goto done;
+			win_len = ZLIB_WINSIZE;
+			if (uncompress(val->data.zlib.window, &win_len, zwin, zlen) != Z_OK ||
+			    win_len != ZLIB_WINSIZE)
+				goto done;
+			break;
+
+		default:
+			goto done;
+		}
+		/* fast_seek_find() needs them in order */
+		if (prev != NULL && val->out <= prev->out)
+			goto done;
+		prev = val;
+	}
+	ok = TRUE;
+
+done:
+	fclose(fp);
+	g_free(zwin);
+	for (i = 0; i < points->len; i++) {
+		if (ok)
+			g_ptr_array_add(file->fast_seek, points->pdata[i]);
+		else
+			g_free(points->pdata[i]);
+	}
+	g_ptr_array_free(points, TRUE);
+	return ok;
+}
+
+static void
+fast_seek_save(FILE_T file)
+{
+	ws_statb64 statb;
+	FILE *fp;
+	guint8 hdr[INDEX_HDR_LEN];
+	guint8 rec[INDEX_POINT_LEN];
+	unsigned char *zwin;
+	uLongf zlen;
+	struct fast_seek_point *item;
+	guint i;
+	gboolean ok = TRUE;
+
+	if (ws_fstat64(file->fd, &statb) == -1)
+		return;
+	if ((fp = ws_fopen(file->index_path, "wb")) == NULL)
+		return;
+
+	memcpy(hdr, INDEX_MAGIC, 8);
+	phtolel(&hdr[8], file->fast_seek->len);
+	phtolell(&hdr[12], (guint64)statb.st_size);
+	phtolell(&hdr[20], (guint64)statb.st_mtime);
+	if (fwrite(hdr, 1, INDEX_HDR_LEN, fp) != INDEX_HDR_LEN)
+		ok = FALSE;
+
+	zwin = (unsigned char *)g_malloc(compressBound(ZLIB_WINSIZE));
+	for (i = 0; ok && i < file->fast_seek->len; i++) {
+		item = (struct fast_seek_point *)file->fast_seek->pdata[i];
+		memset(rec, 0, INDEX_POINT_LEN);
+		phtolell(&rec[0], (guint64)item->out);
+		phtolell(&rec[8], (guint64)item->in);
+		phtolel(&rec[16], item->compression);
+		zlen = 0;
+		if (item->compression == ZLIB) {
+#ifdef HAVE_INFLATEPRIME
+			phtolel(&rec[20], item->data.zlib.bits);
+#endif
+			phtolel(&rec[24], item->data.zlib.adler);
+			phtolel(&rec[28], item->data.zlib.total_out);
+			zlen = compressBound(ZLIB_WINSIZE);
+			if (compress(zwin, &zlen, item->data.zlib.window, ZLIB_WINSIZE) != Z_OK) {
+				ok = FALSE;
+				break;
+			}
+			phtolel(&rec[32], zlen);
+		}
+		if (fwrite(rec, 1, INDEX_POINT_LEN, fp) != INDEX_POINT_LEN ||
+		    fwrite(zwin, 1, zlen, fp) != zlen)
+			ok = FALSE;
+	}
+	g_free(zwin);
+
+	if (fclose(fp) != 0)
+		ok = FALSE;
+	if (!ok)
+		ws_unlink(file->index_path);
+}
+#endif /* HAVE_LIBZ */
+
+/*
+ * Look for a seek point sidecar for the file at "path", and use it if
+ * it's there and up to date; otherwise, if "save" is TRUE, write one when
+ * the stream is closed after having been read all the way through.
+ * The sidecar is only looked for once the stream turns out to be gzipped.
+ * The stream must have been given its seek point array, and not have
+ * been read from yet.
+ */
+void
+file_set_index(FILE_T stream, const char *path _U_, gboolean save _U_)
+{
+#ifdef HAVE_LIBZ
+	if (stream->fast_seek == NULL || stream->fast_seek->len != 0)
+		return;
+
+	stream->index_path = g_strconcat(path, INDEX_SUFFIX, NULL);
+	stream->index_save = save;
+#endif
+}
+
+#ifdef HAVE_LIBZ
+/*
+ * Read-ahead decompression.
+ *
+ * Once a file being read sequentially turns out to be compressed, a
+ * second thread decompresses it into a ring of blocks ahead of the
+ * reader, so that inflating overlaps with whatever the reader does with
+ * the data.  That thread owns the stream itself (the input and output
+ * buffers, the zlib state and the seek points); the reader only takes
+ * filled blocks off the ring, and keeps its own position and error
+ * state in the read_ahead structure.
+ *
+ * Reading forward and seeking within the current block are done from
+ * the ring.  Anything else stops the thread and goes back to reading the
+ * stream directly; the thread is started again once the reader has gone
+ * forward another RA_START_SPAN bytes.
+ */
+#define RA_BLOCK_SIZE	(128 * 1024)
+#define RA_BLOCKS	8
+#define RA_START_SPAN	SPAN
+
+struct ra_block {
+	unsigned char *data;
+	guint len;                 /* amount of data in the block */
+	gint64 raw_pos;            /* position in the file after filling it */
+	gboolean eof;              /* last block: end of file reached */
+	int err;                   /* last block: error code */
+	const char *err_info;      /* additional error information string */
+};
+
+struct read_ahead {
+	GThread *thread;
+	GMutex *mtx;
+	GCond *cond;
+	gboolean stop;             /* TRUE if the thread should exit */
+	struct ra_block blocks[RA_BLOCKS];
+	guint head;                /* next block for the thread to fill */
+	guint tail;                /* block the reader is consuming */
+	guint filled;              /* filled blocks, including the reader's */
+
+	/* reader state */
+	struct ra_block *cur;      /* block being consumed, NULL before the first */
+	guint used;                /* amount of data consumed from it */
+	gint64 pos;                /* current position in uncompressed data */
+	gint64 raw_pos;            /* position in the file, for progress */
+	gint64 skip;               /* amount to skip */
+	gboolean seek_pending;     /* TRUE if seek request pending */
+	int err;                   /* error code */
+	const char *err_info;      /* additional error information string */
+};
+
+/* Fill a block the way file_read() would, but keep what was decompressed
+   before an error, so the reader gets it before getting the error. */
+static void
+ra_fill_block(FILE_T file, struct ra_block *block)
+{
+	guint n;
+
+	block->len = 0;
+	block->eof = FALSE;
+	block->err = 0;
+	block->err_info = NULL;
+	while (block->len < RA_BLOCK_SIZE) {
+		if (file->have) {
+			n = file->have > RA_BLOCK_SIZE - block->len ?
+			    RA_BLOCK_SIZE - block->len : file->have;
+			memcpy(block->data + block->len, file->next, n);
+			file->next += n;
+			file->have -= n;
+			file->pos += n;
+			block->len += n;
+		} else if (file->err) {
+			block->err = file->err;
+			block->err_info = file->err_info;
+			break;
+		} else if (file->eof && file->avail_in == 0) {
+			block->eof = TRUE;
+			break;
+		} else if (file->compression == ZLIB) {
+			/* inflate straight into the block */
+			zlib_read(file, block->data + block->len, RA_BLOCK_SIZE - block->len);
+			file->pos += file->have;
+			block->len += file->have;
+			file->have = 0;
+			file->next = file->out;
+		} else if (fill_out_buffer(file) == -1) {
+			block->err = file->err;
+			block->err_info = file->err_info;
+			break;
+		}
+	}
+	block->raw_pos = file->raw_pos;
+}
+
+static gpointer
+ra_thread(gpointer data)
+{
+	FILE_T file = (FILE_T)data;
+	struct read_ahead *ra = file->ra;
+	struct ra_block *block;
+
+	for (;;) {
+		g_mutex_lock(ra->mtx);
+		while (ra->filled == RA_BLOCKS && !ra->stop)
+			g_cond_wait(ra->cond, ra->mtx);
+		if (ra->stop) {
+			g_mutex_unlock(ra->mtx);
+			break;
+		}
+		block = &ra->blocks[ra->head];
+		g_mutex_unlock(ra->mtx);
+
+		ra_fill_block(file, block);
+
+		g_mutex_lock(ra->mtx);
+		ra->head = (ra->head + 1) % RA_BLOCKS;
+		ra->filled++;
+		g_cond_signal(ra->cond);
+		g_mutex_unlock(ra->mtx);
+
+		if (block->eof || block->err)
+			break;
+	}
+	return NULL;
+}
+
+static void
+ra_free(struct read_ahead *ra)
+{
+	guint i;
+
+	for (i = 0; i < RA_BLOCKS; i++)
+		g_free(ra->blocks[i].data);
+#if GLIB_CHECK_VERSION(2,31,0)
+	g_mutex_clear(ra->mtx);
+	g_free(ra->mtx);
+	g_cond_clear(ra->cond);
+	g_free(ra->cond);
+#else
+	g_mutex_free(ra->mtx);
+	g_cond_free(ra->cond);
+#endif
+	g_free(ra);
+}
+
+/* Start the read-ahead thread if it's worth it. */
+static void
+ra_start(FILE_T file)
+{
+	struct read_ahead *ra;
+	guint i;
+
+	if (!file->read_ahead || file->compression != ZLIB ||
+	    file->pos < file->read_ahead_pos || file->seek_pending ||
+	    file->err)
+		return;
+#if !GLIB_CHECK_VERSION(2,31,0)
+	if (!g_thread_supported()) {
+		file->read_ahead = FALSE;
+		return;
+	}
+#endif
+
+	ra = g_new0(struct read_ahead, 1);
+#if GLIB_CHECK_VERSION(2,31,0)
+	ra->mtx = g_new(GMutex, 1);
+	g_mutex_init(ra->mtx);
+	ra->cond = g_new(GCond, 1);
+	g_cond_init(ra->cond);
+#else
+	ra->mtx = g_mutex_new();
+	ra->cond = g_cond_new();
+#endif
+	for (i = 0; i < RA_BLOCKS; i++) {
+		ra->blocks[i].data = (unsigned char *)g_try_malloc(RA_BLOCK_SIZE);
+		if (ra->blocks[i].data == NULL) {
+			/* just keep reading the stream directly */
+			ra_free(ra);
+			file->read_ahead = FALSE;
+			return;
+		}
+	}
+	ra->pos = file->pos;
+	ra->raw_pos = file->raw_pos;
+
+	file->ra = ra;
+#if GLIB_CHECK_VERSION(2,31,0)
+	ra->thread = g_thread_try_new("file read-ahead", ra_thread, file, NULL);
+#else
+	ra->thread = g_thread_create(ra_thread, file, TRUE, NULL);
+#endif
+	if (ra->thread == NULL) {
+		file->ra = NULL;
+		ra_free(ra);
+		file->read_ahead = FALSE;
+	}
+}
+
+/* Stop the read-ahead thread; the stream is left wherever the thread
+   got to, so the caller has to seek it to where it wants to be. */
+static void
+ra_stop(FILE_T file)
+{
+	struct read_ahead *ra = file->ra;
+
+	g_mutex_lock(ra->mtx);
+	ra->stop = TRUE;
+	g_cond_signal(ra->cond);
+	g_mutex_unlock(ra->mtx);
+	g_thread_join(ra->thread);
+
+	file->ra = NULL;
+	ra_free(ra);
+}
+
+/* Stop the read-ahead thread, and seek the stream back to where the
+   reader was. */
+static void
+ra_cancel(FILE_T file)
+{
+	struct read_ahead *ra = file->ra;
+	gint64 pos = ra->pos + (ra->seek_pending ? ra->skip : 0);
+	int err;
+
+	ra_stop(file);
+	file->read_ahead_pos = pos + RA_START_SPAN;
+	if (file_seek(file, pos, SEEK_SET, &err) == -1) {
+		file->err = err;
+		file->err_info = NULL;
+	}
+}
+
+/* Make sure there's unconsumed data in the current block; return 1 if
+   there is, 0 at the end of the file, and -1 on an error. */
+static int
+ra_avail(struct read_ahead *ra)
+{
+	while (ra->cur == NULL || ra->used == ra->cur->len) {
+		if (ra->cur != NULL && ra->cur->err) {
+			ra->err = ra->cur->err;
+			ra->err_info = ra->cur->err_info;
+			return -1;
+		}
+		if (ra->cur != NULL && ra->cur->eof)
+			return 0;
+
+		/* hand the current block back, and wait for the next one */
+		g_mutex_lock(ra->mtx);
+		if (ra->cur != NULL) {
+			ra->tail = (ra->tail + 1) % RA_BLOCKS;
+			ra->filled--;
+			g_cond_signal(ra->cond);
+		}
+		while (ra->filled == 0)
+			g_cond_wait(ra->cond, ra->mtx);
+		ra->cur = &ra->blocks[ra->tail];
+		g_mutex_unlock(ra->mtx);
+
+		ra->used = 0;
+		ra->raw_pos = ra->cur->raw_pos;
+	}
+	return 1;
+}
+
+static int
+ra_skip(struct read_ahead *ra, gint64 len)
+{
+	guint n;
+	int ret;
+
+	while (len) {
+		if ((ret = ra_avail(ra)) <= 0)
+			return ret;
+		n = (gint64)(ra->cur->len - ra->used) > len ?
+		    (unsigned)len : ra->cur->len - ra->used;
+		ra->used += n;
+		ra->pos += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int
+ra_read(struct read_ahead *ra, void *buf, unsigned int len)
+{
+	guint got, n;
+	int ret;
+
+	if (len == 0)
+		return 0;
+
+	if (ra->seek_pending) {
+		ra->seek_pending = FALSE;
+		if (ra_skip(ra, ra->skip) == -1)
+			return -1;
+	}
+
+	got = 0;
+	do {
+		if ((ret = ra_avail(ra)) == -1)
+			return -1;
+		if (ret == 0)
+			break;
+		n = ra->cur->len - ra->used > len ? len : ra->cur->len - ra->used;
+		memcpy(buf, ra->cur->data + ra->used, n);
+		ra->used += n;
+		len -= n;
+		buf = (char *)buf + n;
+		got += n;
+		ra->pos += n;
+	} while (len);
+
+	return (int)got;
+}
+
+static char *
+ra_gets(struct read_ahead *ra, char *buf, int len)
+{
+	guint left, n;
+	char *str;
+	unsigned char *next, *eol;
+	int ret;
+
+	if (ra->err)
+		return NULL;
+
+	if (ra->seek_pending) {
+		ra->seek_pending = FALSE;
+		if (ra_skip(ra, ra->skip) == -1)
+			return NULL;
+	}
+
+	str = buf;
+	left = (unsigned)len - 1;
+	if (left) do {
+		if ((ret = ra_avail(ra)) == -1)
+			return NULL;
+		if (ret == 0) {
+			if (buf == str)
+				return NULL;
+			break;
+		}
+
+		next = ra->cur->data + ra->used;
+		n = ra->cur->len - ra->used > left ? left : ra->cur->len - ra->used;
+		eol = (unsigned char *)memchr(next, '\n', n);
+		if (eol != NULL)
+			n = (unsigned)(eol - next) + 1;
+
+		memcpy(buf, next, n);
+		ra->used += n;
+		ra->pos += n;
+		left -= n;
+		buf += n;
+	} while (left && eol == NULL);
+
+	buf[0] = 0;
+	return str;
+}
+
+static gint64
+ra_seek(FILE_T file, gint64 offset, int whence, int *err)
+{
+	struct read_ahead *ra = file->ra;
+	gint64 target, start;
+
+	if (whence == SEEK_SET)
+		target = offset;
+	else
+		target = ra->pos + (ra->seek_pending ? ra->skip : 0) + offset;
+	if (target < 0) {
+		*err = EINVAL;
+		return -1;
+	}
+
+	/* within the current block? */
+	if (ra->cur != NULL) {
+		start = ra->pos - ra->used;
+		if (target >= start && target <= start + ra->cur->len) {
+			ra->used = (guint)(target - start);
+			ra->pos = target;
+			ra->seek_pending = FALSE;
+			return target;
+		}
+	}
+
+	/* forward, and the seek points wouldn't get us there any faster?
+	   (A private array has none ahead of the reader.) */
+	if (target > ra->pos && (file->fast_seek == NULL || file->fast_seek_private ||
+	    target - ra->pos <= SPAN)) {
+		ra->seek_pending = TRUE;
+		ra->skip = target - ra->pos;
+		return target;
+	}
+
+	ra_stop(file);
+	file->read_ahead_pos = target + RA_START_SPAN;
+	return file_seek(file, target, SEEK_SET, err);
+}
+#endif /* HAVE_LIBZ */
+
+/*
+ * Allow decompressing the stream in a separate thread, ahead of the
+ * reader.  Only for streams that are read sequentially, and before
+ * they've been read from.
+ */
+void
+file_set_read_ahead(FILE_T stream _U_)
+{
+#ifdef HAVE_LIBZ
+	stream->read_ahead = TRUE;
+	stream->read_ahead_pos = RA_START_SPAN;
+	/* Seeking back past what the reader has in hand stops the thread;
+	   without seek points, the stream would then be inflated again
+	   from the start.  Keep a few recent ones. */
+	if (stream->fast_seek == NULL) {
+		stream->fast_seek = g_ptr_array_new();
+		stream->fast_seek_private = TRUE;
+	}
+#endif
+}
+
 gint64
 file_seek(FILE_T file, gint64 offset, int whence, int *err)
 {
@@ -927,6 +1801,21 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
  */
 	}
 
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		return ra_seek(file, offset, whence, err);
+#endif
+	if (file->mapped) {
+		if (whence == SEEK_CUR)
+			offset += file->pos;
+		if (offset < 0) {
+			*err = EINVAL;
+			return -1;
+		}
+		file->pos = offset;
+		return file->pos;
+	}
+
 	/* normalize offset to a SEEK_CUR specification */
 	if (whence == SEEK_SET)
 		offset -= file->pos;
@@ -1113,6 +2002,10 @@ file_skip(FILE_T file, gint64 delta, int *err)
 gint64
 file_tell(FILE_T stream)
 {
+#ifdef HAVE_LIBZ
+	if (stream->ra)
+		return stream->ra->pos + (stream->ra->seek_pending ? stream->ra->skip : 0);
+#endif
 	/* return position */
 	return stream->pos + (stream->seek_pending ? stream->skip : 0);
 }
@@ -1120,6 +2013,12 @@ file_tell(FILE_T stream)
 gint64
 file_tell_raw(FILE_T stream)
 {
+#ifdef HAVE_LIBZ
+	if (stream->ra)
+		return stream->ra->raw_pos;
+#endif
+	if (stream->mapped)
+		return stream->pos;
 	return stream->raw_pos;
 }
 
@@ -1140,8 +2039,8 @@ file_iscompressed(FILE_T stream)
 	return stream->is_compressed;
 }
 
-int
-file_read(void *buf, unsigned int len, FILE_T file)
+static int
+gz_read(FILE_T file, void *buf, unsigned int len)
 {
 	guint got, n;
 
@@ -1198,6 +2097,35 @@ file_read(void *buf, unsigned int len, FILE_T file)
 	return (int)got;
 }
 
+int
+file_read(void *buf, unsigned int len, FILE_T file)
+{
+	int ret;
+
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		return ra_read(file->ra, buf, len);
+#endif
+#ifdef HAVE_MMAP
+	if (file->mapped) {
+		if (file->pos + len <= file->map_len) {
+			memcpy(buf, file->map + file->pos, len);
+			file->pos += len;
+			if (file->raw_tap != NULL && file->pos >= file->raw_tap_pos + RAW_TAP_CHUNK)
+				raw_tap_catch_up(file, file->pos);
+			return (int)len;
+		}
+		file_unmap(file);
+	}
+#endif
+	ret = gz_read(file, buf, len);
+#ifdef HAVE_LIBZ
+	if (file->read_ahead)
+		ra_start(file);
+#endif
+	return ret;
+}
+
 /*
  * XXX - this gets a byte, not a character.
  */
@@ -1207,6 +2135,21 @@ file_getc(FILE_T file)
 	unsigned char buf[1];
 	int ret;
 
+#ifdef HAVE_LIBZ
+	if (file->ra) {
+		struct read_ahead *ra = file->ra;
+
+		if (ra->cur && ra->used < ra->cur->len && !ra->seek_pending) {
+			ra->pos++;
+			return ra->cur->data[ra->used++];
+		}
+		ret = ra_read(ra, buf, 1);
+		return ret < 1 ? -1 : buf[0];
+	}
+#endif
+	if (file->mapped && file->pos < file->map_len)
+		return file->map[file->pos++];
+
 	/* check that we're reading and that there's no error */
 	if (file->err)
 		return -1;
@@ -1233,6 +2176,11 @@ file_gets(char *buf, int len, FILE_T file)
 	if (buf == NULL || len < 1)
 		return NULL;
 
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		return ra_gets(file->ra, buf, len);
+#endif
+
 	/* check that there's no error */
 	if (file->err)
 		return NULL;
@@ -1249,6 +2197,24 @@ file_gets(char *buf, int len, FILE_T file)
 	   the contents, let the user worry about that) */
 	str = buf;
 	left = (unsigned)len - 1;
+#ifdef HAVE_MMAP
+	if (file->mapped && left) {
+		/* copy straight from the mapping, as far as it goes */
+		n = file->map_len - file->pos > left ? left : (unsigned)(file->map_len - file->pos);
+		eol = (unsigned char *)memchr(file->map + file->pos, '\n', n);
+		if (eol != NULL)
+			n = (unsigned)(eol - (file->map + file->pos)) + 1;
+		memcpy(buf, file->map + file->pos, n);
+		file->pos += n;
+		left -= n;
+		buf += n;
+		if (eol != NULL || left == 0) {
+			buf[0] = 0;
+			return str;
+		}
+		file_unmap(file);
+	}
+#endif
 	if (left) do {
 		/* assure that something is in the output buffer */
 		if (file->have == 0) {
@@ -1287,12 +2253,23 @@ file_gets(char *buf, int len, FILE_T file)
 
 	/* found end-of-line or out of space -- terminate string and return it */
 	buf[0] = 0;
+#ifdef HAVE_LIBZ
+	if (file->read_ahead)
+		ra_start(file);
+#endif
 	return str;
 }
 
 int
 file_eof(FILE_T file)
 {
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		return (file->ra->cur && file->ra->cur->eof &&
+		    file->ra->used == file->ra->cur->len);
+#endif
+	if (file->mapped)
+		return file->pos >= file->map_len;
 	/* return end-of-file state */
 	return (file->eof && file->avail_in == 0 && file->have == 0);
 }
@@ -1305,6 +2282,15 @@ file_eof(FILE_T file)
 int
 file_error(FILE_T fh, gchar **err_info)
 {
+#ifdef HAVE_LIBZ
+	if (fh->ra) {
+		if (fh->ra->err != 0) {
+			*err_info = (fh->ra->err_info == NULL) ? NULL : g_strdup(fh->ra->err_info);
+			return fh->ra->err;
+		}
+		return 0;
+	}
+#endif
 	if (fh->err != 0) {
 		*err_info = (fh->err_info == NULL) ? NULL : g_strdup(fh->err_info);
 		return fh->err;
@@ -1315,15 +2301,47 @@ file_error(FILE_T fh, gchar **err_info)
 void
 file_clearerr(FILE_T stream)
 {
+#ifdef HAVE_LIBZ
+	/* the thread has stopped at the error or end of file */
+	if (stream->ra)
+		ra_cancel(stream);
+#endif
 	/* clear error and end-of-file */
 	stream->err = 0;
 	stream->err_info = NULL;
 	stream->eof = FALSE;
 }
 
+/*
+ * Hand the rest of the file to the tap, and remove it.  Returns 0, or
+ * an error code if not all of the file could be handed to the tap.
+ */
+int
+file_raw_tap_finish(FILE_T stream)
+{
+	int err;
+
+	if (stream->raw_tap == NULL)
+		return 0;
+#ifdef HAVE_LIBZ
+	/* the read-ahead thread may be using the file descriptor */
+	if (stream->ra)
+		ra_cancel(stream);
+#endif
+	raw_tap_catch_up(stream, -1);
+	err = stream->raw_tap_err;
+	stream->raw_tap = NULL;
+	stream->raw_tap_data = NULL;
+	return err;
+}
+
 void
 file_fdclose(FILE_T file)
 {
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		ra_cancel(file);
+#endif
 	ws_close(file->fd);
 	file->fd = -1;
 }
@@ -1344,6 +2362,27 @@ file_close(FILE_T file)
 {
 	int fd = file->fd;
 
+#ifdef HAVE_LIBZ
+	if (file->ra)
+		ra_stop(file);
+	if (file->index_path) {
+		if (file->index_save && file->index_complete && file->is_compressed)
+			fast_seek_save(file);
+		g_free(file->index_path);
+	}
+	if (file->fast_seek_private) {
+		guint i;
+
+		for (i = 0; i < file->fast_seek->len; i++)
+			g_free(file->fast_seek->pdata[i]);
+		g_ptr_array_free(file->fast_seek, TRUE);
+	}
+#endif
+#ifdef HAVE_MMAP
+	if (file->map)
+		munmap(file->map, (size_t)file->map_len);
+#endif
+
 	/* free memory and close file */
 	if (file->size) {
 #ifdef HAVE_LIBZ
@@ -31,6 +31,10 @@
 extern FILE_T file_open(const char *path);
 extern FILE_T file_fdopen(int fildes);
 extern void file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek);
+extern void file_set_index(FILE_T stream, const char *path, gboolean save);
+extern void file_set_read_ahead(FILE_T stream);
+extern void file_set_raw_tap(FILE_T stream, wtap_raw_tap_func func, void *user_data);
+extern int file_raw_tap_finish(FILE_T stream);
 WS_DLL_PUBLIC gint64 file_seek(FILE_T stream, gint64 offset, int whence, int *err);
 extern gint64 file_skip(FILE_T file, gint64 delta, int *err);
 WS_DLL_PUBLIC gint64 file_tell(FILE_T stream);
@@ -38,6 +42,7 @@ extern gint64 file_tell_raw(FILE_T stream);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
 extern gboolean file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
+extern guint8 *file_read_map(FILE_T file, unsigned int len);
 WS_DLL_PUBLIC int file_getc(FILE_T stream);
 WS_DLL_PUBLIC char *file_gets(char *buf, int len, FILE_T stream);
 WS_DLL_PUBLIC int file_eof(FILE_T stream);
@@ -652,10 +652,17 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 	orig_size -= phdr_len;
 	packet_size -= phdr_len;
 
-	buffer_assure_space(wth->frame_buffer, packet_size);
-	if (!libpcap_read_rec_data(wth->fh, buffer_start_ptr(wth->frame_buffer),
-	    packet_size, err, err_info))
-		return FALSE;	/* Read error */
+	/*
+	 * If the data doesn't need any byte-swapping, use it where it
+	 * is if we can, rather than copying it into the frame buffer.
+	 */
+	if (libpcap->byte_swapped ||
+	    (wth->frame_ptr = file_read_map(wth->fh, packet_size)) == NULL) {
+		buffer_assure_space(wth->frame_buffer, packet_size);
+		if (!libpcap_read_rec_data(wth->fh, buffer_start_ptr(wth->frame_buffer),
+		    packet_size, err, err_info))
+			return FALSE;	/* Read error */
+	}
 
 	wth->phdr.presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
 
@@ -676,7 +683,7 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 	wth->phdr.len = orig_size;
 
 	pcap_read_post_process(wth->file_type, wth->file_encap,
-	    &wth->phdr.pseudo_header, buffer_start_ptr(wth->frame_buffer),
+	    &wth->phdr.pseudo_header, wtap_buf_ptr(wth),
 	    wth->phdr.caplen, libpcap->byte_swapped, -1);
 	return TRUE;
 }
@@ -371,6 +371,7 @@ typedef struct wtapng_block_s {
         const union wtap_pseudo_header *pseudo_header;
         struct wtap_pkthdr *packet_header;
         const guint8 *frame_buffer;
+        gboolean use_map;       /* TRUE if packet data that doesn't need byte-swapping can be left where it is in the file */
         int *file_encap;
 } wtapng_block_t;
 
@@ -912,6 +913,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *pn, wta
         int pseudo_header_len;
         char *option_content = NULL; /* Allocate as large as the options block */
         int fcslen;
+        guint8 *frame_data;
 
         /* "(Enhanced) Packet Block" read fixed part */
         errno = WTAP_ERR_CANT_READ;
@@ -1100,7 +1102,12 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *pn, wta
 
         /* "(Enhanced) Packet Block" read capture data */
         errno = WTAP_ERR_CANT_READ;
-        bytes_read = file_read((guint8 *) (wblock->frame_buffer), wblock->data.packet.cap_len - pseudo_header_len, fh);
+        if (wblock->use_map && !pn->byte_swapped &&
+            (frame_data = file_read_map(fh, wblock->data.packet.cap_len - pseudo_header_len)) != NULL) {
+                wblock->frame_buffer = frame_data;
+                bytes_read = wblock->data.packet.cap_len - pseudo_header_len;
+        } else
+                bytes_read = file_read((guint8 *) (wblock->frame_buffer), wblock->data.packet.cap_len - pseudo_header_len, fh);
         if (bytes_read != (int) (wblock->data.packet.cap_len - pseudo_header_len)) {
                 *err = file_error(fh, err_info);
                 pcapng_debug1("pcapng_read_packet_block: couldn't read %u bytes of captured data",
@@ -1239,6 +1246,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *
         guint32 block_total_length;
         guint32 padding;
         int pseudo_header_len;
+        guint8 *frame_data;
 
         /*
          * Is this block long enough to be an SPB?
@@ -1366,7 +1374,12 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh, pcapng_t *
 
         /* "Simple Packet Block" read capture data */
         errno = WTAP_ERR_CANT_READ;
-        bytes_read = file_read((guint8 *) (wblock->frame_buffer), wblock->data.simple_packet.cap_len, fh);
+        if (wblock->use_map && !pn->byte_swapped &&
+            (frame_data = file_read_map(fh, wblock->data.simple_packet.cap_len)) != NULL) {
+                wblock->frame_buffer = frame_data;
+                bytes_read = wblock->data.simple_packet.cap_len;
+        } else
+                bytes_read = file_read((guint8 *) (wblock->frame_buffer), wblock->data.simple_packet.cap_len, fh);
         if (bytes_read != (int) wblock->data.simple_packet.cap_len) {
                 *err = file_error(fh, err_info);
                 pcapng_debug1("pcapng_read_simple_packet_block: couldn't read %u bytes of captured data",
@@ -2077,6 +2090,7 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
 
         /* we don't expect any packet blocks yet */
         wblock.frame_buffer = NULL;
+        wblock.use_map = FALSE;
         wblock.pseudo_header = NULL;
         wblock.packet_header = NULL;
         wblock.file_encap = &wth->file_encap;
@@ -2204,6 +2218,7 @@ pcapng_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
         }
 
         wblock.frame_buffer  = buffer_start_ptr(wth->frame_buffer);
+        wblock.use_map       = TRUE;
         wblock.pseudo_header = &wth->phdr.pseudo_header;
         wblock.packet_header = &wth->phdr;
         wblock.file_encap    = &wth->file_encap;
@@ -2308,6 +2323,10 @@ pcapng_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 
 got_packet:
 
+        /* the packet data may have been left where it is in the file */
+        if (wblock.frame_buffer != buffer_start_ptr(wth->frame_buffer))
+                wth->frame_ptr = (guint8 *)wblock.frame_buffer;
+
         /*pcapng_debug2("Read length: %u Packet length: %u", bytes_read, wth->phdr.caplen);*/
         pcapng_debug1("pcapng_read: data_offset is finally %" G_GINT64_MODIFIER "d", *data_offset + bytes_read);
 
@@ -2336,6 +2355,7 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
         pcapng_debug1("pcapng_seek_read: reading at offset %" G_GINT64_MODIFIER "u", seek_off);
 
         wblock.frame_buffer = pd;
+        wblock.use_map = FALSE;
         wblock.pseudo_header = pseudo_header;
         wblock.packet_header = &wth->phdr;
         wblock.file_encap = &wth->file_encap;
@@ -3598,6 +3618,7 @@ pcapng_dump_open(wtap_dumper *wdh, int *err)
 
                 /* write the interface description block */
                 wblock.frame_buffer            = NULL;
+                wblock.use_map                 = FALSE;
                 wblock.pseudo_header           = NULL;
                 wblock.packet_header           = NULL;
                 wblock.file_encap              = NULL;
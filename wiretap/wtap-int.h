@@ -55,6 +55,7 @@ struct wtap {
     int                         file_type;
     guint                       snapshot_length;
     struct Buffer               *frame_buffer;
+    guint8                      *frame_ptr;             /**< Current packet's data in a mapping of the file, or NULL if it's in frame_buffer */
     struct wtap_pkthdr          phdr;
     struct wtapng_section_s     shb_hdr;
     guint                       number_of_interfaces;   /**< The number of interfaces a capture was made on, number of IDB:s in a pcapng file or equivalent(?)*/
@@ -77,6 +78,7 @@ struct wtap {
     wtap_new_ipv4_callback_t    add_new_ipv4;
     wtap_new_ipv6_callback_t    add_new_ipv6;
     GPtrArray                   *fast_seek;
+    struct wtap_index_writer    *index_writer; /**< Index sidecar being written, see wtap_save_index() */
 };
 
 struct wtap_dumper;
@@ -37,10 +37,19 @@
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 #include "wtap-int.h"
 
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
+#include <wsutil/crc32.h>
 #include "buffer.h"
 
 /*
@@ -615,15 +624,19 @@ gint wtap_num_encap_types = sizeof(encap_table_base) / sizeof(struct encap_type_
 static GArray* encap_table_arr = NULL;
 static const struct encap_type_info* encap_table = NULL;
 
+/* Files may be opened in several threads at once (capinfos -j) */
 static void wtap_init_encap_types(void) {
+	static volatile gsize initialized = 0;
 
-	if (encap_table_arr) return;
+	if (!g_once_init_enter(&initialized)) return;
 
 	encap_table_arr = g_array_new(FALSE,TRUE,sizeof(struct encap_type_info));
 
 	g_array_append_vals(encap_table_arr,encap_table_base,wtap_num_encap_types);
 
 	encap_table = (struct encap_type_info *)encap_table_arr->data;
+
+	g_once_init_leave(&initialized, 1);
 }
 
 int wtap_get_num_encap_types(void) {
@@ -748,6 +761,7 @@ wtap_sequential_close(wtap *wth)
 		file_close(wth->fh);
 		wth->fh = NULL;
 	}
+	wth->frame_ptr = NULL;
 
 	if (wth->frame_buffer) {
 		buffer_free(wth->frame_buffer);
@@ -777,6 +791,8 @@ wtap_fdclose(wtap *wth)
 		file_fdclose(wth->random_fh);
 }
 
+static void index_writer_finish(wtap *wth, gboolean complete);
+
 void
 wtap_close(wtap *wth)
 {
@@ -784,6 +800,10 @@ wtap_close(wtap *wth)
 	wtapng_if_descr_t *wtapng_if_descr;
 	wtapng_if_stats_t *if_stats;
 
+	/* an index of a file that wasn't read through is no use */
+	if (wth->index_writer != NULL)
+		index_writer_finish(wth, FALSE);
+
 	wtap_sequential_close(wth);
 
 	if (wth->subtype_close != NULL)
@@ -851,6 +871,385 @@ void wtap_set_cb_new_ipv6(wtap *wth, wtap_new_ipv6_callback_t add_new_ipv6) {
 		wth->add_new_ipv6 = add_new_ipv6;
 }
 
+/*
+ * Capture index sidecar.
+ *
+ * Listing the packets of a capture file means reading all of it, which
+ * for a large file takes a long time every time it's opened.  Once a
+ * file has been read all the way through with wtap_read(), the offset
+ * and header of every packet can be saved in "<file>.pktidx"; when the
+ * file is opened again, wtap_index_open() makes them available without
+ * reading the file.
+ *
+ * The index is a 64 byte header followed by a 40 byte record for every
+ * packet, all little-endian, so that it can be used where it's mapped:
+ *
+ * header:  0  magic "WTPKIDX1"
+ *          8  version (1)
+ *         12  record length (40)
+ *         16  number of records
+ *         20  file type
+ *         24  file encapsulation after reading the file
+ *         28  time stamp precision after reading the file
+ *         32  number of interfaces after reading the file
+ *         36  CRC-32 of the first and last 64K of the capture file
+ *         40  size of the capture file
+ *         48  modification time of the capture file
+ *         56  reserved
+ *
+ * record:  0  offset of the packet
+ *          8  time stamp, seconds
+ *         16  time stamp, nanoseconds
+ *         20  captured length
+ *         24  length
+ *         28  interface ID
+ *         32  packet flags
+ *         36  packet encapsulation (16 bits)
+ *         38  presence flags (16 bits)
+ *
+ * An index is only used if the size, modification time and checksum of
+ * the capture file match, and only for file types whose random access
+ * reads don't depend on what the sequential read has seen: uncompressed
+ * pcap files, and pcapng files whose interfaces are all described before
+ * the first packet (checked by comparing the number of interfaces known
+ * right after opening the file with the number recorded in the index).
+ */
+#define PKTIDX_SUFFIX		".pktidx"
+#define PKTIDX_MAGIC		"WTPKIDX1"
+#define PKTIDX_VERSION		1
+#define PKTIDX_HDR_LEN		64
+#define PKTIDX_REC_LEN		40
+#define PKTIDX_CHECK_LEN	65536	/* bytes checksummed at each end of the file */
+
+struct wtap_index_writer {
+	FILE    *fp;
+	char    *capture_path;
+	char    *tmp_path;
+	guint32  count;
+	gboolean failed;
+};
+
+struct wtap_index {
+	guint8       *data;		/* the index file, header included */
+	gint64        len;
+	gboolean      mapped;
+	const guint8 *records;
+	guint32       count;
+};
+
+static gboolean
+index_supported(wtap *wth)
+{
+	switch (wth->file_type) {
+
+	case WTAP_FILE_PCAP:
+	case WTAP_FILE_PCAPNG:
+	case WTAP_FILE_PCAP_NSEC:
+	case WTAP_FILE_PCAP_AIX:
+	case WTAP_FILE_PCAP_SS991029:
+	case WTAP_FILE_PCAP_NOKIA:
+	case WTAP_FILE_PCAP_SS990417:
+	case WTAP_FILE_PCAP_SS990915:
+		return !wtap_iscompressed(wth);
+
+	default:
+		return FALSE;
+	}
+}
+
+/* Checksum the first and last PKTIDX_CHECK_LEN bytes of the file; a full
+   checksum would take as long as reading the file, which is what the
+   index is there to avoid. */
+static gboolean
+index_checksum(const char *path, gint64 size, guint32 *crc)
+{
+	guint8 *buf;
+	int fd;
+	gint64 tail;
+	int len;
+	gboolean ok = FALSE;
+
+	if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
+		return FALSE;
+	buf = (guint8 *)g_malloc(PKTIDX_CHECK_LEN);
+
+	len = (int)MIN(size, PKTIDX_CHECK_LEN);
+	if (ws_read(fd, buf, len) != len)
+		goto done;
+	*crc = crc32_ccitt_seed(buf, len, 0xFFFFFFFF);
+
+	if (size > PKTIDX_CHECK_LEN) {
+		tail = MAX(size - PKTIDX_CHECK_LEN, PKTIDX_CHECK_LEN);
+		len = (int)(size - tail);
+		if (ws_lseek64(fd, tail, SEEK_SET) == -1 ||
+		    ws_read(fd, buf, len) != len)
+			goto done;
+		*crc = crc32_ccitt_seed(buf, len, *crc);
+	}
+	ok = TRUE;
+
+done:
+	g_free(buf);
+	ws_close(fd);
+	return ok;
+}
+
+static void
+index_writer_add(wtap *wth, gint64 data_offset)
+{
+	struct wtap_index_writer *iw = wth->index_writer;
+	const struct wtap_pkthdr *phdr = &wth->phdr;
+	guint8 rec[PKTIDX_REC_LEN];
+
+	if (iw->failed)
+		return;
+
+	phtolell(&rec[0], (guint64)data_offset);
+	phtolell(&rec[8], (guint64)(gint64)phdr->ts.secs);
+	phtolel(&rec[16], (guint32)phdr->ts.nsecs);
+	phtolel(&rec[20], phdr->caplen);
+	phtolel(&rec[24], phdr->len);
+	phtolel(&rec[28], phdr->interface_id);
+	phtolel(&rec[32], phdr->pack_flags);
+	phtoles(&rec[36], (guint16)phdr->pkt_encap);
+	phtoles(&rec[38], (guint16)phdr->presence_flags);
+	if (fwrite(rec, 1, PKTIDX_REC_LEN, iw->fp) != PKTIDX_REC_LEN)
+		iw->failed = TRUE;
+	iw->count++;
+}
+
+/* Finish the index if the file was read all the way through, otherwise
+   throw it away. */
+static void
+index_writer_finish(wtap *wth, gboolean complete)
+{
+	struct wtap_index_writer *iw = wth->index_writer;
+	ws_statb64 statb;
+	guint8 hdr[PKTIDX_HDR_LEN];
+	guint32 crc;
+	char *index_path;
+	int err;
+
+	wth->index_writer = NULL;
+
+	if (complete && !iw->failed &&
+	    wtap_fstat(wth, &statb, &err) == 0 &&
+	    index_checksum(iw->capture_path, statb.st_size, &crc)) {
+		memset(hdr, 0, PKTIDX_HDR_LEN);
+		memcpy(hdr, PKTIDX_MAGIC, 8);
+		phtolel(&hdr[8], PKTIDX_VERSION);
+		phtolel(&hdr[12], PKTIDX_REC_LEN);
+		phtolel(&hdr[16], iw->count);
+		phtolel(&hdr[20], (guint32)wth->file_type);
+		phtolel(&hdr[24], (guint32)wth->file_encap);
+		phtolel(&hdr[28], (guint32)wth->tsprecision);
+		phtolel(&hdr[32], wth->number_of_interfaces);
+		phtolel(&hdr[36], crc);
+		phtolell(&hdr[40], (guint64)statb.st_size);
+		phtolell(&hdr[48], (guint64)statb.st_mtime);
+		if (fseek(iw->fp, 0, SEEK_SET) != 0 ||
+		    fwrite(hdr, 1, PKTIDX_HDR_LEN, iw->fp) != PKTIDX_HDR_LEN)
+			iw->failed = TRUE;
+	} else
+		iw->failed = TRUE;
+
+	if (fclose(iw->fp) != 0)
+		iw->failed = TRUE;
+
+	if (!iw->failed) {
+		/* Replace any old index only once the new one is complete */
+		index_path = g_strconcat(iw->capture_path, PKTIDX_SUFFIX, NULL);
+		ws_unlink(index_path);
+		if (ws_rename(iw->tmp_path, index_path) != 0)
+			iw->failed = TRUE;
+		g_free(index_path);
+	}
+	if (iw->failed)
+		ws_unlink(iw->tmp_path);
+
+	g_free(iw->capture_path);
+	g_free(iw->tmp_path);
+	g_free(iw);
+}
+
+void
+wtap_save_index(wtap *wth, const char *filename)
+{
+	struct wtap_index_writer *iw;
+	guint8 hdr[PKTIDX_HDR_LEN];
+	FILE *fp;
+	char *tmp_path;
+
+	if (wth->index_writer != NULL || wth->fh == NULL ||
+	    strcmp(filename, "-") == 0 || !index_supported(wth))
+		return;
+
+	/* The header is written last; until then it's zeroes, which
+	   isn't a valid index if we never get to write it. */
+	tmp_path = g_strconcat(filename, PKTIDX_SUFFIX, ".tmp", NULL);
+	if ((fp = ws_fopen(tmp_path, "wb")) == NULL) {
+		g_free(tmp_path);
+		return;
+	}
+	memset(hdr, 0, PKTIDX_HDR_LEN);
+	if (fwrite(hdr, 1, PKTIDX_HDR_LEN, fp) != PKTIDX_HDR_LEN) {
+		fclose(fp);
+		ws_unlink(tmp_path);
+		g_free(tmp_path);
+		return;
+	}
+
+	iw = g_new0(struct wtap_index_writer, 1);
+	iw->fp = fp;
+	iw->capture_path = g_strdup(filename);
+	iw->tmp_path = tmp_path;
+	wth->index_writer = iw;
+}
+
+static gboolean
+index_load(wtap_index *idx, const char *index_path)
+{
+	ws_statb64 statb;
+	int fd;
+
+	if ((fd = ws_open(index_path, O_RDONLY|O_BINARY, 0000)) == -1)
+		return FALSE;
+	if (ws_fstat64(fd, &statb) == -1 || statb.st_size < PKTIDX_HDR_LEN ||
+	    (guint64)statb.st_size > G_MAXSIZE) {
+		ws_close(fd);
+		return FALSE;
+	}
+	idx->len = statb.st_size;
+
+#ifdef HAVE_MMAP
+	idx->data = (guint8 *)mmap(NULL, (size_t)idx->len, PROT_READ,
+	    MAP_SHARED, fd, 0);
+	if (idx->data != (guint8 *)MAP_FAILED) {
+		idx->mapped = TRUE;
+		ws_close(fd);
+		return TRUE;
+	}
+#endif
+	idx->data = (guint8 *)g_try_malloc((gsize)idx->len);
+	if (idx->data == NULL ||
+	    ws_read(fd, idx->data, (unsigned int)idx->len) != idx->len) {
+		g_free(idx->data);
+		idx->data = NULL;
+		ws_close(fd);
+		return FALSE;
+	}
+	ws_close(fd);
+	return TRUE;
+}
+
+wtap_index *
+wtap_index_open(wtap *wth, const char *filename)
+{
+	wtap_index *idx;
+	char *index_path;
+	const guint8 *hdr;
+	ws_statb64 statb;
+	guint32 crc;
+	int err;
+
+	if (strcmp(filename, "-") == 0 || !index_supported(wth))
+		return NULL;
+
+	idx = g_new0(wtap_index, 1);
+	index_path = g_strconcat(filename, PKTIDX_SUFFIX, NULL);
+	if (!index_load(idx, index_path)) {
+		g_free(index_path);
+		g_free(idx);
+		return NULL;
+	}
+	g_free(index_path);
+
+	hdr = idx->data;
+	idx->records = hdr + PKTIDX_HDR_LEN;
+	idx->count = pletohl(&hdr[16]);
+	if (memcmp(hdr, PKTIDX_MAGIC, 8) != 0 ||
+	    pletohl(&hdr[8]) != PKTIDX_VERSION ||
+	    pletohl(&hdr[12]) != PKTIDX_REC_LEN ||
+	    idx->len != PKTIDX_HDR_LEN + (gint64)idx->count * PKTIDX_REC_LEN ||
+	    pletohl(&hdr[20]) != (guint32)wth->file_type ||
+	    pletohl(&hdr[32]) != wth->number_of_interfaces ||
+	    wtap_fstat(wth, &statb, &err) == -1 ||
+	    pletohll(&hdr[40]) != (guint64)statb.st_size ||
+	    pletohll(&hdr[48]) != (guint64)statb.st_mtime ||
+	    !index_checksum(filename, statb.st_size, &crc) ||
+	    pletohl(&hdr[36]) != crc) {
+		wtap_index_close(idx);
+		return NULL;
+	}
+
+	/* Leave the file the way reading it through would have */
+	wth->file_encap = (int)pletohl(&hdr[24]);
+	wth->tsprecision = (int)pletohl(&hdr[28]);
+
+	/* ...and there's no need to write the index again */
+	if (wth->index_writer != NULL)
+		index_writer_finish(wth, FALSE);
+
+	return idx;
+}
+
+guint32
+wtap_index_count(const wtap_index *idx)
+{
+	return idx->count;
+}
+
+gint64
+wtap_index_get(const wtap_index *idx, guint32 n, struct wtap_pkthdr *phdr)
+{
+	const guint8 *rec;
+
+	g_assert(n < idx->count);
+	rec = idx->records + (gsize)n * PKTIDX_REC_LEN;
+
+	phdr->ts.secs = (time_t)(gint64)pletohll(&rec[8]);
+	phdr->ts.nsecs = (int)pletohl(&rec[16]);
+	phdr->caplen = pletohl(&rec[20]);
+	phdr->len = pletohl(&rec[24]);
+	phdr->interface_id = pletohl(&rec[28]);
+	phdr->pack_flags = pletohl(&rec[32]);
+	phdr->pkt_encap = (gint16)pletohs(&rec[36]);
+	phdr->presence_flags = pletohs(&rec[38]);
+	phdr->opt_comment = NULL;	/* the presence flag tells if there is one */
+	phdr->drop_count = 0;
+
+	return (gint64)pletohll(&rec[0]);
+}
+
+void
+wtap_index_close(wtap_index *idx)
+{
+#ifdef HAVE_MMAP
+	if (idx->mapped)
+		munmap(idx->data, (size_t)idx->len);
+	else
+#endif
+		g_free(idx->data);
+	g_free(idx);
+}
+
+gint64
+wtap_tell_next(wtap *wth)
+{
+	/* The same formats as can be indexed: their records can be read
+	   starting at a record offset, with no other state. */
+	if (!index_supported(wth))
+		return -1;
+	return file_tell(wth->fh);
+}
+
+gboolean
+wtap_seek_next(wtap *wth, gint64 offset, int *err)
+{
+	*err = 0;
+	return file_seek(wth->fh, offset, SEEK_SET, err) != -1;
+}
+
 gboolean
 wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 {
@@ -863,6 +1262,7 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 	 * anyway.
 	 */
 	wth->phdr.pkt_encap = wth->file_encap;
+	wth->frame_ptr = NULL;
 
 	if (!wth->subtype_read(wth, err, err_info, data_offset)) {
 		/*
@@ -876,6 +1276,8 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 		 */
 		if (*err == 0)
 			*err = file_error(wth->fh, err_info);
+		if (wth->index_writer != NULL)
+			index_writer_finish(wth, *err == 0);
 		return FALSE;	/* failure */
 	}
 
@@ -894,6 +1296,9 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 	 */
 	g_assert(wth->phdr.pkt_encap != WTAP_ENCAP_PER_PACKET);
 
+	if (wth->index_writer != NULL)
+		index_writer_add(wth, *data_offset);
+
 	return TRUE;	/* success */
 }
 
@@ -901,6 +1306,19 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (gint64, in case that's 64 bits.)
  */
+void
+wtap_set_raw_tap(wtap *wth, wtap_raw_tap_func func, void *user_data)
+{
+	file_set_raw_tap(wth->fh, func, user_data);
+}
+
+gboolean
+wtap_raw_tap_finish(wtap *wth, int *err)
+{
+	*err = file_raw_tap_finish(wth->fh);
+	return *err == 0;
+}
+
 gint64
 wtap_read_so_far(wtap *wth)
 {
@@ -916,6 +1334,9 @@ wtap_phdr(wtap *wth)
 guint8 *
 wtap_buf_ptr(wtap *wth)
 {
+	/* the read routine may have left the data where it is in the file */
+	if (wth->frame_ptr != NULL)
+		return wth->frame_ptr;
 	return buffer_start_ptr(wth->frame_buffer);
 }
 
@@ -1222,6 +1222,78 @@ wtapng_iface_descriptions_t *wtap_file_get_idb_info(wtap *wth);
 WS_DLL_PUBLIC
 void wtap_write_shb_comment(wtap *wth, gchar *comment);
 
+/*** capture index sidecars ***/
+
+/**
+ * A capture index records where every packet of a capture file is and
+ * its packet header (time stamp, lengths, encapsulation, interface and
+ * flags, but not the comment or pseudo-header), so the packets of a
+ * large file can be listed, and read with wtap_seek_read(), without
+ * reading through the file first.  It is kept in a "<file>.pktidx" file
+ * next to the capture file, and only for uncompressed pcap and pcapng
+ * files.
+ */
+typedef struct wtap_index wtap_index;
+
+/** Write an index for the file once it has been read all the way
+ * through with wtap_read().  Does nothing if the file type can't be
+ * indexed, or if the file is read from the standard input. */
+WS_DLL_PUBLIC
+void wtap_save_index(wtap *wth, const char *filename);
+
+/** Open the index of the file if there is one and it is up to date,
+ * otherwise return NULL.  The file must just have been opened; on
+ * success, the file encapsulation is set to what reading it through
+ * would have left it as. */
+WS_DLL_PUBLIC
+wtap_index *wtap_index_open(wtap *wth, const char *filename);
+
+/** The number of packets in the index. */
+WS_DLL_PUBLIC
+guint32 wtap_index_count(const wtap_index *idx);
+
+/** Fill in the packet header of packet number n (counting from 0) and
+ * return the offset to pass to wtap_seek_read() for it. */
+WS_DLL_PUBLIC
+gint64 wtap_index_get(const wtap_index *idx, guint32 n, struct wtap_pkthdr *phdr);
+
+WS_DLL_PUBLIC
+void wtap_index_close(wtap_index *idx);
+
+/** Where the next wtap_read() would read from, to pass to wtap_seek_next()
+ * after opening the same file again; -1 if reading can't be resumed like
+ * that for this file (it's the same files as can be indexed). */
+WS_DLL_PUBLIC
+gint64 wtap_tell_next(wtap *wth);
+
+/** Make the next wtap_read() read from an offset that wtap_tell_next(),
+ * or wtap_read() as the data offset of a record, returned for the same
+ * file.  Records before the offset are skipped, so anything they'd have
+ * told wiretap (pcapng interfaces, for example) isn't known. */
+WS_DLL_PUBLIC
+gboolean wtap_seek_next(wtap *wth, gint64 offset, int *err);
+
+/*** raw file data ***/
+
+/** Called with data of the file as it's read; data is only valid during
+ * the call. */
+typedef void (*wtap_raw_tap_func)(const guint8 *data, guint len, void *user_data);
+
+/** Have func handed all of the raw (compressed, if the file is) data of
+ * the file exactly once and in order, from the buffers the file is read
+ * into as it is read, so that e.g. a hash of the file can be computed
+ * without reading it again.  func is called from whichever thread reads
+ * the file, which may be a read-ahead thread. */
+WS_DLL_PUBLIC
+void wtap_set_raw_tap(wtap *wth, wtap_raw_tap_func func, void *user_data);
+
+/** Hand whatever of the file hasn't been read yet to the raw tap, and
+ * remove the tap; the file can't be read any further afterwards.
+ * Returns FALSE, with *err set, if not all of the file could be handed
+ * to the tap. */
+WS_DLL_PUBLIC
+gboolean wtap_raw_tap_finish(wtap *wth, int *err);
+
 /*** close the file descriptors for the current file ***/
 WS_DLL_PUBLIC
 void wtap_fdclose(wtap *wth);
@@ -0,0 +1,230 @@
+/* ws_mempbrk.c
+ * Search a buffer for any of a set of bytes
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * The sets of bytes that dissectors search for, such as CR and LF, are
+ * small, so on x86 a block of 16 or 32 bytes is compared with each of the
+ * bytes in the set with SSE2 or AVX2 instructions, and the comparisons
+ * are combined into a mask of the positions that matched.  SSE2 is part of
+ * x86-64, and is used if the compiler targets it; AVX2 is used if this CPU
+ * supports it, which is checked when the first pattern is compiled.
+ * Everything else uses the table lookup per byte that tvbuffs always used.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "ws_mempbrk.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define HAVE_SSE2_MEMPBRK
+#include <emmintrin.h>
+/* GCC 4.9 and later allow AVX2 intrinsics in functions with the "avx2"
+ * target attribute, without building the whole file for AVX2. */
+#if !defined(__clang__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_AVX2_MEMPBRK
+#include <immintrin.h>
+#endif
+#endif
+
+typedef const guint8 *(*mempbrk_func)(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle);
+
+static const guint8 *
+mempbrk_c(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle)
+{
+	const guint8 *haystack_end;
+
+	haystack_end = haystack + haystacklen;
+	while (haystack < haystack_end) {
+		if (pattern->table[*haystack]) {
+			if (found_needle)
+				*found_needle = *haystack;
+			return haystack;
+		}
+		haystack++;
+	}
+
+	return NULL;
+}
+
+#ifdef HAVE_SSE2_MEMPBRK
+static const guint8 *
+mempbrk_sse2(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle)
+{
+	__m128i	needles[WS_MEMPBRK_MAX_SIMD_NEEDLES];
+	__m128i	chunk, match;
+	guint	i, mask;
+
+	for (i = 0; i < pattern->num_needles; i++)
+		needles[i] = _mm_set1_epi8((char)pattern->needles[i]);
+
+	while (haystacklen >= 16) {
+		chunk = _mm_loadu_si128((const __m128i *)haystack);
+		match = _mm_cmpeq_epi8(chunk, needles[0]);
+		for (i = 1; i < pattern->num_needles; i++)
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, needles[i]));
+		mask = (guint)_mm_movemask_epi8(match);
+		if (mask) {
+			haystack += g_bit_nth_lsf(mask, -1);
+			if (found_needle)
+				*found_needle = *haystack;
+			return haystack;
+		}
+		haystack += 16;
+		haystacklen -= 16;
+	}
+
+	return mempbrk_c(haystack, haystacklen, pattern, found_needle);
+}
+#endif
+
+#ifdef HAVE_AVX2_MEMPBRK
+__attribute__((target("avx2")))
+static const guint8 *
+mempbrk_avx2(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle)
+{
+	__m256i	needles[WS_MEMPBRK_MAX_SIMD_NEEDLES];
+	__m256i	chunk, match;
+	guint	i;
+	guint32	mask;
+
+	for (i = 0; i < pattern->num_needles; i++)
+		needles[i] = _mm256_set1_epi8((char)pattern->needles[i]);
+
+	while (haystacklen >= 32) {
+		chunk = _mm256_loadu_si256((const __m256i *)haystack);
+		match = _mm256_cmpeq_epi8(chunk, needles[0]);
+		for (i = 1; i < pattern->num_needles; i++)
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, needles[i]));
+		mask = (guint32)_mm256_movemask_epi8(match);
+		if (mask) {
+			haystack += g_bit_nth_lsf(mask, -1);
+			if (found_needle)
+				*found_needle = *haystack;
+			return haystack;
+		}
+		haystack += 32;
+		haystacklen -= 32;
+	}
+
+	return mempbrk_sse2(haystack, haystacklen, pattern, found_needle);
+}
+#endif
+
+/* The implementation for patterns with few enough needles */
+static mempbrk_func mempbrk_simd = NULL;
+static const char *mempbrk_simd_name = NULL;
+
+static void
+mempbrk_init(void)
+{
+#ifdef HAVE_AVX2_MEMPBRK
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		mempbrk_simd = mempbrk_avx2;
+		mempbrk_simd_name = "avx2";
+		return;
+	}
+#endif
+#ifdef HAVE_SSE2_MEMPBRK
+	mempbrk_simd = mempbrk_sse2;
+	mempbrk_simd_name = "sse2";
+#else
+	mempbrk_simd = mempbrk_c;
+	mempbrk_simd_name = "c";
+#endif
+}
+
+void
+ws_mempbrk_compile(ws_mempbrk_pattern *pattern, const gchar *needles)
+{
+	const guint8 *needle;
+
+	if (!mempbrk_simd)
+		mempbrk_init();
+
+	memset(pattern, 0, sizeof(*pattern));
+	for (needle = (const guint8 *)needles; *needle; needle++) {
+		if (pattern->table[*needle])
+			continue;
+		pattern->table[*needle] = 1;
+		if (pattern->num_needles < WS_MEMPBRK_MAX_SIMD_NEEDLES)
+			pattern->needles[pattern->num_needles] = *needle;
+		pattern->num_needles++;
+	}
+}
+
+const guint8 *
+ws_mempbrk_exec(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle)
+{
+	if (pattern->num_needles == 0)
+		return NULL;
+	if (pattern->num_needles <= WS_MEMPBRK_MAX_SIMD_NEEDLES && haystacklen >= 16)
+		return mempbrk_simd(haystack, haystacklen, pattern, found_needle);
+	return mempbrk_c(haystack, haystacklen, pattern, found_needle);
+}
+
+const char *
+ws_mempbrk_impl(void)
+{
+	if (!mempbrk_simd)
+		mempbrk_init();
+	return mempbrk_simd_name;
+}
+
+gboolean
+ws_mempbrk_set_impl(const char *name)
+{
+	if (!mempbrk_simd)
+		mempbrk_init();
+
+	if (strcmp(name, "c") == 0) {
+		mempbrk_simd = mempbrk_c;
+		mempbrk_simd_name = "c";
+		return TRUE;
+	}
+#ifdef HAVE_SSE2_MEMPBRK
+	if (strcmp(name, "sse2") == 0) {
+		mempbrk_simd = mempbrk_sse2;
+		mempbrk_simd_name = "sse2";
+		return TRUE;
+	}
+#endif
+#ifdef HAVE_AVX2_MEMPBRK
+	if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+		mempbrk_simd = mempbrk_avx2;
+		mempbrk_simd_name = "avx2";
+		return TRUE;
+	}
+#endif
+	return FALSE;
+}
@@ -0,0 +1,65 @@
+/* ws_mempbrk.h
+ * Search a buffer for any of a set of bytes
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __WS_MEMPBRK_H__
+#define __WS_MEMPBRK_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+/** The largest set of bytes that the vectorized searches handle; larger
+ * sets are searched with a table lookup per byte. */
+#define WS_MEMPBRK_MAX_SIMD_NEEDLES	8
+
+/** A set of bytes to search for, compiled once by ws_mempbrk_compile()
+ * and then used for any number of searches. */
+typedef struct {
+	gchar	table[256];	/* non-zero for the bytes in the set */
+	guint8	needles[WS_MEMPBRK_MAX_SIMD_NEEDLES];
+	guint	num_needles;	/* number of different bytes in the set */
+} ws_mempbrk_pattern;
+
+/** Compile the bytes of the NUL-terminated string needles into a pattern. */
+WS_DLL_PUBLIC
+void ws_mempbrk_compile(ws_mempbrk_pattern *pattern, const gchar *needles);
+
+/** Find the first byte of haystack that is in pattern.  Returns a pointer
+ * to it, and sets *found_needle to it if found_needle isn't NULL, or
+ * returns NULL if there is none. */
+WS_DLL_PUBLIC
+const guint8 *ws_mempbrk_exec(const guint8 *haystack, size_t haystacklen,
+    const ws_mempbrk_pattern *pattern, guchar *found_needle);
+
+/** The name of the implementation that ws_mempbrk_exec() uses: "avx2",
+ * "sse2" or "c". */
+WS_DLL_PUBLIC
+const char *ws_mempbrk_impl(void);
+
+/** Make ws_mempbrk_exec() use the named implementation, if it was built
+ * and this CPU supports it; for benchmarks.  Returns FALSE if it can't. */
+WS_DLL_PUBLIC
+gboolean ws_mempbrk_set_impl(const char *name);
+
+#endif /* __WS_MEMPBRK_H__ */